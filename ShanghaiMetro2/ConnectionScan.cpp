@@ -0,0 +1,146 @@
+﻿/***************************************************************************
+  文件名称：ConnectionScan.cpp
+  功    能：按时刻表查询最早到达的实现文件
+  说    明：各站的最早到达时刻只会变早，区间运行按出发时刻排序，因此扫描
+            到某段时其出发站的最早到达时刻已经确定；换乘其他车次须在到达后
+            等待该站的换乘时间，留在同一车次上则不受限制
+***************************************************************************/
+
+#include "ConnectionScan.h"
+#include <algorithm>
+#include <limits>
+
+/***************************************************************************
+  函数名称：ConnectionScan::ConnectionScan
+  功    能：构造函数
+  输入参数：TimetablePtr timetable - 时刻表，不能为空
+  返 回 值：
+  说    明：
+***************************************************************************/
+ConnectionScan::ConnectionScan(TimetablePtr timetable)
+    : timetable(timetable), epoch(0), scanned(0) {
+    const int stationCount = timetable->getStationCount();
+    const int tripCount    = timetable->getTripCount();
+    arrival     .resize(stationCount);
+    ready       .resize(stationCount);
+    inConnection.resize(stationCount);
+    reached     .assign(stationCount, 0);
+    tripEntry   .resize(tripCount);
+    tripReached .assign(tripCount, 0);
+}
+
+/***************************************************************************
+  函数名称：ConnectionScan::earliestArrival
+  功    能：查询最早到达的行程
+  输入参数：StationId from - 起点编号
+            StationId to   - 终点编号
+            int departure  - 出发时刻（当日零点起的秒数）
+  返 回 值：TimetableJourney - 行程，当日无法到达时legs为空
+  说    明：从第一段不早于出发时刻的区间运行开始扫描；某段可以乘坐的条件是
+            已经在该车次上，或出发站的可换乘时刻不晚于其出发时刻；乘坐后若
+            到达站时刻更早则更新该站并记录区间运行，首次登上的车次记录上车
+            所在的区间运行。出发时刻不早于终点已知到达时刻的区间运行不可能
+            再改进终点，扫描到此停止
+***************************************************************************/
+TimetableJourney ConnectionScan::earliestArrival(StationId from, StationId to, int departure) {
+    scanned = 0;
+    const int stationCount = timetable->getStationCount();
+    if (from >= StationId(stationCount) || to >= StationId(stationCount)) {
+        return TimetableJourney();
+    }
+
+    if (++epoch == 0) {
+        /* 编号回绕，旧标记可能与新编号相同*/
+        std::fill(reached.begin(), reached.end(), 0);
+        std::fill(tripReached.begin(), tripReached.end(), 0);
+        epoch = 1;
+    }
+    const qint32 unreachable = std::numeric_limits<qint32>::max();
+    reached[from]      = epoch;
+    arrival[from]      = departure;
+    ready[from]        = departure;
+    inConnection[from] = -1;
+    if (from == to) {
+        return buildJourney(from, to, departure);
+    }
+
+    const QVector<TimetableConnection>& connections = timetable->getConnections();
+    const TimetableConnection*          data        = connections.constData();
+    const int                           count       = connections.size();
+    for (int c = timetable->findFirstConnection(departure); c < count; c++) {
+        const TimetableConnection& connection = data[c];
+        const qint32 targetArrival = reached[to] == epoch ? arrival[to] : unreachable;
+        if (connection.departure >= targetArrival) {
+            break;
+        }
+        scanned++;
+
+        const bool onTrip = tripReached[connection.trip] == epoch;
+        if (!onTrip && (reached[connection.from] != epoch || ready[connection.from] > connection.departure)) {
+            continue;
+        }
+        if (!onTrip) {
+            tripReached[connection.trip] = epoch;
+            tripEntry[connection.trip]   = c;
+        }
+        if (reached[connection.to] != epoch || connection.arrival < arrival[connection.to]) {
+            reached[connection.to]      = epoch;
+            arrival[connection.to]      = connection.arrival;
+            ready[connection.to]        = connection.arrival + timetable->getTransferTime(connection.to);
+            inConnection[connection.to] = c;
+        }
+    }
+
+    return buildJourney(from, to, departure);
+}
+
+/***************************************************************************
+  函数名称：ConnectionScan::buildJourney
+  功    能：由各站的区间运行指针还原行程
+  输入参数：StationId from - 起点编号
+            StationId to   - 终点编号
+            int departure  - 出发时刻
+  返 回 值：TimetableJourney - 行程
+  说    明：从终点出发，取带来最早到达的区间运行所在车次的上车点，跳到上车站
+            继续，直到回到起点；每段途经的站点取自车次的停站序列
+***************************************************************************/
+TimetableJourney ConnectionScan::buildJourney(StationId from, StationId to, int departure) const {
+    TimetableJourney journey;
+    journey.departure = departure;
+    if (reached[to] != epoch) {
+        return journey;
+    }
+    journey.arrival = arrival[to];
+
+    const QVector<TimetableConnection>& connections = timetable->getConnections();
+    for (StationId station = to; station != from; ) {
+        const TimetableConnection& exit  = connections[inConnection[station]];
+        const TimetableConnection& entry = connections[tripEntry[exit.trip]];
+        const TimetableTrip&       trip  = timetable->getTrip(exit.trip);
+
+        TimetableLeg leg;
+        leg.line      = trip.line;
+        leg.trip      = exit.trip;
+        leg.departure = entry.departure;
+        leg.arrival   = exit.arrival;
+        for (int stop = entry.stop; stop <= exit.stop + 1; stop++) {
+            leg.stations.append(timetable->getStopStation(trip.firstStop + stop));
+        }
+        journey.legs.prepend(leg);
+        station = entry.from;
+    }
+    return journey;
+}
+
+/***************************************************************************
+  函数名称：ConnectionScan::getScannedCount
+  功    能：获取最近一次查询扫描的区间运行数
+  输入参数：
+  返 回 值：int - 区间运行数
+  说    明：
+***************************************************************************/
+int ConnectionScan::getScannedCount() const {
+    return scanned;
+}
+
+/*ConnectionScan.cpp*/
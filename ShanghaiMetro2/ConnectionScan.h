@@ -0,0 +1,37 @@
+﻿/***************************************************************************
+  文件名称：ConnectionScan.h
+  功    能：按时刻表查询最早到达的头文件
+  说    明：Connection Scan Algorithm：从出发时刻起按时间顺序扫描一次区间
+            运行数组，逐段更新各站的最早到达时刻，扫描到晚于终点已知到达
+            时刻的区间运行即停止；不需要优先队列，内存访问是连续的。
+            同一对象可重复查询，临时数组只分配一次；不同线程应各用一个对象
+***************************************************************************/
+
+#ifndef CONNECTIONSCAN_H
+#define CONNECTIONSCAN_H
+
+#include "Timetable.h"
+#include <vector>
+
+/*时刻表上的最早到达查询*/
+class ConnectionScan {
+public:
+    explicit ConnectionScan(TimetablePtr timetable);                               //构造函数，按时刻表的规模分配临时数组
+    TimetableJourney earliestArrival(StationId from, StationId to, int departure); //在departure时刻从from出发，最早到达to的行程
+    int              getScannedCount() const;                                      //最近一次查询扫描的区间运行数
+
+private:
+    TimetablePtr         timetable;    //时刻表
+    quint32              epoch;        //当前查询的编号，各标记数组等于它时有效
+    int                  scanned;      //最近一次查询扫描的区间运行数
+    std::vector<qint32>  arrival;      //按站点：最早到达时刻
+    std::vector<qint32>  ready;        //按站点：可以登上其他车次的最早时刻
+    std::vector<int>     inConnection; //按站点：带来最早到达的区间运行，起点为-1
+    std::vector<quint32> reached;      //按站点：等于epoch时以上三项有效
+    std::vector<int>     tripEntry;    //按车次：上车所在的区间运行
+    std::vector<quint32> tripReached;  //按车次：等于epoch时已经上车
+
+    TimetableJourney buildJourney(StationId from, StationId to, int departure) const; //沿区间运行指针还原各段
+};
+
+#endif // CONNECTIONSCAN_H
@@ -0,0 +1,539 @@
+﻿/***************************************************************************
+  文件名称：ContractionHierarchy.cpp
+  功    能：收缩层次索引的实现文件
+  说    明：站点按优先级（需添加的捷径数减去相邻边数，再加上已收缩的邻居数
+            和所在层数）从小到大收缩，优先级惰性更新；是否需要捷径由限定规模的见证搜索
+            判断，见证搜索提前停止只会多加捷径，不影响正确性。
+            文件由定长文件头和依次排列的定长数组段组成，按本机字节序存储
+***************************************************************************/
+
+#include "ContractionHierarchy.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <vector>
+
+namespace {
+
+const quint32 BYTE_ORDER_MARK       = 0x01020304u; //用于识别字节序不同的文件
+const int     MAX_HASH_LENGTH       = 32;    //文件头中哈希的最大长度
+const int     ESTIMATE_SETTLE_LIMIT = 30;    //估计优先级时一次见证搜索最多确定的站点数
+const int     CONTRACT_SETTLE_LIMIT = 500;   //实际收缩时一次见证搜索最多确定的站点数
+
+/*文件头*/
+struct HierarchyHeader {
+    quint32 magic;                 //文件标识
+    quint32 version;               //格式版本
+    quint32 byteOrder;             //字节序标记
+    quint32 hashLength;            //CSR出边哈希的实际长度
+    quint8  hash[MAX_HASH_LENGTH]; //CSR出边哈希
+    quint32 stationCount;          //站点数量
+    quint32 arcCount;              //向上边数量
+    quint32 shortcutCount;         //捷径数量
+    quint32 reserved;              //保留，对齐用
+    quint64 fileSize;              //文件总长度
+};
+
+/*收缩过程中的一条无向边*/
+struct WorkArc {
+    StationId to;     //另一端站点
+    double    weight; //边长
+    StationId middle; //捷径跨过的站点，原始边为INVALID_ID
+};
+
+/*收缩过程中尚未收缩的部分图*/
+struct WorkGraph {
+    std::vector<std::vector<WorkArc>> arcs; //每个站点到未收缩站点的边，同一终点只保留最短的一条
+
+    /*添加或缩短一条无向边*/
+    void add(StationId a, StationId b, double weight, StationId middle) {
+        addDirected(a, b, weight, middle);
+        addDirected(b, a, weight, middle);
+    }
+
+    void addDirected(StationId from, StationId to, double weight, StationId middle) {
+        for (WorkArc& arc : arcs[from]) {
+            if (arc.to == to) {
+                if (weight < arc.weight) {
+                    arc.weight = weight;
+                    arc.middle = middle;
+                }
+                return;
+            }
+        }
+        arcs[from].push_back(WorkArc{ to, weight, middle });
+    }
+};
+
+/*见证搜索：不经过被收缩站点的局部Dijkstra*/
+struct WitnessSearch {
+    std::vector<double>  dist;    //到各站点的距离
+    std::vector<quint32> reached; //等于epoch时dist有效
+    quint32              epoch = 0;
+
+    explicit WitnessSearch(int stationCount) : dist(stationCount), reached(stationCount, 0) {}
+
+    /*从source出发，不经过excluded，距离超过limit或确定的站点超过settleLimit时停止*/
+    void run(const WorkGraph& graph, StationId source, StationId excluded, double limit, int settleLimit) {
+        epoch++;
+        typedef std::pair<double, StationId> Entry;
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> heap;
+        dist[source]    = 0;
+        reached[source] = epoch;
+        heap.push(Entry(0, source));
+
+        int settledCount = 0;
+        while (!heap.empty() && settledCount < settleLimit) {
+            Entry top = heap.top();
+            heap.pop();
+            if (top.first > dist[top.second]) {
+                continue;
+            }
+            if (top.first > limit) {
+                break;
+            }
+            settledCount++;
+            for (const WorkArc& arc : graph.arcs[top.second]) {
+                if (arc.to == excluded) {
+                    continue;
+                }
+                double alt = top.first + arc.weight;
+                if (reached[arc.to] != epoch || alt < dist[arc.to]) {
+                    dist[arc.to]    = alt;
+                    reached[arc.to] = epoch;
+                    heap.push(Entry(alt, arc.to));
+                }
+            }
+        }
+    }
+
+    /*本次搜索到target的距离，未到达时为无穷大*/
+    double distanceTo(StationId target) const {
+        return reached[target] == epoch ? dist[target] : std::numeric_limits<double>::infinity();
+    }
+};
+
+/*收缩一个站点时需要添加的捷径*/
+struct Shortcut {
+    StationId from;   //一端站点
+    StationId to;     //另一端站点
+    double    weight; //长度
+};
+
+/***************************************************************************
+  函数名称：findShortcuts
+  功    能：计算收缩站点时需要添加的捷径
+  输入参数：const WorkGraph& graph    - 未收缩的部分图
+            WitnessSearch& witness    - 见证搜索
+            StationId station         - 被收缩的站点
+            std::vector<Shortcut>& out - 输出捷径
+            int settleLimit           - 一次见证搜索最多确定的站点数
+  返 回 值：
+  说    明：对每对邻居u、w，若不经过该站点找不到不长于u-站点-w的路径，
+            就需要一条u-w捷径；每对邻居只检查一次
+***************************************************************************/
+void findShortcuts(const WorkGraph& graph, WitnessSearch& witness, StationId station, std::vector<Shortcut>& out, int settleLimit) {
+    out.clear();
+    const std::vector<WorkArc>& arcs = graph.arcs[station];
+    double maxWeight = 0;
+    for (const WorkArc& arc : arcs) {
+        maxWeight = std::max(maxWeight, arc.weight);
+    }
+
+    for (size_t i = 0; i + 1 < arcs.size(); i++) {
+        witness.run(graph, arcs[i].to, station, arcs[i].weight + maxWeight, settleLimit);
+        for (size_t j = i + 1; j < arcs.size(); j++) {
+            const double via = arcs[i].weight + arcs[j].weight;
+            if (witness.distanceTo(arcs[j].to) > via) {
+                out.push_back(Shortcut{ arcs[i].to, arcs[j].to, via });
+            }
+        }
+    }
+}
+
+/***************************************************************************
+  函数名称：isMonotonic
+  功    能：检查偏移数组是否单调不减且首尾落在[0, limit]内
+  输入参数：const QVector<int>& offsets - 偏移数组
+            int limit                   - 最后一个偏移应等于的值
+  返 回 值：bool - 是否合法
+  说    明：
+***************************************************************************/
+bool isMonotonic(const QVector<int>& offsets, int limit) {
+    if (offsets.isEmpty() || offsets.first() != 0 || offsets.last() != limit) {
+        return false;
+    }
+    for (int i = 1; i < offsets.size(); i++) {
+        if (offsets[i] < offsets[i - 1]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/***************************************************************************
+  函数名称：appendArray
+  功    能：将QVector中的定长数组追加到文件缓冲区
+  输入参数：QByteArray& buffer       - 文件缓冲区
+            const QVector<T>& source - 源数组
+  返 回 值：
+  说    明：
+***************************************************************************/
+template <typename T>
+void appendArray(QByteArray& buffer, const QVector<T>& source) {
+    buffer.append(reinterpret_cast<const char*>(source.constData()), int(source.size() * sizeof(T)));
+}
+
+/***************************************************************************
+  函数名称：readArray
+  功    能：从映射内存中按顺序读出一段定长数组
+  输入参数：QVector<T>& target - 目标数组
+            const uchar*& cursor - 当前读取位置，读取后前移
+            int count          - 元素数量
+  返 回 值：
+  说    明：调用方已检查文件长度
+***************************************************************************/
+template <typename T>
+void readArray(QVector<T>& target, const uchar*& cursor, int count) {
+    target.resize(count);
+    if (count > 0) {
+        std::memcpy(target.data(), cursor, size_t(count) * sizeof(T));
+    }
+    cursor += qint64(count) * sizeof(T);
+}
+
+} // namespace
+
+/***************************************************************************
+  函数名称：ContractionHierarchy::ContractionHierarchy
+  功    能：构造函数
+  输入参数：
+  返 回 值：
+  说    明：
+***************************************************************************/
+ContractionHierarchy::ContractionHierarchy() : graphVersion(0), shortcutCount(0) {
+}
+
+/***************************************************************************
+  函数名称：ContractionHierarchy::build
+  功    能：由地铁图的CSR构建收缩层次
+  输入参数：const MetroGraph& graph - 地铁图
+  返 回 值：ContractionHierarchyPtr - 构建完成的索引
+  说    明：出边按无向边处理，同一对站点间的多条线路只保留最短的一条；
+            每个站点收缩时仍与其相连的未收缩站点即为其向上边的终点
+***************************************************************************/
+ContractionHierarchyPtr ContractionHierarchy::build(const MetroGraph& graph) {
+    const MetroCsr& csr          = graph.getCsr();
+    const int       stationCount = graph.getStationCount();
+
+    std::shared_ptr<ContractionHierarchy> hierarchy(new ContractionHierarchy());
+    hierarchy->hash         = graph.getEdgeHash();
+    hierarchy->graphVersion = graph.getVersion();
+    hierarchy->rank.fill(-1, stationCount);
+
+    WorkGraph work;
+    work.arcs.resize(stationCount);
+    for (StationId from = 0; from < StationId(stationCount); from++) {
+        for (int e = csr.offsets[from]; e < csr.offsets[from + 1]; e++) {
+            if (csr.targets[e] != from) {
+                work.add(from, csr.targets[e], csr.weights[e], INVALID_ID);
+            }
+        }
+    }
+
+    WitnessSearch         witness(stationCount);
+    std::vector<Shortcut> shortcuts;
+    std::vector<int>      contractedNeighbours(stationCount, 0); //已收缩的邻居数
+    std::vector<int>      level(stationCount, 0);                //已收缩邻居的最大层数加一
+    auto priority = [&](StationId station) {
+        findShortcuts(work, witness, station, shortcuts, ESTIMATE_SETTLE_LIMIT);
+        return int(shortcuts.size()) - int(work.arcs[station].size()) + contractedNeighbours[station] + level[station];
+    };
+
+    /* 按优先级收缩，出队时重新计算，变大且不再最小则放回*/
+    typedef std::pair<int, StationId> Entry;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+    for (StationId station = 0; station < StationId(stationCount); station++) {
+        queue.push(Entry(priority(station), station));
+    }
+
+    std::vector<std::vector<WorkArc>> upwardArcs(stationCount);
+    int order = 0;
+    while (!queue.empty()) {
+        const StationId station = queue.top().second;
+        queue.pop();
+        const int current = priority(station);
+        if (!queue.empty() && current > queue.top().first) {
+            queue.push(Entry(current, station));
+            continue;
+        }
+
+        /* 估计时的见证搜索较小，收缩时用更大的搜索减少多余的捷径*/
+        findShortcuts(work, witness, station, shortcuts, CONTRACT_SETTLE_LIMIT);
+        hierarchy->rank[station] = order++;
+        upwardArcs[station] = work.arcs[station];
+        for (const WorkArc& arc : work.arcs[station]) {
+            std::vector<WorkArc>& neighbourArcs = work.arcs[arc.to];
+            for (size_t i = 0; i < neighbourArcs.size(); i++) {
+                if (neighbourArcs[i].to == station) {
+                    neighbourArcs.erase(neighbourArcs.begin() + i);
+                    break;
+                }
+            }
+            contractedNeighbours[arc.to]++;
+            level[arc.to] = std::max(level[arc.to], level[station] + 1);
+        }
+        for (const Shortcut& shortcut : shortcuts) {
+            work.add(shortcut.from, shortcut.to, shortcut.weight, station);
+        }
+        work.arcs[station].clear();
+    }
+
+    /* 冻结为CSR形式的向上图*/
+    UpwardGraph& upward = hierarchy->upward;
+    upward.offsets.resize(stationCount + 1);
+    for (StationId station = 0; station < StationId(stationCount); station++) {
+        upward.offsets[station] = upward.targets.size();
+        for (const WorkArc& arc : upwardArcs[station]) {
+            upward.targets.append(arc.to);
+            upward.weights.append(arc.weight);
+            upward.middles.append(arc.middle);
+            if (arc.middle != INVALID_ID) {
+                hierarchy->shortcutCount++;
+            }
+        }
+    }
+    upward.offsets[stationCount] = upward.targets.size();
+
+    qDebug() << "收缩层次构建完成:" << stationCount << "个站点," << upward.targets.size()
+             << "条向上边, 其中捷径" << hierarchy->shortcutCount << "条";
+    return hierarchy;
+}
+
+/***************************************************************************
+  函数名称：ContractionHierarchy::save
+  功    能：将索引写入二进制文件
+  输入参数：const QString& filename - 文件名
+  返 回 值：bool - 是否写入成功
+  说    明：通过QSaveFile原子替换，写入中途失败不会留下残缺文件
+***************************************************************************/
+bool ContractionHierarchy::save(const QString& filename) const {
+    HierarchyHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic         = MAGIC;
+    header.version       = VERSION;
+    header.byteOrder     = BYTE_ORDER_MARK;
+    header.hashLength    = quint32(qMin(int(hash.size()), MAX_HASH_LENGTH));
+    std::memcpy(header.hash, hash.constData(), header.hashLength);
+    header.stationCount  = quint32(rank.size());
+    header.arcCount      = quint32(upward.targets.size());
+    header.shortcutCount = quint32(shortcutCount);
+    header.fileSize      = sizeof(header) + quint64(header.arcCount) * (sizeof(double) + 2 * sizeof(quint32))
+                         + quint64(header.stationCount) * sizeof(qint32) * 2 + sizeof(qint32);
+
+    /* 先写double段，各段都落在自身大小的整数倍上*/
+    QByteArray buffer(reinterpret_cast<const char*>(&header), int(sizeof(header)));
+    appendArray(buffer, upward.weights);
+    appendArray(buffer, rank);
+    appendArray(buffer, upward.offsets);
+    appendArray(buffer, upward.targets);
+    appendArray(buffer, upward.middles);
+
+    QSaveFile file(filename);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "无法写入收缩层次文件:" << filename;
+        return false;
+    }
+    if (file.write(buffer) != buffer.size() || !file.commit()) {
+        qWarning() << "收缩层次文件写入失败:" << filename;
+        return false;
+    }
+
+    qDebug() << "已写入收缩层次" << filename << ":" << buffer.size() << "字节";
+    return true;
+}
+
+/***************************************************************************
+  函数名称：ContractionHierarchy::load
+  功    能：读取与地铁图匹配的索引文件
+  输入参数：const MetroGraph& graph - 地铁图
+            const QString& filename - 文件名
+  返 回 值：ContractionHierarchyPtr - 读取的索引，文件缺失或不匹配时为空
+  说    明：标识、版本、字节序、CSR哈希、长度、编号范围或层次顺序任一不符
+            都视为失效，由调用方重新构建。层次须是站点的一个排列，捷径的
+            中间站点层次低于两端，且两段半边都存在，展开捷径时才能终止
+***************************************************************************/
+ContractionHierarchyPtr ContractionHierarchy::load(const MetroGraph& graph, const QString& filename) {
+    QFile file(filename);
+    if (!file.exists() || !file.open(QIODevice::ReadOnly)) {
+        return ContractionHierarchyPtr();
+    }
+
+    const qint64 fileSize = file.size();
+    if (fileSize < qint64(sizeof(HierarchyHeader))) {
+        return ContractionHierarchyPtr();
+    }
+
+    const uchar* base = file.map(0, fileSize);
+    if (base == nullptr) {
+        qWarning() << "收缩层次文件映射失败:" << filename;
+        return ContractionHierarchyPtr();
+    }
+
+    /* 校验文件头*/
+    HierarchyHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    const QByteArray expected   = graph.getEdgeHash();
+    const int        hashLength = qMin(int(expected.size()), MAX_HASH_LENGTH);
+    const quint64    arcCount   = header.arcCount;
+    const quint64    count      = header.stationCount;
+    if (header.magic != MAGIC || header.version != VERSION || header.byteOrder != BYTE_ORDER_MARK
+        || header.fileSize != quint64(fileSize) || header.hashLength != quint32(hashLength)
+        || std::memcmp(header.hash, expected.constData(), size_t(hashLength)) != 0
+        || count != quint64(graph.getStationCount())
+        || header.fileSize != sizeof(header) + arcCount * (sizeof(double) + 2 * sizeof(quint32))
+                              + count * sizeof(qint32) * 2 + sizeof(qint32)) {
+        qDebug() << "收缩层次与地铁图不匹配，忽略:" << filename;
+        file.unmap(const_cast<uchar*>(base));
+        return ContractionHierarchyPtr();
+    }
+
+    std::shared_ptr<ContractionHierarchy> hierarchy(new ContractionHierarchy());
+    hierarchy->hash          = expected;
+    hierarchy->graphVersion  = graph.getVersion();
+    hierarchy->shortcutCount = int(header.shortcutCount);
+
+    UpwardGraph&  upward       = hierarchy->upward;
+    const int     stationCount = int(count);
+    const uchar*  cursor       = base + sizeof(header);
+    readArray(upward.weights, cursor, int(arcCount));
+    readArray(hierarchy->rank, cursor, stationCount);
+    readArray(upward.offsets, cursor, stationCount + 1);
+    readArray(upward.targets, cursor, int(arcCount));
+    readArray(upward.middles, cursor, int(arcCount));
+    file.unmap(const_cast<uchar*>(base));
+
+    /* 层次须是0到站点数减一的排列*/
+    const QVector<int>& rank  = hierarchy->rank;
+    bool                valid = isMonotonic(upward.offsets, int(arcCount));
+    QVector<bool>       ranked(stationCount, false);
+    for (int station = 0; valid && station < stationCount; station++) {
+        valid = rank[station] >= 0 && rank[station] < stationCount && !ranked[rank[station]];
+        if (valid) {
+            ranked[rank[station]] = true;
+        }
+    }
+
+    /* 编号范围和层次顺序：向上边的终点层次必须更高*/
+    for (StationId station = 0; valid && station < StationId(stationCount); station++) {
+        for (int e = upward.offsets[station]; valid && e < upward.offsets[station + 1]; e++) {
+            valid = upward.targets[e] < StationId(stationCount)
+                 && rank[upward.targets[e]] > rank[station]
+                 && (upward.middles[e] == INVALID_ID || upward.middles[e] < StationId(stationCount));
+        }
+    }
+
+    /* 捷径：中间站点层次低于两端，两段半边都存在*/
+    for (StationId station = 0; valid && station < StationId(stationCount); station++) {
+        for (int e = upward.offsets[station]; valid && e < upward.offsets[station + 1]; e++) {
+            const StationId middle = upward.middles[e];
+            if (middle != INVALID_ID) {
+                valid = rank[middle] < rank[station]
+                     && hierarchy->findArc(middle, station) >= 0
+                     && hierarchy->findArc(middle, upward.targets[e]) >= 0;
+            }
+        }
+    }
+    if (!valid) {
+        qWarning() << "收缩层次文件内容损坏:" << filename;
+        return ContractionHierarchyPtr();
+    }
+
+    qDebug() << "从文件加载收缩层次:" << stationCount << "个站点," << arcCount << "条向上边";
+    return hierarchy;
+}
+
+/***************************************************************************
+  函数名称：ContractionHierarchy::matches
+  功    能：判断索引是否对应该地铁图版本
+  输入参数：const MetroGraph& graph - 地铁图
+  返 回 值：bool - 是否对应
+  说    明：图被修改后版本号改变，旧索引不再使用
+***************************************************************************/
+bool ContractionHierarchy::matches(const MetroGraph& graph) const {
+    return graph.getVersion() == graphVersion && graph.getStationCount() == rank.size();
+}
+
+/***************************************************************************
+  函数名称：ContractionHierarchy::getUpwardGraph
+  功    能：获取向上图
+  输入参数：
+  返 回 值：const UpwardGraph& - 向上图
+  说    明：
+***************************************************************************/
+const UpwardGraph& ContractionHierarchy::getUpwardGraph() const {
+    return upward;
+}
+
+/***************************************************************************
+  函数名称：ContractionHierarchy::getShortcutCount
+  功    能：获取捷径数量
+  输入参数：
+  返 回 值：int - 捷径数量
+  说    明：
+***************************************************************************/
+int ContractionHierarchy::getShortcutCount() const {
+    return shortcutCount;
+}
+
+/***************************************************************************
+  函数名称：ContractionHierarchy::findArc
+  功    能：查找两站间的向上边
+  输入参数：StationId station1 - 站点1编号
+            StationId station2 - 站点2编号
+  返 回 值：int - 边在向上图中的下标，不存在时为-1
+  说    明：边存放在层次较低的一端，同一对站点至多一条
+***************************************************************************/
+int ContractionHierarchy::findArc(StationId station1, StationId station2) const {
+    const StationId lower  = rank[station1] < rank[station2] ? station1 : station2;
+    const StationId higher = lower == station1 ? station2 : station1;
+    for (int e = upward.offsets[lower]; e < upward.offsets[lower + 1]; e++) {
+        if (upward.targets[e] == higher) {
+            return e;
+        }
+    }
+    return -1;
+}
+
+/***************************************************************************
+  函数名称：ContractionHierarchy::unpackEdge
+  功    能：将向上图中的一条边展开为原始站点序列
+  输入参数：StationId from          - 边的一端
+            StationId to            - 边的另一端
+            QVector<StationId>& path - 输出路径，追加from之后到to为止的站点
+  返 回 值：
+  说    明：捷径展开为两段，用显式的栈代替递归，先展开靠近from的一段；
+            边可按任一方向展开
+***************************************************************************/
+void ContractionHierarchy::unpackEdge(StationId from, StationId to, QVector<StationId>& path) const {
+    QVector<std::pair<StationId, StationId>> pending; //待展开的边，栈顶先展开
+    pending.append(std::make_pair(from, to));
+    while (!pending.isEmpty()) {
+        const std::pair<StationId, StationId> edge = pending.takeLast();
+        const int arc = findArc(edge.first, edge.second);
+        if (arc < 0 || upward.middles[arc] == INVALID_ID) {
+            path.append(edge.second);
+            continue;
+        }
+        const StationId middle = upward.middles[arc];
+        pending.append(std::make_pair(middle, edge.second));
+        pending.append(std::make_pair(edge.first, middle));
+    }
+}
+
+/*ContractionHierarchy.cpp*/
@@ -0,0 +1,57 @@
+﻿/***************************************************************************
+  文件名称：ContractionHierarchy.h
+  功    能：收缩层次(Contraction Hierarchies)索引的头文件
+  说    明：按重要性依次收缩站点并添加保持最短距离的捷径，查询时只需从起点
+            和终点分别沿层次向上搜索；索引可写成二进制文件与地铁数据一同保存
+***************************************************************************/
+
+#ifndef CONTRACTIONHIERARCHY_H
+#define CONTRACTIONHIERARCHY_H
+
+#include "MetroGraph.h"
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include <memory>
+
+/*向上图：每个站点只保留指向层次更高站点的边（原始边或捷径）*/
+struct UpwardGraph {
+    QVector<int>       offsets; //站点i的向上边位于[offsets[i], offsets[i+1])
+    QVector<StationId> targets; //边的终点，层次高于起点
+    QVector<double>    weights; //边长（公里），捷径为所跨原始边之和
+    QVector<StationId> middles; //捷径跨过的中间站点，原始边为INVALID_ID
+};
+
+class ContractionHierarchy;
+
+/*只读的收缩层次索引，可在多个查找器之间共享*/
+typedef std::shared_ptr<const ContractionHierarchy> ContractionHierarchyPtr;
+
+/*收缩层次索引*/
+class ContractionHierarchy {
+public:
+    static const quint32 MAGIC   = 0x3148434Du; //文件标识"MCH1"
+    static const quint32 VERSION = 1;           //格式版本，布局变化时递增
+
+    static ContractionHierarchyPtr build(const MetroGraph& graph);                          //由地铁图的CSR构建索引
+    static ContractionHierarchyPtr load(const MetroGraph& graph, const QString& filename);  //读取与该地铁图匹配的索引文件
+    bool                           save(const QString& filename)                  const;   //将索引写入文件
+
+    bool               matches(const MetroGraph& graph)                           const;//索引是否对应该地铁图版本
+    const UpwardGraph& getUpwardGraph()                                           const;//获取向上图
+    int                getShortcutCount()                                         const;//获取捷径数量
+    void               unpackEdge(StationId from, StationId to,
+                                  QVector<StationId>& path)                       const;//将向上图中的一条边展开为原始站点序列
+
+private:
+    QVector<int> rank;          //站点的收缩次序，越大层次越高
+    UpwardGraph  upward;        //向上图
+    QByteArray   hash;          //构建时CSR出边的哈希
+    quint64      graphVersion;  //对应的地铁图版本号
+    int          shortcutCount; //捷径数量
+
+    ContractionHierarchy();                                //只能通过build或load创建
+    int findArc(StationId station1, StationId station2) const; //查找两站间的向上边
+};
+
+#endif // CONTRACTIONHIERARCHY_H
@@ -0,0 +1,134 @@
+﻿/***************************************************************************
+  文件名称：CostModel.cpp
+  功    能：广义代价模型的实现文件
+  说    明：出边的乘车时间取时刻表按里程估算的区间运行时间加上该线路的
+            停站时间，与按间隔生成的车次一致；同站分组之间的步行时间取
+            时刻表中按线路对配置的值，未配置时为该站的换乘时间，再取经过
+            站内其他站台的最短步行时间。地标沿用
+            地铁图按里程选出的站点，只把边权换成乘车时间重新计算
+***************************************************************************/
+
+#include "CostModel.h"
+#include <QDebug>
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+/***************************************************************************
+  函数名称：CostModel::CostModel
+  功    能：构造函数
+  输入参数：
+  返 回 值：
+  说    明：
+***************************************************************************/
+CostModel::CostModel() : graphVersion(0), stationCount(0), landmarkCount(0) {
+}
+
+/***************************************************************************
+  函数名称：CostModel::build
+  功    能：为地铁图版本计算乘车和步行时间
+  输入参数：const MetroGraph& graph     - 地铁图
+            const Timetable& timetable - 提供运营参数的时刻表
+  返 回 值：CostModelPtr - 代价模型
+  说    明：图被编辑后重新构建即可。出边两个方向的乘车时间相同，地标到
+            各站与各站到地标的值相同，每个地标只需一次Dijkstra；不计换乘
+            的乘车时间不超过任何路径的乘车时间，乘以乘车权重即为广义代价
+            的下界
+***************************************************************************/
+CostModelPtr CostModel::build(const MetroGraph& graph, const Timetable& timetable) {
+    const MetroCsr& csr = graph.getCsr();
+    std::shared_ptr<CostModel> model(new CostModel());
+    model->graphVersion = graph.getVersion();
+    model->stationCount = graph.getStationCount();
+
+    /* 出边的乘车时间*/
+    model->rideSeconds.resize(csr.targets.size());
+    for (int e = 0; e < csr.targets.size(); e++) {
+        const LineId line = csr.lines[e];
+        model->rideSeconds[e] = float(timetable.getSectionTime(line, csr.weights[e]) + timetable.getDwellTime(line));
+    }
+
+    /* 同站各分组之间的步行时间；配置的线路对不一定满足三角不等式（如
+       龙阳路2号线经18号线站台到16号线比直接换乘近），按站内最短步行
+       时间取值，一次换乘总不比连续两次换乘差，搜索得到的路径不会在同一
+       站连续换乘，路径段与代价分解的换乘次数一致*/
+    model->walkRows.resize(csr.groupLines.size());
+    for (StationId station = 0; station < StationId(model->stationCount); station++) {
+        const int first = csr.groupOffsets[station];
+        const int last  = csr.groupOffsets[station + 1];
+        const int count = last - first;
+        const int base  = model->walkSeconds.size();
+        for (int from = first; from < last; from++) {
+            model->walkRows[from] = model->walkSeconds.size();
+            for (int to = first; to < last; to++) {
+                model->walkSeconds.append(from == to ? 0.0f
+                                          : float(timetable.getWalkTime(station, csr.groupLines[from], csr.groupLines[to])));
+            }
+        }
+        float* walks = model->walkSeconds.data() + base;
+        for (int via = 0; via < count; via++) {
+            for (int from = 0; from < count; from++) {
+                for (int to = 0; to < count; to++) {
+                    walks[from * count + to] = qMin(walks[from * count + to], walks[from * count + via] + walks[via * count + to]);
+                }
+            }
+        }
+    }
+
+    /* 各地标到各站的最短乘车时间，不可达为-1*/
+    const QVector<StationId>& landmarks = graph.getLandmarks().landmarks;
+    model->landmarkCount = landmarks.size();
+    model->landmarkSeconds.fill(-1, model->stationCount * model->landmarkCount);
+    std::vector<std::pair<float, StationId>> heap;
+    for (int l = 0; l < model->landmarkCount; l++) {
+        float* seconds = model->landmarkSeconds.data() + l;
+        heap.clear();
+        heap.push_back(std::make_pair(0.0f, landmarks[l]));
+        seconds[landmarks[l] * model->landmarkCount] = 0;
+        while (!heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end(), std::greater<std::pair<float, StationId>>());
+            const std::pair<float, StationId> top = heap.back();
+            heap.pop_back();
+            if (top.first > seconds[top.second * model->landmarkCount]) {
+                continue; // 过期条目
+            }
+            for (int e = csr.offsets[top.second]; e < csr.offsets[top.second + 1]; e++) {
+                float&      known = seconds[csr.targets[e] * model->landmarkCount];
+                const float alt   = top.first + model->rideSeconds[e];
+                if (known < 0 || alt < known) {
+                    known = alt;
+                    heap.push_back(std::make_pair(alt, csr.targets[e]));
+                    std::push_heap(heap.begin(), heap.end(), std::greater<std::pair<float, StationId>>());
+                }
+            }
+        }
+    }
+
+    qDebug() << "广义代价模型构建完成:" << model->rideSeconds.size() << "条出边,"
+             << model->walkSeconds.size() << "个步行时间," << model->landmarkCount << "个地标";
+    return model;
+}
+
+/***************************************************************************
+  函数名称：CostModel::matches
+  功    能：判断代价模型是否对应该地铁图版本
+  输入参数：const MetroGraph& graph - 地铁图
+  返 回 值：bool - 是否对应
+  说    明：图被修改后版本号改变，旧模型不再使用
+***************************************************************************/
+bool CostModel::matches(const MetroGraph& graph) const {
+    return graph.getVersion() == graphVersion && graph.getStationCount() == stationCount;
+}
+
+/***************************************************************************
+  函数名称：CostModel::getLandmarkCount
+  功    能：获取地标数量
+  输入参数：
+  返 回 值：int - 地标数量，没有出边时为0
+  说    明：
+***************************************************************************/
+int CostModel::getLandmarkCount() const {
+    return landmarkCount;
+}
+
+/*CostModel.cpp*/
@@ -0,0 +1,96 @@
+﻿/***************************************************************************
+  文件名称：CostModel.h
+  功    能：广义代价模型的头文件
+  说    明：广义代价 = 乘车权重 × 乘车时间 + 步行权重 × 换乘步行时间
+                     + 换乘惩罚 × 换乘次数。
+            乘车时间和步行时间只依赖地铁图和时刻表，每个图版本按CSR的出边
+            和(站点, 线路)分组编号预先算成连续数组，并沿用地铁图的地标计算
+            各站到地标的最短乘车时间；权重在查询时才参与计算，随时修改都
+            不需要重新预处理
+***************************************************************************/
+
+#ifndef COSTMODEL_H
+#define COSTMODEL_H
+
+#include "MetroGraph.h"
+#include "Timetable.h"
+#include <QVector>
+#include <memory>
+
+/*广义代价各项的权重，单位均折算为乘车秒数*/
+struct CostWeights {
+    double inVehicle = 1.0; //乘车时间每秒的代价
+    double walking   = 2.0; //换乘步行每秒的代价，步行通常比坐车更难受
+    double transfer  = 120; //每次换乘额外的固定代价
+};
+
+/*一条路径的广义代价分解*/
+struct CostBreakdown {
+    double inVehicle = 0; //乘车时间（秒），含途经各站的停站时间
+    double walking   = 0; //换乘步行时间（秒）
+    int    transfers = 0; //换乘次数
+    double total     = 0; //按权重合计的广义代价，不可达为-1
+};
+
+class CostModel;
+
+/*只读的广义代价模型，可在多个查找器之间共享*/
+typedef std::shared_ptr<const CostModel> CostModelPtr;
+
+/*按地铁图版本预先计算的乘车和步行时间*/
+class CostModel {
+public:
+    static CostModelPtr build(const MetroGraph& graph, const Timetable& timetable); //按时刻表的运营参数为该图版本计算各项时间
+
+    bool         matches(const MetroGraph& graph)   const; //是否对应该地铁图版本
+    float        getRideSeconds(int edge)           const; //CSR出边的乘车秒数（区间运行加到站停站）
+    const float* getWalkRow(int group)              const; //从该分组换到同站各分组的步行秒数，按分组在站内的顺序
+    int          getLandmarkCount()                 const; //地标数量
+    const float* getLandmarkRow(StationId station)  const; //该站到各地标的最短乘车秒数，不可达为-1
+
+private:
+    quint64         graphVersion;    //对应的地铁图版本号
+    int             stationCount;    //站点数
+    int             landmarkCount;   //地标数量
+    QVector<float>  rideSeconds;     //按CSR出边的乘车秒数
+    QVector<int>    walkRows;        //按分组：步行秒数行在walkSeconds中的起点
+    QVector<float>  walkSeconds;     //各站k个分组之间的k×k最短步行秒数矩阵，按行连续存放
+    QVector<float>  landmarkSeconds; //按[station * 地标数 + 地标序号]存放的最短乘车秒数
+
+    CostModel(); //只能通过build创建
+};
+
+/***************************************************************************
+  函数名称：CostModel::getRideSeconds
+  功    能：获取CSR出边的乘车秒数
+  输入参数：int edge - 出边在CSR中的下标
+  返 回 值：float - 秒数
+  说    明：位于搜索的内层循环，定义在头文件中以便内联
+***************************************************************************/
+inline float CostModel::getRideSeconds(int edge) const {
+    return rideSeconds[edge];
+}
+
+/***************************************************************************
+  函数名称：CostModel::getWalkRow
+  功    能：获取从一个分组换到同站各分组的步行秒数
+  输入参数：int group - 分组编号
+  返 回 值：const float* - 第j项为换到该站第j个分组的秒数，自身为0
+  说    明：位于搜索的内层循环，定义在头文件中以便内联
+***************************************************************************/
+inline const float* CostModel::getWalkRow(int group) const {
+    return walkSeconds.constData() + walkRows[group];
+}
+
+/***************************************************************************
+  函数名称：CostModel::getLandmarkRow
+  功    能：获取一个站点到各地标的最短乘车秒数
+  输入参数：StationId station - 站点编号
+  返 回 值：const float* - 第l项为到第l个地标的秒数，不可达为-1
+  说    明：位于搜索的内层循环，定义在头文件中以便内联
+***************************************************************************/
+inline const float* CostModel::getLandmarkRow(StationId station) const {
+    return landmarkSeconds.constData() + station * landmarkCount;
+}
+
+#endif // COSTMODEL_H
@@ -0,0 +1,455 @@
+﻿/***************************************************************************
+  文件名称：JsonStreamReader.cpp
+  功    能：流式JSON读取器的实现文件
+  说    明：只检查括号配对（结束括号须与最近未结束的对象或数组一致）和
+            记号本身的合法性，逗号与冒号当作分隔符处理
+***************************************************************************/
+
+#include "JsonStreamReader.h"
+
+/***************************************************************************
+  函数名称：JsonStreamReader::JsonStreamReader
+  功    能：构造函数
+  输入参数：QIODevice* device - 已打开的数据来源
+            int chunkSize     - 每次读取的字节数
+  返 回 值：
+  说    明：
+***************************************************************************/
+JsonStreamReader::JsonStreamReader(QIODevice* device, int chunkSize)
+    : device(device), chunkSize(chunkSize), position(0), consumed(0),
+      token(Invalid), number(0), boolean(false) {
+    /* 跳过UTF-8 BOM*/
+    if (fillBuffer() && buffer.startsWith("\xEF\xBB\xBF")) {
+        position = 3;
+    }
+}
+
+/***************************************************************************
+  函数名称：JsonStreamReader::fillBuffer
+  功    能：读取下一个数据块
+  输入参数：
+  返 回 值：bool - 是否读到了数据
+  说    明：
+***************************************************************************/
+bool JsonStreamReader::fillBuffer() {
+    consumed += buffer.size();
+    buffer   = device->read(chunkSize);
+    position = 0;
+    return !buffer.isEmpty();
+}
+
+/***************************************************************************
+  函数名称：JsonStreamReader::peekChar
+  功    能：查看下一个字符
+  输入参数：
+  返 回 值：int - 下一个字节，文件结束时为-1
+  说    明：
+***************************************************************************/
+int JsonStreamReader::peekChar() {
+    if (position >= buffer.size() && !fillBuffer()) {
+        return -1;
+    }
+    return static_cast<uchar>(buffer.at(position));
+}
+
+/***************************************************************************
+  函数名称：JsonStreamReader::getChar
+  功    能：取出下一个字符
+  输入参数：
+  返 回 值：int - 下一个字节，文件结束时为-1
+  说    明：
+***************************************************************************/
+int JsonStreamReader::getChar() {
+    int c = peekChar();
+    if (c >= 0) {
+        position++;
+    }
+    return c;
+}
+
+/***************************************************************************
+  函数名称：JsonStreamReader::skipWhitespace
+  功    能：跳过空白和逗号
+  输入参数：
+  返 回 值：int - 下一个非空白字符（未取出），文件结束时为-1
+  说    明：
+***************************************************************************/
+int JsonStreamReader::skipWhitespace() {
+    int c = peekChar();
+    while (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == ',') {
+        position++;
+        c = peekChar();
+    }
+    return c;
+}
+
+/***************************************************************************
+  函数名称：JsonStreamReader::fail
+  功    能：记录错误
+  输入参数：const QString& message - 错误说明
+  返 回 值：TokenType - 恒为Invalid
+  说    明：
+***************************************************************************/
+JsonStreamReader::TokenType JsonStreamReader::fail(const QString& message) {
+    if (error.isEmpty()) {
+        error = QString::fromUtf8("位置%1: %2").arg(bytesRead()).arg(message);
+    }
+    token = Invalid;
+    return token;
+}
+
+/***************************************************************************
+  函数名称：JsonStreamReader::readNext
+  功    能：读取下一个记号
+  输入参数：
+  返 回 值：TokenType - 记号类型
+  说    明：出错后一直返回Invalid
+***************************************************************************/
+JsonStreamReader::TokenType JsonStreamReader::readNext() {
+    if (token == Invalid && !error.isEmpty()) {
+        return token;
+    }
+
+    int c = skipWhitespace();
+    switch (c) {
+    case -1:
+        if (!nesting.isEmpty()) {
+            return fail(QString::fromUtf8("文件意外结束"));
+        }
+        token = EndDocument;
+        return token;
+    case '{':
+        position++;
+        nesting.append('{');
+        token = BeginObject;
+        return token;
+    case '[':
+        position++;
+        nesting.append('[');
+        token = BeginArray;
+        return token;
+    case '}':
+    case ']':
+        position++;
+        if (nesting.isEmpty() || nesting.back() != (c == '}' ? '{' : '[')) {
+            return fail(QString::fromUtf8("括号不匹配"));
+        }
+        nesting.chop(1);
+        token = (c == '}') ? EndObject : EndArray;
+        return token;
+    case '"':
+        position++;
+        if (!readString()) {
+            return fail(QString::fromUtf8("字符串格式错误"));
+        }
+        /* 紧跟冒号的字符串是对象的键*/
+        c = peekChar();
+        while (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+            position++;
+            c = peekChar();
+        }
+        if (c == ':') {
+            position++;
+            token = Name;
+        }
+        else {
+            token = String;
+        }
+        return token;
+    case 't':
+        position++;
+        if (!readLiteral("rue")) {
+            return fail(QString::fromUtf8("无法识别的字面量"));
+        }
+        boolean = true;
+        token   = Bool;
+        return token;
+    case 'f':
+        position++;
+        if (!readLiteral("alse")) {
+            return fail(QString::fromUtf8("无法识别的字面量"));
+        }
+        boolean = false;
+        token   = Bool;
+        return token;
+    case 'n':
+        position++;
+        if (!readLiteral("ull")) {
+            return fail(QString::fromUtf8("无法识别的字面量"));
+        }
+        token = Null;
+        return token;
+    default:
+        if (c == '-' || (c >= '0' && c <= '9')) {
+            position++;
+            if (!readNumber(c)) {
+                return fail(QString::fromUtf8("数值格式错误"));
+            }
+            token = Number;
+            return token;
+        }
+        return fail(QString::fromUtf8("无法识别的字符"));
+    }
+}
+
+/***************************************************************************
+  函数名称：JsonStreamReader::readString
+  功    能：读取字符串内容（开头的引号已取出）
+  输入参数：
+  返 回 值：bool - 是否读取成功
+  说    明：转义序列按JSON规范解码，\u代理对合并为一个字符
+***************************************************************************/
+bool JsonStreamReader::readString() {
+    scratch.clear();
+    for (;;) {
+        int c = getChar();
+        if (c < 0) {
+            return false;
+        }
+        if (c == '"') {
+            break;
+        }
+        if (c != '\\') {
+            scratch.append(static_cast<char>(c));
+            continue;
+        }
+
+        c = getChar();
+        switch (c) {
+        case '"':  scratch.append('"');  break;
+        case '\\': scratch.append('\\'); break;
+        case '/':  scratch.append('/');  break;
+        case 'b':  scratch.append('\b'); break;
+        case 'f':  scratch.append('\f'); break;
+        case 'n':  scratch.append('\n'); break;
+        case 'r':  scratch.append('\r'); break;
+        case 't':  scratch.append('\t'); break;
+        case 'u': {
+            uint code = 0;
+            if (!readHex4(code)) {
+                return false;
+            }
+            /* 高位代理后必须跟低位代理*/
+            if (code >= 0xD800 && code <= 0xDBFF) {
+                uint low = 0;
+                if (getChar() != '\\' || getChar() != 'u' || !readHex4(low) || low < 0xDC00 || low > 0xDFFF) {
+                    return false;
+                }
+                code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+            }
+
+            /* 按UTF-8编码写入*/
+            if (code < 0x80) {
+                scratch.append(static_cast<char>(code));
+            }
+            else if (code < 0x800) {
+                scratch.append(static_cast<char>(0xC0 | (code >> 6)));
+                scratch.append(static_cast<char>(0x80 | (code & 0x3F)));
+            }
+            else if (code < 0x10000) {
+                scratch.append(static_cast<char>(0xE0 | (code >> 12)));
+                scratch.append(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+                scratch.append(static_cast<char>(0x80 | (code & 0x3F)));
+            }
+            else {
+                scratch.append(static_cast<char>(0xF0 | (code >> 18)));
+                scratch.append(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+                scratch.append(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+                scratch.append(static_cast<char>(0x80 | (code & 0x3F)));
+            }
+            break;
+        }
+        default:
+            return false;
+        }
+    }
+
+    text = QString::fromUtf8(scratch);
+    return true;
+}
+
+/***************************************************************************
+  函数名称：JsonStreamReader::readHex4
+  功    能：读取四位十六进制数
+  输入参数：uint& value - 读取结果
+  返 回 值：bool - 是否读取成功
+  说    明：
+***************************************************************************/
+bool JsonStreamReader::readHex4(uint& value) {
+    value = 0;
+    for (int i = 0; i < 4; i++) {
+        int c = getChar();
+        value <<= 4;
+        if (c >= '0' && c <= '9') {
+            value |= uint(c - '0');
+        }
+        else if (c >= 'a' && c <= 'f') {
+            value |= uint(c - 'a' + 10);
+        }
+        else if (c >= 'A' && c <= 'F') {
+            value |= uint(c - 'A' + 10);
+        }
+        else {
+            return false;
+        }
+    }
+    return true;
+}
+
+/***************************************************************************
+  函数名称：JsonStreamReader::readNumber
+  功    能：读取数值
+  输入参数：int first - 已取出的第一个字符
+  返 回 值：bool - 是否读取成功
+  说    明：QByteArray::toDouble不受系统区域设置影响
+***************************************************************************/
+bool JsonStreamReader::readNumber(int first) {
+    scratch.clear();
+    scratch.append(static_cast<char>(first));
+    for (;;) {
+        int c = peekChar();
+        if ((c >= '0' && c <= '9') || c == '.' || c == 'e' || c == 'E' || c == '+' || c == '-') {
+            scratch.append(static_cast<char>(c));
+            position++;
+        }
+        else {
+            break;
+        }
+    }
+
+    bool ok = false;
+    number = scratch.toDouble(&ok);
+    return ok;
+}
+
+/***************************************************************************
+  函数名称：JsonStreamReader::readLiteral
+  功    能：读取true/false/null的剩余字符
+  输入参数：const char* rest - 首字符之后应有的字符
+  返 回 值：bool - 是否匹配
+  说    明：
+***************************************************************************/
+bool JsonStreamReader::readLiteral(const char* rest) {
+    for (; *rest != '\0'; rest++) {
+        if (getChar() != *rest) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/***************************************************************************
+  函数名称：JsonStreamReader::skipValue
+  功    能：跳过当前记号开始的整个值
+  输入参数：
+  返 回 值：bool - 是否跳过成功
+  说    明：当前记号为对象或数组开始时，读到与之配对的结束记号为止；
+            当前记号为键时，跳过该键对应的值
+***************************************************************************/
+bool JsonStreamReader::skipValue() {
+    if (token == Name) {
+        readNext();
+    }
+    if (token != BeginObject && token != BeginArray) {
+        return token != Invalid;
+    }
+
+    const int targetDepth = nesting.size() - 1;
+    while (nesting.size() > targetDepth) {
+        if (readNext() == Invalid || token == EndDocument) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/***************************************************************************
+  函数名称：JsonStreamReader::tokenType
+  功    能：获取当前记号类型
+  输入参数：
+  返 回 值：TokenType - 记号类型
+  说    明：
+***************************************************************************/
+JsonStreamReader::TokenType JsonStreamReader::tokenType() const {
+    return token;
+}
+
+/***************************************************************************
+  函数名称：JsonStreamReader::stringValue
+  功    能：获取当前键或字符串值
+  输入参数：
+  返 回 值：const QString& - 字符串内容
+  说    明：
+***************************************************************************/
+const QString& JsonStreamReader::stringValue() const {
+    return text;
+}
+
+/***************************************************************************
+  函数名称：JsonStreamReader::numberValue
+  功    能：获取当前数值
+  输入参数：
+  返 回 值：double - 数值
+  说    明：
+***************************************************************************/
+double JsonStreamReader::numberValue() const {
+    return number;
+}
+
+/***************************************************************************
+  函数名称：JsonStreamReader::intValue
+  功    能：获取当前数值对应的整数
+  输入参数：int defaultValue - 当前记号不是整数时的返回值
+  返 回 值：int - 整数值
+  说    明：与QJsonValue::toInt的行为一致
+***************************************************************************/
+int JsonStreamReader::intValue(int defaultValue) const {
+    if (token != Number || number != static_cast<double>(static_cast<int>(number))) {
+        return defaultValue;
+    }
+    return static_cast<int>(number);
+}
+
+/***************************************************************************
+  函数名称：JsonStreamReader::boolValue
+  功    能：获取当前布尔值
+  输入参数：
+  返 回 值：bool - 布尔值
+  说    明：
+***************************************************************************/
+bool JsonStreamReader::boolValue() const {
+    return boolean;
+}
+
+/***************************************************************************
+  函数名称：JsonStreamReader::hasError
+  功    能：是否出错
+  输入参数：
+  返 回 值：bool - 是否出错
+  说    明：
+***************************************************************************/
+bool JsonStreamReader::hasError() const {
+    return !error.isEmpty();
+}
+
+/***************************************************************************
+  函数名称：JsonStreamReader::errorString
+  功    能：获取错误说明
+  输入参数：
+  返 回 值：QString - 错误说明
+  说    明：
+***************************************************************************/
+QString JsonStreamReader::errorString() const {
+    return error;
+}
+
+/***************************************************************************
+  函数名称：JsonStreamReader::bytesRead
+  功    能：获取已处理的字节数
+  输入参数：
+  返 回 值：qint64 - 字节数
+  说    明：
+***************************************************************************/
+qint64 JsonStreamReader::bytesRead() const {
+    return consumed + position;
+}
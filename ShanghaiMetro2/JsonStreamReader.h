@@ -0,0 +1,71 @@
+﻿/***************************************************************************
+  文件名称：JsonStreamReader.h
+  功    能：流式JSON读取器的头文件
+  说    明：按固定大小的块从设备读取数据，逐个产生记号（拉取式），
+            不构建完整的文档树，内存占用与文件大小无关
+***************************************************************************/
+
+#ifndef JSONSTREAMREADER_H
+#define JSONSTREAMREADER_H
+
+#include <QString>
+#include <QByteArray>
+#include <QIODevice>
+
+/*流式JSON读取器*/
+class JsonStreamReader {
+public:
+    /*记号类型*/
+    enum TokenType {
+        Invalid,     //出错
+        BeginObject, //对象开始 {
+        EndObject,   //对象结束 }
+        BeginArray,  //数组开始 [
+        EndArray,    //数组结束 ]
+        Name,        //对象中的键
+        String,      //字符串值
+        Number,      //数值
+        Bool,        //布尔值
+        Null,        //空值
+        EndDocument  //文档结束
+    };
+
+    explicit JsonStreamReader(QIODevice* device, int chunkSize = 64 * 1024); //构造函数
+
+    TokenType      readNext();                    //读取下一个记号
+    TokenType      tokenType()   const;           //当前记号类型
+    const QString& stringValue() const;           //当前键或字符串值
+    double         numberValue() const;           //当前数值
+    int            intValue(int defaultValue = 0) const; //当前数值转为整数，非整数时返回默认值
+    bool           boolValue()   const;           //当前布尔值
+    bool           skipValue();                   //跳过当前记号开始的整个值
+    bool           hasError()    const;           //是否出错
+    QString        errorString() const;           //错误说明
+    qint64         bytesRead()   const;           //已从设备读取的字节数
+
+private:
+    QIODevice* device;    //数据来源
+    QByteArray buffer;    //当前数据块
+    int        chunkSize; //每次读取的字节数
+    int        position;  //在当前数据块中的位置
+    qint64     consumed;  //之前各数据块的总字节数
+    QByteArray nesting;   //尚未结束的对象和数组，按嵌套顺序存放'{'或'['，长度即嵌套深度
+    TokenType  token;     //当前记号类型
+    QString    text;      //当前键或字符串值
+    double     number;    //当前数值
+    bool       boolean;   //当前布尔值
+    QString    error;     //错误说明
+    QByteArray scratch;   //读取字符串和数值时的临时缓冲
+
+    bool      fillBuffer();                      //读取下一个数据块
+    int       peekChar();                        //查看下一个字符，文件结束时为-1
+    int       getChar();                         //取出下一个字符，文件结束时为-1
+    int       skipWhitespace();                  //跳过空白、逗号，返回下一个字符
+    bool      readString();                      //读取字符串到text
+    bool      readNumber(int first);             //读取数值到number
+    bool      readLiteral(const char* rest);     //读取true/false/null的剩余部分
+    bool      readHex4(uint& value);             //读取\u后的四位十六进制数
+    TokenType fail(const QString& message);      //记录错误并返回Invalid
+};
+
+#endif // JSONSTREAMREADER_H
@@ -41,15 +41,20 @@ void LineStationDialog::setupUI() {
     lineComboBox = new QComboBox(this);
 
     /* 获取所有线路并按名称排序*/
-    QVector<MetroLine> lines = metroGraph.getLines();
+    QVector<QString> lineNames;
+    lineNames.reserve(metroGraph.getLineCount());
+    for (const MetroLine& line : metroGraph.getLines()) {
+        lineNames.append(line.name);
+    }
+
     QCollator collator;
     collator.setNumericMode(false);
-    std::sort(lines.begin(), lines.end(), [&collator](const MetroLine& a, const MetroLine& b) {
-        return collator.compare(a.name, b.name) < 0;
+    std::sort(lineNames.begin(), lineNames.end(), [&collator](const QString& a, const QString& b) {
+        return collator.compare(a, b) < 0;
     });
 
-    for (const MetroLine& line : lines) {
-        lineComboBox->addItem(line.name);
+    for (const QString& name : lineNames) {
+        lineComboBox->addItem(name);
     }
 
     lineLayout->addWidget(lineComboBox);
@@ -106,8 +111,13 @@ void LineStationDialog::updateStationsList(const QString& line) {
     selectedLine = line;
 
     // 获取该线路上的所有站点
-    QMap<QString, QVector<QString>> lineStations = metroGraph.getLineStations();
-    QVector<QString>                stations     = lineStations[line];
+    QVector<QString> stations;
+    LineId           lineId = metroGraph.getLineId(line);
+    if (lineId != INVALID_ID) {
+        for (StationId id : metroGraph.getLineStationIds(lineId)) {
+            stations.append(metroGraph.getStationName(id));
+        }
+    }
 
     // 按拼音排序
     QCollator collator;
@@ -5,6 +5,8 @@
 ***************************************************************************/
 
 #include "MainWindow.h"
+#include "RouteTable.h"
+#include "RouteCache.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QLabel>
@@ -24,7 +26,6 @@
 #include "AddStationDialog.h"
 #include <QGraphicsOpacityEffect>
 #include<QPropertyAnimation>
-#include <QCollator>
 #include <QFormLayout>
 
 /***************************************************************************
@@ -36,11 +37,21 @@
 ***************************************************************************/
 MainWindow::MainWindow(QWidget* parent)
     : QMainWindow(parent), 
-      pathFinder(&metroGraph), 
-      selectedStrategy(MIN_STATIONS) 
+      pathFinder(graphStore.current()), 
+      selectedStrategy(MIN_STATIONS),
+      showAllOptions(false),
+      useTimetable(false),
+      useGeneralizedCost(false),
+      shownGraphVersion(0),
+      stationNameModel(nullptr),
+      cacheStatsLabel(nullptr)
 {
+    pathFinder.setRouteCache(std::make_shared<RouteCache>());
     setupUI();
     loadMetroData();
+
+    /*之后每次发布新版本都按变更增量刷新界面*/
+    graphStore.subscribe([this](const MetroGraphPtr& graph) { onGraphChanged(graph); });
     setupAudio();
     playBackgroundMusic();
 }
@@ -351,12 +362,52 @@ void MainWindow::setupUI() {
     QRadioButton* minTransferRadio = new QRadioButton(QString::fromUtf8("换乘最少"), this);
     QRadioButton* minStationsRadio = new QRadioButton(QString::fromUtf8("经过站点最少"), this);
     QRadioButton* minDistanceRadio = new QRadioButton(QString::fromUtf8("路径长度最短"), this);
+    QRadioButton* allOptionsRadio  = new QRadioButton(QString::fromUtf8("列出全部方案"), this);
+    QRadioButton* earliestRadio    = new QRadioButton(QString::fromUtf8("最早到达（按时刻表）"), this);
+    QRadioButton* costRadio        = new QRadioButton(QString::fromUtf8("综合代价最少（乘车+步行+换乘）"), this);
 
     minStationsRadio->setChecked(true); // 默认选择
 
     strategyLayout->addWidget(minTransferRadio);
     strategyLayout->addWidget(minStationsRadio);
     strategyLayout->addWidget(minDistanceRadio);
+    strategyLayout->addWidget(allOptionsRadio);
+    strategyLayout->addWidget(earliestRadio);
+
+    /*最早到达查询的出发时刻，默认为当前时刻*/
+    QHBoxLayout* departureLayout = new QHBoxLayout();
+    departureTimeEdit            = new QTimeEdit(QTime::currentTime(), this);
+    departureTimeEdit->setDisplayFormat("HH:mm");
+    departureLayout->addWidget(new QLabel(QString::fromUtf8("出发时刻"), this));
+    departureLayout->addWidget(departureTimeEdit);
+    strategyLayout ->addLayout(departureLayout);
+    strategyLayout ->addWidget(costRadio);
+
+    /*综合代价的权重，每次查找时读取，修改后无需重新加载数据*/
+    QHBoxLayout* weightLayout = new QHBoxLayout();
+    rideWeightSpin            = new QDoubleSpinBox(this);
+    walkWeightSpin            = new QDoubleSpinBox(this);
+    transferPenaltySpin       = new QDoubleSpinBox(this);
+    const CostWeights defaultWeights;
+    for (QDoubleSpinBox* spin : { rideWeightSpin, walkWeightSpin, transferPenaltySpin }) {
+        spin->setRange(0, 30);
+        spin->setDecimals(1);
+        spin->setSingleStep(0.5);
+    }
+    rideWeightSpin     ->setValue(defaultWeights.inVehicle);
+    walkWeightSpin     ->setValue(defaultWeights.walking);
+    transferPenaltySpin->setValue(defaultWeights.transfer / 60);
+    transferPenaltySpin->setSuffix(QString::fromUtf8(" 分"));
+    rideWeightSpin     ->setToolTip(QString::fromUtf8("乘车每分钟折合的代价"));
+    walkWeightSpin     ->setToolTip(QString::fromUtf8("换乘步行每分钟折合的代价"));
+    transferPenaltySpin->setToolTip(QString::fromUtf8("每次换乘额外折合的乘车分钟数"));
+    weightLayout  ->addWidget(new QLabel(QString::fromUtf8("乘车"), this));
+    weightLayout  ->addWidget(rideWeightSpin);
+    weightLayout  ->addWidget(new QLabel(QString::fromUtf8("步行"), this));
+    weightLayout  ->addWidget(walkWeightSpin);
+    weightLayout  ->addWidget(new QLabel(QString::fromUtf8("换乘"), this));
+    weightLayout  ->addWidget(transferPenaltySpin);
+    strategyLayout->addLayout(weightLayout);
 
     controlLayout->addWidget(strategyGroup);
 
@@ -365,6 +416,9 @@ void MainWindow::setupUI() {
     strategyButtonGroup->addButton(minTransferRadio, MIN_TRANSFER);
     strategyButtonGroup->addButton(minStationsRadio, MIN_STATIONS);
     strategyButtonGroup->addButton(minDistanceRadio, MIN_DISTANCE);
+    strategyButtonGroup->addButton(allOptionsRadio,  ALL_OPTIONS);
+    strategyButtonGroup->addButton(earliestRadio,    EARLIEST_ARRIVAL);
+    strategyButtonGroup->addButton(costRadio,        GENERALIZED_COST);
 
     // 查找按钮和清除按钮
     QHBoxLayout* buttonLayout = new QHBoxLayout();
@@ -379,6 +433,31 @@ void MainWindow::setupUI() {
     buttonLayout ->addWidget(clearButton);
     controlLayout->addLayout(buttonLayout);
 
+    // 可达范围：从起点按当前策略一次搜索全图，预算的单位随策略变化
+    QHBoxLayout* isochroneLayout = new QHBoxLayout();
+    isochroneBudgetSpin          = new QDoubleSpinBox(this);
+    isochroneBudgetSpin->setRange(0, 999);
+    isochroneBudgetSpin->setDecimals(1);
+    isochroneButton              = new QPushButton(QString::fromUtf8("显示可达范围"), this);
+
+    isochroneLayout->addWidget(new QLabel(QString::fromUtf8("范围"), this));
+    isochroneLayout->addWidget(isochroneBudgetSpin, 1);
+    isochroneLayout->addWidget(isochroneButton);
+    controlLayout  ->addLayout(isochroneLayout);
+
+    // 临时封闭：不重新加载数据，下次查找即绕开封闭处
+    QHBoxLayout* closureLayout = new QHBoxLayout();
+    closeStationButton         = new QPushButton(QString::fromUtf8("封闭/恢复起点站"), this);
+    closeSegmentButton         = new QPushButton(QString::fromUtf8("封闭/恢复区间"), this);
+    reopenAllButton            = new QPushButton(QString::fromUtf8("全部恢复"), this);
+    closeSegmentButton->setToolTip(QString::fromUtf8("起点和终点须相邻，封闭两站间的全部线路"));
+
+    closureLayout->addWidget(closeStationButton);
+    closureLayout->addWidget(closeSegmentButton);
+    closureLayout->addWidget(reopenAllButton);
+    controlLayout->addLayout(closureLayout);
+    onStrategyChanged(minStationsRadio); // 按默认策略设置预算的单位
+
     // 添加线路和站点按钮
     QHBoxLayout* addButtonLayout = new QHBoxLayout();
     addLineButton                = new QPushButton(QString::fromUtf8("添加线路"), this);
@@ -428,6 +507,10 @@ void MainWindow::setupUI() {
     connect(toComboBox,       &QComboBox::currentTextChanged,  this, &MainWindow::onToStationSelected);
     connect(findPathButton,   &QPushButton::clicked,           this, &MainWindow::onFindPathClicked);
     connect(clearButton,      &QPushButton::clicked,           this, &MainWindow::onClearClicked);
+    connect(isochroneButton,  &QPushButton::clicked,           this, &MainWindow::onIsochroneClicked);
+    connect(closeStationButton, &QPushButton::clicked,         this, &MainWindow::onCloseStationClicked);
+    connect(closeSegmentButton, &QPushButton::clicked,         this, &MainWindow::onCloseSegmentClicked);
+    connect(reopenAllButton,    &QPushButton::clicked,         this, &MainWindow::onReopenAllClicked);
     connect(addLineButton,    &QPushButton::clicked,           this, &MainWindow::onAddLineClicked);
     connect(addStationButton, &QPushButton::clicked,           this, &MainWindow::onAddStationClicked);
     connect(stationWidget,    &StationWidget::stationSelected, this, &MainWindow::onStationClicked);
@@ -447,9 +530,11 @@ void MainWindow::setupUI() {
     stationCountLabel = new QLabel(this);
     lineCountLabel    = new QLabel(this);
     mousePosLabel     = new QLabel(this); // 鼠标位置标签
+    cacheStatsLabel   = new QLabel(this);
 
     statusBar->addPermanentWidget(stationCountLabel);
     statusBar->addPermanentWidget(lineCountLabel);
+    statusBar->addPermanentWidget(cacheStatsLabel);
     statusBar->addPermanentWidget(mousePosLabel); // 添加到状态栏
     QLabel* hintLabel = new QLabel(QString::fromUtf8("提示: 右键点击地图空白处添加站点"), this);
     statusBar->addWidget(hintLabel);
@@ -466,8 +551,17 @@ void MainWindow::setupUI() {
   说    明：
   ***************************************************************************/
 void MainWindow::updateStatusBar() {
-    stationCountLabel->setText(QString::fromUtf8("站点数量: %1").arg(metroGraph.getStations().size()));
-    lineCountLabel   ->setText(QString::fromUtf8("线路数量: %1").arg(metroGraph.getLines().size()));
+    MetroGraphPtr graph = graphStore.current();
+    stationCountLabel->setText(QString::fromUtf8("站点数量: %1").arg(graph->getStationCount()));
+    lineCountLabel   ->setText(QString::fromUtf8("线路数量: %1").arg(graph->getLineCount()));
+
+    /*第一套状态栏在setupUI后半段被替换，此时缓存标签尚未创建*/
+    if (cacheStatsLabel != nullptr) {
+        const RouteCache::Stats stats = pathFinder.getRouteCache()->getStats();
+        cacheStatsLabel->setText(QString::fromUtf8("缓存命中: %1/%2 (%3%)")
+                                 .arg(stats.hits).arg(stats.hits + stats.misses)
+                                 .arg(stats.hitRate() * 100, 0, 'f', 1));
+    }
 }
 
 /***************************************************************************
@@ -475,10 +569,34 @@ void MainWindow::updateStatusBar() {
   功    能：监测查询策略的改变
   输入参数：QAbstractButton* - button 按键
   返 回 值：
-  说    明：
+  说    明："全部方案"、"最早到达"和"综合代价"按钮不对应单一策略，保留
+            上次选择的策略；
+            可达范围预算的单位和默认值随策略切换
   ***************************************************************************/
 void MainWindow::onStrategyChanged(QAbstractButton* button) {
-    selectedStrategy = static_cast<SearchStrategy>(strategyButtonGroup->id(button));
+    const int id = strategyButtonGroup->id(button);
+    showAllOptions = id == ALL_OPTIONS;
+    useTimetable   = id == EARLIEST_ARRIVAL;
+    useGeneralizedCost = id == GENERALIZED_COST;
+    if (showAllOptions || useTimetable || useGeneralizedCost) {
+        return;
+    }
+
+    selectedStrategy = static_cast<SearchStrategy>(id);
+    switch (selectedStrategy) {
+    case MIN_TRANSFER:
+        isochroneBudgetSpin->setSuffix(QString::fromUtf8(" 次换乘"));
+        isochroneBudgetSpin->setValue(1);
+        break;
+    case MIN_STATIONS:
+        isochroneBudgetSpin->setSuffix(QString::fromUtf8(" 站"));
+        isochroneBudgetSpin->setValue(10);
+        break;
+    case MIN_DISTANCE:
+        isochroneBudgetSpin->setSuffix(QString::fromUtf8(" 公里"));
+        isochroneBudgetSpin->setValue(10);
+        break;
+    }
 }
 
 /***************************************************************************
@@ -497,7 +615,7 @@ void MainWindow::loadSortedStations() {
     if (!file.open(QIODevice::ReadOnly)) {
         qWarning() << "无法打开排序后的站点文件";
         // 使用原始顺序
-        QVector<QString> stationNames = metroGraph.getStationNames();
+        QVector<QString> stationNames = graphStore.current()->getStationNames();
         for (const QString& name : stationNames) {
             fromComboBox->addItem(name);
             toComboBox  ->addItem(name);
@@ -532,44 +650,54 @@ void MainWindow::loadSortedStations() {
 void MainWindow::loadMetroData() {
     QString basePath = QCoreApplication::applicationDirPath();
     QString dataPath = basePath + "/data/";
-    if (metroGraph.loadFromJson(dataPath+"metroInfo.json")) {
-        stationWidget->setMetroGraph(metroGraph);
+    if (graphStore.load(dataPath + "metroInfo.json", dataPath + "metroInfo.mgb")) {
+        /*收缩层次索引与数据文件一同保存，出边变化后重新构建；图被编辑后在后台按新版本重新构建*/
+        MetroGraphPtr           graph     = graphStore.current();
+        ContractionHierarchyPtr hierarchy = ContractionHierarchy::load(*graph, dataPath + "metroInfo.mch");
+        if (hierarchy == nullptr) {
+            hierarchy = ContractionHierarchy::build(*graph);
+            hierarchy->save(dataPath + "metroInfo.mch");
+        }
+        pathFinder.setContractionHierarchy(hierarchy);
+
+        /*全源路径表同样与数据文件一同保存，站点过多时不构建，查找器退回在线搜索*/
+        RouteTablePtr routeTable = RouteTable::load(*graph, dataPath + "metroInfo.mrt");
+        if (routeTable == nullptr) {
+            routeTable = RouteTable::build(*graph);
+            if (routeTable != nullptr) {
+                routeTable->save(dataPath + "metroInfo.mrt");
+            }
+        }
+        pathFinder.setRouteTable(routeTable);
 
-        /*更新PathFinder中的图指针*/
-        pathFinder.setGraph(&metroGraph);
+        /*列车时刻表是可选的，缺少时"最早到达"查询给出提示*/
+        timetable = Timetable::load(*graph, dataPath + "timetable.json");
+        if (timetable != nullptr) {
+            connectionScan.reset(new ConnectionScan(timetable));
+        }
 
         connect(stationWidget, &StationWidget::mousePositionChanged,
                 this, &MainWindow::onMousePositionChanged);
 
-        /*获取所有站点名称*/
-        QVector<QString> stationNames = metroGraph.getStationNames();
-        qDebug() << "站点总数:" << stationNames.size();
+        /*起终点的自动补全共用一个名称模型，增删站点时只需修改该模型*/
+        stationNameModel = new QStringListModel(this);
 
-        /*清空下拉框*/
-        fromComboBox->clear();
-        toComboBox->clear();
-
-        /*创建自动补全模型*/
-        QStringList stationList;
-        for (const QString& name : stationNames) {
-            stationList << name;
-            fromComboBox->addItem(name);
-            toComboBox->addItem(name);
-        }
-
-        /*设置自动补全*/
-        QCompleter* fromCompleter = new QCompleter(stationList, this);
+        QCompleter* fromCompleter = new QCompleter(stationNameModel, this);
         fromCompleter->setCaseSensitivity(Qt::CaseInsensitive);
         fromCompleter->setFilterMode(Qt::MatchContains);
         fromComboBox->setCompleter(fromCompleter);
         fromComboBox->setEditable(true);
 
-        QCompleter* toCompleter = new QCompleter(stationList, this);
+        QCompleter* toCompleter = new QCompleter(stationNameModel, this);
         toCompleter->setCaseSensitivity(Qt::CaseInsensitive);
         toCompleter->setFilterMode(Qt::MatchContains);
         toComboBox->setCompleter(toCompleter);
         toComboBox->setEditable(true);
 
+        /*填充下拉框、补全模型、地铁图和状态栏*/
+        refreshUI();
+        qDebug() << "站点总数:" << graphStore.current()->getStationCount();
+
         /*连接编辑完成的信号*/
         connect(fromComboBox->lineEdit(), &QLineEdit::editingFinished, this, [this]() {
             QString text = fromComboBox->currentText();
@@ -586,7 +714,6 @@ void MainWindow::loadMetroData() {
                 selectedToStation = text;
             }
         });
-        updateStatusBar();
     }
     else {
         QMessageBox::critical(this, QString::fromUtf8("错误"), QString::fromUtf8("无法加载地铁数据文件"));
@@ -632,22 +759,168 @@ void MainWindow::onFindPathClicked() {
     }
 
     /*检查站点是否存在*/
-    if (!metroGraph.hasStation(selectedFromStation)) {
+    MetroGraphPtr graph = graphStore.current();
+    if (!graph->hasStation(selectedFromStation)) {
         QMessageBox::warning(this, QString::fromUtf8("错误"),
             QString::fromUtf8("起点站 '%1' 不存在").arg(selectedFromStation));
         return;
     }
 
-    if (!metroGraph.hasStation(selectedToStation)) {
+    if (!graph->hasStation(selectedToStation)) {
         QMessageBox::warning(this, QString::fromUtf8("错误"),
             QString::fromUtf8("终点站 '%1' 不存在").arg(selectedToStation));
         return;
     }
 
+    /*全部方案：一次多目标搜索得到互不支配的各条路径，地图上显示换乘最少的一条*/
+    if (showAllOptions) {
+        QVector<MetroPath> paths = pathFinder.findParetoPaths(selectedFromStation, selectedToStation);
+        stationWidget->setPath(paths.isEmpty() ? MetroPath() : paths.first());
+        updateOptionsGuide(paths);
+        return;
+    }
+
+    /*最早到达：在时刻表上按出发时刻扫描，行程不一定沿拓扑上的最优路径，地图上不绘制*/
+    if (useTimetable) {
+        if (connectionScan == nullptr) {
+            QMessageBox::warning(this, QString::fromUtf8("错误"), QString::fromUtf8("未找到列车时刻表"));
+            return;
+        }
+        const QTime departure = departureTimeEdit->time();
+        stationWidget->setPath(MetroPath());
+        updateJourneyGuide(connectionScan->earliestArrival(graph->getStationId(selectedFromStation),
+                                                           graph->getStationId(selectedToStation),
+                                                           departure.hour() * 3600 + departure.minute() * 60));
+        return;
+    }
+
+    /*综合代价：按界面上的权重查找，权重只影响本次查询*/
+    if (useGeneralizedCost) {
+        if (pathFinder.getCostModel() == nullptr) {
+            QMessageBox::warning(this, QString::fromUtf8("错误"), QString::fromUtf8("未找到列车时刻表，无法估算乘车和步行时间"));
+            return;
+        }
+        CostWeights weights;
+        weights.inVehicle = rideWeightSpin->value();
+        weights.walking   = walkWeightSpin->value();
+        weights.transfer  = transferPenaltySpin->value() * 60;
+        pathFinder.setCostWeights(weights);
+
+        CostBreakdown breakdown;
+        MetroPath     path = pathFinder.findMinCostPath(selectedFromStation, selectedToStation, &breakdown);
+        stationWidget->setPath(path);
+        updateCostGuide(path, breakdown);
+        return;
+    }
+
     MetroPath path = pathFinder.findPath(selectedFromStation, selectedToStation, selectedStrategy);
     stationWidget->setPath(path);
     updatePathGuide(path);
+    updateStatusBar();
+}
+/***************************************************************************
+  函数名称：MainWindow::onIsochroneClicked
+  功    能：显示从起点出发的可达范围
+  输入参数：
+  返 回 值：
+  说    明：按当前策略一次搜索全图，预算内的站点在地图上按代价分级着色，
+            不需要选择终点
+  ***************************************************************************/
+void MainWindow::onIsochroneClicked() {
+    if (selectedFromStation.isEmpty()) {
+        QMessageBox::warning(this, QString::fromUtf8("警告"), QString::fromUtf8("请选择起点站"));
+        return;
+    }
+
+    MetroGraphPtr graph = graphStore.current();
+    if (!graph->hasStation(selectedFromStation)) {
+        QMessageBox::warning(this, QString::fromUtf8("错误"),
+            QString::fromUtf8("起点站 '%1' 不存在").arg(selectedFromStation));
+        return;
+    }
+
+    const double budget    = isochroneBudgetSpin->value();
+    Isochrone    isochrone = pathFinder.computeIsochrone(selectedFromStation, selectedStrategy);
+    stationWidget->setIsochrone(isochrone, budget);
+    updateIsochroneGuide(isochrone, budget);
+}
+
+/***************************************************************************
+  函数名称：MainWindow::onCloseStationClicked
+  功    能：封闭或恢复起点站
+  输入参数：
+  返 回 值：
+  说    明：起点站未封闭时封闭，已封闭时恢复
+  ***************************************************************************/
+void MainWindow::onCloseStationClicked() {
+    MetroGraphPtr   graph   = graphStore.current();
+    const StationId station = graph->getStationId(selectedFromStation);
+    if (station == INVALID_ID) {
+        QMessageBox::warning(this, QString::fromUtf8("警告"), QString::fromUtf8("请选择起点站"));
+        return;
+    }
+
+    if (graphStore.setStationClosed(station, true)) {
+        showClosureChange(QString::fromUtf8("已封闭 %1 站").arg(selectedFromStation));
+    }
+    else if (graphStore.setStationClosed(station, false)) {
+        showClosureChange(QString::fromUtf8("已恢复 %1 站").arg(selectedFromStation));
+    }
 }
+
+/***************************************************************************
+  函数名称：MainWindow::onCloseSegmentClicked
+  功    能：封闭或恢复起终点之间的区间
+  输入参数：
+  返 回 值：
+  说    明：起点和终点须相邻，两站间有多条线路时一并封闭；区间未封闭时
+            封闭，已封闭时恢复
+  ***************************************************************************/
+void MainWindow::onCloseSegmentClicked() {
+    MetroGraphPtr   graph = graphStore.current();
+    const StationId from  = graph->getStationId(selectedFromStation);
+    const StationId to    = graph->getStationId(selectedToStation);
+    if (from == INVALID_ID || to == INVALID_ID || graph->findConnection(from, to) == nullptr) {
+        QMessageBox::warning(this, QString::fromUtf8("警告"), QString::fromUtf8("请选择相邻的起点和终点站"));
+        return;
+    }
+
+    const QString segment = QString::fromUtf8("%1—%2").arg(selectedFromStation).arg(selectedToStation);
+    if (graphStore.setSegmentClosed(from, to, INVALID_ID, true)) {
+        showClosureChange(QString::fromUtf8("已封闭 %1 区间").arg(segment));
+    }
+    else if (graphStore.setSegmentClosed(from, to, INVALID_ID, false)) {
+        showClosureChange(QString::fromUtf8("已恢复 %1 区间").arg(segment));
+    }
+}
+
+/***************************************************************************
+  函数名称：MainWindow::onReopenAllClicked
+  功    能：恢复全部封闭
+  输入参数：
+  返 回 值：
+  说    明：
+  ***************************************************************************/
+void MainWindow::onReopenAllClicked() {
+    graphStore.clearClosures();
+    showClosureChange(QString::fromUtf8("已恢复全部封闭"));
+}
+
+/***************************************************************************
+  函数名称：MainWindow::showClosureChange
+  功    能：封闭变化后刷新地图并提示
+  输入参数：const QString& message - 提示信息
+  返 回 值：
+  说    明：封闭不发布新版本，地图只需重绘；之前显示的路径可能经过封闭处，
+            一并清除
+  ***************************************************************************/
+void MainWindow::showClosureChange(const QString& message) {
+    stationWidget->setPath(MetroPath());
+    stationWidget->clearIsochrone();
+    pathGuideText->setPlainText(message + QString::fromUtf8("，重新查找即可绕开封闭处"));
+    updateStatusBar();
+}
+
 /***************************************************************************
   函数名称：MainWindow::onStationClicked
   功    能：设置起点或终点站
@@ -712,6 +985,157 @@ void MainWindow::updatePathGuide(const MetroPath& path) {
             break;
     }
 
+    guide += formatSegments(path);
+    guide += QString::fromUtf8("到达终点站: %1").arg(selectedToStation);
+    pathGuideText->setPlainText(guide);
+    playArrivalSound();
+}
+
+/***************************************************************************
+  函数名称：MainWindow::updateCostGuide
+  功    能：描述广义代价最小的路径及代价分解
+  输入参数：const MetroPath& path           - 路径方案
+            const CostBreakdown& breakdown - 代价分解
+  返 回 值：
+  说    明：乘车时间含途经各站的停站时间，均按时刻表的运营参数估算
+  ***************************************************************************/
+void MainWindow::updateCostGuide(const MetroPath& path, const CostBreakdown& breakdown) {
+    if (path.segments.isEmpty() || breakdown.total < 0) {
+        pathGuideText->setPlainText(QString::fromUtf8("无法找到路径"));
+        return;
+    }
+
+    QString guide = QString::fromUtf8("从 %1 到 %2 的换乘指南（综合代价最少）:\n\n")
+        .arg(selectedFromStation)
+        .arg(selectedToStation);
+    guide += QString::fromUtf8("共经过 %1 站, 换乘 %2 次, 总距离 %3 公里\n")
+        .arg(path.stationCount)
+        .arg(breakdown.transfers)
+        .arg(QString::number(path.totalDistance, 'f', 2));
+    guide += QString::fromUtf8("乘车约 %1 分钟, 换乘步行约 %2 分钟, 综合代价 %3 分\n\n")
+        .arg(QString::number(breakdown.inVehicle / 60, 'f', 1))
+        .arg(QString::number(breakdown.walking / 60, 'f', 1))
+        .arg(QString::number(breakdown.total / 60, 'f', 1));
+
+    guide += formatSegments(path);
+    guide += QString::fromUtf8("到达终点站: %1").arg(selectedToStation);
+    pathGuideText->setPlainText(guide);
+    playArrivalSound();
+}
+
+/***************************************************************************
+  函数名称：MainWindow::updateOptionsGuide
+  功    能：列出互不支配的全部方案
+  输入参数：const QVector<MetroPath>& paths - 按换乘次数、站点数、距离排序的方案
+  返 回 值：
+  说    明：每个方案在换乘次数、经过站点数和总距离中至少有一项优于其他方案
+  ***************************************************************************/
+void MainWindow::updateOptionsGuide(const QVector<MetroPath>& paths) {
+    if (paths.isEmpty()) {
+        pathGuideText->setPlainText(QString::fromUtf8("无法找到路径"));
+        return;
+    }
+
+    QString guide = QString::fromUtf8("从 %1 到 %2 共有 %3 种方案:\n\n")
+        .arg(selectedFromStation)
+        .arg(selectedToStation)
+        .arg(paths.size());
+
+    for (int i = 0; i < paths.size(); i++) {
+        const MetroPath& path = paths[i];
+        guide += QString::fromUtf8("方案 %1: 共经过 %2 站, 换乘 %3 次, 总距离 %4 公里\n\n")
+            .arg(i + 1)
+            .arg(path.stationCount)
+            .arg(path.transferCount)
+            .arg(QString::number(path.totalDistance, 'f', 2));
+        guide += formatSegments(path);
+    }
+
+    guide += QString::fromUtf8("到达终点站: %1").arg(selectedToStation);
+    pathGuideText->setPlainText(guide);
+    playArrivalSound();
+}
+
+/***************************************************************************
+  函数名称：MainWindow::updateJourneyGuide
+  功    能：按时刻表描述最早到达的行程
+  输入参数：const TimetableJourney& journey - 最早到达查询的结果
+  返 回 值：
+  说    明：
+  ***************************************************************************/
+void MainWindow::updateJourneyGuide(const TimetableJourney& journey) {
+    if (journey.legs.isEmpty()) {
+        pathGuideText->setPlainText(QString::fromUtf8("%1 出发当日无法到达").arg(Timetable::formatTime(journey.departure)));
+        return;
+    }
+
+    MetroGraphPtr graph = graphStore.current();
+    QString guide = QString::fromUtf8("%1 从 %2 出发, 最早 %3 到达 %4, 用时 %5 分钟, 换乘 %6 次\n\n")
+        .arg(Timetable::formatTime(journey.departure))
+        .arg(selectedFromStation)
+        .arg(Timetable::formatTime(journey.arrival))
+        .arg(selectedToStation)
+        .arg((journey.arrival - journey.departure + 59) / 60)
+        .arg(journey.legs.size() - 1);
+
+    for (const TimetableLeg& leg : journey.legs) {
+        guide += QString::fromUtf8("%1 在 %2 站乘坐 %3, %4 到达 %5 站\n")
+            .arg(Timetable::formatTime(leg.departure))
+            .arg(graph->getStationName(leg.stations.first()))
+            .arg(graph->getLineName(leg.line))
+            .arg(Timetable::formatTime(leg.arrival))
+            .arg(graph->getStationName(leg.stations.last()));
+        guide += QString::fromUtf8("经过: ");
+        for (int j = 0; j < leg.stations.size(); j++) {
+            if (j > 0) guide += QString::fromUtf8(" → ");
+            guide += graph->getStationName(leg.stations[j]);
+        }
+        guide += QString::fromUtf8("\n\n");
+    }
+
+    guide += QString::fromUtf8("到达终点站: %1").arg(selectedToStation);
+    pathGuideText->setPlainText(guide);
+    playArrivalSound();
+}
+
+/***************************************************************************
+  函数名称：MainWindow::updateIsochroneGuide
+  功    能：列出可达范围内的站点
+  输入参数：const Isochrone& isochrone - 从起点到各站的结果
+            double budget              - 预算
+  返 回 值：
+  说    明：按代价由近及远列出，每站附带里程、站点数和换乘次数
+  ***************************************************************************/
+void MainWindow::updateIsochroneGuide(const Isochrone& isochrone, double budget) {
+    MetroGraphPtr            graph    = graphStore.current();
+    const QVector<StationId> stations = isochrone.reachableWithin(budget);
+    QString guide = QString::fromUtf8("从 %1 出发, %2内可达 %3 个站点\n\n")
+        .arg(selectedFromStation)
+        .arg(isochroneBudgetSpin->text())
+        .arg(stations.size() - 1);
+
+    for (StationId station : stations) {
+        if (station == isochrone.origin) {
+            continue;
+        }
+        guide += QString::fromUtf8("%1: %2 公里, %3 站, 换乘 %4 次\n")
+            .arg(graph->getStationName(station))
+            .arg(QString::number(isochrone.distances[station], 'f', 2))
+            .arg(isochrone.stationCounts[station])
+            .arg(isochrone.transfers[station]);
+    }
+    pathGuideText->setPlainText(guide);
+}
+
+/***************************************************************************
+  函数名称：MainWindow::formatSegments
+  功    能：逐段描述乘车和换乘
+  输入参数：const MetroPath& path - 路径方案
+  返 回 值：QString - 各段的上车站、线路和途经站点
+  说    明：
+  ***************************************************************************/
+QString MainWindow::formatSegments(const MetroPath& path) const {
+    QString guide;
     for (int i = 0; i < path.segments.size(); i++) {
         const PathSegment& segment = path.segments[i];
 
@@ -734,9 +1158,7 @@ void MainWindow::updatePathGuide(const MetroPath& path) {
         guide += QString::fromUtf8("\n\n");
     }
 
-    guide += QString::fromUtf8("到达终点站: %1").arg(selectedToStation);
-    pathGuideText->setPlainText(guide);
-    playArrivalSound();
+    return guide;
 }
 /***************************************************************************
   函数名称：MainWindow::ClearClicked
@@ -753,9 +1175,10 @@ void MainWindow::onClearClicked() {
     /*清除路径指南*/
     pathGuideText->clear();
 
-    /*清除地图上的高亮*/
+    /*清除地图上的高亮和可达范围*/
     MetroPath emptyPath;
     stationWidget->setPath(emptyPath);
+    stationWidget->clearIsochrone();
 
     /*重置选择的站点*/
     selectedFromStation = "";
@@ -764,57 +1187,159 @@ void MainWindow::onClearClicked() {
 
 /***************************************************************************
   函数名称：MainWindow::refreshUI
-  功    能：更新UI显示
+  功    能：按当前版本整体刷新UI
   输入参数：
   返 回 值：
-  说    明：添加了中文拼音排序功能
+  说    明：站点按拼音顺序排列，顺序由地铁图维护的排序索引给出
   ***************************************************************************/
 void MainWindow::refreshUI() {
-    /*更新下拉框*/
+    MetroGraphPtr graph = graphStore.current();
+
+    /*按拼音顺序填充下拉框和自动补全模型*/
+    QStringList stationList;
+    for (StationId id : graph->getSortedStationIds()) {
+        stationList << graph->getStationName(id);
+    }
+
     fromComboBox->clear();
     toComboBox->clear();
+    fromComboBox->addItems(stationList);
+    toComboBox->addItems(stationList);
+    if (stationNameModel) {
+        stationNameModel->setStringList(stationList);
+    }
 
-    /*获取所有站点名称并按拼音排序*/
-    QVector<QString> stationNames = metroGraph.getStationNames();
+    /*更新地铁图*/
+    stationWidget->setMetroGraph(graph);
 
-    /*使用QCollator进行中文拼音排序*/
-    QCollator collator;
-    collator.setNumericMode(false);
-    std::sort(stationNames.begin(), stationNames.end(), [&collator](const QString& a, const QString& b) {
-        return collator.compare(a, b) < 0;
-    });
+    /*更新路径查找器*/
+    pathFinder.setGraph(graph);
+    updateHierarchy(graph);
+    updateRouteTable(graph);
+    updateCostModel(graph);
 
-    /*添加站点到下拉框*/
-    for (const QString& name : stationNames) {
-        fromComboBox->addItem(name);
-        toComboBox->addItem(name);
+    /*更新状态栏*/
+    updateStatusBar();
+    shownGraphVersion = graph->getVersion();
+}
+
+/***************************************************************************
+  函数名称：MainWindow::onGraphChanged
+  功    能：按新版本的变更增量刷新UI
+  输入参数：const MetroGraphPtr& graph - 新发布的版本
+  返 回 值：
+  说    明：新站点按排序位置插入下拉框和补全模型；版本不连续或没有
+            变更列表（如重新加载）时整体刷新。收缩层次、全源路径表和广义
+            代价模型不做增量修补，每次编辑后都按全图重新构建，前两者在
+            后台构建，不阻塞界面
+  ***************************************************************************/
+void MainWindow::onGraphChanged(const MetroGraphPtr& graph) {
+    if (graph->getVersion() != shownGraphVersion + 1 || graph->getChanges().isEmpty()) {
+        refreshUI();
+        return;
     }
 
-    /*更新自动补全*/
-    QStringList stationList;
-    for (const QString& name : stationNames) {
-        stationList << name;
+    /*按新版本中的最终位置从前往后插入，先插入的不会影响后插入的位置*/
+    QVector<int> rows;
+    for (const MetroChange& change : graph->getChanges()) {
+        if (change.type == MetroChange::StationAdded) {
+            rows.append(graph->getSortedIndex(change.station1));
+        }
+    }
+    std::sort(rows.begin(), rows.end());
+
+    const QVector<StationId>& sortedIds = graph->getSortedStationIds();
+    for (int row : rows) {
+        const QString& name = graph->getStationName(sortedIds[row]);
+        fromComboBox->insertItem(row, name);
+        toComboBox->insertItem(row, name);
+        if (stationNameModel) {
+            stationNameModel->insertRows(row, 1);
+            stationNameModel->setData(stationNameModel->index(row), name);
+        }
     }
 
-    QCompleter* fromCompleter = new QCompleter(stationList, this);
-    fromCompleter->setCaseSensitivity(Qt::CaseInsensitive);
-    fromCompleter->setFilterMode(Qt::MatchContains);
-    fromComboBox->setCompleter(fromCompleter);
+    stationWidget->setMetroGraph(graph);
+    pathFinder.setGraph(graph);
+    updateHierarchy(graph);
+    updateRouteTable(graph);
+    updateCostModel(graph);
+    updateStatusBar();
+    shownGraphVersion = graph->getVersion();
+}
 
-    QCompleter* toCompleter = new QCompleter(stationList, this);
-    toCompleter->setCaseSensitivity(Qt::CaseInsensitive);
-    toCompleter->setFilterMode(Qt::MatchContains);
-    toComboBox->setCompleter(toCompleter);
+/***************************************************************************
+  函数名称：MainWindow::updateHierarchy
+  功    能：图被编辑后在后台重新构建收缩层次
+  输入参数：const MetroGraphPtr& graph - 当前版本
+  返 回 值：
+  说    明：构建期间最短距离查询退回设置的搜索算法；任务开始时已有更新的
+            版本则跳过，完成后回到界面线程，仍对应当前版本才交给查找器。
+            编辑后的索引只保存在内存中，与全源路径表相同
+  ***************************************************************************/
+void MainWindow::updateHierarchy(const MetroGraphPtr& graph) {
+    ContractionHierarchyPtr hierarchy = pathFinder.getContractionHierarchy();
+    if (hierarchy != nullptr && hierarchy->matches(*graph)) {
+        return;
+    }
 
-    /*更新地铁图*/
-    stationWidget->setMetroGraph(metroGraph);
+    indexPool.start([this, graph]() {
+        if (graphStore.version() != graph->getVersion()) {
+            return;
+        }
+        ContractionHierarchyPtr built = ContractionHierarchy::build(*graph);
+        QMetaObject::invokeMethod(this, [this, built]() {
+            if (built->matches(*graphStore.current())) {
+                pathFinder.setContractionHierarchy(built);
+            }
+        }, Qt::QueuedConnection);
+    });
+}
 
-    /*更新路径查找器*/
-    pathFinder.setGraph(&metroGraph);
+/***************************************************************************
+  函数名称：MainWindow::updateRouteTable
+  功    能：图被编辑后在后台重新构建全源路径表
+  输入参数：const MetroGraphPtr& graph - 当前版本
+  返 回 值：
+  说    明：旧表按版本号失效，构建期间查找器退回在线搜索；与收缩层次相同，
+            已被取代的版本不再构建，完成后仍对应当前版本才交给查找器。
+            编辑后的表只保存在内存中，磁盘上的表仍对应数据文件，数据文件
+            改变后下次启动时按哈希重新构建
+  ***************************************************************************/
+void MainWindow::updateRouteTable(const MetroGraphPtr& graph) {
+    RouteTablePtr routeTable = pathFinder.getRouteTable();
+    if (routeTable == nullptr || routeTable->matches(*graph)) {
+        return;
+    }
 
-    /*更新状态栏*/
-    updateStatusBar();
+    indexPool.start([this, graph]() {
+        if (graphStore.version() != graph->getVersion()) {
+            return;
+        }
+        RouteTablePtr built = RouteTable::build(*graph);
+        QMetaObject::invokeMethod(this, [this, graph, built]() {
+            if (graphStore.version() == graph->getVersion()) {
+                pathFinder.setRouteTable(built);
+            }
+        }, Qt::QueuedConnection);
+    });
 }
+
+/***************************************************************************
+  函数名称：MainWindow::updateCostModel
+  功    能：按当前版本构建广义代价模型
+  输入参数：const MetroGraphPtr& graph - 当前版本
+  返 回 值：
+  说    明：没有时刻表时不构建；旧模型按版本号失效，新增的站点和线路按
+            时刻表的默认参数估算
+  ***************************************************************************/
+void MainWindow::updateCostModel(const MetroGraphPtr& graph) {
+    CostModelPtr model = pathFinder.getCostModel();
+    if (timetable != nullptr && (model == nullptr || !model->matches(*graph))) {
+        pathFinder.setCostModel(CostModel::build(*graph, *timetable));
+    }
+}
+
 /***************************************************************************
   函数名称：MainWindow::onAddLineClicked
   功    能：处理点击添加路线按钮事件
@@ -823,7 +1348,8 @@ void MainWindow::refreshUI() {
   说    明：能够处理存在转折连接点的站点之间的连接
   ***************************************************************************/
 void MainWindow::onAddLineClicked() {
-    AddLineDialog dialog(metroGraph, this);
+    MetroGraphPtr graph = graphStore.current(); // 对话框打开期间固定当前版本
+    AddLineDialog dialog(*graph, this);
     if (dialog.exec() == QDialog::Accepted) {
         /*获取线路信息*/
         MetroLine line = dialog.getLine();
@@ -831,12 +1357,17 @@ void MainWindow::onAddLineClicked() {
         /*获取站点和连接信息*/
         QVector<QPair<QString, QVector<QPoint>>> stationsAndConnections = dialog.getStationsAndConnections();
 
-        /*添加线路*/
-        if (metroGraph.addLine(line)) {
-            /*添加连接*/
-            QVector<QString> selectedStations;
-            for (int i = 0; i < dialog.selectedStationsList->count(); i++) {
-                selectedStations.append(dialog.selectedStationsList->item(i)->text());
+        /*添加连接*/
+        QVector<QString> selectedStations;
+        for (int i = 0; i < dialog.selectedStationsList->count(); i++) {
+            selectedStations.append(dialog.selectedStationsList->item(i)->text());
+        }
+
+        /*线路和全部连接在同一个新版本中添加，读者不会看到只加了一半的线路*/
+        QVector<QPair<QString, QString>> failedConnections;
+        bool added = graphStore.edit([&](MetroGraph& next) {
+            if (!next.addLine(line)) {
+                return false;
             }
 
             for (int i = 0; i < selectedStations.size() - 1; i++) {
@@ -859,14 +1390,18 @@ void MainWindow::onAddLineClicked() {
                     }
                 }
 
-                if (!metroGraph.addConnection(from, to, line.name, viaPoints)) {
-                    QMessageBox::warning(this, QString::fromUtf8("警告"),
-                        QString::fromUtf8("无法添加连接: %1 -> %2").arg(from).arg(to));
+                if (!next.addConnection(from, to, line.name, viaPoints)) {
+                    failedConnections.append(qMakePair(from, to));
                 }
             }
+            return true;
+        });
 
-            /* 刷新UI*/
-            refreshUI();
+        if (added) {
+            for (const QPair<QString, QString>& failed : failedConnections) {
+                QMessageBox::warning(this, QString::fromUtf8("警告"),
+                    QString::fromUtf8("无法添加连接: %1 -> %2").arg(failed.first).arg(failed.second));
+            }
 
             QMessageBox::information(this, QString::fromUtf8("成功"),
                 QString::fromUtf8("已添加线路: %1").arg(line.name));
@@ -911,10 +1446,7 @@ void MainWindow::onAddStationClicked() {
         station.type          = type;
 
         /* 添加站点*/
-        if (metroGraph.addStation(station)) {
-            /* 刷新UI*/
-            refreshUI();
-
+        if (graphStore.edit([&station](MetroGraph& next) { return next.addStation(station); })) {
             QMessageBox::information(this, QString::fromUtf8("成功"),
                 QString::fromUtf8("已添加站点: %1").arg(name));
         }
@@ -1045,10 +1577,7 @@ void MainWindow::onAddStationAtPosition(const QPoint& position) {
         station.type          = typeCombo->currentData().toString();
 
         /* 添加站点*/
-        if (metroGraph.addStation(station)) {
-            /* 刷新UI*/
-            refreshUI();
-
+        if (graphStore.edit([&station](MetroGraph& next) { return next.addStation(station); })) {
             QMessageBox::information(this, QString::fromUtf8("成功"),
                 QString::fromUtf8("已添加站点: %1").arg(station.name));
         }
@@ -1081,7 +1610,8 @@ void MainWindow::keyPressEvent(QKeyEvent* event) {
   说    明：
   ***************************************************************************/
 void MainWindow::onSelectStartByLine() {
-    LineStationDialog dialog(metroGraph, this);
+    MetroGraphPtr graph = graphStore.current();
+    LineStationDialog dialog(*graph, this);
     if (dialog.exec() == QDialog::Accepted) {
         QString station = dialog.getSelectedStation();
         fromComboBox->setCurrentText(station);
@@ -1096,7 +1626,8 @@ void MainWindow::onSelectStartByLine() {
   说    明：
   ***************************************************************************/
 void MainWindow::onSelectEndByLine() {
-    LineStationDialog dialog(metroGraph, this);
+    MetroGraphPtr graph = graphStore.current();
+    LineStationDialog dialog(*graph, this);
     if (dialog.exec() == QDialog::Accepted) {
         QString station = dialog.getSelectedStation();
         toComboBox->setCurrentText(station);
@@ -16,12 +16,19 @@
 #include <QLineEdit>
 #include <QStatusBar>
 #include <QLabel>
+#include <QStringListModel>
 #include <QSplitter>
 #include <QScrollArea>
+#include <QThreadPool>
 #include "StationWidget.h"
 #include "MetroGraph.h"
+#include "MetroGraphStore.h"
 #include "PathFinder.h"
+#include "ConnectionScan.h"
 #include <QKeyEvent>
+#include <QTimeEdit>
+#include <QDoubleSpinBox>
+#include <memory>
 #include "LineStationDialog.h"
 
 #include <QMediaPlayer>
@@ -40,6 +47,10 @@ private slots:
     void onFromStationSelected(const QString& station);  //选择起点站
     void onToStationSelected(const QString& station);    //选择终点站
     void onFindPathClicked();                            //点击查找路线
+    void onIsochroneClicked();                           //点击显示可达范围
+    void onCloseStationClicked();                        //封闭或恢复起点站
+    void onCloseSegmentClicked();                        //封闭或恢复起终点间的区间
+    void onReopenAllClicked();                           //恢复全部封闭
 	void onStationClicked(const QString& station);       //点击站点
     void onStrategyChanged(QAbstractButton* button);     //改变查找策略
     void onClearClicked();                               //点击清除
@@ -60,13 +71,30 @@ private:
     void loadMetroData();                        //加载站点数据
     void loadSortedStations();                   //加载按拼音排序的站点数据
     void updatePathGuide(const MetroPath& path); //更新换乘攻略
-    void refreshUI();                            //刷新UI
+    void updateOptionsGuide(const QVector<MetroPath>& paths); //列出互不支配的全部方案
+    QString formatSegments(const MetroPath& path) const;      //逐段描述乘车和换乘
+    void updateJourneyGuide(const TimetableJourney& journey); //按时刻表描述最早到达的行程
+    void updateCostGuide(const MetroPath& path, const CostBreakdown& breakdown); //描述广义代价最小的路径及代价分解
+    void updateIsochroneGuide(const Isochrone& isochrone, double budget); //列出可达范围内的站点
+    void refreshUI();                            //按当前版本整体刷新UI
+    void onGraphChanged(const MetroGraphPtr& graph); //按新版本的变更增量刷新UI
     void updateStatusBar();                      //更新状态条
+    void showClosureChange(const QString& message); //封闭变化后刷新地图并提示
+    void updateHierarchy(const MetroGraphPtr& graph);  //图被编辑后在后台重新构建收缩层次
+    void updateRouteTable(const MetroGraphPtr& graph); //图被编辑后在后台重新构建全源路径表
+    void updateCostModel(const MetroGraphPtr& graph);  //按当前版本构建广义代价模型
 
     /*数据处理*/
-    MetroGraph     metroGraph;           //全局地铁线路数据
+    MetroGraphStore graphStore;          //全局地铁线路数据（按版本发布）
     PathFinder     pathFinder;           //路径查找类
     SearchStrategy selectedStrategy;     //路径搜索策略
+    bool           showAllOptions;       //是否列出全部方案而不是按单一策略查找
+    bool           useTimetable;         //是否按时刻表查询最早到达
+    bool           useGeneralizedCost;   //是否按广义代价查找
+    TimetablePtr   timetable;            //列车时刻表，数据文件不存在时为空
+    std::unique_ptr<ConnectionScan> connectionScan; //时刻表上的最早到达查询
+    quint64        shownGraphVersion;    //界面当前显示的地铁图版本
+    QThreadPool    indexPool;            //在后台构建查询索引，析构时等待任务结束，须在graphStore之后声明
 
     /* UI组件*/
 	QSplitter*     mainSplitter;       //主分割器
@@ -75,15 +103,29 @@ private:
     QWidget*       controlPanel;       //控制面板
 	QComboBox*     fromComboBox;       //起点选择框
     QComboBox*     toComboBox;         //终点选择框
+    QStringListModel* stationNameModel; //起终点自动补全共用的站点名称模型
     QPushButton*   findPathButton;     //查找按键
 	QPushButton*   clearButton;        //清除按键
+    QPushButton*   isochroneButton;    //可达范围按键
+    QDoubleSpinBox* isochroneBudgetSpin; //可达范围的预算，单位随策略变化
+    QPushButton*   closeStationButton; //封闭车站按键
+    QPushButton*   closeSegmentButton; //封闭区间按键
+    QPushButton*   reopenAllButton;    //全部恢复按键
     QPushButton*   addLineButton;      //添加路线按键
     QPushButton*   addStationButton;   //添加站点按键
     QTextEdit*     pathGuideText;      //换乘策略文本框
     QButtonGroup*  strategyButtonGroup;//策略选择栏
+    static const int ALL_OPTIONS = MIN_DISTANCE + 1; //策略选择栏中"全部方案"按钮的编号
+    static const int EARLIEST_ARRIVAL = ALL_OPTIONS + 1; //策略选择栏中"最早到达"按钮的编号
+    static const int GENERALIZED_COST = EARLIEST_ARRIVAL + 1; //策略选择栏中"综合代价"按钮的编号
+    QTimeEdit*     departureTimeEdit;  //最早到达查询的出发时刻
+    QDoubleSpinBox* rideWeightSpin;    //广义代价中乘车时间的权重
+    QDoubleSpinBox* walkWeightSpin;    //广义代价中换乘步行时间的权重
+    QDoubleSpinBox* transferPenaltySpin; //广义代价中每次换乘的惩罚（分钟）
     QStatusBar*    statusBar;          //状态栏
     QLabel*        stationCountLabel;  //站点名称标签
     QLabel*        lineCountLabel;     //路线名称标签
+    QLabel*        cacheStatsLabel;    //路径缓存命中率标签
 
     QString selectedFromStation;//起点站名称
     QString selectedToStation;  //终点站名称
@@ -5,12 +5,19 @@
 ***************************************************************************/
 
 #include "MetroGraph.h"
+#include "MetroSnapshot.h"
+#include "JsonStreamReader.h"
 #include <QFile>
-#include <QJsonDocument>
-#include <QJsonArray>
-#include <QJsonObject>
 #include <QDebug>
+#include <QCryptographicHash>
+#include <QElapsedTimer>
+#include <QCollator>
 #include <QPair>
+#include <algorithm>
+#include <functional>
+#include <vector>
+#include <cmath>
+#include <QtMath>
 /***************************************************************************
   函数名称：MetroGraph::MetroGraph
   功    能：构造函数，初始化地铁图数据
@@ -18,7 +25,37 @@
   返 回 值：
   说    明：初始化空的地铁图数据结构
 ***************************************************************************/
-MetroGraph::MetroGraph() {
+MetroGraph::MetroGraph() : version(0) {
+}
+
+/***************************************************************************
+  函数名称：MetroGraph::MetroGraph
+  功    能：复制构造函数
+  输入参数：const MetroGraph& other - 被复制的版本，可能已经发布
+  返 回 值：
+  说    明：MetroGraphStore::edit在已发布版本的副本上修改，复制期间读者线程
+            可能正通过getLineTopology、getLandmarks首次写入缓存，封闭位图也
+            可能被原子地替换，因此这三项用atomic_load读取，不能与其他成员
+            一样按值复制；副本被修改时缓存照常清空
+***************************************************************************/
+MetroGraph::MetroGraph(const MetroGraph& other)
+    : lines(other.lines),
+      stations(other.stations),
+      connections(other.connections),
+      stationIds(other.stationIds),
+      lineIds(other.lineIds),
+      connectionMap(other.connectionMap),
+      adjacency(other.adjacency),
+      csr(other.csr),
+      version(other.version),
+      changes(other.changes),
+      lineStationIndex(other.lineStationIndex),
+      transferFlags(other.transferFlags),
+      spatialGrid(other.spatialGrid),
+      sortedStationIds(other.sortedStationIds),
+      lineTopology(std::atomic_load(&other.lineTopology)),
+      landmarkTable(std::atomic_load(&other.landmarkTable)),
+      closureMask(std::atomic_load(&other.closureMask)) {
 }
 
 /***************************************************************************
@@ -33,246 +70,634 @@ MetroGraph::~MetroGraph() {
     lines.clear();
     stations.clear();
     connections.clear();
-    stationMap.clear();
+    stationIds.clear();
+    lineIds.clear();
     connectionMap.clear();
+    adjacency.clear();
+    csr = MetroCsr();
+    changes.clear();
+    lineStationIndex.clear();
+    transferFlags.clear();
+    spatialGrid.clear();
+    sortedStationIds.clear();
+    lineTopology.reset();
+    landmarkTable.reset();
+    closureMask.reset();
+}
+
+/*流式加载过程中的临时状态*/
+struct MetroGraph::JsonLoadState {
+    /*读取到的一条出边，终点可能尚未出现*/
+    struct PendingEdge {
+        StationId from;      //起点编号
+        StationId to;        //终点编号，终点尚未出现时为INVALID_ID
+        int       forward;   //终点尚未出现时在forwardNames中的下标
+        LineId    line;      //线路编号
+        int       viaOffset; //首个拐点在viaPoints中的下标
+        int       viaCount;  //拐点数量
+    };
+
+    QVector<bool>        lineDefined;  //线路是否已在lines数组中出现
+    QVector<PendingEdge> edges;        //按文件顺序排列的出边
+    QVector<QPoint>      viaPoints;    //全部出边的拐点
+    QVector<QString>     forwardNames; //在定义之前被引用的站点名称
+    QHash<QString, int>  forwardIndex; //前向引用名称到下标的映射
+};
+
+namespace {
+
+/***************************************************************************
+  函数名称：readStringValue
+  功    能：读取键之后的字符串值
+  输入参数：JsonStreamReader& reader - 读取器，当前记号为键
+            QString& value           - 读取结果
+  返 回 值：bool - 是否读取成功，值不是字符串时跳过该值并返回true
+  说    明：
+***************************************************************************/
+bool readStringValue(JsonStreamReader& reader, QString& value) {
+    JsonStreamReader::TokenType type = reader.readNext();
+    if (type == JsonStreamReader::String) {
+        value = reader.stringValue();
+        return true;
+    }
+    return reader.skipValue();
+}
+
+/***************************************************************************
+  函数名称：readPair
+  功    能：读取形如[x, y]的二元数值数组
+  输入参数：JsonStreamReader& reader - 读取器，当前记号为数组开始
+            double& x, double& y     - 读取结果
+            bool& valid              - 数组是否恰好包含两个数值
+  返 回 值：bool - 是否读取成功
+  说    明：y在元素不足两个时保持原值
+***************************************************************************/
+bool readPair(JsonStreamReader& reader, double& x, double& y, bool& valid) {
+    int count = 0;
+    valid = true;
+    for (;;) {
+        JsonStreamReader::TokenType type = reader.readNext();
+        if (type == JsonStreamReader::EndArray) {
+            break;
+        }
+        if (type == JsonStreamReader::Number) {
+            if (count == 0) x = reader.numberValue();
+            if (count == 1) y = reader.numberValue();
+        }
+        else {
+            valid = false;
+            if (!reader.skipValue()) return false;
+        }
+        count++;
+    }
+    valid = valid && count == 2;
+    return true;
+}
+
+/***************************************************************************
+  函数名称：toJsonInt
+  功    能：将数值按QJsonValue::toInt的规则转为整数
+  输入参数：double value - 数值
+  返 回 值：int - 整数，非整数时为0
+  说    明：
+***************************************************************************/
+int toJsonInt(double value) {
+    if (value < -2147483648.0 || value > 2147483647.0 || value != static_cast<double>(static_cast<int>(value))) {
+        return 0;
+    }
+    return static_cast<int>(value);
 }
 
+} // namespace
+
 /***************************************************************************
   函数名称：MetroGraph::loadFromJson
   功    能：从Json文件加载地铁图数据
   输入参数：const QString& filename - 地铁数据文件名
   返 回 值：bool 是否正确加载
-  说    明：
+  说    明：用流式读取器单遍读取，线路、站点和出边边读边建立，
+            不构建完整的Json文档；读完后统一建立连接和CSR结构，
+            并在日志中输出各阶段耗时
 ***************************************************************************/
 bool MetroGraph::loadFromJson(const QString& filename) {
+    QElapsedTimer timer;
+    timer.start();
+
     QFile file(filename);
     if (!file.open(QIODevice::ReadOnly)) {
         qWarning() << QString::fromUtf8("无法打开文件:") << filename;
         return false;
     }
 
-    QByteArray data = file.readAll();
-    QJsonDocument doc = QJsonDocument::fromJson(data);
-    if (doc.isNull()) {
-        qWarning() << QString::fromUtf8("无效的JSON文件");
+    lines.clear();
+    stations.clear();
+    connections.clear();
+    stationIds.clear();
+    lineIds.clear();
+    connectionMap.clear();
+    adjacency.clear();
+    csr = MetroCsr();
+
+    /* 单遍读取：顶层对象中只关心lines和stations两个数组*/
+    JsonLoadState    state;
+    JsonStreamReader reader(&file);
+    bool ok = reader.readNext() == JsonStreamReader::BeginObject;
+    while (ok) {
+        JsonStreamReader::TokenType type = reader.readNext();
+        if (type == JsonStreamReader::EndObject) {
+            break;
+        }
+        if (type != JsonStreamReader::Name) {
+            ok = false;
+            break;
+        }
+
+        const QString key = reader.stringValue();
+        if (key == QString::fromUtf8("lines") || key == QString::fromUtf8("stations")) {
+            const bool isLines = (key == QString::fromUtf8("lines"));
+            if (reader.readNext() != JsonStreamReader::BeginArray) {
+                ok = reader.skipValue();
+                continue;
+            }
+            for (;;) {
+                type = reader.readNext();
+                if (type == JsonStreamReader::EndArray) {
+                    break;
+                }
+                if (type != JsonStreamReader::BeginObject) {
+                    ok = reader.skipValue();
+                }
+                else {
+                    ok = isLines ? parseLine(reader, state) : parseStation(reader, state);
+                }
+                if (!ok) {
+                    break;
+                }
+            }
+        }
+        else {
+            ok = reader.skipValue();
+        }
+    }
+
+    if (!ok || reader.hasError()) {
+        qWarning() << QString::fromUtf8("无效的JSON文件") << reader.errorString();
+        lines.clear();
+        stations.clear();
+        stationIds.clear();
+        lineIds.clear();
+        adjacency.clear();
         return false;
     }
+    const qint64 parseTime = timer.nsecsElapsed();
+
+    linkPendingEdges(state);
+    const qint64 linkTime = timer.nsecsElapsed();
+
+    buildCsr();
+    const qint64 csrTime = timer.nsecsElapsed();
+
+    buildDerivedIndices();
+    changes.clear();
+    const qint64 indexTime = timer.nsecsElapsed();
+
+    qDebug() << "加载完成: " << stations.size() << "个站点, " << connections.size() << "个连接";
+    qDebug() << "加载耗时(ms): 读取解析" << parseTime / 1e6
+             << ", 建立连接" << (linkTime - parseTime) / 1e6
+             << ", 构建CSR" << (csrTime - linkTime) / 1e6
+             << ", 构建索引" << (indexTime - csrTime) / 1e6
+             << ", 合计" << indexTime / 1e6
+             << ", 读取" << reader.bytesRead() << "字节";
+    return true;
+}
 
-    QJsonObject root = doc.object();
-    if (root.contains(QString::fromUtf8("lines")) && root[QString::fromUtf8("lines")].isArray()) {
-        parseLines(root[QString::fromUtf8("lines")].toArray());
+/***************************************************************************
+  函数名称：MetroGraph::loadWithSnapshot
+  功    能：优先从二进制快照加载地铁图，快照缺失或失效时从Json加载并重写快照
+  输入参数：const QString& filename         - 地铁数据Json文件名
+            const QString& snapshotFilename - 二进制快照文件名
+  返 回 值：bool 是否正确加载
+  说    明：快照以Json内容的哈希校验，数据文件改动后会自动重建
+***************************************************************************/
+bool MetroGraph::loadWithSnapshot(const QString& filename, const QString& snapshotFilename) {
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << QString::fromUtf8("无法打开文件:") << filename;
+        return false;
     }
+    const QByteArray hash = MetroSnapshot::sourceHash(file);
+    file.close();
 
-    if (root.contains(QString::fromUtf8("stations")) && root[QString::fromUtf8("stations")].isArray()) {
-        parseStations   (root[QString::fromUtf8("stations")].toArray());
-        parseConnections(root[QString::fromUtf8("stations")].toArray());
-        buildStationMap(); // 构建站点映射
+    if (MetroSnapshot::load(*this, snapshotFilename, hash)) {
+        return true;
     }
 
-    qDebug() << "加载完成: " << stations.size() << "个站点, " << connections.size() << "个连接";
+    if (!loadFromJson(filename)) {
+        return false;
+    }
+    MetroSnapshot::save(*this, snapshotFilename, hash);
     return true;
 }
 
 /***************************************************************************
-  函数名称：MetroGraph::parseLines
-  功    能：构造函数，初始化地铁图数据
-  输入参数：const QJsonArray& linesArray - 线路数据数组
-  返 回 值：
-  说    明：
+  函数名称：MetroGraph::parseLine
+  功    能：解析一条线路信息
+  输入参数：JsonStreamReader& reader - 读取器，当前记号为线路对象开始
+            JsonLoadState& state     - 加载状态
+  返 回 值：bool 是否读取成功
+  说    明：线路按在lines数组中出现的顺序编号
 ***************************************************************************/
-void MetroGraph::parseLines(const QJsonArray& linesArray) {
-    lines.clear();
-    for (const QJsonValue& value : linesArray) {
-        QJsonObject obj = value.toObject();
-        MetroLine line;
-        line.name = obj[QString::fromUtf8("name")].toString();
+bool MetroGraph::parseLine(JsonStreamReader& reader, JsonLoadState& state) {
+    MetroLine line;
+    line.color = Qt::black;
 
-        QJsonArray colorArray = obj[QString::fromUtf8("color")].toArray();
-        if (colorArray.size() == 3) {
-            line.color = QColor(colorArray[0].toInt(),
-                colorArray[1].toInt(),
-                colorArray[2].toInt());
+    for (;;) {
+        JsonStreamReader::TokenType type = reader.readNext();
+        if (type == JsonStreamReader::EndObject) {
+            break;
         }
-        else {
-            line.color = Qt::black;
+        if (type != JsonStreamReader::Name) {
+            return false;
+        }
+
+        const QString& key = reader.stringValue();
+        if (key == QString::fromUtf8("name")) {
+            if (!readStringValue(reader, line.name)) return false;
+        }
+        else if (key == QString::fromUtf8("color")) {
+            if (reader.readNext() != JsonStreamReader::BeginArray) {
+                if (!reader.skipValue()) return false;
+                continue;
+            }
+            int rgb[3] = { 0, 0, 0 };
+            int count  = 0;
+            for (;;) {
+                type = reader.readNext();
+                if (type == JsonStreamReader::EndArray) {
+                    break;
+                }
+                if (type == JsonStreamReader::Number && count < 3) {
+                    rgb[count] = toJsonInt(reader.numberValue());
+                }
+                else if (!reader.skipValue()) {
+                    return false;
+                }
+                count++;
+            }
+            line.color = (count == 3) ? QColor(rgb[0], rgb[1], rgb[2]) : QColor(Qt::black);
+        }
+        else if (!reader.skipValue()) {
+            return false;
         }
+    }
 
+    /* 已被出边引用过的线路只补全颜色*/
+    LineId id = getLineId(line.name);
+    if (id == INVALID_ID) {
+        id = static_cast<LineId>(lines.size());
+        lineIds[line.name] = id;
         lines.append(line);
     }
+    else if (id < static_cast<LineId>(state.lineDefined.size()) && state.lineDefined[id]) {
+        qWarning() << "线路重复:" << line.name;
+        return true;
+    }
+    else {
+        lines[id].color = line.color;
+    }
+
+    state.lineDefined.resize(lines.size());
+    state.lineDefined[id] = true;
+    return true;
 }
 
 /***************************************************************************
   函数名称：MetroGraph::parseStation
-  功    能：解析站点信息
-  输入参数：const QJsonArray& stationsArray - 站点信息Json数组
-  返 回 值：
-  说    明：
+  功    能：解析一个站点及其出边
+  输入参数：JsonStreamReader& reader - 读取器，当前记号为站点对象开始
+            JsonLoadState& state     - 加载状态
+  返 回 值：bool 是否读取成功
+  说    明：站点按出现顺序编号；出边先记入state，终点尚未出现的按名称暂存，
+            全部读完后由linkPendingEdges统一连接；重复站点的出边归入首次出现的站点
 ***************************************************************************/
-void MetroGraph::parseStations(const QJsonArray& stationsArray) {
-    stations.clear();
+bool MetroGraph::parseStation(JsonStreamReader& reader, JsonLoadState& state) {
+    Station   station;
+    const int firstEdge = state.edges.size();
+    const int firstVia  = state.viaPoints.size();
 
-    for (const QJsonValue& value : stationsArray) {
-        QJsonObject obj = value.toObject();
-        Station station;
-        station.name = obj[QString::fromUtf8("name")].toString();
-        station.tag  = obj[QString::fromUtf8("tag") ].toString();
-        station.type = obj[QString::fromUtf8("type")].toString();
-
-        QJsonArray posArray = obj[QString::fromUtf8("graph-position")].toArray();
-        if (posArray.size() == 2) {
-            station.graphPosition = QPoint(posArray[0].toInt(), posArray[1].toInt());
+    for (;;) {
+        JsonStreamReader::TokenType type = reader.readNext();
+        if (type == JsonStreamReader::EndObject) {
+            break;
+        }
+        if (type != JsonStreamReader::Name) {
+            return false;
         }
 
-        QJsonArray realPosArray = obj[QString::fromUtf8("real-position")].toArray();
-        if (realPosArray.size() == 2) {
-            station.realPosition = QPointF(realPosArray[0].toDouble(), realPosArray[1].toDouble());
+        const QString& key = reader.stringValue();
+        if (key == QString::fromUtf8("name")) {
+            if (!readStringValue(reader, station.name)) return false;
+        }
+        else if (key == QString::fromUtf8("tag")) {
+            if (!readStringValue(reader, station.tag)) return false;
+        }
+        else if (key == QString::fromUtf8("type")) {
+            if (!readStringValue(reader, station.type)) return false;
+        }
+        else if (key == QString::fromUtf8("graph-position") || key == QString::fromUtf8("real-position")) {
+            const bool isGraph = (key == QString::fromUtf8("graph-position"));
+            if (reader.readNext() != JsonStreamReader::BeginArray) {
+                if (!reader.skipValue()) return false;
+                continue;
+            }
+            double x = 0, y = 0;
+            bool   valid = false;
+            if (!readPair(reader, x, y, valid)) return false;
+            if (valid && isGraph) {
+                station.graphPosition = QPoint(toJsonInt(x), toJsonInt(y));
+            }
+            else if (valid) {
+                station.realPosition = QPointF(x, y);
+            }
+        }
+        else if (key == QString::fromUtf8("edges")) {
+            if (reader.readNext() != JsonStreamReader::BeginArray) {
+                if (!reader.skipValue()) return false;
+                continue;
+            }
+            if (!parseEdges(reader, state)) return false;
         }
+        else if (!reader.skipValue()) {
+            return false;
+        }
+    }
 
+    /* 确定站点编号，补全本站出边的起点*/
+    StationId id = getStationId(station.name);
+    if (station.name.isEmpty()) {
+        qWarning() << "站点缺少名称，已忽略";
+        state.edges.resize(firstEdge);
+        state.viaPoints.resize(firstVia);
+        return true;
+    }
+    if (id != INVALID_ID) {
+        qWarning() << "站点重复:" << station.name;
+    }
+    else {
+        id = static_cast<StationId>(stations.size());
+        stationIds[station.name] = id;
         stations.append(station);
+        adjacency.append(QVector<StationEdge>());
+    }
+
+    for (int e = firstEdge; e < state.edges.size(); e++) {
+        state.edges[e].from = id;
     }
+    return true;
 }
 
 /***************************************************************************
-  函数名称：MetroGraph::buildStationMap
-  功    能：构建站点名称到站点对象的映射
-  输入参数：
-  返 回 值：
-  说    明：用于快速查找站点信息
+  函数名称：MetroGraph::parseEdges
+  功    能：解析站点的出边数组
+  输入参数：JsonStreamReader& reader - 读取器，当前记号为出边数组开始
+            JsonLoadState& state     - 加载状态
+  返 回 值：bool 是否读取成功
+  说    明：出边的起点由parseStation在站点对象读完后补全
 ***************************************************************************/
-void MetroGraph::buildStationMap() {
-    stationMap.clear();
-    for (const Station& station : stations) {
-        stationMap[station.name] = station;
+bool MetroGraph::parseEdges(JsonStreamReader& reader, JsonLoadState& state) {
+    for (;;) {
+        JsonStreamReader::TokenType type = reader.readNext();
+        if (type == JsonStreamReader::EndArray) {
+            return true;
+        }
+        if (type != JsonStreamReader::BeginObject) {
+            if (!reader.skipValue()) return false;
+            continue;
+        }
+
+        QString toStation;
+        QString line;
+        JsonLoadState::PendingEdge edge;
+        edge.from      = INVALID_ID;
+        edge.viaOffset = state.viaPoints.size();
+        edge.viaCount  = 0;
+
+        for (;;) {
+            type = reader.readNext();
+            if (type == JsonStreamReader::EndObject) {
+                break;
+            }
+            if (type != JsonStreamReader::Name) {
+                return false;
+            }
+
+            const QString& key = reader.stringValue();
+            if (key == QString::fromUtf8("to")) {
+                if (!readStringValue(reader, toStation)) return false;
+            }
+            else if (key == QString::fromUtf8("line")) {
+                if (!readStringValue(reader, line)) return false;
+            }
+            else if (key == QString::fromUtf8("via")) {
+                if (reader.readNext() != JsonStreamReader::BeginArray) {
+                    if (!reader.skipValue()) return false;
+                    continue;
+                }
+
+                /* 解析转折点*/
+                edge.viaOffset = state.viaPoints.size();
+                for (;;) {
+                    type = reader.readNext();
+                    if (type == JsonStreamReader::EndArray) {
+                        break;
+                    }
+                    if (type != JsonStreamReader::BeginArray) {
+                        if (!reader.skipValue()) return false;
+                        continue;
+                    }
+                    double x = 0, y = 0;
+                    bool   valid = false;
+                    if (!readPair(reader, x, y, valid)) return false;
+                    if (valid) {
+                        state.viaPoints.append(QPoint(toJsonInt(x), toJsonInt(y)));
+                    }
+                }
+                edge.viaCount = state.viaPoints.size() - edge.viaOffset;
+            }
+            else if (!reader.skipValue()) {
+                return false;
+            }
+        }
+
+        /* 终点已出现的直接记编号，否则按名称暂存*/
+        edge.line    = internLine(line);
+        edge.to      = getStationId(toStation);
+        edge.forward = -1;
+        if (edge.to == INVALID_ID) {
+            edge.forward = state.forwardIndex.value(toStation, -1);
+            if (edge.forward < 0) {
+                edge.forward = state.forwardNames.size();
+                state.forwardIndex.insert(toStation, edge.forward);
+                state.forwardNames.append(toStation);
+            }
+        }
+        state.edges.append(edge);
     }
-    qDebug() << "构建站点映射: " << stationMap.size() << "个站点";
 }
 
 /***************************************************************************
-  函数名称：MetroGraph::parseConnections
-  功    能：解析站点连接状态
-  输入参数：const QJsonArray& stationsArray - 站点数据Json数组
+  函数名称：MetroGraph::linkPendingEdges
+  功    能：按文件顺序将读取到的出边加入连接表和邻接表
+  输入参数：JsonLoadState& state - 加载状态
   返 回 值：
-  说    明：
+  说    明：连接按(站点对, 线路)去重，同一区间上的多条线路各自保留；
+            重复的连接保留转折点更详细的一份
 ***************************************************************************/
-void MetroGraph::parseConnections(const QJsonArray& stationsArray) {
+void MetroGraph::linkPendingEdges(JsonLoadState& state) {
     connections.clear();
     connectionMap.clear();
-    QSet<QPair<QString, QString>> addedConnections;
 
-    qDebug() << "开始解析连接信息";
-
-    /* 首先构建完整的站点映射*/
-    buildStationMap();
-
-    for (const QJsonValue& value : stationsArray) {
-        QJsonObject obj = value.toObject();
-        QString fromStation = obj[QString::fromUtf8("name")].toString();
+    for (const JsonLoadState::PendingEdge& edge : state.edges) {
+        StationId toId = edge.to;
+        if (toId == INVALID_ID) {
+            toId = getStationId(state.forwardNames[edge.forward]);
+        }
 
-        /* 检查站点是否存在*/
-        if (!stationMap.contains(fromStation)) {
-            qDebug() << "警告: 站点" << fromStation << "不存在于站点映射中";
+        /* 检查目标站点是否存在*/
+        if (toId == INVALID_ID) {
+            qDebug() << "警告: 目标站点" << state.forwardNames[edge.forward] << "不存在于站点映射中";
             continue;
         }
 
-        /* 解析连接信息*/
-        if (obj.contains(QString::fromUtf8("edges")) && obj[QString::fromUtf8("edges")].isArray()) {
-            QJsonArray edgesArray = obj[QString::fromUtf8("edges")].toArray();
+        QVector<QPoint> viaPoints = state.viaPoints.mid(edge.viaOffset, edge.viaCount);
+        int connectionIndex = findConnectionIndex(edge.from, toId, edge.line);
 
-            for (const QJsonValue& edgeValue : edgesArray) {
-                QJsonObject edgeObj   = edgeValue.toObject();
-                QString     toStation = edgeObj[QString::fromUtf8("to")  ].toString();
-                QString     line      = edgeObj[QString::fromUtf8("line")].toString();
+        /* 如果这个连接还没有被添加*/
+        if (connectionIndex < 0) {
+            StationConnection connection;
+            connection.id1       = qMin(edge.from, toId);
+            connection.id2       = qMax(edge.from, toId);
+            connection.station1  = stations[connection.id1].name;
+            connection.station2  = stations[connection.id2].name;
+            connection.line      = lines[edge.line].name;
+            connection.lineId    = edge.line;
+            connection.viaPoints = viaPoints;
+            sortViaPoints(connection);
 
-                /* 检查目标站点是否存在*/
-                if (!stationMap.contains(toStation)) {
-                    qDebug() << "警告: 目标站点" << toStation << "不存在于站点映射中";
-                    continue;
-                }
+            connectionMap[pairKey(edge.from, toId)].append(connections.size());
+            connections.append(connection);
 
-                /* 创建连接的键（按字母顺序排序，确保双向连接使用相同的键）*/
-                QPair<QString, QString> connectionKey;
-                if (fromStation < toStation) {
-                    connectionKey = qMakePair(fromStation, toStation);
-                }
-                else {
-                    connectionKey = qMakePair(toStation, fromStation);
-                }
+            /* 更新站点的连接信息*/
+            linkStations(edge.from, toId, edge.line);
+        }
+        else {
+            /* 如果连接已存在，且新的转折点信息更详细，则更新*/
+            StationConnection& existingConnection = connections[connectionIndex];
+            if (viaPoints.size() > existingConnection.viaPoints.size()) {
+                existingConnection.viaPoints = viaPoints;
+                sortViaPoints(existingConnection);
+            }
+        }
+    }
 
-                /* 如果这个连接还没有被添加，或者需要更新转折点信息*/
-                if (!addedConnections.contains(connectionKey)) {
-                    StationConnection connection;
-                    connection.station1 = connectionKey.first;
-                    connection.station2 = connectionKey.second;
-                    connection.line     = line;
-
-                    if (edgeObj.contains(QString::fromUtf8("via")) && edgeObj[QString::fromUtf8("via")].isArray()) {
-                        QJsonArray viaArray = edgeObj[QString::fromUtf8("via")].toArray();
-                        for (const QJsonValue& viaValue : viaArray) {
-                            if (viaValue.isArray()) {
-                                QJsonArray pointArray = viaValue.toArray();
-                                if (pointArray.size() == 2) {
-                                    connection.viaPoints.append(QPoint(pointArray[0].toInt(), pointArray[1].toInt()));
-                                }
-                            }
-                        }
-                    }
+    qDebug() << "解析完成，共添加" << connections.size() << "个连接";
+}
 
-                    connections.append(connection);
-                    connectionMap[connectionKey] = connection;
-                    addedConnections.insert(connectionKey);
+/***************************************************************************
+  函数名称：MetroGraph::sortViaPoints
+  功    能：将连接的转折点按到站点1的距离由近到远排列
+  输入参数：StationConnection& connection - 待整理的连接，站点编号需已设置
+  返 回 值：
+  说    明：加载时排好序，绘制时可直接按顺序连线而无需复制排序
+***************************************************************************/
+void MetroGraph::sortViaPoints(StationConnection& connection) const {
+    if (connection.viaPoints.size() < 2) {
+        return;
+    }
 
-                    /* 更新站点的连接信息*/
-                    if (stationMap.contains(fromStation)) {
-                        stationMap[fromStation].connectedStations.append(toStation);
-                    }
-                    if (stationMap.contains(toStation)) {
-                        stationMap[toStation].connectedStations.append(fromStation);
-                    }
-                }
-                else {
-                    /* 如果连接已存在，检查是否需要更新转折点信息*/
-                    StationConnection& existingConnection = connectionMap[connectionKey];
-                    if (edgeObj.contains(QString::fromUtf8("via")) && edgeObj[QString::fromUtf8("via")].isArray()) {
-                        QJsonArray viaArray = edgeObj[QString::fromUtf8("via")].toArray();
-                        QVector<QPoint> viaPoints;
-
-                        for (const QJsonValue& viaValue : viaArray) {
-                            if (viaValue.isArray()) {
-                                QJsonArray pointArray = viaValue.toArray();
-                                if (pointArray.size() == 2) {
-                                    viaPoints.append(QPoint(pointArray[0].toInt(), pointArray[1].toInt()));
-                                }
-                            }
-                        }
-
-                        /* 如果新的转折点信息更详细，则更新*/
-                        if (viaPoints.size() > existingConnection.viaPoints.size()) {
-                            existingConnection.viaPoints = viaPoints;
-                        }
-                    }
-                }
-            }
-        }
+    const QPoint fromPos = stations[connection.id1].graphPosition;
+    auto distanceToStart = [fromPos](const QPoint& p) {
+        return std::sqrt(std::pow(p.x() - fromPos.x(), 2) + std::pow(p.y() - fromPos.y(), 2));
+    };
+
+    std::sort(connection.viaPoints.begin(), connection.viaPoints.end(),
+        [&](const QPoint& a, const QPoint& b) {
+            return distanceToStart(a) < distanceToStart(b);
+    });
+}
+
+/***************************************************************************
+  函数名称：MetroGraph::internLine
+  功    能：获取线路名称对应的编号
+  输入参数：const QString& name - 线路名称
+  返 回 值：LineId - 线路编号
+  说    明：线路表中没有的线路会以默认颜色登记，保证每条连接都有合法编号
+***************************************************************************/
+LineId MetroGraph::internLine(const QString& name) {
+    auto it = lineIds.constFind(name);
+    if (it != lineIds.constEnd()) {
+        return it.value();
     }
 
-    /* 更新stations向量中的连接信息*/
-    for (Station& station : stations) {
-        if (stationMap.contains(station.name)) {
-            station.connectedStations = stationMap[station.name].connectedStations;
+    qWarning() << "线路未在线路表中声明:" << name;
+    MetroLine line;
+    line.name  = name;
+    line.color = Qt::black;
+
+    LineId id     = static_cast<LineId>(lines.size());
+    lineIds[name] = id;
+    lines.append(line);
+    return id;
+}
+
+/***************************************************************************
+  函数名称：MetroGraph::linkStations
+  功    能：在邻接表中加入一条双向边
+  输入参数：StationId id1  - 站点1编号
+            StationId id2  - 站点2编号
+            LineId    line - 线路编号
+  返 回 值：
+  说    明：邻接表按相邻站点名称有序插入，使遍历顺序稳定且无需在搜索时排序；
+            同一对站点间的多条线路按添加顺序排列
+***************************************************************************/
+void MetroGraph::linkStations(StationId id1, StationId id2, LineId line) {
+    auto insertSorted = [this](StationId from, StationId to, LineId line) {
+        QVector<StationEdge>& edges = adjacency[from];
+        const QString& toName = stations[to].name;
+        auto pos = std::upper_bound(edges.begin(), edges.end(), toName,
+            [this](const QString& name, const StationEdge& edge) {
+                return name < stations[edge.to].name;
+            });
+        edges.insert(pos, StationEdge{ to, line });
+        if (!stations[from].connectedStations.contains(toName)) {
+            stations[from].connectedStations.append(toName);
         }
-    }
+    };
 
-    qDebug() << "解析完成，共添加" << connections.size() << "个连接";
+    insertSorted(id1, id2, line);
+    insertSorted(id2, id1, line);
+}
+
+/***************************************************************************
+  函数名称：MetroGraph::pairKey
+  功    能：生成无序站点编号对的键
+  输入参数：StationId id1 - 站点1编号
+            StationId id2 - 站点2编号
+  返 回 值：quint64 - 较小编号在高32位、较大编号在低32位的键
+  说    明：
+***************************************************************************/
+quint64 MetroGraph::pairKey(StationId id1, StationId id2) {
+    return (static_cast<quint64>(qMin(id1, id2)) << 32) | qMax(id1, id2);
 }
 
 /***************************************************************************
   函数名称：MetroGraph::getLines
   功    能：向外提供线路数据
   输入参数：
-  返 回 值：QVector<MetroLine> 线路列表
-  说    明：
+  返 回 值：const QVector<MetroLine>& 线路列表
+  说    明：返回内部存储的引用，图被修改后失效
 ***************************************************************************/
-QVector<MetroLine> MetroGraph::getLines() const {
+const QVector<MetroLine>& MetroGraph::getLines() const {
     return lines;
 }
 
@@ -280,10 +705,10 @@ QVector<MetroLine> MetroGraph::getLines() const {
   函数名称：MetroGraph::getStations
   功    能：向外提供站点数据
   输入参数：
-  返 回 值：QVector<Station> 站点列表
-  说    明：
+  返 回 值：const QVector<Station>& 站点列表，下标即站点编号
+  说    明：返回内部存储的引用，图被修改后失效
 ***************************************************************************/
-QVector<Station> MetroGraph::getStations() const {
+const QVector<Station>& MetroGraph::getStations() const {
     return stations;
 }
 
@@ -291,14 +716,25 @@ QVector<Station> MetroGraph::getStations() const {
   函数名称：MetroGraph::getStation
   功    能：根据输入的站点名称返回站点信息
   输入参数：const QString &name - 站点名称
-  返 回 值：Station 相应的站点信息
-  说    明：查无此站点则返回空
+  返 回 值：const Station& 相应的站点信息
+  说    明：查无此站点则返回空站点
 ***************************************************************************/
-Station MetroGraph::getStation(const QString& name) const {
-    if (stationMap.contains(name)) {
-        return stationMap.value(name);
-    }
-    return Station(); // 返回空站点
+const Station& MetroGraph::getStation(const QString& name) const {
+    static const Station emptyStation;
+    const Station* station = findStation(name);
+    return station ? *station : emptyStation;
+}
+
+/***************************************************************************
+  函数名称：MetroGraph::findStation
+  功    能：根据输入的站点名称查找站点
+  输入参数：const QString &name - 站点名称
+  返 回 值：const Station* 站点指针，查无此站点则为nullptr
+  说    明：指针指向内部存储，图被修改后失效
+***************************************************************************/
+const Station* MetroGraph::findStation(const QString& name) const {
+    StationId id = getStationId(name);
+    return id == INVALID_ID ? nullptr : &stations[id];
 }
 
 /***************************************************************************
@@ -309,7 +745,7 @@ Station MetroGraph::getStation(const QString& name) const {
   说    明：
 ***************************************************************************/
 bool MetroGraph::hasStation(const QString& name) const {
-    return stationMap.contains(name);
+    return stationIds.contains(name);
 }
 
 /***************************************************************************
@@ -321,6 +757,7 @@ bool MetroGraph::hasStation(const QString& name) const {
 ***************************************************************************/
 QVector<QString> MetroGraph::getStationNames() const {
     QVector<QString> names;
+    names.reserve(stations.size());
     for (const Station& station : stations) {
         names.append(station.name);
     }
@@ -331,10 +768,10 @@ QVector<QString> MetroGraph::getStationNames() const {
   函数名称：MetroGraph::getConnections
   功    能：获取所有连接信息
   输入参数：
-  返 回 值：QVector<StationConnection> 连接列表
-  说    明：
+  返 回 值：const QVector<StationConnection>& 连接列表
+  说    明：返回内部存储的引用，图被修改后失效
 ***************************************************************************/
-QVector<StationConnection> MetroGraph::getConnections() const {
+const QVector<StationConnection>& MetroGraph::getConnections() const {
     return connections;
 }
 
@@ -343,18 +780,71 @@ QVector<StationConnection> MetroGraph::getConnections() const {
   功    能：获取两个站点之间的连接信息
   输入参数：const QString& station1 - 站点1 
             const QString& station2 - 站点2
-  返 回 值：StationConnection 连接信息
+  返 回 值：const StationConnection& 连接信息，不存在时为空连接
+  说    明：
+***************************************************************************/
+const StationConnection& MetroGraph::getConnection(const QString& station1, const QString& station2) const {
+    return getConnection(station1, station2, QString());
+}
+
+/***************************************************************************
+  函数名称：MetroGraph::getConnection
+  功    能：获取两个站点之间指定线路上的连接信息
+  输入参数：const QString& station1 - 站点1
+            const QString& station2 - 站点2
+            const QString& line     - 线路名称，为空时返回第一条连接
+  返 回 值：const StationConnection& 连接信息，不存在时为空连接
   说    明：
 ***************************************************************************/
-StationConnection MetroGraph::getConnection(const QString& station1, const QString& station2) const {
-    QPair<QString, QString> key;
-    if (station1 < station2) {
-        key = qMakePair(station1, station2);
+const StationConnection& MetroGraph::getConnection(const QString& station1, const QString& station2, const QString& line) const {
+    static const StationConnection emptyConnection;
+
+    StationId id1    = getStationId(station1);
+    StationId id2    = getStationId(station2);
+    LineId    lineId = line.isEmpty() ? INVALID_ID : getLineId(line);
+    if (id1 == INVALID_ID || id2 == INVALID_ID || (!line.isEmpty() && lineId == INVALID_ID)) {
+        return emptyConnection;
     }
-    else {
-        key = qMakePair(station2, station1);
+
+    const StationConnection* connection = findConnection(id1, id2, lineId);
+    return connection ? *connection : emptyConnection;
+}
+
+/***************************************************************************
+  函数名称：MetroGraph::findConnection
+  功    能：按编号查找两个站点之间指定线路上的连接
+  输入参数：StationId id1  - 站点1编号
+            StationId id2  - 站点2编号
+            LineId    line - 线路编号，为INVALID_ID时返回第一条连接
+  返 回 值：const StationConnection* 连接指针，不存在时为nullptr
+  说    明：指针指向内部存储，图被修改后失效
+***************************************************************************/
+const StationConnection* MetroGraph::findConnection(StationId id1, StationId id2, LineId line) const {
+    int index = findConnectionIndex(id1, id2, line);
+    return index < 0 ? nullptr : &connections[index];
+}
+
+/***************************************************************************
+  函数名称：MetroGraph::findConnectionIndex
+  功    能：查找两个站点之间指定线路上的连接下标
+  输入参数：StationId id1  - 站点1编号
+            StationId id2  - 站点2编号
+            LineId    line - 线路编号，为INVALID_ID时返回第一条连接
+  返 回 值：int - 连接在connections中的下标，不存在时为-1
+  说    明：
+***************************************************************************/
+int MetroGraph::findConnectionIndex(StationId id1, StationId id2, LineId line) const {
+    auto it = connectionMap.constFind(pairKey(id1, id2));
+    if (it == connectionMap.constEnd()) {
+        return -1;
+    }
+
+    for (int index : it.value()) {
+        if (line == INVALID_ID || connections[index].lineId == line) {
+            return index;
+        }
     }
-    return connectionMap.value(key);
+    return -1;
 }
 
 /***************************************************************************
@@ -366,15 +856,23 @@ StationConnection MetroGraph::getConnection(const QString& station1, const QStri
 ***************************************************************************/
 bool MetroGraph::addLine(const MetroLine& line) {
     /* 检查线路是否已存在*/
-    for (const MetroLine& existingLine : lines) {
-        if (existingLine.name == line.name) {
-            qWarning() << "线路已存在:" << line.name;
-            return false;
-        }
+    if (lineIds.contains(line.name)) {
+        qWarning() << "线路已存在:" << line.name;
+        return false;
     }
 
     /* 添加新线路*/
+    MetroChange change;
+    change.type = MetroChange::LineAdded;
+    change.line = static_cast<LineId>(lines.size());
+
+    lineIds[line.name] = change.line;
     lines.append(line);
+    lineStationIndex.append(QVector<StationId>());
+    changes.append(change);
+    /* 线路拓扑和地标表不做增量修补，作废后在下次使用时按全图重新计算*/
+    lineTopology.reset();
+    landmarkTable.reset();
     qDebug() << "成功添加线路:" << line.name;
     return true;
 }
@@ -388,14 +886,35 @@ bool MetroGraph::addLine(const MetroLine& line) {
 ***************************************************************************/
 bool MetroGraph::addStation(const Station& station) {
     /* 检查站点是否已存在*/
-    if (stationMap.contains(station.name)) {
+    if (stationIds.contains(station.name)) {
         qWarning() << "站点已存在:" << station.name;
         return false;
     }
 
-    /* 添加新站点*/
+    /* 添加新站点，编号为当前站点数*/
+    const StationId id = static_cast<StationId>(stations.size());
+    stationIds[station.name] = id;
     stations.append(station);
-    stationMap[station.name] = station;
+    stations.last().connectedStations.clear();
+    adjacency.append(QVector<StationEdge>());
+
+    /* 新站点没有出边，CSR只需追加空区间*/
+    if (csr.offsets.isEmpty()) {
+        buildCsr();
+    }
+    else {
+        csr.offsets.append(csr.offsets.last());
+        csr.groupOffsets.append(csr.groupOffsets.last());
+    }
+    indexStation(id);
+
+    MetroChange change;
+    change.type     = MetroChange::StationAdded;
+    change.station1 = id;
+    changes.append(change);
+    /* 线路拓扑和地标表不做增量修补，作废后在下次使用时按全图重新计算*/
+    lineTopology.reset();
+    landmarkTable.reset();
     qDebug() << "成功添加站点:" << station.name;
     return true;
 }
@@ -412,79 +931,1158 @@ bool MetroGraph::addStation(const Station& station) {
 ***************************************************************************/
 bool MetroGraph::addConnection(const QString& station1, const QString& station2, const QString& line, const QVector<QPoint>& viaPoints) {
     /* 检查站点是否存在*/
-    if (!stationMap.contains(station1) || !stationMap.contains(station2)) {
+    StationId id1 = getStationId(station1);
+    StationId id2 = getStationId(station2);
+    if (id1 == INVALID_ID || id2 == INVALID_ID) {
         qWarning() << "站点不存在:" << station1 << "或" << station2;
         return false;
     }
 
     /* 检查线路是否存在*/
-    bool lineExists = false;
-    for (const MetroLine& metroLine : lines) {
-        if (metroLine.name == line) {
-            lineExists = true;
-            break;
-        }
-    }
-
-    if (!lineExists) {
+    LineId lineId = getLineId(line);
+    if (lineId == INVALID_ID) {
         qWarning() << "线路不存在:" << line;
         return false;
     }
 
-    /* 创建连接的键（按字母顺序排序，确保双向连接使用相同的键）*/
-    QPair<QString, QString> connectionKey;
-    if (station1 < station2) {
-        connectionKey = qMakePair(station1, station2);
-    }
-    else {
-        connectionKey = qMakePair(station2, station1);
-    }
-
-    /* 检查连接是否已存在*/
-    if (connectionMap.contains(connectionKey)) {
-        qWarning() << "连接已存在:" << station1 << "<->" << station2;
+    /* 检查该线路上的连接是否已存在，其他线路共用同一区间是允许的*/
+    if (findConnectionIndex(id1, id2, lineId) >= 0) {
+        qWarning() << "连接已存在:" << station1 << "<->" << station2 << "线路:" << line;
         return false;
     }
 
     /* 创建新连接*/
     StationConnection connection;
-    connection.station1  = connectionKey.first;
-    connection.station2  = connectionKey.second;
+    connection.id1       = qMin(id1, id2);
+    connection.id2       = qMax(id1, id2);
+    connection.station1  = stations[connection.id1].name;
+    connection.station2  = stations[connection.id2].name;
     connection.line      = line;
+    connection.lineId    = lineId;
     connection.viaPoints = viaPoints;
+    sortViaPoints(connection);
 
     /* 添加到连接列表和映射*/
+    connectionMap[pairKey(id1, id2)].append(connections.size());
     connections.append(connection);
-    connectionMap[connectionKey] = connection;
 
-    // 更新站点的连接信息
-    stationMap[station1].connectedStations.append(station2);
-    stationMap[station2].connectedStations.append(station1);
+    // 更新站点的连接信息，派生索引只改动两端站点，CSR数组的插入和平移见insertCsrEdge
+    linkStations(id1, id2, lineId);
+    insertCsrEdge(id1, id2, lineId);
+    insertCsrEdge(id2, id1, lineId);
+
+    MetroChange change;
+    change.type     = MetroChange::ConnectionAdded;
+    change.station1 = connection.id1;
+    change.station2 = connection.id2;
+    change.line     = lineId;
+    changes.append(change);
+    /* 线路拓扑和地标表不做增量修补，作废后在下次使用时按全图重新计算*/
+    lineTopology.reset();
+    landmarkTable.reset();
 
     qDebug() << "成功添加连接:" << station1 << "<->" << station2 << "线路:" << line;
     return true;
 }
 
 /***************************************************************************
-  函数名称：MetroGraph::getStationLines
-  功    能：获取每个站点所属的线路
+  函数名称：MetroGraph::getLineStations
+  功    能：获取每条线路上的站点
   输入参数：
-  返 回 值：QMap<QString, QVector<QString>> 站点到线路的映射
-  说    明：
+  返 回 值：QMap<QString, QVector<QString>> 线路到站点的映射
+  说    明：站点按轨道顺序排列，有分支的线路先列出第一条走向
   ***************************************************************************/
 QMap<QString, QVector<QString>> MetroGraph::getLineStations() const {
     QMap<QString, QVector<QString>> lineStations;
 
-    // 遍历所有连接，构建线路到站点的映射
-    for (const StationConnection& conn : connections) {
-        if (!lineStations[conn.line].contains(conn.station1)) {
-            lineStations[conn.line].append(conn.station1);
-        }
-        if (!lineStations[conn.line].contains(conn.station2)) {
-            lineStations[conn.line].append(conn.station2);
+    const LineTopology& topology = getLineTopology();
+    for (LineId line = 0; line < static_cast<LineId>(lines.size()); line++) {
+        QVector<QString>& names = lineStations[lines[line].name];
+        for (StationId id : topology.stationOrder[line]) {
+            names.append(stations[id].name);
         }
     }
 
     return lineStations;
 }
-/*MetroGraph.cpp*/
\ No newline at end of file
+
+/***************************************************************************
+  函数名称：MetroGraph::getVersion
+  功    能：获取版本号
+  输入参数：
+  返 回 值：quint64 - 版本号，未经MetroGraphStore发布的图为0
+  说    明：
+***************************************************************************/
+quint64 MetroGraph::getVersion() const {
+    return version;
+}
+
+/***************************************************************************
+  函数名称：MetroGraph::getStationCount
+  功    能：获取站点数量
+  输入参数：
+  返 回 值：int - 站点数量，同时也是站点编号的上界
+  说    明：
+***************************************************************************/
+int MetroGraph::getStationCount() const {
+    return stations.size();
+}
+
+/***************************************************************************
+  函数名称：MetroGraph::getLineCount
+  功    能：获取线路数量
+  输入参数：
+  返 回 值：int - 线路数量，同时也是线路编号的上界
+  说    明：
+***************************************************************************/
+int MetroGraph::getLineCount() const {
+    return lines.size();
+}
+
+/***************************************************************************
+  函数名称：MetroGraph::getStationId
+  功    能：站点名称转编号
+  输入参数：const QString& name - 站点名称
+  返 回 值：StationId - 站点编号，不存在时为INVALID_ID
+  说    明：
+***************************************************************************/
+StationId MetroGraph::getStationId(const QString& name) const {
+    return stationIds.value(name, INVALID_ID);
+}
+
+/***************************************************************************
+  函数名称：MetroGraph::getLineId
+  功    能：线路名称转编号
+  输入参数：const QString& name - 线路名称
+  返 回 值：LineId - 线路编号，不存在时为INVALID_ID
+  说    明：
+***************************************************************************/
+LineId MetroGraph::getLineId(const QString& name) const {
+    return lineIds.value(name, INVALID_ID);
+}
+
+/***************************************************************************
+  函数名称：MetroGraph::getStationName
+  功    能：站点编号转名称
+  输入参数：StationId id - 站点编号
+  返 回 值：const QString& - 站点名称，编号无效时为空字符串
+  说    明：
+***************************************************************************/
+const QString& MetroGraph::getStationName(StationId id) const {
+    static const QString emptyName;
+    return id < static_cast<StationId>(stations.size()) ? stations[id].name : emptyName;
+}
+
+/***************************************************************************
+  函数名称：MetroGraph::getLineName
+  功    能：线路编号转名称
+  输入参数：LineId id - 线路编号
+  返 回 值：const QString& - 线路名称，编号无效时为空字符串
+  说    明：
+***************************************************************************/
+const QString& MetroGraph::getLineName(LineId id) const {
+    static const QString emptyName;
+    return id < static_cast<LineId>(lines.size()) ? lines[id].name : emptyName;
+}
+
+/***************************************************************************
+  函数名称：MetroGraph::getStationById
+  功    能：根据编号获取站点
+  输入参数：StationId id - 站点编号
+  返 回 值：const Station& - 站点信息，编号无效时为空站点
+  说    明：
+***************************************************************************/
+const Station& MetroGraph::getStationById(StationId id) const {
+    static const Station emptyStation;
+    return id < static_cast<StationId>(stations.size()) ? stations[id] : emptyStation;
+}
+
+/***************************************************************************
+  函数名称：MetroGraph::getStationEdges
+  功    能：获取站点的全部出边
+  输入参数：StationId id - 站点编号
+  返 回 值：const QVector<StationEdge>& - 出边列表，按相邻站点名称有序
+  说    明：
+***************************************************************************/
+const QVector<StationEdge>& MetroGraph::getStationEdges(StationId id) const {
+    static const QVector<StationEdge> noEdges;
+    return id < static_cast<StationId>(adjacency.size()) ? adjacency[id] : noEdges;
+}
+
+/***************************************************************************
+  函数名称：MetroGraph::getLineStationIds
+  功    能：获取线路上的全部站点编号
+  输入参数：LineId line - 线路编号
+  返 回 值：const QVector<StationId>& - 站点编号列表，按编号升序
+  说    明：直接返回随修改维护的索引，线路不存在时为空列表
+***************************************************************************/
+const QVector<StationId>& MetroGraph::getLineStationIds(LineId line) const {
+    static const QVector<StationId> emptyList;
+    if (line >= static_cast<LineId>(lineStationIndex.size())) {
+        return emptyList;
+    }
+    return lineStationIndex[line];
+}
+
+/***************************************************************************
+  函数名称：MetroGraph::buildCsr
+  功    能：由邻接表构建CSR结构
+  输入参数：
+  返 回 值：
+  说    明：出边连续存放并沿用邻接表的名称顺序，边长在此一次算好，
+            搜索时只需顺序扫描数组
+***************************************************************************/
+void MetroGraph::buildCsr() {
+    int edgeCount = 0;
+    for (const QVector<StationEdge>& edges : adjacency) {
+        edgeCount += edges.size();
+    }
+
+    csr.offsets.resize(adjacency.size() + 1);
+    csr.targets.clear();
+    csr.lines.clear();
+    csr.weights.clear();
+    csr.targets.reserve(edgeCount);
+    csr.lines.reserve(edgeCount);
+    csr.weights.reserve(edgeCount);
+
+    for (StationId id = 0; id < static_cast<StationId>(adjacency.size()); id++) {
+        csr.offsets[id] = csr.targets.size();
+        for (const StationEdge& edge : adjacency[id]) {
+            csr.targets.append(edge.to);
+            csr.lines.append(edge.line);
+            csr.weights.append(calculateDistance(id, edge.to));
+        }
+    }
+    csr.offsets[adjacency.size()] = csr.targets.size();
+
+    /* 将每个站点的出边按线路分组*/
+    csr.groupOffsets.resize(adjacency.size() + 1);
+    csr.groupLines.clear();
+    csr.groupEdgeOffsets.clear();
+    csr.groupEdges.clear();
+    csr.groupEdges.reserve(edgeCount);
+
+    QVector<int> stationEdges;
+    for (StationId id = 0; id < static_cast<StationId>(adjacency.size()); id++) {
+        csr.groupOffsets[id] = csr.groupLines.size();
+
+        stationEdges.clear();
+        for (int e = csr.offsets[id]; e < csr.offsets[id + 1]; e++) {
+            stationEdges.append(e);
+        }
+        std::stable_sort(stationEdges.begin(), stationEdges.end(), [this](int a, int b) {
+            return csr.lines[a] < csr.lines[b];
+        });
+
+        for (int e : stationEdges) {
+            if (csr.groupLines.size() == csr.groupOffsets[id] || csr.groupLines.last() != csr.lines[e]) {
+                csr.groupLines.append(csr.lines[e]);
+                csr.groupEdgeOffsets.append(csr.groupEdges.size());
+            }
+            csr.groupEdges.append(e);
+        }
+    }
+    csr.groupOffsets[adjacency.size()] = csr.groupLines.size();
+    csr.groupEdgeOffsets.append(csr.groupEdges.size());
+}
+
+/***************************************************************************
+  函数名称：MetroGraph::findLineGroup
+  功    能：获取站点在某条线路上的出边分组
+  输入参数：StationId station - 站点编号
+            LineId    line    - 线路编号
+  返 回 值：int - 分组下标，站点不在该线路上时为-1
+  说    明：一个站点只属于少数几条线路，扫描其分组即为常数时间
+***************************************************************************/
+int MetroGraph::findLineGroup(StationId station, LineId line) const {
+    if (station >= static_cast<StationId>(stations.size())) {
+        return -1;
+    }
+    for (int g = csr.groupOffsets[station]; g < csr.groupOffsets[station + 1]; g++) {
+        if (csr.groupLines[g] == line) {
+            return g;
+        }
+    }
+    return -1;
+}
+
+/***************************************************************************
+  函数名称：MetroGraph::getLinesBetween
+  功    能：获取两个相邻站点之间的全部线路编号
+  输入参数：StationId id1 - 站点1编号
+            StationId id2 - 站点2编号
+  返 回 值：QVector<LineId> - 线路编号列表，按添加顺序排列
+  说    明：多条线路共线的区间会返回多条线路
+***************************************************************************/
+QVector<LineId> MetroGraph::getLinesBetween(StationId id1, StationId id2) const {
+    QVector<LineId> result;
+    if (id1 >= static_cast<StationId>(stations.size())) {
+        return result;
+    }
+    for (int e = csr.offsets[id1]; e < csr.offsets[id1 + 1]; e++) {
+        if (csr.targets[e] == id2) {
+            result.append(csr.lines[e]);
+        }
+    }
+    return result;
+}
+
+/***************************************************************************
+  函数名称：MetroGraph::getCsr
+  功    能：获取CSR邻接结构
+  输入参数：
+  返 回 值：const MetroCsr& - CSR结构，随图的修改重建
+  说    明：
+***************************************************************************/
+const MetroCsr& MetroGraph::getCsr() const {
+    return csr;
+}
+
+/***************************************************************************
+  函数名称：MetroGraph::calculateDistance
+  功    能：计算两个站点之间的距离
+  输入参数：StationId id1 - 站点编号1
+            StationId id2 - 站点编号2
+  返 回 值：double 两个站点之间的距离（公里）
+  说    明：
+***************************************************************************/
+double MetroGraph::calculateDistance(StationId id1, StationId id2) const {
+    const Station& s1 = getStationById(id1);
+    const Station& s2 = getStationById(id2);
+
+    double dx = s1.realPosition.x() - s2.realPosition.x();
+    double dy = s1.realPosition.y() - s2.realPosition.y();
+
+    /*
+      将经纬度距离转换为近似公里数
+      1度纬度约111公里，1度经度约111*cos(纬度)公里
+      上海纬度约31度，所以1度经度约111*cos(31°) ≈ 95公里
+    */
+    const double latToKm = 111.0;
+    const double lonToKm = 111.0 * std::cos(31.0 * M_PI / 180.0);
+
+    return std::sqrt(std::pow(dx * lonToKm, 2) + std::pow(dy * latToKm, 2));
+}
+
+/***************************************************************************
+  函数名称：MetroGraph::getEdgeHash
+  功    能：计算CSR出边的哈希
+  输入参数：
+  返 回 值：QByteArray - 哈希值
+  说    明：覆盖站点数和每条出边的终点、线路与长度；由出边预计算并随数据
+            保存的索引（收缩层次、全源路径表）以此判断是否仍然有效，名称、
+            颜色、坐标等改动不影响该值
+***************************************************************************/
+QByteArray MetroGraph::getEdgeHash() const {
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(reinterpret_cast<const char*>(csr.offsets.constData()), int(csr.offsets.size() * sizeof(int)));
+    hash.addData(reinterpret_cast<const char*>(csr.targets.constData()), int(csr.targets.size() * sizeof(StationId)));
+    hash.addData(reinterpret_cast<const char*>(csr.lines.constData()),   int(csr.lines.size() * sizeof(LineId)));
+    hash.addData(reinterpret_cast<const char*>(csr.weights.constData()), int(csr.weights.size() * sizeof(double)));
+    return hash.result();
+}
+
+/***************************************************************************
+  函数名称：MetroGraph::insertCsrEdge
+  功    能：将邻接表中新加的一条出边插入CSR结构
+  输入参数：StationId from - 起点编号
+            StationId to   - 终点编号
+            LineId    line - 线路编号
+  返 回 值：
+  说    明：出边已由linkStations放入邻接表，此处按相同位置插入各数组并平移
+            其后的偏移，结果与buildCsr全量构建一致；起点首次出现在该线路上时
+            同时更新线路站点索引和换乘标记。数组中间插入和平移偏移、分组中的
+            出边下标都要遍历全图，代价与出边数加分组数成正比，只是省去了
+            buildCsr的逐站排序和分组
+***************************************************************************/
+void MetroGraph::insertCsrEdge(StationId from, StationId to, LineId line) {
+    const QVector<StationEdge>& edges = adjacency[from];
+    int k = 0;
+    while (k < edges.size() && !(edges[k].to == to && edges[k].line == line)) {
+        k++;
+    }
+
+    /* 插入出边本身*/
+    const int e = csr.offsets[from] + k;
+    csr.targets.insert(e, to);
+    csr.lines.insert(e, line);
+    csr.weights.insert(e, calculateDistance(from, to));
+    for (int s = from + 1; s < csr.offsets.size(); s++) {
+        csr.offsets[s]++;
+    }
+    for (int& index : csr.groupEdges) {
+        if (index >= e) {
+            index++;
+        }
+    }
+
+    /* 放入(站点, 线路)分组，分组内按出边下标升序*/
+    int group = findLineGroup(from, line);
+    if (group < 0) {
+        group = csr.groupOffsets[from];
+        while (group < csr.groupOffsets[from + 1] && csr.groupLines[group] < line) {
+            group++;
+        }
+        csr.groupLines.insert(group, line);
+        csr.groupEdgeOffsets.insert(group, csr.groupEdgeOffsets[group]);
+        for (int s = from + 1; s < csr.groupOffsets.size(); s++) {
+            csr.groupOffsets[s]++;
+        }
+
+        /* 站点新加入该线路*/
+        QVector<StationId>& lineStations = lineStationIndex[line];
+        lineStations.insert(std::lower_bound(lineStations.begin(), lineStations.end(), from), from);
+        transferFlags[from] = csr.groupOffsets[from + 1] - csr.groupOffsets[from] > 1;
+    }
+
+    int pos = csr.groupEdgeOffsets[group];
+    while (pos < csr.groupEdgeOffsets[group + 1] && csr.groupEdges[pos] < e) {
+        pos++;
+    }
+    csr.groupEdges.insert(pos, e);
+    for (int g = group + 1; g < csr.groupEdgeOffsets.size(); g++) {
+        csr.groupEdgeOffsets[g]++;
+    }
+}
+
+/***************************************************************************
+  函数名称：MetroGraph::buildDerivedIndices
+  功    能：全量构建派生索引
+  输入参数：
+  返 回 值：
+  说    明：仅在整体加载后调用一次。之后线路站点索引、换乘标记、空间网格
+            和排序列表由各添加方法只按改动的站点维护；线路拓扑和地标表在
+            每次添加后作废，下次使用时按全图重新计算
+***************************************************************************/
+void MetroGraph::buildDerivedIndices() {
+    const int stationCount = stations.size();
+    lineTopology.reset();
+    landmarkTable.reset();
+
+    /* 线路到站点、换乘标记*/
+    lineStationIndex.clear();
+    lineStationIndex.resize(lines.size());
+    transferFlags.fill(false, stationCount);
+    for (StationId id = 0; id < static_cast<StationId>(stationCount); id++) {
+        for (int g = csr.groupOffsets[id]; g < csr.groupOffsets[id + 1]; g++) {
+            lineStationIndex[csr.groupLines[g]].append(id);
+        }
+        transferFlags[id] = csr.groupOffsets[id + 1] - csr.groupOffsets[id] > 1;
+    }
+
+    /* 空间网格*/
+    spatialGrid.clear();
+    for (StationId id = 0; id < static_cast<StationId>(stationCount); id++) {
+        spatialGrid[gridKey(stations[id].graphPosition)].append(id);
+    }
+
+    /* 按名称排序，与界面中的拼音排序规则一致*/
+    sortedStationIds.resize(stationCount);
+    for (StationId id = 0; id < static_cast<StationId>(stationCount); id++) {
+        sortedStationIds[id] = id;
+    }
+    QCollator collator;
+    collator.setNumericMode(false);
+    std::sort(sortedStationIds.begin(), sortedStationIds.end(), [&](StationId a, StationId b) {
+        return collator.compare(stations[a].name, stations[b].name) < 0;
+    });
+}
+
+/***************************************************************************
+  函数名称：MetroGraph::indexStation
+  功    能：将新站点加入各派生索引
+  输入参数：StationId id - 新站点编号
+  返 回 值：
+  说    明：新站点尚无出边，只需登记换乘标记、空间网格和排序位置
+***************************************************************************/
+void MetroGraph::indexStation(StationId id) {
+    transferFlags.append(false);
+    spatialGrid[gridKey(stations[id].graphPosition)].append(id);
+    sortedStationIds.insert(getSortedIndex(id), id);
+}
+
+/***************************************************************************
+  函数名称：MetroGraph::gridKey
+  功    能：计算坐标所在网格的键
+  输入参数：const QPoint& pos - 图上坐标
+  返 回 值：quint64 - 网格键，行列各占32位
+  说    明：网格边长为64个图上单位
+***************************************************************************/
+quint64 MetroGraph::gridKey(const QPoint& pos) {
+    const int cellX = static_cast<int>(std::floor(pos.x() / 64.0));
+    const int cellY = static_cast<int>(std::floor(pos.y() / 64.0));
+    return (static_cast<quint64>(static_cast<quint32>(cellX)) << 32) | static_cast<quint32>(cellY);
+}
+
+/***************************************************************************
+  函数名称：MetroGraph::getStationLineIds
+  功    能：获取站点所在的全部线路
+  输入参数：StationId id - 站点编号
+  返 回 值：QVector<LineId> - 线路编号，按编号升序
+  说    明：
+***************************************************************************/
+QVector<LineId> MetroGraph::getStationLineIds(StationId id) const {
+    QVector<LineId> result;
+    if (id >= static_cast<StationId>(stations.size())) {
+        return result;
+    }
+    for (int g = csr.groupOffsets[id]; g < csr.groupOffsets[id + 1]; g++) {
+        result.append(csr.groupLines[g]);
+    }
+    return result;
+}
+
+/***************************************************************************
+  函数名称：MetroGraph::isTransferStation
+  功    能：判断站点是否连接多条线路
+  输入参数：StationId id - 站点编号
+  返 回 值：bool - 是否换乘站
+  说    明：
+***************************************************************************/
+bool MetroGraph::isTransferStation(StationId id) const {
+    return id < static_cast<StationId>(transferFlags.size()) && transferFlags[id];
+}
+
+/***************************************************************************
+  函数名称：MetroGraph::getSortedStationIds
+  功    能：获取按名称排序的站点编号
+  输入参数：
+  返 回 值：const QVector<StationId>& - 排序后的站点编号
+  说    明：排序规则与QCollator默认区域设置一致
+***************************************************************************/
+const QVector<StationId>& MetroGraph::getSortedStationIds() const {
+    return sortedStationIds;
+}
+
+/***************************************************************************
+  函数名称：MetroGraph::getSortedIndex
+  功    能：获取站点在按名称排序的列表中的位置
+  输入参数：StationId id - 站点编号
+  返 回 值：int - 位置；站点尚未登记时为应插入的位置
+  说    明：二分查找，O(log n)次比较
+***************************************************************************/
+int MetroGraph::getSortedIndex(StationId id) const {
+    QCollator collator;
+    collator.setNumericMode(false);
+    const QString& name = stations[id].name;
+    auto it = std::lower_bound(sortedStationIds.begin(), sortedStationIds.end(), name,
+        [&](StationId other, const QString& value) {
+            return collator.compare(stations[other].name, value) < 0;
+        });
+    return static_cast<int>(it - sortedStationIds.begin());
+}
+
+/***************************************************************************
+  函数名称：MetroGraph::findNearestStation
+  功    能：查找图上距离某点最近的站点
+  输入参数：const QPoint& pos     - 图上坐标
+            double maxDistance    - 最大距离，超出则不算命中
+  返 回 值：StationId - 站点编号，范围内没有站点时为INVALID_ID
+  说    明：只检查与搜索圆相交的网格；距离相同时取编号较小的站点
+***************************************************************************/
+StationId MetroGraph::findNearestStation(const QPoint& pos, double maxDistance) const {
+    StationId best     = INVALID_ID;
+    double    bestDist = maxDistance;
+
+    const int radius = static_cast<int>(std::ceil(maxDistance));
+    const int minX   = static_cast<int>(std::floor((pos.x() - radius) / 64.0));
+    const int maxX   = static_cast<int>(std::floor((pos.x() + radius) / 64.0));
+    const int minY   = static_cast<int>(std::floor((pos.y() - radius) / 64.0));
+    const int maxY   = static_cast<int>(std::floor((pos.y() + radius) / 64.0));
+
+    for (int cellX = minX; cellX <= maxX; cellX++) {
+        for (int cellY = minY; cellY <= maxY; cellY++) {
+            auto it = spatialGrid.constFind(gridKey(QPoint(cellX * 64, cellY * 64)));
+            if (it == spatialGrid.constEnd()) {
+                continue;
+            }
+            for (StationId id : it.value()) {
+                const QPoint& stationPos = stations[id].graphPosition;
+                double dist = std::sqrt(std::pow(stationPos.x() - pos.x(), 2) + std::pow(stationPos.y() - pos.y(), 2));
+                if (dist < bestDist || (dist == bestDist && best != INVALID_ID && id < best)) {
+                    bestDist = dist;
+                    best     = id;
+                }
+            }
+        }
+    }
+    return best;
+}
+
+/***************************************************************************
+  函数名称：MetroGraph::getChanges
+  功    能：获取产生本版本的变更
+  输入参数：
+  返 回 值：const QVector<MetroChange>& - 相对上一版本的变更列表
+  说    明：整体加载得到的版本变更列表为空，读者应全量刷新
+***************************************************************************/
+const QVector<MetroChange>& MetroGraph::getChanges() const {
+    return changes;
+}
+
+/***************************************************************************
+  函数名称：MetroGraph::getLineTopology
+  功    能：获取线路拓扑
+  输入参数：
+  返 回 值：const LineTopology& - 本版本的线路拓扑
+  说    明：首次调用时构建并缓存，之后直接返回；已发布的版本不再修改，
+            多个线程同时首次调用时各自构建，只保留先写入的一份
+***************************************************************************/
+const LineTopology& MetroGraph::getLineTopology() const {
+    std::shared_ptr<const LineTopology> cached = std::atomic_load(&lineTopology);
+    if (!cached) {
+        std::shared_ptr<const LineTopology> built = buildLineTopology();
+        if (std::atomic_compare_exchange_strong(&lineTopology, &cached, built)) {
+            cached = built;
+        }
+    }
+    return *cached;
+}
+
+/***************************************************************************
+  函数名称：MetroGraph::getLandmarks
+  功    能：获取地标表
+  输入参数：
+  返 回 值：const LandmarkTable& - 本版本的地标表
+  说    明：与线路拓扑相同，首次调用时构建并缓存；从快照加载时直接取用快照中
+            保存的表，图被修改后清空，下次调用时按新版本重新构建
+***************************************************************************/
+const LandmarkTable& MetroGraph::getLandmarks() const {
+    std::shared_ptr<const LandmarkTable> cached = std::atomic_load(&landmarkTable);
+    if (!cached) {
+        std::shared_ptr<const LandmarkTable> built = buildLandmarks();
+        if (std::atomic_compare_exchange_strong(&landmarkTable, &cached, built)) {
+            cached = built;
+        }
+    }
+    return *cached;
+}
+
+/***************************************************************************
+  函数名称：MetroGraph::getClosures
+  功    能：获取临时封闭
+  输入参数：
+  返 回 值：ClosureMaskPtr - 封闭位图，从未设置过封闭时为空指针
+  说    明：封闭由MetroGraphStore在已发布的版本上整体替换，不改变版本号，
+            是版本不可变约定的例外；同一版本先后调用可能得到不同的位图，
+            调用方在一次搜索中应只取一次并持有，以免搜索中途看到不同的封闭情况
+***************************************************************************/
+ClosureMaskPtr MetroGraph::getClosures() const {
+    return std::atomic_load(&closureMask);
+}
+
+/***************************************************************************
+  函数名称：MetroGraph::compileClosures
+  功    能：按封闭的车站和区间生成本版本的位图
+  输入参数：const ClosureMask& spec - 封闭的车站、区间和修改次数，位图被忽略
+  返 回 值：std::shared_ptr<const ClosureMask> - 带本版本出边位图的封闭
+  说    明：车站封闭时其全部出边和入边都置位，搜索只需检查出边位图；
+            区间的两个方向分别置位。出边下标随版本变化，编辑发布新版本后
+            须重新生成；编号超出本版本范围的车站和区间被忽略
+***************************************************************************/
+std::shared_ptr<const ClosureMask> MetroGraph::compileClosures(const ClosureMask& spec) const {
+    std::shared_ptr<ClosureMask> mask = std::make_shared<ClosureMask>();
+    mask->stations   = spec.stations;
+    mask->segments   = spec.segments;
+    mask->generation = spec.generation;
+    mask->reopened   = spec.reopened;
+    if (spec.stations.isEmpty() && spec.segments.isEmpty()) {
+        return mask;
+    }
+
+    const int stationCount = stations.size();
+    mask->edgeBits.fill(0, (csr.targets.size() + 31) / 32);
+    mask->stationBits.fill(0, (stationCount + 31) / 32);
+    auto closeEdge = [&](int e) { mask->edgeBits[e >> 5] |= 1u << (e & 31); };
+
+    for (StationId id : spec.stations) {
+        if (id >= static_cast<StationId>(stationCount)) {
+            continue;
+        }
+        mask->stationBits[id >> 5] |= 1u << (id & 31);
+        for (int e = csr.offsets[id]; e < csr.offsets[id + 1]; e++) {
+            closeEdge(e);
+            const StationId neighbor = csr.targets[e];
+            for (int r = csr.offsets[neighbor]; r < csr.offsets[neighbor + 1]; r++) {
+                if (csr.targets[r] == id) {
+                    closeEdge(r);
+                }
+            }
+        }
+    }
+
+    for (const ClosedSegment& segment : spec.segments) {
+        if (segment.id1 >= static_cast<StationId>(stationCount) || segment.id2 >= static_cast<StationId>(stationCount)) {
+            continue;
+        }
+        for (int e = csr.offsets[segment.id1]; e < csr.offsets[segment.id1 + 1]; e++) {
+            if (csr.targets[e] == segment.id2 && (segment.line == INVALID_ID || csr.lines[e] == segment.line)) {
+                closeEdge(e);
+            }
+        }
+        for (int e = csr.offsets[segment.id2]; e < csr.offsets[segment.id2 + 1]; e++) {
+            if (csr.targets[e] == segment.id1 && (segment.line == INVALID_ID || csr.lines[e] == segment.line)) {
+                closeEdge(e);
+            }
+        }
+    }
+    return mask;
+}
+
+/***************************************************************************
+  函数名称：ClosureMask::isEmpty
+  功    能：判断是否没有任何封闭
+  输入参数：
+  返 回 值：bool - 没有封闭的车站和区间时为true
+  说    明：
+***************************************************************************/
+bool ClosureMask::isEmpty() const {
+    return edgeBits.isEmpty();
+}
+
+/***************************************************************************
+  函数名称：ClosureMask::isStationClosed
+  功    能：判断车站是否封闭
+  输入参数：StationId id - 站点编号
+  返 回 值：bool - 是否封闭
+  说    明：
+***************************************************************************/
+bool ClosureMask::isStationClosed(StationId id) const {
+    return id < static_cast<StationId>(stationBits.size()) * 32 && ((stationBits[id >> 5] >> (id & 31)) & 1u);
+}
+
+/***************************************************************************
+  函数名称：ClosureMask::isSegmentClosed
+  功    能：判断相邻两站间某线路上的区间是否不可通行
+  输入参数：StationId id1 - 站点1编号
+            StationId id2 - 站点2编号
+            LineId line   - 线路编号
+  返 回 值：bool - 区间封闭或任一端车站封闭时为true
+  说    明：按封闭的区间列表判断，不依赖出边下标，可用于检查以站点和线路
+            表示的已有路径；封闭的区间通常只有几处，逐条比较即可
+***************************************************************************/
+bool ClosureMask::isSegmentClosed(StationId id1, StationId id2, LineId line) const {
+    if (isStationClosed(id1) || isStationClosed(id2)) {
+        return true;
+    }
+    for (const ClosedSegment& segment : segments) {
+        const bool samePair = (segment.id1 == id1 && segment.id2 == id2) || (segment.id1 == id2 && segment.id2 == id1);
+        if (samePair && (segment.line == INVALID_ID || segment.line == line)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/***************************************************************************
+  函数名称：MetroGraph::buildLandmarks
+  功    能：选取地标并计算到各站的最短里程和最少区间数
+  输入参数：
+  返 回 值：std::shared_ptr<const LandmarkTable> - 构建结果
+  说    明：按最远点选取：第一个地标是离任一有出边站点最远的站，之后每次取
+            离已选地标最近距离最大的站，不可达的站视为无穷远，因而各连通块
+            都会分到地标；地图是无向的，地标到各站与各站到地标的值相同，
+            每个地标只需一次Dijkstra和一次BFS
+***************************************************************************/
+std::shared_ptr<const LandmarkTable> MetroGraph::buildLandmarks() const {
+    std::shared_ptr<LandmarkTable> table = std::make_shared<LandmarkTable>();
+    const int stationCount = stations.size();
+    if (csr.offsets.size() != stationCount + 1) {
+        return table;
+    }
+
+    QVector<StationId> candidates;
+    for (StationId id = 0; id < static_cast<StationId>(stationCount); id++) {
+        if (csr.offsets[id + 1] > csr.offsets[id]) {
+            candidates.append(id);
+        }
+    }
+    if (candidates.isEmpty()) {
+        return table;
+    }
+    const int landmarkCount = qMin(int(LandmarkTable::MAX_LANDMARKS), candidates.size());
+
+    /* 单源Dijkstra，不可达为-1*/
+    std::vector<std::pair<double, StationId>> heap;
+    auto shortestDistances = [&](StationId source, QVector<double>& dist) {
+        dist.fill(-1, stationCount);
+        dist[source] = 0;
+        heap.clear();
+        heap.push_back(std::make_pair(0.0, source));
+        while (!heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end(), std::greater<std::pair<double, StationId>>());
+            const std::pair<double, StationId> top = heap.back();
+            heap.pop_back();
+            if (top.first > dist[top.second]) {
+                continue; // 过期条目
+            }
+            for (int e = csr.offsets[top.second]; e < csr.offsets[top.second + 1]; e++) {
+                const StationId neighbor = csr.targets[e];
+                const double    alt      = top.first + csr.weights[e];
+                if (dist[neighbor] < 0 || alt < dist[neighbor]) {
+                    dist[neighbor] = alt;
+                    heap.push_back(std::make_pair(alt, neighbor));
+                    std::push_heap(heap.begin(), heap.end(), std::greater<std::pair<double, StationId>>());
+                }
+            }
+        }
+    };
+
+    /* 最远点选取地标*/
+    QVector<double> dist;
+    QVector<double> nearest(stationCount, -1); //离已选地标的最近距离，-1表示均不可达
+    shortestDistances(candidates.first(), dist);
+    StationId next = candidates.first();
+    for (StationId id : candidates) {
+        if (dist[id] > dist[next]) {
+            next = id;
+        }
+    }
+
+    QVector<QVector<double>> landmarkDistances;
+    while (table->landmarks.size() < landmarkCount) {
+        table->landmarks.append(next);
+        shortestDistances(next, dist);
+        landmarkDistances.append(dist);
+
+        next = INVALID_ID;
+        for (StationId id : candidates) {
+            if (dist[id] >= 0 && (nearest[id] < 0 || dist[id] < nearest[id])) {
+                nearest[id] = dist[id];
+            }
+            if (table->landmarks.contains(id)) {
+                continue;
+            }
+            if (next == INVALID_ID || (nearest[next] >= 0 && (nearest[id] < 0 || nearest[id] > nearest[next]))) {
+                next = id;
+            }
+        }
+    }
+
+    /* 按站点连续存放各地标的里程，并逐个地标BFS得到区间数*/
+    table->distances.resize(stationCount * landmarkCount);
+    table->hops.fill(-1, stationCount * landmarkCount);
+    QVector<StationId> queue;
+    for (int l = 0; l < landmarkCount; l++) {
+        for (int id = 0; id < stationCount; id++) {
+            table->distances[id * landmarkCount + l] = landmarkDistances[l][id];
+        }
+
+        queue.clear();
+        queue.append(table->landmarks[l]);
+        table->hops[table->landmarks[l] * landmarkCount + l] = 0;
+        for (int head = 0; head < queue.size(); head++) {
+            const StationId current = queue[head];
+            const qint32    depth   = table->hops[current * landmarkCount + l] + 1;
+            for (int e = csr.offsets[current]; e < csr.offsets[current + 1]; e++) {
+                qint32& hop = table->hops[csr.targets[e] * landmarkCount + l];
+                if (hop < 0) {
+                    hop = depth;
+                    queue.append(csr.targets[e]);
+                }
+            }
+        }
+    }
+    return table;
+}
+
+/***************************************************************************
+  函数名称：MetroGraph::buildLineTopology
+  功    能：构建线路拓扑
+  输入参数：
+  返 回 值：std::shared_ptr<const LineTopology> - 构建结果
+  说    明：逐条线路识别形状和走向
+***************************************************************************/
+std::shared_ptr<const LineTopology> MetroGraph::buildLineTopology() const {
+    std::shared_ptr<LineTopology> topology = std::make_shared<LineTopology>();
+    const int lineCount = lines.size();
+    topology->shapes.fill(LineTopology::EmptyLine, lineCount);
+    topology->routes.resize(lineCount);
+    topology->stationOrder.resize(lineCount);
+
+    for (LineId line = 0; line < static_cast<LineId>(lineCount); line++) {
+        buildLineRoutes(line, *topology);
+    }
+    return topology;
+}
+
+/***************************************************************************
+  函数名称：MetroGraph::buildLineRoutes
+  功    能：构建一条线路的形状、走向和站点顺序
+  输入参数：LineId line           - 线路编号
+            LineTopology& topology - 写入结果的线路拓扑
+  返 回 值：
+  说    明：只看该线路自身的(站点, 线路)分组。无环时每对端点之间取一条走向，
+            端点按编号升序配对；单一的环从编号最小的站点出发绕行一周；
+            其他含环的情况不生成走向，沿线路的查询退回到搜索
+***************************************************************************/
+void MetroGraph::buildLineRoutes(LineId line, LineTopology& topology) const {
+    const QVector<StationId>& stationsOnLine = lineStationIndex[line];
+    if (stationsOnLine.isEmpty()) {
+        return;
+    }
+
+    /* 同线度数：站点在该线路上的相邻站数*/
+    auto lineNeighbors = [this, line](StationId station, int& begin, int& end) {
+        int group = findLineGroup(station, line);
+        begin = csr.groupEdgeOffsets[group];
+        end   = csr.groupEdgeOffsets[group + 1];
+    };
+
+    /* 找出端点、分支点，并按连通分量编号*/
+    QVector<StationId>    branchPoints; //连接三个及以上同线站点的站点
+    QVector<StationId>    endpoints;
+    QHash<StationId, int> component;
+    int edgeCount      = 0;
+    int componentCount = 0;
+    for (StationId station : stationsOnLine) {
+        int begin, end;
+        lineNeighbors(station, begin, end);
+        edgeCount += end - begin;
+        if (end - begin == 1) {
+            endpoints.append(station);
+        }
+        else if (end - begin > 2) {
+            branchPoints.append(station);
+        }
+
+        if (component.contains(station)) {
+            continue;
+        }
+        QVector<StationId> queue;
+        queue.append(station);
+        component.insert(station, componentCount);
+        for (int head = 0; head < queue.size(); head++) {
+            lineNeighbors(queue[head], begin, end);
+            for (int k = begin; k < end; k++) {
+                StationId neighbor = csr.targets[csr.groupEdges[k]];
+                if (!component.contains(neighbor)) {
+                    component.insert(neighbor, componentCount);
+                    queue.append(neighbor);
+                }
+            }
+        }
+        componentCount++;
+    }
+    edgeCount /= 2;
+
+    /* 由站点序列生成走向，累计里程*/
+    QVector<LineRoute>& routes = topology.routes[line];
+    auto appendRoute = [&](const QVector<StationId>& sequence, bool loop) {
+        LineRoute route;
+        route.stations = sequence;
+        route.loop     = loop;
+        route.distances.resize(sequence.size());
+        route.index.reserve(sequence.size());
+        double distance = 0;
+        for (int i = 0; i < sequence.size(); i++) {
+            if (i > 0) {
+                distance += lineEdgeWeight(sequence[i - 1], sequence[i], line);
+            }
+            route.distances[i] = distance;
+            route.index.insert(sequence[i], i);
+        }
+        route.length = loop ? distance + lineEdgeWeight(sequence.last(), sequence.first(), line) : distance;
+        routes.append(route);
+    };
+
+    if (edgeCount == stationsOnLine.size() - componentCount) {
+        /* 无环：每对同一分量内的端点之间为一条走向*/
+        topology.shapes[line] = branchPoints.isEmpty() ? LineTopology::LinearLine : LineTopology::BranchedLine;
+        for (int i = 0; i < endpoints.size(); i++) {
+            QHash<StationId, StationId> parent;
+            QVector<StationId>          queue;
+            parent.insert(endpoints[i], INVALID_ID);
+            queue.append(endpoints[i]);
+            for (int head = 0; head < queue.size(); head++) {
+                int begin, end;
+                lineNeighbors(queue[head], begin, end);
+                for (int k = begin; k < end; k++) {
+                    StationId neighbor = csr.targets[csr.groupEdges[k]];
+                    if (!parent.contains(neighbor)) {
+                        parent.insert(neighbor, queue[head]);
+                        queue.append(neighbor);
+                    }
+                }
+            }
+
+            for (int j = i + 1; j < endpoints.size(); j++) {
+                if (!parent.contains(endpoints[j])) {
+                    continue;
+                }
+                QVector<StationId> sequence;
+                for (StationId node = endpoints[j]; node != INVALID_ID; node = parent.value(node)) {
+                    sequence.prepend(node);
+                }
+                appendRoute(sequence, false);
+            }
+        }
+    }
+    else if (componentCount == 1 && endpoints.isEmpty() && branchPoints.isEmpty()) {
+        /* 单一的环：从编号最小的站点出发，沿第一条出边绕行一周*/
+        topology.shapes[line] = LineTopology::LoopLine;
+        QVector<StationId> sequence;
+        StationId previous = INVALID_ID;
+        StationId current  = stationsOnLine.first();
+        do {
+            sequence.append(current);
+            int begin, end;
+            lineNeighbors(current, begin, end);
+            StationId next = csr.targets[csr.groupEdges[begin]];
+            if (next == previous) {
+                next = csr.targets[csr.groupEdges[begin + 1]];
+            }
+            previous = current;
+            current  = next;
+        } while (current != stationsOnLine.first());
+        appendRoute(sequence, true);
+    }
+    else {
+        topology.shapes[line] = LineTopology::IrregularLine;
+    }
+
+    /* 站点顺序：依次取各走向上尚未出现的站点*/
+    QVector<StationId>& order = topology.stationOrder[line];
+    QSet<StationId>     seen;
+    for (const LineRoute& route : routes) {
+        for (StationId station : route.stations) {
+            if (!seen.contains(station)) {
+                seen.insert(station);
+                order.append(station);
+            }
+        }
+    }
+    if (routes.isEmpty()) {
+        order = stationsOnLine;
+    }
+}
+
+/***************************************************************************
+  函数名称：MetroGraph::lineEdgeWeight
+  功    能：获取同一线路上相邻两站的里程
+  输入参数：StationId from - 站点1编号
+            StationId to   - 站点2编号
+            LineId line    - 线路编号
+  返 回 值：double - 里程（公里），两站在该线路上不相邻时为0
+  说    明：
+***************************************************************************/
+double MetroGraph::lineEdgeWeight(StationId from, StationId to, LineId line) const {
+    int group = findLineGroup(from, line);
+    if (group < 0) {
+        return 0;
+    }
+    for (int k = csr.groupEdgeOffsets[group]; k < csr.groupEdgeOffsets[group + 1]; k++) {
+        int edge = csr.groupEdges[k];
+        if (csr.targets[edge] == to) {
+            return csr.weights[edge];
+        }
+    }
+    return 0;
+}
+
+/***************************************************************************
+  函数名称：MetroGraph::locateOnLine
+  功    能：找到同时包含两站的走向并确定行进方向
+  输入参数：LineId line    - 线路编号
+            StationId from - 起点编号
+            StationId to   - 终点编号
+            int& fromIndex - 输出起点在走向中的位置
+            int& toIndex   - 输出终点在走向中的位置
+            bool& forward  - 输出是否沿走向正向行进
+  返 回 值：const LineRoute* - 找到的走向，两站不在同一走向上时为空指针
+  说    明：环线取经过站数较少的方向，站数相同时取里程较短的方向
+***************************************************************************/
+const LineRoute* MetroGraph::locateOnLine(LineId line, StationId from, StationId to,
+                                          int& fromIndex, int& toIndex, bool& forward) const {
+    const LineTopology& topology = getLineTopology();
+    if (line >= static_cast<LineId>(topology.routes.size())) {
+        return nullptr;
+    }
+
+    for (const LineRoute& route : topology.routes[line]) {
+        fromIndex = route.index.value(from, -1);
+        toIndex   = route.index.value(to, -1);
+        if (fromIndex < 0 || toIndex < 0) {
+            continue;
+        }
+
+        if (!route.loop) {
+            forward = fromIndex <= toIndex;
+        }
+        else {
+            const int n            = route.stations.size();
+            const int forwardHops  = (toIndex - fromIndex + n) % n;
+            const int backwardHops = (n - forwardHops) % n;
+            if (forwardHops != backwardHops) {
+                forward = forwardHops < backwardHops;
+            }
+            else {
+                double forwardDistance = route.distances[toIndex] - route.distances[fromIndex];
+                if (forwardDistance < 0) {
+                    forwardDistance += route.length;
+                }
+                forward = forwardDistance * 2 <= route.length;
+            }
+        }
+        return &route;
+    }
+    return nullptr;
+}
+
+/***************************************************************************
+  函数名称：MetroGraph::getLinePath
+  功    能：沿线路从一站到另一站经过的站点
+  输入参数：LineId line    - 线路编号
+            StationId from - 起点编号
+            StationId to   - 终点编号
+  返 回 值：QVector<StationId> - 含两端的站点序列；两站不在同一走向上
+            （不在该线路上、位于不连通的两段或线路形状不规则）时为空
+  说    明：按走向中的位置截取，不做搜索
+***************************************************************************/
+QVector<StationId> MetroGraph::getLinePath(LineId line, StationId from, StationId to) const {
+    QVector<StationId> path;
+    int  fromIndex, toIndex;
+    bool forward;
+    const LineRoute* route = locateOnLine(line, from, to, fromIndex, toIndex, forward);
+    if (route == nullptr) {
+        return path;
+    }
+
+    const int n    = route->stations.size();
+    const int step = forward ? 1 : -1;
+    const int hops = route->loop ? (step * (toIndex - fromIndex) + n) % n : std::abs(toIndex - fromIndex);
+    path.reserve(hops + 1);
+    for (int k = 0, i = fromIndex; k <= hops; k++, i = (i + step + n) % n) {
+        path.append(route->stations[i]);
+    }
+    return path;
+}
+
+/***************************************************************************
+  函数名称：MetroGraph::getLineDistance
+  功    能：沿线路两站间的里程
+  输入参数：LineId line    - 线路编号
+            StationId from - 起点编号
+            StationId to   - 终点编号
+  返 回 值：double - 里程（公里），两站不在同一走向上时为-1
+  说    明：由累计里程相减得到，方向与getLinePath一致
+***************************************************************************/
+double MetroGraph::getLineDistance(LineId line, StationId from, StationId to) const {
+    int  fromIndex, toIndex;
+    bool forward;
+    const LineRoute* route = locateOnLine(line, from, to, fromIndex, toIndex, forward);
+    if (route == nullptr) {
+        return -1;
+    }
+
+    double distance = route->distances[toIndex] - route->distances[fromIndex];
+    if (!route->loop) {
+        return std::abs(distance);
+    }
+    if (distance < 0) {
+        distance += route->length;
+    }
+    return forward || distance == 0 ? distance : route->length - distance;
+}
+/*MetroGraph.cpp*/
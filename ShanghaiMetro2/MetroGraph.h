@@ -8,12 +8,20 @@
 #define METROGRAPH_H
 
 #include <QString>
+#include <QByteArray>
 #include <QVector>
 #include <QPoint>
 #include <QColor>
 #include <QMap>
-#include <QJsonObject>
 #include <QSet>
+#include <QHash>
+#include <cstdint>
+#include <memory>
+
+/*稠密整数编号：站点和线路名称在加载时被映射为连续的编号*/
+typedef uint32_t StationId; //站点编号
+typedef uint32_t LineId;    //线路编号
+const uint32_t INVALID_ID = 0xFFFFFFFFu; //无效编号
 
 /*地铁线路信息*/
 struct MetroLine {
@@ -27,6 +35,9 @@ struct StationConnection {
     QString         station2;  //站点名称2
 	QString         line;      //连接线路
     QVector<QPoint> viaPoints; //连接线的拐点
+    StationId       id1    = INVALID_ID; //站点1编号
+    StationId       id2    = INVALID_ID; //站点2编号
+    LineId          lineId = INVALID_ID; //线路编号
 };
 
 /*地铁站点信息*/
@@ -39,24 +50,166 @@ struct Station {
     QVector<QString> connectedStations; //连接的站点名称
 };
 
+/*站点的一条出边（按编号表示）*/
+struct StationEdge {
+    StationId to;   //相邻站点编号
+    LineId    line; //所在线路编号
+};
+
+/*地铁图的一次变更，随新版本一同发布*/
+struct MetroChange {
+    enum Type {
+        StationAdded,   //新增站点station1
+        LineAdded,      //新增线路line
+        ConnectionAdded //在线路line上连接station1和station2
+    };
+    Type      type;                  //变更类型
+    StationId station1 = INVALID_ID; //相关站点1
+    StationId station2 = INVALID_ID; //相关站点2
+    LineId    line     = INVALID_ID; //相关线路
+};
+
+/*压缩稀疏行(CSR)格式的只读邻接结构*/
+struct MetroCsr {
+    QVector<int>       offsets; //站点i的出边位于[offsets[i], offsets[i+1])
+    QVector<StationId> targets; //出边终点编号，同一站点内按名称有序
+    QVector<LineId>    lines;   //出边线路编号
+    QVector<double>    weights; //出边长度（公里）
+
+    /*按(站点, 线路)分组的出边索引，用于沿线路行走和换乘判断*/
+    QVector<int>       groupOffsets;     //站点i的线路分组位于[groupOffsets[i], groupOffsets[i+1])
+    QVector<LineId>    groupLines;       //分组对应的线路编号，同一站点内按编号升序
+    QVector<int>       groupEdgeOffsets; //分组g的出边位于groupEdges[groupEdgeOffsets[g], groupEdgeOffsets[g+1])
+    QVector<int>       groupEdges;       //出边在targets等数组中的下标
+};
+
+/*线路上的一条走向：两个端点之间（环线为绕行一周）按轨道顺序排列的站点*/
+struct LineRoute {
+    QVector<StationId>    stations;  //按轨道顺序排列的站点
+    QVector<double>       distances; //distances[i]为stations[0]到stations[i]的累计里程（公里）
+    QHash<StationId, int> index;     //站点在stations中的位置
+    bool                  loop = false; //是否环线，环线的最后一站与第一站相连
+    double                length = 0;   //全程里程，环线包含闭合的一段
+};
+
+/*线路拓扑：各线路的形状、走向和站点顺序，每个版本只计算一次*/
+struct LineTopology {
+    /*线路形状*/
+    enum Shape {
+        EmptyLine,    //没有连接
+        LinearLine,   //无分支的直线
+        BranchedLine, //有分支点的树形线路，每对端点之间为一条走向
+        LoopLine,     //环线
+        IrregularLine //含环且有分支，只能搜索
+    };
+
+    QVector<Shape>                 shapes;        //每条线路的形状
+    QVector<QVector<LineRoute>>    routes;        //每条线路的走向，同一线路上任意两站至少同在一条走向上
+    QVector<QVector<StationId>>    stationOrder;  //每条线路的站点，先按第一条走向的顺序，再补充其余走向上的站点
+};
+
+/*地标表：若干地标站到各站的最短里程和最少区间数，用作目标导向搜索的下界*/
+struct LandmarkTable {
+    static const int MAX_LANDMARKS = 16; //地标数量上限
+
+    QVector<StationId> landmarks; //地标站编号
+    QVector<double>    distances; //按[station * 地标数 + 地标序号]存放的最短里程，不可达为-1
+    QVector<qint32>    hops;      //按[station * 地标数 + 地标序号]存放的最少区间数，不可达为-1
+};
+
+/*封闭的区间：两站之间一条线路上的一段，两个方向同时停运*/
+struct ClosedSegment {
+    StationId id1;  //站点1编号
+    StationId id2;  //站点2编号
+    LineId    line; //线路编号，INVALID_ID表示两站间的全部线路
+};
+
+/*临时封闭：不改变图的结构和版本号，搜索时按位图跳过封闭的出边*/
+struct ClosureMask {
+    QVector<StationId>     stations;       //封闭的车站，不能进出也不能通过
+    QVector<ClosedSegment> segments;       //封闭的区间
+    quint64                generation = 0; //封闭情况的修改次数，每次修改递增，跨版本延续
+    quint64                reopened   = 0; //最近一次恢复（封闭范围缩小）时的generation
+    QVector<quint32>       edgeBits;       //按CSR出边下标的位图，出边所在区间封闭或任一端车站封闭时置位，没有封闭时为空
+    QVector<quint32>       stationBits;    //按站点编号的位图，车站封闭时置位，没有封闭时为空
+
+    bool isEmpty() const;                                                  //是否没有任何封闭
+    bool isEdgeClosed(int edge) const;                                     //CSR出边是否封闭
+    bool isStationClosed(StationId id) const;                              //车站是否封闭
+    bool isSegmentClosed(StationId id1, StationId id2, LineId line) const; //相邻两站间某线路上的区间是否不可通行（含两端车站封闭）
+};
+
+/*搜索的内层循环逐边调用，定义在头文件中以便内联*/
+inline bool ClosureMask::isEdgeClosed(int edge) const {
+    return (edgeBits[edge >> 5] >> (edge & 31)) & 1u;
+}
+
+/*只读的封闭位图，整体替换，搜索中持有即固定*/
+typedef std::shared_ptr<const ClosureMask> ClosureMaskPtr;
+
+class JsonStreamReader;
+class MetroGraph;
+
+/*不可变的地铁图版本，读者持有即固定该版本；唯一的例外是临时封闭，见closureMask*/
+typedef std::shared_ptr<const MetroGraph> MetroGraphPtr;
+
 /*地铁网络图*/
 class MetroGraph {
 public:
-    MetroGraph();  //构造函数
-    ~MetroGraph(); //析构函数
+    MetroGraph();                                 //构造函数
+    MetroGraph(const MetroGraph& other);          //复制构造函数，原子地读取其他线程可能写入的缓存
+    MetroGraph& operator=(const MetroGraph&) = delete; //已发布的版本不可整体赋值
+    ~MetroGraph();                                //析构函数
 
-    bool loadFromJson(const QString& filename); //加载数据
+    bool loadFromJson(const QString& filename);                                   //加载数据
+    bool loadWithSnapshot(const QString& filename, const QString& snapshotFilename); //优先从二进制快照加载数据
+    quint64 getVersion() const;                                                   //获取版本号
 
 	/*向外提供的接口*/
-    QVector<MetroLine>              getLines()                                                      const;//获取全部路线
-	QVector<Station>                getStations()                                                   const;//获取全部站点
-	Station                         getStation(const QString& name)                                 const;//获取指定站点
+    const QVector<MetroLine>&       getLines()                                                      const;//获取全部路线
+	const QVector<Station>&         getStations()                                                   const;//获取全部站点
+	const Station&                  getStation(const QString& name)                                 const;//获取指定站点
+	const Station*                  findStation(const QString& name)                                const;//查找指定站点，不存在时为空指针
 	QVector<QString>                getStationNames()                                               const;//获取站点名称列表
-    QVector<StationConnection>      getConnections()                                                const;//获取全部连接
-	StationConnection               getConnection(const QString& station1, const QString& station2) const;//获取指定连接
+    const QVector<StationConnection>& getConnections()                                              const;//获取全部连接
+	const StationConnection&        getConnection(const QString& station1, const QString& station2) const;//获取指定连接
+	const StationConnection&        getConnection(const QString& station1, const QString& station2,
+                                                  const QString& line)                              const;//获取指定线路上的连接
+	const StationConnection*        findConnection(StationId id1, StationId id2,
+                                                   LineId line = INVALID_ID)                        const;//查找两站间的连接，不存在时为空指针
     bool                            hasStation(const QString& name)                                 const;//检查站点是否存在
     QMap<QString, QVector<QString>> getLineStations()                                               const;//获取每条线路的站点列表
 
+    /*基于编号的接口*/
+    int                             getStationCount()                                               const;//获取站点数量
+    int                             getLineCount()                                                  const;//获取线路数量
+    StationId                       getStationId(const QString& name)                               const;//站点名称转编号
+    LineId                          getLineId(const QString& name)                                  const;//线路名称转编号
+    const QString&                  getStationName(StationId id)                                    const;//站点编号转名称
+    const QString&                  getLineName(LineId id)                                          const;//线路编号转名称
+    const Station&                  getStationById(StationId id)                                    const;//根据编号获取站点
+    const QVector<StationEdge>&     getStationEdges(StationId id)                                   const;//获取站点的全部出边
+    const QVector<StationId>&       getLineStationIds(LineId line)                                  const;//获取线路上的站点编号（按编号升序）
+    const MetroCsr&                 getCsr()                                                        const;//获取CSR邻接结构
+    int                             findLineGroup(StationId station, LineId line)                   const;//获取站点在某线路上的出边分组
+    QVector<LineId>                 getLinesBetween(StationId id1, StationId id2)                   const;//获取两站间的全部线路编号
+    double                          calculateDistance(StationId id1, StationId id2)                 const;//计算两站间距离（公里）
+    QByteArray                      getEdgeHash()                                                   const;//计算CSR出边的哈希，用于校验随数据保存的索引
+
+    /*派生索引：站点线路、换乘标记、排序和最近站点查询随修改只按改动的站点维护；
+      线路拓扑和地标表在修改后作废，下次使用时按全图重建*/
+    QVector<LineId>                 getStationLineIds(StationId id)                                 const;//获取站点所在的线路编号
+    bool                            isTransferStation(StationId id)                                 const;//站点是否连接多条线路
+    const QVector<StationId>&       getSortedStationIds()                                           const;//获取按名称排序的站点编号
+    int                             getSortedIndex(StationId id)                                    const;//获取站点在排序列表中的位置
+    StationId                       findNearestStation(const QPoint& pos, double maxDistance)       const;//查找图上距离某点最近的站点
+    const QVector<MetroChange>&     getChanges()                                                    const;//获取产生本版本的变更
+    const LineTopology&             getLineTopology()                                               const;//获取线路拓扑，首次调用时构建并缓存
+    const LandmarkTable&            getLandmarks()                                                  const;//获取地标表，首次调用时构建并缓存
+    ClosureMaskPtr                  getClosures()                                                   const;//获取临时封闭，从未设置过时为空指针
+    QVector<StationId>              getLinePath(LineId line, StationId from, StationId to)          const;//沿线路从一站到另一站经过的站点，不可直达时为空
+    double                          getLineDistance(LineId line, StationId from, StationId to)      const;//沿线路两站间的里程，不可直达时为-1
+
     /*添加方法*/
     bool addLine(const MetroLine& line);                                           //添加线路
     bool addStation(const Station& station);                                       //添加站点
@@ -64,18 +217,56 @@ public:
         const QString& line, const QVector<QPoint>& viaPoints = QVector<QPoint>());//添加连接
 
 private:
+    friend class MetroSnapshot;   //快照读写直接访问内部存储
+    friend class MetroGraphStore; //版本仓库发布时写入版本号并重置变更列表
+
     /*内部存储数据结构*/
     QVector<MetroLine>                               lines;         //路线信息
     QVector<Station>                                 stations;      //站点信息
     QVector<StationConnection>                       connections;   //连接信息
-    QMap<QString, Station>                           stationMap;    //站点与名称映射表
-    QMap<QPair<QString, QString>, StationConnection> connectionMap; //连接映射表
-
-    /*根据数组解析信息及构建映射方法*/
-	void parseLines(const QJsonArray& linesArray);         // 解析线路信息
-    void parseStations(const QJsonArray& stationsArray);   // 解析站点信息
-	void parseConnections(const QJsonArray& stationsArray);// 解析连接信息
-    void buildStationMap();                                // 构建站点映射
+    QHash<QString, StationId>                        stationIds;    //站点名称到编号的映射
+    QHash<QString, LineId>                           lineIds;       //线路名称到编号的映射
+    QHash<quint64, QVector<int>>                     connectionMap; //站点编号对到各线路连接下标的映射
+    QVector<QVector<StationEdge>>                    adjacency;     //按编号索引的邻接表
+    MetroCsr                                         csr;           //由邻接表冻结得到的CSR结构
+    quint64                                          version;       //由MetroGraphStore发布时分配的版本号
+    QVector<MetroChange>                             changes;       //相对上一版本的变更
+
+    /*派生索引*/
+    QVector<QVector<StationId>>                      lineStationIndex; //线路到站点编号（升序）
+    QVector<bool>                                    transferFlags;    //按站点编号索引的换乘站标记
+    QHash<quint64, QVector<StationId>>               spatialGrid;      //图上坐标网格到站点编号
+    QVector<StationId>                               sortedStationIds; //按名称排序的站点编号
+    mutable std::shared_ptr<const LineTopology>      lineTopology;     //线路拓扑缓存，图被修改时清空
+    mutable std::shared_ptr<const LandmarkTable>     landmarkTable;    //地标表缓存，图被修改时清空
+    /*临时封闭：有意不随版本固定，是已发布版本上唯一会被改动的成员。封闭频繁且只影响
+      可走的出边，为它复制整张图并发布新版本代价过大，因此由MetroGraphStore在当前
+      版本上原子地整体替换；位图本身只读，读者每次搜索取一次即固定*/
+    mutable std::shared_ptr<const ClosureMask>       closureMask;      //临时封闭，只通过原子操作读写
+
+    /*流式解析信息及构建映射方法*/
+    struct JsonLoadState;                                                  // 流式加载的临时状态
+    bool parseLine(JsonStreamReader& reader, JsonLoadState& state);        // 解析一条线路信息
+    bool parseStation(JsonStreamReader& reader, JsonLoadState& state);     // 解析一个站点及其出边
+    bool parseEdges(JsonStreamReader& reader, JsonLoadState& state);       // 解析站点的出边数组
+    void linkPendingEdges(JsonLoadState& state);                           // 将读取到的出边加入连接表
+    LineId  internLine(const QString& name);               // 获取线路编号，不存在时登记
+    void    linkStations(StationId id1, StationId id2, LineId line); // 在邻接表中加入一条双向边
+    static quint64 pairKey(StationId id1, StationId id2);  // 生成无序站点编号对的键
+    int     findConnectionIndex(StationId id1, StationId id2, LineId line) const; // 查找指定线路上的连接下标
+    void    buildCsr();                                    // 由邻接表构建CSR结构
+    void    sortViaPoints(StationConnection& connection) const; // 按到站点1的距离排列转折点
+    void    insertCsrEdge(StationId from, StationId to, LineId line); // 将邻接表中新加的一条出边插入CSR结构
+    void    buildDerivedIndices();                         // 全量构建派生索引
+    void    indexStation(StationId id);                    // 将新站点加入空间网格和排序列表
+    static quint64 gridKey(const QPoint& pos);             // 坐标所在网格的键
+    std::shared_ptr<const LineTopology> buildLineTopology() const; // 构建线路拓扑
+    void    buildLineRoutes(LineId line, LineTopology& topology) const;   // 构建一条线路的形状和走向
+    std::shared_ptr<const LandmarkTable> buildLandmarks() const;   // 选取地标并计算到各站的里程和区间数
+    std::shared_ptr<const ClosureMask> compileClosures(const ClosureMask& spec) const; // 按封闭的车站和区间生成本版本的位图
+    double  lineEdgeWeight(StationId from, StationId to, LineId line) const; // 同一线路上相邻两站的里程
+    const LineRoute* locateOnLine(LineId line, StationId from, StationId to,
+                                  int& fromIndex, int& toIndex, bool& forward) const; // 找到同时包含两站的走向及行进方向
 };
 
 #endif // METROGRAPH_H
\ No newline at end of file
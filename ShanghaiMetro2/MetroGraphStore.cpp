@@ -0,0 +1,241 @@
+﻿/***************************************************************************
+  文件名称：MetroGraphStore.cpp
+  功    能：地铁图版本仓库的实现文件
+  说    明：MetroGraph内部的容器都是隐式共享的，复制一份版本只增加引用计数，
+            修改时只有被改动的容器才会真正分离
+***************************************************************************/
+
+#include "MetroGraphStore.h"
+#include <QMutexLocker>
+
+/***************************************************************************
+  函数名称：MetroGraphStore::MetroGraphStore
+  功    能：构造函数
+  输入参数：
+  返 回 值：
+  说    明：初始发布一个版本号为0的空图，读者总能拿到非空指针
+***************************************************************************/
+MetroGraphStore::MetroGraphStore() : head(std::make_shared<const MetroGraph>()) {
+}
+
+/***************************************************************************
+  函数名称：MetroGraphStore::current
+  功    能：获取当前版本
+  输入参数：
+  返 回 值：MetroGraphPtr - 当前版本的共享指针
+  说    明：可在任意线程调用；返回的版本不会再被修改
+***************************************************************************/
+MetroGraphPtr MetroGraphStore::current() const {
+    return std::atomic_load(&head);
+}
+
+/***************************************************************************
+  函数名称：MetroGraphStore::version
+  功    能：获取当前版本号
+  输入参数：
+  返 回 值：quint64 - 版本号
+  说    明：
+***************************************************************************/
+quint64 MetroGraphStore::version() const {
+    return current()->getVersion();
+}
+
+/***************************************************************************
+  函数名称：MetroGraphStore::load
+  功    能：加载地铁数据并发布为新版本
+  输入参数：const QString& filename         - 地铁数据Json文件名
+            const QString& snapshotFilename - 二进制快照文件名
+  返 回 值：bool - 是否加载成功，失败时当前版本保持不变
+  说    明：
+***************************************************************************/
+bool MetroGraphStore::load(const QString& filename, const QString& snapshotFilename) {
+    QMutexLocker locker(&writeMutex);
+
+    std::shared_ptr<MetroGraph> next = std::make_shared<MetroGraph>();
+    if (!next->loadWithSnapshot(filename, snapshotFilename)) {
+        return false;
+    }
+    QVector<Listener> targets = publish(next);
+    locker.unlock();
+
+    notify(targets, next);
+    return true;
+}
+
+/***************************************************************************
+  函数名称：MetroGraphStore::edit
+  功    能：在当前版本的副本上执行修改并发布
+  输入参数：const std::function<bool(MetroGraph&)>& change - 修改操作，返回是否发布
+  返 回 值：bool - 是否发布了新版本
+  说    明：写者之间互斥；修改期间读者继续使用旧版本，不受影响
+***************************************************************************/
+bool MetroGraphStore::edit(const std::function<bool(MetroGraph&)>& change) {
+    QMutexLocker locker(&writeMutex);
+
+    std::shared_ptr<MetroGraph> next = std::make_shared<MetroGraph>(*current());
+    next->changes.clear();
+    if (!change(*next)) {
+        return false;
+    }
+
+    /* 出边下标可能因新连接而移动，按新版本重新生成封闭位图*/
+    const ClosureMaskPtr closures = next->getClosures();
+    if (closures != nullptr) {
+        next->closureMask = next->compileClosures(*closures);
+    }
+    QVector<Listener> targets = publish(next);
+    locker.unlock();
+
+    notify(targets, next);
+    return true;
+}
+
+/***************************************************************************
+  函数名称：MetroGraphStore::subscribe
+  功    能：订阅新版本发布事件
+  输入参数：const Listener& listener - 回调，参数为新发布的版本
+  返 回 值：
+  说    明：回调在发布者的线程中、释放写锁之后调用，可在回调中读取仓库；
+            新版本的getChanges()给出相对上一版本的变更，为空时表示整体替换
+***************************************************************************/
+void MetroGraphStore::subscribe(const Listener& listener) {
+    QMutexLocker locker(&writeMutex);
+    listeners.append(listener);
+}
+
+/***************************************************************************
+  函数名称：MetroGraphStore::setStationClosed
+  功    能：封闭或恢复车站
+  输入参数：StationId station - 站点编号
+            bool closed       - true为封闭，false为恢复
+  返 回 值：bool - 封闭情况是否改变
+  说    明：封闭的车站不能进出也不能通过，到达和离开它的区间一并停运
+***************************************************************************/
+bool MetroGraphStore::setStationClosed(StationId station, bool closed) {
+    if (station >= static_cast<StationId>(current()->getStationCount())) {
+        return false;
+    }
+    return updateClosures([station, closed](ClosureMask& mask) {
+        const int index = mask.stations.indexOf(station);
+        if (closed == (index >= 0)) {
+            return false;
+        }
+        if (closed) {
+            mask.stations.append(station);
+        }
+        else {
+            mask.stations.remove(index);
+        }
+        return true;
+    });
+}
+
+/***************************************************************************
+  函数名称：MetroGraphStore::setSegmentClosed
+  功    能：封闭或恢复区间
+  输入参数：StationId id1 - 站点1编号
+            StationId id2 - 站点2编号
+            LineId line   - 线路编号，INVALID_ID表示两站间的全部线路
+            bool closed   - true为封闭，false为恢复
+  返 回 值：bool - 封闭情况是否改变，两站不相邻时为false
+  说    明：两个方向同时停运；恢复时须与封闭时给出相同的线路
+***************************************************************************/
+bool MetroGraphStore::setSegmentClosed(StationId id1, StationId id2, LineId line, bool closed) {
+    MetroGraphPtr graph = current();
+    if (graph->findConnection(id1, id2, line) == nullptr) {
+        return false;
+    }
+    return updateClosures([id1, id2, line, closed](ClosureMask& mask) {
+        int index = -1;
+        for (int k = 0; k < mask.segments.size(); k++) {
+            const ClosedSegment& segment = mask.segments[k];
+            if (segment.line == line && ((segment.id1 == id1 && segment.id2 == id2) || (segment.id1 == id2 && segment.id2 == id1))) {
+                index = k;
+                break;
+            }
+        }
+        if (closed == (index >= 0)) {
+            return false;
+        }
+        if (closed) {
+            mask.segments.append(ClosedSegment{ id1, id2, line });
+        }
+        else {
+            mask.segments.remove(index);
+        }
+        return true;
+    });
+}
+
+/***************************************************************************
+  函数名称：MetroGraphStore::clearClosures
+  功    能：恢复全部封闭
+  输入参数：
+  返 回 值：
+  说    明：
+***************************************************************************/
+void MetroGraphStore::clearClosures() {
+    updateClosures([](ClosureMask& mask) {
+        if (mask.stations.isEmpty() && mask.segments.isEmpty()) {
+            return false;
+        }
+        mask.stations.clear();
+        mask.segments.clear();
+        return true;
+    });
+}
+
+/***************************************************************************
+  函数名称：MetroGraphStore::updateClosures
+  功    能：修改封闭并替换当前版本的位图
+  输入参数：const std::function<bool(ClosureMask&)>& change - 修改封闭的车站和区间，返回是否有改变
+  返 回 值：bool - 是否有改变
+  说    明：与编辑互斥。在当前封闭的副本上修改，递增修改次数，封闭范围缩小
+            时记下恢复的修改次数供路径缓存判断；位图只按出边数和封闭处的度数
+            生成，不做任何搜索，完成后原子地替换，正在进行的搜索仍使用
+            开始时取得的位图
+***************************************************************************/
+bool MetroGraphStore::updateClosures(const std::function<bool(ClosureMask&)>& change) {
+    QMutexLocker   locker(&writeMutex);
+    MetroGraphPtr  graph    = current();
+    ClosureMaskPtr previous = graph->getClosures();
+    ClosureMask    spec     = previous != nullptr ? *previous : ClosureMask();
+    const int      before   = spec.stations.size() + spec.segments.size();
+    if (!change(spec)) {
+        return false;
+    }
+
+    spec.generation++;
+    if (spec.stations.size() + spec.segments.size() < before) {
+        spec.reopened = spec.generation;
+    }
+    std::atomic_store(&graph->closureMask, graph->compileClosures(spec));
+    return true;
+}
+
+/***************************************************************************
+  函数名称：MetroGraphStore::publish
+  功    能：为新版本编号并原子地替换当前版本
+  输入参数：const std::shared_ptr<MetroGraph>& next - 新版本
+  返 回 值：QVector<Listener> - 订阅者的副本，供释放写锁后通知
+  说    明：调用方需持有writeMutex
+***************************************************************************/
+QVector<MetroGraphStore::Listener> MetroGraphStore::publish(const std::shared_ptr<MetroGraph>& next) {
+    next->version = current()->getVersion() + 1;
+    std::atomic_store(&head, std::shared_ptr<const MetroGraph>(next));
+    return listeners;
+}
+
+/***************************************************************************
+  函数名称：MetroGraphStore::notify
+  功    能：通知订阅者
+  输入参数：const QVector<Listener>& targets - 订阅者
+            const MetroGraphPtr& graph        - 新发布的版本
+  返 回 值：
+  说    明：
+***************************************************************************/
+void MetroGraphStore::notify(const QVector<Listener>& targets, const MetroGraphPtr& graph) {
+    for (const Listener& listener : targets) {
+        listener(graph);
+    }
+}
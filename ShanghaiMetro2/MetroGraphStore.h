@@ -0,0 +1,50 @@
+﻿/***************************************************************************
+  文件名称：MetroGraphStore.h
+  功    能：地铁图版本仓库的头文件
+  说    明：地铁图以不可变的版本发布，读者持有某一版本的共享指针即可在
+            任意线程中安全读取；修改在当前版本的副本上进行，完成后原子地
+            替换为新版本，旧版本在最后一个读者释放后自动销毁。临时封闭车站或
+            区间是这一约定的唯一例外：不发布新版本，只原子地替换当前版本上的
+            封闭位图，持有该版本的各查找器下一次搜索即绕开封闭处；编辑发布
+            新版本时封闭随之延续
+***************************************************************************/
+
+#ifndef METROGRAPHSTORE_H
+#define METROGRAPHSTORE_H
+
+#include "MetroGraph.h"
+#include <QMutex>
+#include <QVector>
+#include <functional>
+#include <memory>
+
+/*地铁图版本仓库*/
+class MetroGraphStore {
+public:
+    typedef std::function<void(const MetroGraphPtr&)> Listener; //新版本发布后的回调
+
+    MetroGraphStore(); //构造函数，初始为空图
+
+    MetroGraphPtr current() const; //获取当前版本，持有返回值即固定该版本
+    quint64       version() const; //获取当前版本号
+
+    bool load(const QString& filename, const QString& snapshotFilename); //加载数据并发布为新版本
+    bool edit(const std::function<bool(MetroGraph&)>& change);           //在副本上修改并发布为新版本
+    void subscribe(const Listener& listener);                            //订阅新版本发布事件
+
+    bool setStationClosed(StationId station, bool closed);                        //封闭或恢复车站
+    bool setSegmentClosed(StationId id1, StationId id2, LineId line, bool closed); //封闭或恢复区间，line为INVALID_ID时包括两站间的全部线路
+    void clearClosures();                                                         //恢复全部封闭
+
+private:
+    std::shared_ptr<const MetroGraph> head;        //当前版本，只通过原子操作读写
+    QMutex                            writeMutex;  //串行化写者，同时保护listeners
+    QVector<Listener>                 listeners;   //订阅者
+
+    QVector<Listener> publish(const std::shared_ptr<MetroGraph>& next);        //发布新版本，返回需通知的订阅者
+    bool              updateClosures(const std::function<bool(ClosureMask&)>& change); //修改封闭并替换当前版本的位图
+    static void       notify(const QVector<Listener>& targets,
+                             const MetroGraphPtr& graph);                      //通知订阅者
+};
+
+#endif // METROGRAPHSTORE_H
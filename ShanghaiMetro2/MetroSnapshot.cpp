@@ -0,0 +1,537 @@
+﻿/***************************************************************************
+  文件名称：MetroSnapshot.cpp
+  功    能：地铁图二进制快照的实现文件
+  说    明：文件由定长文件头和若干按8字节对齐的定长数组段组成，
+            字符串统一存放在文件末尾的UTF-8名称表中，按本机字节序存储
+***************************************************************************/
+
+#include "MetroSnapshot.h"
+#include "MetroGraph.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QCryptographicHash>
+#include <QDebug>
+#include <cstring>
+
+namespace {
+
+const quint32 BYTE_ORDER_MARK = 0x01020304u; //用于识别字节序不同的文件
+const int     MAX_HASH_LENGTH = 32;          //文件头中哈希的最大长度
+
+/*文件头*/
+struct SnapshotHeader {
+    quint32 magic;                 //文件标识
+    quint32 version;               //格式版本
+    quint32 byteOrder;             //字节序标记
+    quint32 hashLength;            //源JSON哈希的实际长度
+    quint8  hash[MAX_HASH_LENGTH]; //源JSON哈希
+    quint32 lineCount;             //线路数量
+    quint32 stationCount;          //站点数量
+    quint32 connectionCount;       //连接数量
+    quint32 edgeCount;             //CSR出边数量
+    quint32 groupCount;            //CSR(站点, 线路)分组数量
+    quint32 viaCount;              //拐点总数
+    quint32 stringBytes;           //名称表字节数
+    quint32 landmarkCount;         //地标数量
+    quint64 fileSize;              //文件总长度
+};
+
+/*名称表中的一个字符串*/
+struct SnapshotString {
+    quint32 offset; //在名称表中的起始位置
+    quint32 length; //UTF-8字节数
+};
+
+/*线路记录*/
+struct SnapshotLine {
+    SnapshotString name;    //线路名称
+    quint32        rgba;    //线路颜色
+    quint32        reserved;//保留，对齐用
+};
+
+/*站点记录*/
+struct SnapshotStation {
+    SnapshotString name;  //站点名称
+    SnapshotString tag;   //标签位置
+    SnapshotString type;  //站点类型
+    qint32         graphX;//图上横坐标
+    qint32         graphY;//图上纵坐标
+    double         realX; //经度
+    double         realY; //纬度
+};
+
+/*连接记录*/
+struct SnapshotConnection {
+    quint32 id1;       //站点1编号
+    quint32 id2;       //站点2编号
+    quint32 lineId;    //线路编号
+    quint32 viaOffset; //首个拐点在拐点段中的下标
+    quint32 viaCount;  //拐点数量
+    quint32 reserved;  //保留，对齐用
+};
+
+/*各数组段在文件中的偏移*/
+struct SnapshotLayout {
+    qint64 lines;
+    qint64 stations;
+    qint64 connections;
+    qint64 viaPoints;
+    qint64 offsets;
+    qint64 targets;
+    qint64 edgeLines;
+    qint64 weights;
+    qint64 groupOffsets;
+    qint64 groupLines;
+    qint64 groupEdgeOffsets;
+    qint64 groupEdges;
+    qint64 landmarks;
+    qint64 distanceTable;
+    qint64 hopTable;
+    qint64 strings;
+    qint64 end;
+};
+
+/***************************************************************************
+  函数名称：align8
+  功    能：将偏移向上取整到8字节边界
+  输入参数：qint64 value - 原偏移
+  返 回 值：qint64 - 对齐后的偏移
+  说    明：
+***************************************************************************/
+qint64 align8(qint64 value) {
+    return (value + 7) & ~qint64(7);
+}
+
+/***************************************************************************
+  函数名称：computeLayout
+  功    能：根据文件头中的数量计算各数组段的偏移
+  输入参数：const SnapshotHeader& header - 文件头
+  返 回 值：SnapshotLayout - 各段偏移
+  说    明：读写两端共用，保证布局一致
+***************************************************************************/
+SnapshotLayout computeLayout(const SnapshotHeader& header) {
+    const qint64 stationCount = header.stationCount;
+    const qint64 edgeCount    = header.edgeCount;
+    const qint64 groupCount   = header.groupCount;
+    const qint64 tableSize    = stationCount * header.landmarkCount;
+
+    SnapshotLayout layout;
+    qint64 pos = align8(sizeof(SnapshotHeader));
+    layout.lines            = pos; pos = align8(pos + qint64(header.lineCount)       * sizeof(SnapshotLine));
+    layout.stations         = pos; pos = align8(pos + stationCount                   * sizeof(SnapshotStation));
+    layout.connections      = pos; pos = align8(pos + qint64(header.connectionCount) * sizeof(SnapshotConnection));
+    layout.viaPoints        = pos; pos = align8(pos + qint64(header.viaCount)        * 2 * sizeof(qint32));
+    layout.offsets          = pos; pos = align8(pos + (stationCount + 1)             * sizeof(qint32));
+    layout.targets          = pos; pos = align8(pos + edgeCount                      * sizeof(quint32));
+    layout.edgeLines        = pos; pos = align8(pos + edgeCount                      * sizeof(quint32));
+    layout.weights          = pos; pos = align8(pos + edgeCount                      * sizeof(double));
+    layout.groupOffsets     = pos; pos = align8(pos + (stationCount + 1)             * sizeof(qint32));
+    layout.groupLines       = pos; pos = align8(pos + groupCount                     * sizeof(quint32));
+    layout.groupEdgeOffsets = pos; pos = align8(pos + (groupCount + 1)               * sizeof(qint32));
+    layout.groupEdges       = pos; pos = align8(pos + edgeCount                      * sizeof(qint32));
+    layout.landmarks        = pos; pos = align8(pos + qint64(header.landmarkCount)   * sizeof(quint32));
+    layout.distanceTable    = pos; pos = align8(pos + tableSize                      * sizeof(double));
+    layout.hopTable         = pos; pos = align8(pos + tableSize                      * sizeof(qint32));
+    layout.strings          = pos; pos = align8(pos + qint64(header.stringBytes));
+    layout.end              = pos;
+    return layout;
+}
+
+/***************************************************************************
+  函数名称：copyArray
+  功    能：将映射内存中的一段定长数组拷贝到QVector
+  输入参数：QVector<T>& target - 目标数组
+            const uchar* base  - 映射内存起始地址
+            qint64 offset      - 段偏移
+            int count          - 元素数量
+  返 回 值：
+  说    明：T与文件中元素的大小必须一致
+***************************************************************************/
+template <typename T>
+void copyArray(QVector<T>& target, const uchar* base, qint64 offset, int count) {
+    target.resize(count);
+    if (count > 0) {
+        std::memcpy(target.data(), base + offset, size_t(count) * sizeof(T));
+    }
+}
+
+/***************************************************************************
+  函数名称：writeArray
+  功    能：将QVector中的定长数组写入快照缓冲区
+  输入参数：QByteArray& buffer      - 快照缓冲区
+            qint64 offset           - 段偏移
+            const QVector<T>& source - 源数组
+  返 回 值：
+  说    明：
+***************************************************************************/
+template <typename T>
+void writeArray(QByteArray& buffer, qint64 offset, const QVector<T>& source) {
+    if (!source.isEmpty()) {
+        std::memcpy(buffer.data() + offset, source.constData(), size_t(source.size()) * sizeof(T));
+    }
+}
+
+/***************************************************************************
+  函数名称：isMonotonic
+  功    能：检查偏移数组是否单调不减且首尾落在[0, limit]内
+  输入参数：const QVector<int>& offsets - 偏移数组
+            int limit                   - 最后一个偏移应等于的值
+  返 回 值：bool - 是否合法
+  说    明：
+***************************************************************************/
+bool isMonotonic(const QVector<int>& offsets, int limit) {
+    if (offsets.isEmpty() || offsets.first() != 0 || offsets.last() != limit) {
+        return false;
+    }
+    for (int i = 1; i < offsets.size(); i++) {
+        if (offsets[i] < offsets[i - 1]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*字符串写入名称表的辅助结构*/
+struct StringTableWriter {
+    QByteArray bytes; //名称表内容
+
+    SnapshotString add(const QString& text) {
+        QByteArray utf8 = text.toUtf8();
+        SnapshotString entry;
+        entry.offset = quint32(bytes.size());
+        entry.length = quint32(utf8.size());
+        bytes.append(utf8);
+        return entry;
+    }
+};
+
+} // namespace
+
+/***************************************************************************
+  函数名称：MetroSnapshot::sourceHash
+  功    能：计算源JSON内容的哈希
+  输入参数：QIODevice& device - 已打开的JSON文件
+  返 回 值：QByteArray - 哈希值
+  说    明：分块读取，不把整个文件读入内存；快照中保存该值，源文件改动后快照自动失效
+***************************************************************************/
+QByteArray MetroSnapshot::sourceHash(QIODevice& device) {
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    for (;;) {
+        QByteArray chunk = device.read(64 * 1024);
+        if (chunk.isEmpty()) {
+            break;
+        }
+        hash.addData(chunk);
+    }
+    return hash.result();
+}
+
+/***************************************************************************
+  函数名称：MetroSnapshot::save
+  功    能：将地铁图写入二进制快照
+  输入参数：const MetroGraph& graph - 已加载完成的地铁图
+            const QString& filename - 快照文件名
+            const QByteArray& hash  - 源JSON内容的哈希
+  返 回 值：bool - 是否写入成功
+  说    明：通过QSaveFile原子替换，写入中途失败不会留下残缺文件
+***************************************************************************/
+bool MetroSnapshot::save(const MetroGraph& graph, const QString& filename, const QByteArray& hash) {
+    const MetroCsr&      csr       = graph.csr;
+    const LandmarkTable& landmarks = graph.getLandmarks();
+
+    /* 先收集字符串和拐点，得到各段长度*/
+    StringTableWriter strings;
+    QVector<SnapshotLine> lineRecords;
+    lineRecords.reserve(graph.lines.size());
+    for (const MetroLine& line : graph.lines) {
+        SnapshotLine record;
+        record.name     = strings.add(line.name);
+        record.rgba     = (quint32(line.color.alpha()) << 24) | (quint32(line.color.red()) << 16)
+                        | (quint32(line.color.green()) << 8) | quint32(line.color.blue());
+        record.reserved = 0;
+        lineRecords.append(record);
+    }
+
+    QVector<SnapshotStation> stationRecords;
+    stationRecords.reserve(graph.stations.size());
+    for (const Station& station : graph.stations) {
+        SnapshotStation record;
+        record.name   = strings.add(station.name);
+        record.tag    = strings.add(station.tag);
+        record.type   = strings.add(station.type);
+        record.graphX = station.graphPosition.x();
+        record.graphY = station.graphPosition.y();
+        record.realX  = station.realPosition.x();
+        record.realY  = station.realPosition.y();
+        stationRecords.append(record);
+    }
+
+    QVector<SnapshotConnection> connectionRecords;
+    QVector<qint32>             viaPoints;
+    connectionRecords.reserve(graph.connections.size());
+    for (const StationConnection& connection : graph.connections) {
+        SnapshotConnection record;
+        record.id1       = connection.id1;
+        record.id2       = connection.id2;
+        record.lineId    = connection.lineId;
+        record.viaOffset = quint32(viaPoints.size() / 2);
+        record.viaCount  = quint32(connection.viaPoints.size());
+        record.reserved  = 0;
+        for (const QPoint& point : connection.viaPoints) {
+            viaPoints.append(point.x());
+            viaPoints.append(point.y());
+        }
+        connectionRecords.append(record);
+    }
+
+    /* 填写文件头并计算布局*/
+    SnapshotHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic           = MAGIC;
+    header.version         = VERSION;
+    header.byteOrder       = BYTE_ORDER_MARK;
+    header.hashLength      = quint32(qMin(int(hash.size()), MAX_HASH_LENGTH));
+    std::memcpy(header.hash, hash.constData(), header.hashLength);
+    header.lineCount       = quint32(lineRecords.size());
+    header.stationCount    = quint32(stationRecords.size());
+    header.connectionCount = quint32(connectionRecords.size());
+    header.edgeCount       = quint32(csr.targets.size());
+    header.groupCount      = quint32(csr.groupLines.size());
+    header.viaCount        = quint32(viaPoints.size() / 2);
+    header.stringBytes     = quint32(strings.bytes.size());
+    header.landmarkCount   = quint32(landmarks.landmarks.size());
+
+    const SnapshotLayout layout = computeLayout(header);
+    header.fileSize = quint64(layout.end);
+
+    /* 按布局拼装整个文件*/
+    QByteArray buffer(int(layout.end), '\0');
+    std::memcpy(buffer.data(), &header, sizeof(header));
+    writeArray(buffer, layout.lines,            lineRecords);
+    writeArray(buffer, layout.stations,         stationRecords);
+    writeArray(buffer, layout.connections,      connectionRecords);
+    writeArray(buffer, layout.viaPoints,        viaPoints);
+    writeArray(buffer, layout.offsets,          csr.offsets);
+    writeArray(buffer, layout.targets,          csr.targets);
+    writeArray(buffer, layout.edgeLines,        csr.lines);
+    writeArray(buffer, layout.weights,          csr.weights);
+    writeArray(buffer, layout.groupOffsets,     csr.groupOffsets);
+    writeArray(buffer, layout.groupLines,       csr.groupLines);
+    writeArray(buffer, layout.groupEdgeOffsets, csr.groupEdgeOffsets);
+    writeArray(buffer, layout.groupEdges,       csr.groupEdges);
+    writeArray(buffer, layout.landmarks,        landmarks.landmarks);
+    writeArray(buffer, layout.distanceTable,    landmarks.distances);
+    writeArray(buffer, layout.hopTable,         landmarks.hops);
+    if (!strings.bytes.isEmpty()) {
+        std::memcpy(buffer.data() + layout.strings, strings.bytes.constData(), size_t(strings.bytes.size()));
+    }
+
+    QSaveFile file(filename);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "无法写入快照文件:" << filename;
+        return false;
+    }
+    if (file.write(buffer) != buffer.size() || !file.commit()) {
+        qWarning() << "快照文件写入失败:" << filename;
+        return false;
+    }
+
+    qDebug() << "已写入快照" << filename << ":" << buffer.size() << "字节";
+    return true;
+}
+
+/***************************************************************************
+  函数名称：MetroSnapshot::load
+  功    能：从二进制快照恢复地铁图
+  输入参数：MetroGraph& graph       - 待填充的地铁图
+            const QString& filename - 快照文件名
+            const QByteArray& hash  - 当前源JSON内容的哈希
+  返 回 值：bool - 是否恢复成功
+  说    明：文件通过QFile::map映射后按段整块拷贝，不做任何文本解析；
+            标识、版本、字节序、哈希、长度或编号范围任一不符都视为失效，
+            此时地铁图保持原状，由调用方回退到JSON加载
+***************************************************************************/
+bool MetroSnapshot::load(MetroGraph& graph, const QString& filename, const QByteArray& hash) {
+    QFile file(filename);
+    if (!file.exists() || !file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    const qint64 fileSize = file.size();
+    if (fileSize < qint64(sizeof(SnapshotHeader))) {
+        return false;
+    }
+
+    const uchar* base = file.map(0, fileSize);
+    if (base == nullptr) {
+        qWarning() << "快照文件映射失败:" << filename;
+        return false;
+    }
+
+    /* 校验文件头*/
+    SnapshotHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    const int hashLength = qMin(int(hash.size()), MAX_HASH_LENGTH);
+    if (header.magic != MAGIC || header.version != VERSION || header.byteOrder != BYTE_ORDER_MARK
+        || header.fileSize != quint64(fileSize) || header.hashLength != quint32(hashLength)
+        || std::memcmp(header.hash, hash.constData(), size_t(hashLength)) != 0) {
+        qDebug() << "快照与数据文件不匹配，忽略:" << filename;
+        return false;
+    }
+
+    const SnapshotLayout layout = computeLayout(header);
+    if (layout.end != fileSize) {
+        qWarning() << "快照文件长度异常:" << filename;
+        return false;
+    }
+
+    const int lineCount       = int(header.lineCount);
+    const int stationCount    = int(header.stationCount);
+    const int connectionCount = int(header.connectionCount);
+    const int edgeCount       = int(header.edgeCount);
+    const int groupCount      = int(header.groupCount);
+    const int viaCount        = int(header.viaCount);
+    const int landmarkCount   = int(header.landmarkCount);
+    const char* stringBase    = reinterpret_cast<const char*>(base + layout.strings);
+    auto readString = [&](const SnapshotString& entry, QString& out) {
+        if (quint64(entry.offset) + entry.length > header.stringBytes) {
+            return false;
+        }
+        out = QString::fromUtf8(stringBase + entry.offset, int(entry.length));
+        return true;
+    };
+
+    /* 整块拷贝CSR各段并检查编号范围*/
+    MetroCsr csr;
+    copyArray(csr.offsets,          base, layout.offsets,          stationCount + 1);
+    copyArray(csr.targets,          base, layout.targets,          edgeCount);
+    copyArray(csr.lines,            base, layout.edgeLines,        edgeCount);
+    copyArray(csr.weights,          base, layout.weights,          edgeCount);
+    copyArray(csr.groupOffsets,     base, layout.groupOffsets,     stationCount + 1);
+    copyArray(csr.groupLines,       base, layout.groupLines,       groupCount);
+    copyArray(csr.groupEdgeOffsets, base, layout.groupEdgeOffsets, groupCount + 1);
+    copyArray(csr.groupEdges,       base, layout.groupEdges,       edgeCount);
+
+    bool valid = isMonotonic(csr.offsets, edgeCount) && isMonotonic(csr.groupOffsets, groupCount)
+              && isMonotonic(csr.groupEdgeOffsets, edgeCount);
+    for (int e = 0; valid && e < edgeCount; e++) {
+        valid = csr.targets[e] < quint32(stationCount) && csr.lines[e] < quint32(lineCount)
+             && csr.groupEdges[e] >= 0 && csr.groupEdges[e] < edgeCount;
+    }
+    for (int g = 0; valid && g < groupCount; g++) {
+        valid = csr.groupLines[g] < quint32(lineCount);
+    }
+
+    /* 地标表随CSR一起保存，与之对应*/
+    std::shared_ptr<LandmarkTable> landmarks = std::make_shared<LandmarkTable>();
+    valid = valid && landmarkCount <= LandmarkTable::MAX_LANDMARKS;
+    if (valid) {
+        copyArray(landmarks->landmarks, base, layout.landmarks,         landmarkCount);
+        copyArray(landmarks->distances, base, layout.distanceTable,     stationCount * landmarkCount);
+        copyArray(landmarks->hops,      base, layout.hopTable,          stationCount * landmarkCount);
+    }
+    for (int l = 0; valid && l < landmarkCount; l++) {
+        valid = landmarks->landmarks[l] < quint32(stationCount);
+    }
+
+    /* 恢复线路和站点记录*/
+    QVector<MetroLine> lines(lineCount);
+    for (int i = 0; valid && i < lineCount; i++) {
+        SnapshotLine record;
+        std::memcpy(&record, base + layout.lines + qint64(i) * sizeof(SnapshotLine), sizeof(record));
+        valid = readString(record.name, lines[i].name);
+        lines[i].color = QColor((record.rgba >> 16) & 0xFF, (record.rgba >> 8) & 0xFF,
+                                record.rgba & 0xFF, (record.rgba >> 24) & 0xFF);
+    }
+
+    QVector<Station> stations(stationCount);
+    for (int i = 0; valid && i < stationCount; i++) {
+        SnapshotStation record;
+        std::memcpy(&record, base + layout.stations + qint64(i) * sizeof(SnapshotStation), sizeof(record));
+        Station& station = stations[i];
+        valid = readString(record.name, station.name) && readString(record.tag, station.tag)
+             && readString(record.type, station.type);
+        station.graphPosition = QPoint(record.graphX, record.graphY);
+        station.realPosition  = QPointF(record.realX, record.realY);
+    }
+
+    QVector<StationConnection> connections(connectionCount);
+    const qint32* viaBase = reinterpret_cast<const qint32*>(base + layout.viaPoints);
+    for (int i = 0; valid && i < connectionCount; i++) {
+        SnapshotConnection record;
+        std::memcpy(&record, base + layout.connections + qint64(i) * sizeof(SnapshotConnection), sizeof(record));
+        valid = record.id1 < quint32(stationCount) && record.id2 < quint32(stationCount)
+             && record.lineId < quint32(lineCount)
+             && quint64(record.viaOffset) + record.viaCount <= quint64(viaCount);
+        if (!valid) {
+            break;
+        }
+
+        StationConnection& connection = connections[i];
+        connection.id1      = record.id1;
+        connection.id2      = record.id2;
+        connection.lineId   = record.lineId;
+        connection.station1 = stations[record.id1].name;
+        connection.station2 = stations[record.id2].name;
+        connection.line     = lines[record.lineId].name;
+        connection.viaPoints.reserve(int(record.viaCount));
+        for (quint32 v = 0; v < record.viaCount; v++) {
+            const qint32* point = viaBase + 2 * (qint64(record.viaOffset) + v);
+            connection.viaPoints.append(QPoint(point[0], point[1]));
+        }
+    }
+
+    file.unmap(const_cast<uchar*>(base));
+    if (!valid) {
+        qWarning() << "快照文件内容损坏:" << filename;
+        return false;
+    }
+
+    /* 由快照内容重建名称映射、连接索引和邻接表*/
+    QHash<QString, LineId> lineIds;
+    lineIds.reserve(lineCount);
+    for (LineId id = 0; id < LineId(lineCount); id++) {
+        lineIds.insert(lines[id].name, id);
+    }
+
+    QHash<QString, StationId> stationIds;
+    stationIds.reserve(stationCount);
+    for (StationId id = 0; id < StationId(stationCount); id++) {
+        stationIds.insert(stations[id].name, id);
+    }
+
+    QHash<quint64, QVector<int>> connectionMap;
+    connectionMap.reserve(connectionCount);
+    for (int i = 0; i < connectionCount; i++) {
+        connectionMap[MetroGraph::pairKey(connections[i].id1, connections[i].id2)].append(i);
+    }
+
+    /* CSR保持了邻接表的顺序，相邻站点名称按出边顺序去重*/
+    QVector<QVector<StationEdge>> adjacency(stationCount);
+    for (StationId id = 0; id < StationId(stationCount); id++) {
+        QVector<StationEdge>& edges = adjacency[id];
+        edges.reserve(csr.offsets[id + 1] - csr.offsets[id]);
+        for (int e = csr.offsets[id]; e < csr.offsets[id + 1]; e++) {
+            edges.append(StationEdge{ csr.targets[e], csr.lines[e] });
+            const QString& neighbour = stations[csr.targets[e]].name;
+            if (!stations[id].connectedStations.contains(neighbour)) {
+                stations[id].connectedStations.append(neighbour);
+            }
+        }
+    }
+
+    graph.lines         = lines;
+    graph.stations      = stations;
+    graph.connections   = connections;
+    graph.lineIds       = lineIds;
+    graph.stationIds    = stationIds;
+    graph.connectionMap = connectionMap;
+    graph.adjacency     = adjacency;
+    graph.csr           = csr;
+    graph.changes.clear();
+    graph.buildDerivedIndices();
+    graph.landmarkTable = landmarks;
+
+    qDebug() << "从快照加载完成: " << stationCount << "个站点, " << connectionCount << "个连接";
+    return true;
+}
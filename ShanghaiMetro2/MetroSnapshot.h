@@ -0,0 +1,30 @@
+﻿/***************************************************************************
+  文件名称：MetroSnapshot.h
+  功    能：地铁图二进制快照的头文件
+  说    明：将加载完成的地铁图（名称表、站点、CSR出边、拐点、地标表）写成紧凑的
+            二进制文件，下次启动时通过内存映射直接恢复，无需解析JSON
+***************************************************************************/
+
+#ifndef METROSNAPSHOT_H
+#define METROSNAPSHOT_H
+
+#include <QString>
+#include <QByteArray>
+#include <QIODevice>
+
+class MetroGraph;
+
+/*地铁图二进制快照(.mgb)的读写*/
+class MetroSnapshot {
+public:
+    static const quint32 MAGIC   = 0x3142474Du; //文件标识"MGB1"
+    static const quint32 VERSION = 2;           //格式版本，布局变化时递增
+
+    static QByteArray sourceHash(QIODevice& device);                                       //计算源JSON内容的哈希
+    static bool       save(const MetroGraph& graph, const QString& filename,
+                           const QByteArray& hash);                                       //将地铁图写入快照
+    static bool       load(MetroGraph& graph, const QString& filename,
+                           const QByteArray& hash);                                       //从快照恢复地铁图
+};
+
+#endif // METROSNAPSHOT_H
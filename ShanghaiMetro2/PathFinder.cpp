@@ -1,11 +1,16 @@
 ﻿/***************************************************************************
   文件名称：PathFinder.cpp
   功    能：路径查找算法的实现文件
-  说    明：实现多种地铁路径搜索算法，包括最少换乘、最少站点和最短距离
+  说    明：实现多种地铁路径搜索算法，包括最少换乘、最少站点、最短距离和
+            广义代价最小
 ***************************************************************************/
 
 #include "PathFinder.h"
-#include <queue>
+#include "RouteTable.h"
+#include "RouteCache.h"
+#include "SearchTree.h"
+#include <QThread>
+#include <QThreadPool>
 #include <QSet>
 #include <QMap>
 #include <cmath>
@@ -13,33 +18,495 @@
 #include <QDebug>
 #include <algorithm>
 
-/*用于优先队列的比较函数*/
+/*用于优先队列的比较函数：距离小者优先，距离相同时编号小者优先*/
 struct ComparePair {
-    bool operator()(const std::pair<int, int>& a, const std::pair<int, int>& b) const {
+    bool operator()(const std::pair<double, StationId>& a, const std::pair<double, StationId>& b) const {
         if (a.first != b.first) 
             return a.first > b.first;
         return a.second > b.second;
     }
 };
 
+/*地标下界：先取出终点对各地标的值，某站到终点的下界为各地标三角不等式下界中的最大者*/
+struct LandmarkBound {
+    const LandmarkTable* table = nullptr;                         //地标表
+    int                  count = 0;                               //地标数量
+    double               targetDistances[LandmarkTable::MAX_LANDMARKS]; //终点到各地标的里程
+    qint32               targetHops[LandmarkTable::MAX_LANDMARKS];      //终点到各地标的区间数
+
+    LandmarkBound() {}
+    LandmarkBound(const LandmarkTable& landmarks, StationId to) : table(&landmarks), count(landmarks.landmarks.size()) {
+        for (int l = 0; l < count; l++) {
+            targetDistances[l] = landmarks.distances[to * count + l];
+            targetHops[l]      = landmarks.hops[to * count + l];
+        }
+    }
+
+    /*里程下界，某地标到两站之一不可达时该地标不提供信息；没有地标时为0*/
+    double distance(StationId station) const {
+        if (count == 0) {
+            return 0;
+        }
+        const double* row   = table->distances.constData() + station * count;
+        double        bound = 0;
+        for (int l = 0; l < count; l++) {
+            if (row[l] >= 0 && targetDistances[l] >= 0) {
+                bound = qMax(bound, std::fabs(row[l] - targetDistances[l]));
+            }
+        }
+        return bound;
+    }
+
+    /*区间数下界*/
+    int hops(StationId station) const {
+        if (count == 0) {
+            return 0;
+        }
+        const qint32* row   = table->hops.constData() + station * count;
+        int           bound = 0;
+        for (int l = 0; l < count; l++) {
+            if (row[l] >= 0 && targetHops[l] >= 0) {
+                bound = qMax(bound, int(std::abs(row[l] - targetHops[l])));
+            }
+        }
+        return bound;
+    }
+};
+
+/*最少换乘搜索的堆比较函数：代价逐项比较，小者优先，代价相同时分组编号小者优先*/
+struct CompareTransferCost {
+    bool operator()(const std::pair<TransferCost, int>& a, const std::pair<TransferCost, int>& b) const {
+        if (a.first.transfers != b.first.transfers)
+            return a.first.transfers > b.first.transfers;
+        if (a.first.primary != b.first.primary)
+            return a.first.primary > b.first.primary;
+        if (a.first.secondary != b.first.secondary)
+            return a.first.secondary > b.first.secondary;
+        return a.second > b.second;
+    }
+};
+
+/***************************************************************************
+  函数名称：SearchScratch::prepare
+  功    能：为一次新的搜索准备临时数组
+  输入参数：int stationCount - 站点数量
+            int groupCount   - (站点, 线路)分组数量，不做分组上的搜索时为0
+  返 回 值：
+  说    明：数组大小不变时只递增epoch，不清空数组；堆和队列保留已分配的容量
+***************************************************************************/
+void SearchScratch::prepare(int stationCount, int groupCount) {
+    SearchSide* sides[] = { &forward, &backward };
+    if (forward.reached.size() != stationCount) {
+        for (SearchSide* side : sides) {
+            side->dist.resize(stationCount);
+            side->prev.resize(stationCount);
+            side->reached.fill(0, stationCount);
+            side->settled.fill(0, stationCount);
+        }
+        pareto.bagHead.resize(stationCount);
+        pareto.hopBound.resize(stationCount);
+        pareto.distanceBound.resize(stationCount);
+        pareto.bagReached.fill(0, stationCount);
+        epoch = 0;
+    }
+    if (groups.reached.size() < groupCount) {
+        groups.cost.resize(groupCount);
+        groups.prev.resize(groupCount);
+        groups.station.resize(groupCount);
+        groups.reached.fill(0, groupCount);
+        groups.settled.fill(0, groupCount);
+        costs.cost.resize(groupCount);
+        costs.prev.resize(groupCount);
+        costs.station.resize(groupCount);
+        costs.reached.fill(0, groupCount);
+        costs.settled.fill(0, groupCount);
+        epoch = 0;
+    }
+    if (++epoch == 0 || epoch == 1) {
+        /* 编号回绕或数组刚分配，旧标记可能与新编号相同*/
+        for (SearchSide* side : sides) {
+            side->reached.fill(0);
+            side->settled.fill(0);
+        }
+        groups.reached.fill(0);
+        groups.settled.fill(0);
+        costs.reached.fill(0);
+        costs.settled.fill(0);
+        pareto.bagReached.fill(0);
+        epoch = 1;
+    }
+    for (SearchSide* side : sides) {
+        side->heap.clear();
+        side->queue.clear();
+    }
+    groups.heap.clear();
+    costs.heap.clear();
+}
+
 /***************************************************************************
   函数名称：PathFinder::PathFinder
   功    能：构造函数，初始化路径查找器
-  输入参数：const MetroGraph* graph - 地铁图数据指针
+  输入参数：MetroGraphPtr graph - 地铁图版本
   返 回 值：
   说    明：初始化路径查找器并设置地铁图数据
 ***************************************************************************/
-PathFinder::PathFinder(const MetroGraph* graph) : graph(graph) {}
+PathFinder::PathFinder(MetroGraphPtr graph)
+    : graph(graph), transferTieBreak(FEWER_STATIONS), stationsAlgorithm(BFS), distanceAlgorithm(ALT_A_STAR) {}
 
 /***************************************************************************
   函数名称：PathFinder::setGraph
   功    能：设置地图信息
-  输入参数：const MetroGraph* graph - 地铁图数据指针
+  输入参数：MetroGraphPtr graph - 地铁图版本
   返 回 值：
-  说    明：
+  说    明：查找器持有该版本直到下次设置，期间图的修改不影响正在进行的查询；
+            多目标搜索的乘车步骤依赖地铁图，在此作废
 ***************************************************************************/
-void PathFinder::setGraph(const MetroGraph* graph) {
+void PathFinder::setGraph(MetroGraphPtr graph) {
     this->graph = graph;
+    scratch.pareto.rideOffsets.clear();
+}
+
+/***************************************************************************
+  函数名称：PathFinder::setTransferTieBreak
+  功    能：设置最少换乘策略在换乘次数相同时的比较依据
+  输入参数：TransferTieBreak tieBreak - 比较依据
+  返 回 值：
+  说    明：默认经过站点少者优先
+***************************************************************************/
+void PathFinder::setTransferTieBreak(TransferTieBreak tieBreak) {
+    transferTieBreak = tieBreak;
+}
+
+/***************************************************************************
+  函数名称：PathFinder::setStationsAlgorithm
+  功    能：设置最少站点策略的搜索算法
+  输入参数：StationsAlgorithm algorithm - 搜索算法
+  返 回 值：
+  说    明：两种算法得到的站点数相同，站点数相同的多条路径中选出的可能不同；
+            默认使用单向BFS，界面上的结果保持稳定
+***************************************************************************/
+void PathFinder::setStationsAlgorithm(StationsAlgorithm algorithm) {
+    stationsAlgorithm = algorithm;
+}
+
+/***************************************************************************
+  函数名称：PathFinder::setDistanceAlgorithm
+  功    能：设置最短距离策略的搜索算法
+  输入参数：DistanceAlgorithm algorithm - 搜索算法
+  返 回 值：
+  说    明：各算法得到的距离相同，扩展的站点数不同；默认使用ALT，地标表
+            随快照加载或在首次查询时构建
+***************************************************************************/
+void PathFinder::setDistanceAlgorithm(DistanceAlgorithm algorithm) {
+    distanceAlgorithm = algorithm;
+}
+
+/***************************************************************************
+  函数名称：PathFinder::setContractionHierarchy
+  功    能：设置最短距离查询使用的收缩层次索引
+  输入参数：ContractionHierarchyPtr hierarchy - 索引，为空时不使用
+  返 回 值：
+  说    明：索引只在与当前图版本对应时使用，图被修改后自动回退到设置的搜索算法
+***************************************************************************/
+void PathFinder::setContractionHierarchy(ContractionHierarchyPtr hierarchy) {
+    this->hierarchy = hierarchy;
+}
+
+/***************************************************************************
+  函数名称：PathFinder::getContractionHierarchy
+  功    能：获取收缩层次索引
+  输入参数：
+  返 回 值：ContractionHierarchyPtr - 当前设置的索引，可能已与图版本不对应
+  说    明：
+***************************************************************************/
+ContractionHierarchyPtr PathFinder::getContractionHierarchy() const {
+    return hierarchy;
+}
+
+/***************************************************************************
+  函数名称：PathFinder::setRouteTable
+  功    能：设置全源路径表
+  输入参数：RouteTablePtr table - 路径表，为空时不使用
+  返 回 值：
+  说    明：路径表只在与当前图版本对应时使用，此时三种策略都直接查表；
+            最少换乘表按站点少者优先构建，设置为距离优先时仍然搜索
+***************************************************************************/
+void PathFinder::setRouteTable(RouteTablePtr table) {
+    routeTable = table;
+}
+
+/***************************************************************************
+  函数名称：PathFinder::getRouteTable
+  功    能：获取全源路径表
+  输入参数：
+  返 回 值：RouteTablePtr - 当前设置的路径表，可能已与图版本不对应
+  说    明：
+***************************************************************************/
+RouteTablePtr PathFinder::getRouteTable() const {
+    return routeTable;
+}
+
+/***************************************************************************
+  函数名称：PathFinder::setRouteCache
+  功    能：设置findPath使用的结果缓存
+  输入参数：RouteCachePtr cache - 结果缓存，为空时不使用
+  返 回 值：
+  说    明：缓存键含图版本号和影响所选路径的设置，多个查找器可共享同一缓存
+***************************************************************************/
+void PathFinder::setRouteCache(RouteCachePtr cache) {
+    routeCache = cache;
+}
+
+/***************************************************************************
+  函数名称：PathFinder::getRouteCache
+  功    能：获取结果缓存
+  输入参数：
+  返 回 值：RouteCachePtr - 当前设置的结果缓存
+  说    明：
+***************************************************************************/
+RouteCachePtr PathFinder::getRouteCache() const {
+    return routeCache;
+}
+
+/***************************************************************************
+  函数名称：PathFinder::computeMatrix
+  功    能：计算多起点到多终点的里程、换乘次数和站点数矩阵
+  输入参数：const QVector<StationId>& origins      - 起点编号列表
+            const QVector<StationId>& destinations - 终点编号列表
+            SearchStrategy strategy                - 搜索策略
+            int threadCount                        - 线程数，0表示按处理器核数
+  返 回 值：OdMatrix - 结果矩阵，编号无效或不可达的格子保持不可达
+  说    明：不逐对调用findPath，也不输出调试信息。以起点和终点中较少的一侧
+            为根，每个根做一次完整搜索即得到一行或一列（地铁图是无向的），
+            各根轮流分给多个线程，每个线程使用自己的搜索树，只写自己负责的
+            行或列。不使用全源路径表：表中里程为单精度，且取站点数需要逐站
+            展开，不比搜索快。结果与findPath的代价相同，代价相同的路径之间
+            可能取不同的一条；起终点相同时站点数为1
+***************************************************************************/
+OdMatrix PathFinder::computeMatrix(const QVector<StationId>& origins, const QVector<StationId>& destinations,
+                                   SearchStrategy strategy, int threadCount) const {
+    OdMatrix matrix;
+    matrix.originCount      = origins.size();
+    matrix.destinationCount = destinations.size();
+    const int cells = matrix.originCount * matrix.destinationCount;
+    matrix.distances.fill(-1, cells);
+    matrix.transfers.fill(-1, cells);
+    matrix.stationCounts.fill(0, cells);
+    if (!graph || cells == 0) {
+        return matrix;
+    }
+
+    const bool                byOrigin    = matrix.originCount <= matrix.destinationCount;
+    const QVector<StationId>& roots       = byOrigin ? origins : destinations;
+    const QVector<StationId>& others      = byOrigin ? destinations : origins;
+    const int                 rootStride  = byOrigin ? matrix.destinationCount : 1;
+    const int                 otherStride = byOrigin ? 1 : matrix.destinationCount;
+
+    if (threadCount <= 0) {
+        threadCount = QThread::idealThreadCount();
+    }
+    threadCount = qBound(1, threadCount, roots.size());
+
+    /* 各线程只写自己负责的格子，数组已在此分配完毕，线程中只通过指针写入，不会发生分离*/
+    const MetroGraph&      metroGraph    = *graph;
+    const TransferTieBreak tieBreak      = transferTieBreak;
+    const ClosureMaskPtr   closures      = activeClosures(graph->getClosures());
+    double*                distances     = matrix.distances.data();
+    int*                   transfers     = matrix.transfers.data();
+    int*                   stationCounts = matrix.stationCounts.data();
+    auto work = [&, strategy, tieBreak](int first, int step) {
+        SearchTree tree(metroGraph);
+        for (int r = first; r < roots.size(); r += step) {
+            tree.grow(roots[r], strategy, tieBreak, closures);
+            for (int k = 0; k < others.size(); k++) {
+                const StationId station = others[k];
+                if (tree.isReached(station)) {
+                    const int cell = r * rootStride + k * otherStride;
+                    distances[cell]     = tree.getDistance(station);
+                    transfers[cell]     = tree.getTransfers(station);
+                    stationCounts[cell] = tree.getStationCount(station);
+                }
+            }
+        }
+    };
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(threadCount);
+    for (int k = 0; k < threadCount; k++) {
+        pool.start([&work, k, threadCount]() { work(k, threadCount); });
+    }
+    pool.waitForDone();
+    return matrix;
+}
+
+/***************************************************************************
+  函数名称：PathFinder::computeIsochrone
+  功    能：计算从一个站点出发到全图各站的里程、换乘次数和站点数
+  输入参数：const QString& from      - 起点站名称
+            SearchStrategy strategy - 搜索策略
+  返 回 值：Isochrone - 按站点编号存放的结果，起点不存在时origin为INVALID_ID
+  说    明：以起点为根做一次完整搜索，代替对每个终点分别调用findPath；
+            不经过路径缓存，也不输出调试信息。各站的三项代价取自同一棵
+            搜索树，与findPath按该策略得到的代价相同
+***************************************************************************/
+Isochrone PathFinder::computeIsochrone(const QString& from, SearchStrategy strategy) const {
+    Isochrone isochrone;
+    isochrone.strategy = strategy;
+    if (!graph) {
+        return isochrone;
+    }
+    const StationId origin = graph->getStationId(from);
+    if (origin == INVALID_ID) {
+        return isochrone;
+    }
+
+    const int stationCount = graph->getStationCount();
+    isochrone.origin = origin;
+    isochrone.distances.fill(-1, stationCount);
+    isochrone.transfers.fill(-1, stationCount);
+    isochrone.stationCounts.fill(0, stationCount);
+
+    SearchTree tree(*graph);
+    tree.grow(origin, strategy, transferTieBreak, activeClosures(graph->getClosures()));
+    for (StationId station = 0; station < static_cast<StationId>(stationCount); station++) {
+        if (tree.isReached(station)) {
+            isochrone.distances[station]     = tree.getDistance(station);
+            isochrone.transfers[station]     = tree.getTransfers(station);
+            isochrone.stationCounts[station] = tree.getStationCount(station);
+        }
+    }
+    return isochrone;
+}
+
+/***************************************************************************
+  函数名称：Isochrone::getCost
+  功    能：按搜索策略取到达一个站点的代价
+  输入参数：StationId station - 站点编号
+  返 回 值：double - 里程、站点数或换乘次数，不可达或编号无效时为-1
+  说    明：
+***************************************************************************/
+double Isochrone::getCost(StationId station) const {
+    if (station >= static_cast<StationId>(stationCounts.size()) || stationCounts[station] == 0) {
+        return -1;
+    }
+    switch (strategy) {
+    case MIN_TRANSFER:
+        return transfers[station];
+    case MIN_STATIONS:
+        return stationCounts[station];
+    case MIN_DISTANCE:
+    default:
+        return distances[station];
+    }
+}
+
+/***************************************************************************
+  函数名称：Isochrone::reachableWithin
+  功    能：列出代价不超过预算的站点
+  输入参数：double budget - 预算，单位与策略的代价相同
+  返 回 值：QVector<StationId> - 站点编号，按代价升序，代价相同按编号，含起点
+  说    明：
+***************************************************************************/
+QVector<StationId> Isochrone::reachableWithin(double budget) const {
+    QVector<std::pair<double, StationId>> reached;
+    for (StationId station = 0; station < static_cast<StationId>(stationCounts.size()); station++) {
+        const double cost = getCost(station);
+        if (cost >= 0 && cost <= budget) {
+            reached.append(std::make_pair(cost, station));
+        }
+    }
+    std::sort(reached.begin(), reached.end());
+
+    QVector<StationId> stations;
+    stations.reserve(reached.size());
+    for (const std::pair<double, StationId>& entry : reached) {
+        stations.append(entry.second);
+    }
+    return stations;
+}
+
+/***************************************************************************
+  函数名称：PathFinder::hasRouteTable
+  功    能：判断全源路径表是否对应当前图版本
+  输入参数：const ClosureMaskPtr& closures - 本次查询生效的临时封闭，没有时为空
+  返 回 值：bool - 是否可用
+  说    明：查表不做搜索，统计信息清零；表按未封闭的图计算，有临时封闭时
+            不使用
+***************************************************************************/
+bool PathFinder::hasRouteTable(const ClosureMaskPtr& closures) const {
+    return routeTable != nullptr && routeTable->matches(*graph) && closures == nullptr;
+}
+
+/***************************************************************************
+  函数名称：PathFinder::activeClosures
+  功    能：由地铁图上的封闭得到生效的临时封闭
+  输入参数：const ClosureMaskPtr& mask - 从图上取得的封闭，可为空
+  返 回 值：ClosureMaskPtr - 封闭位图，没有任何封闭时为空指针
+  说    明：各公开查询开始时从图上取一次，传给缓存、查表和收缩层次的取舍、
+            各搜索以及buildPath，一次查询中只看到同一封闭情况；内层循环据此
+            跳过封闭的出边，没有封闭时为空指针，每条边只多一次指针比较
+***************************************************************************/
+ClosureMaskPtr PathFinder::activeClosures(const ClosureMaskPtr& mask) {
+    return mask != nullptr && !mask->isEmpty() ? mask : ClosureMaskPtr();
+}
+
+/***************************************************************************
+  函数名称：PathFinder::setCostModel
+  功    能：设置广义代价模型
+  输入参数：CostModelPtr model - 代价模型，为空或与当前图版本不对应时无法
+                                 查询广义代价
+  返 回 值：
+  说    明：图被编辑后由调用方按新版本重新构建
+***************************************************************************/
+void PathFinder::setCostModel(CostModelPtr model) {
+    costModel = model;
+}
+
+/***************************************************************************
+  函数名称：PathFinder::getCostModel
+  功    能：获取广义代价模型
+  输入参数：
+  返 回 值：CostModelPtr - 当前设置的代价模型
+  说    明：
+***************************************************************************/
+CostModelPtr PathFinder::getCostModel() const {
+    return costModel;
+}
+
+/***************************************************************************
+  函数名称：PathFinder::setCostWeights
+  功    能：设置广义代价各项的权重
+  输入参数：const CostWeights& weights - 权重
+  返 回 值：
+  说    明：负的权重按0处理，保证各段代价非负；只影响下一次查询，代价模型
+            不需要重新构建
+***************************************************************************/
+void PathFinder::setCostWeights(const CostWeights& weights) {
+    costWeights.inVehicle = qMax(0.0, weights.inVehicle);
+    costWeights.walking   = qMax(0.0, weights.walking);
+    costWeights.transfer  = qMax(0.0, weights.transfer);
+}
+
+/***************************************************************************
+  函数名称：PathFinder::getCostWeights
+  功    能：获取广义代价各项的权重
+  输入参数：
+  返 回 值：const CostWeights& - 权重
+  说    明：
+***************************************************************************/
+const CostWeights& PathFinder::getCostWeights() const {
+    return costWeights;
+}
+
+/***************************************************************************
+  函数名称：PathFinder::getLastStats
+  功    能：获取最近一次站点级搜索的统计信息
+  输入参数：
+  返 回 值：const SearchStats& - 扩展站点数和入堆次数
+  说    明：用于比较不同算法的剪枝效果
+***************************************************************************/
+const SearchStats& PathFinder::getLastStats() const {
+    return lastStats;
 }
 
 /***************************************************************************
@@ -49,7 +516,9 @@ void PathFinder::setGraph(const MetroGraph* graph) {
 			const QString& to       - 终点站点名称
 			SearchStrategy strategy - 搜索策略
   返 回 值：MetroPath - 搜索得到的地铁线路
-  说    明：
+  说    明：设置了结果缓存时先查缓存，命中则不再搜索，统计清零；返回的路径
+            与缓存中的结果共享数据，拷贝不复制各路径段。各搜索都跳过临时
+            封闭的车站和区间，无需重建任何索引
 ***************************************************************************/
 MetroPath PathFinder::findPath(const QString& from, const QString& to, SearchStrategy strategy) {
     qDebug() << "开始搜索从" << from << "到" << to << "的策略:" << strategy;
@@ -70,16 +539,58 @@ MetroPath PathFinder::findPath(const QString& from, const QString& to, SearchStr
         return MetroPath();
     }
 
+    /* 封闭只在此取一次，缓存键、查表和收缩层次的取舍、搜索和构建路径都按它进行*/
+    const ClosureMaskPtr mask     = graph->getClosures();
+    const ClosureMaskPtr closures = activeClosures(mask);
+    if (routeCache == nullptr) {
+        return searchPath(from, to, strategy, closures);
+    }
+
+    /* 键中的设置只取该策略用到的一项，其余设置改变时仍可命中*/
+    RouteCache::Key key;
+    key.from     = graph->getStationId(from);
+    key.to       = graph->getStationId(to);
+    key.strategy = strategy;
+    key.variant  = strategy == MIN_TRANSFER ? int(transferTieBreak)
+                 : strategy == MIN_DISTANCE ? int(distanceAlgorithm) : int(stationsAlgorithm);
+    key.version  = graph->getVersion();
+
+    /* 临时封闭有变化时先清除经过封闭处的结果*/
+    key.closures = mask != nullptr ? mask->generation : 0;
+    routeCache->acceptClosures(*graph, mask);
+    MetroPathPtr cached = routeCache->find(key);
+    if (cached != nullptr) {
+        lastStats = SearchStats();
+        qDebug() << "命中路径缓存";
+        return *cached;
+    }
+
+    MetroPathPtr path = std::make_shared<const MetroPath>(searchPath(from, to, strategy, closures));
+    routeCache->insert(key, path);
+    return *path;
+}
+
+/***************************************************************************
+  函数名称：PathFinder::searchPath
+  功    能：按策略分派搜索
+  输入参数：const QString& from     - 起点站点名称
+			const QString& to       - 终点站点名称
+			SearchStrategy strategy - 搜索策略
+			const ClosureMaskPtr& closures - 本次查询生效的临时封闭，没有时为空
+  返 回 值：MetroPath - 搜索得到的地铁线路
+  说    明：调用方已检查起点和终点存在
+***************************************************************************/
+MetroPath PathFinder::searchPath(const QString& from, const QString& to, SearchStrategy strategy, const ClosureMaskPtr& closures) {
     /* 根据策略选择搜索方法*/
     switch (strategy) {
         case MIN_TRANSFER:
-            return findMinTransferPath(from, to);
+            return findMinTransferPath(from, to, closures);
         case MIN_STATIONS:
-            return findMinStationsPath(from, to);
+            return findMinStationsPath(from, to, closures);
         case MIN_DISTANCE:
-            return findMinDistancePath(from, to);
+            return findMinDistancePath(from, to, closures);
         default:
-            return findMinStationsPath(from, to);
+            return findMinStationsPath(from, to, closures);
     }
 }
 
@@ -88,10 +599,12 @@ MetroPath PathFinder::findPath(const QString& from, const QString& to, SearchStr
   功    能：最少换乘策略
   输入参数：const QString& from - 起点名称 
 			const QString& to   - 终点名称
+			const ClosureMaskPtr& closures - 本次查询生效的临时封闭，没有时为空
   返 回 值：MetroPath - 搜索得到的地铁线路
-  说    明：使用BFS算法辅助搜索
+  说    明：在(站点, 线路)扩展图上搜索，换乘次数相同时按设置比较站点数或距离；
+            有对应的全源路径表且站点少者优先时直接查表
 ***************************************************************************/
-MetroPath PathFinder::findMinTransferPath(const QString& from, const QString& to) {
+MetroPath PathFinder::findMinTransferPath(const QString& from, const QString& to, const ClosureMaskPtr& closures) {
     qDebug() << "开始搜索最少换乘路径从" << from << "到" << to;
 
     /* 检查graph指针是否有效*/
@@ -110,174 +623,329 @@ MetroPath PathFinder::findMinTransferPath(const QString& from, const QString& to
         return MetroPath();
     }
 
-    /* 获取所有线路和站点信息*/
-    QMap<QString, QVector<QString>> lineStations = getLineStations();
-    QMap<QString, QVector<QString>> stationLines = getStationLines();
-
-    /* 找出起点和终点所在的线路*/
-    QVector<QString> startLines = stationLines[from];
-    QVector<QString> endLines   = stationLines[to];
-
-    if (startLines.isEmpty() || endLines.isEmpty()) {
+    const StationId fromId = graph->getStationId(from);
+    const StationId toId   = graph->getStationId(to);
+    if (graph->getStationLineIds(fromId).isEmpty() || graph->getStationLineIds(toId).isEmpty()) {
         qDebug() << "错误: 无法确定起点或终点所在的线路";
         return MetroPath();
     }
 
-    qDebug() << "起点" << from << "所在线路:" << startLines;
-    qDebug() << "终点" << to   << "所在线路:" << endLines;
-
-    /* 如果起点和终点在同一条线路上，直接返回这条线路上的路径*/
-    for (const QString& line : startLines) {
-        if (endLines.contains(line)) {
-            qDebug() << "起点和终点在同一线路" << line << "上";
-            QVector<QString> stationNames = findPathOnLine(line, from, to);
-            if (!stationNames.isEmpty()) {
-                MetroPath result = buildPath(stationNames);
-                result.transferCount = 0;
-                return result;
-            }
-        }
+    int                transfers  = 0;
+    QVector<StationId> stationIds;
+    if (hasRouteTable(closures) && transferTieBreak == FEWER_STATIONS) {
+        lastStats  = SearchStats();
+        stationIds = routeTable->getPath(MIN_TRANSFER, fromId, toId);
+        transfers  = routeTable->getTransfers(MIN_TRANSFER, fromId, toId);
     }
-
-    /* 构建线路图（将每条线路视为一个节点）*/
-    QMap<QString, QVector<QPair<QString, int>>> lineGraph; // 线路图：线路 -> [(相邻线路, 权重)]
-
-    /* 找出所有换乘站，并构建线路之间的连接*/
-    for (const auto& line1 : lineStations.keys()) {
-        for (const auto& line2 : lineStations.keys()) {
-            if (line1 == line2) 
-                continue;
-
-            /* 检查两条线路是否有共同的站点（换乘站）*/
-            for (const QString& station : lineStations[line1]) {
-                if (lineStations[line2].contains(station)) {
-                    /* 找到换乘站，在两条线路之间添加边*/
-                    /* 检查是否已存在连接*/
-                    bool exists = false;
-                    for (const auto& pair : lineGraph[line1]) {
-                        if (pair.first == line2) {
-                            exists = true;
-                            break;
-                        }
-                    }
-
-                    if (!exists) {
-                        lineGraph[line1].append(qMakePair(line2, 1));
-                        lineGraph[line2].append(qMakePair(line1, 1));
-                    }
-                    break;
-                }
-            }
-        }
+    else {
+        stationIds = minTransferSearch(fromId, toId, transfers, closures);
+    }
+    if (stationIds.isEmpty()) {
+        qDebug() << "最少换乘算法未找到有效路径";
+        // 回退到最少站点算法
+        qDebug() << "回退到最少站点算法";
+        return findMinStationsPath(from, to, closures);
     }
 
-    /* 使用BFS找到最少换乘路径*/
-    QMap<QString, int>     dist;
-    QMap<QString, QString> prev;
-    QSet<QString>          visited;
+    MetroPath result = buildPath(stationIds, closures);
+    result.transferCount = transfers;
 
-    /* 初始化距离*/
-    for (const auto& line : lineGraph.keys()) {
-        dist[line] = std::numeric_limits<int>::max();
-    }
+    qDebug() << "最少换乘路径找到，换乘次数:" << result.transferCount;
 
-    /* 将起点所在的所有线路加入队列*/
-    std::queue<QString> q;
+    return result;
+}
 
-    for (const QString& line : startLines) {
-        dist[line] = 0;
-        q.push(line);
-        visited.insert(line);
+/***************************************************************************
+  函数名称：PathFinder::minTransferSearch
+  功    能：在(站点, 线路)扩展图上搜索换乘最少的路径
+  输入参数：StationId from      - 起点编号
+			StationId to        - 终点编号
+			int&      transfers - 输出换乘次数
+			const ClosureMaskPtr& closures - 本次查询生效的临时封闭，没有时为空
+  返 回 值：QVector<StationId> - 站点编号列表，不可达时为空
+  说    明：扩展图的节点即CSR中的(站点, 线路)分组，无需为查询建图：沿线路
+            到相邻站的同线分组不增加换乘，在同一站点换到其他线路的分组增加一次
+            换乘。代价按(换乘次数, 次要项, 最后项)逐项比较，各项均非负，
+            Dijkstra首次确定终点的某个分组时即为字典序最优，因此换乘次数
+            一定最少，并在换乘次数相同的路径中按transferTieBreak取最优
+  ***************************************************************************/
+QVector<StationId> PathFinder::minTransferSearch(StationId from, StationId to, int& transfers, const ClosureMaskPtr& closures) {
+    const MetroCsr& csr = graph->getCsr();
+    lastStats = SearchStats();
+    scratch.prepare(graph->getStationCount(), csr.groupLines.size());
+    const quint32       epoch = scratch.epoch;
+    TransferSearchSide& side  = scratch.groups;
+    std::vector<std::pair<TransferCost, int>>& heap = side.heap;
+    CompareTransferCost compare;
+
+    /* 起点在各条线路上的分组代价均为0*/
+    for (int g = csr.groupOffsets[from]; g < csr.groupOffsets[from + 1]; g++) {
+        side.cost[g]    = TransferCost();
+        side.prev[g]    = -1;
+        side.station[g] = from;
+        side.reached[g] = epoch;
+        heap.push_back(std::make_pair(TransferCost(), g));
+        lastStats.heapPushes++;
     }
+    std::make_heap(heap.begin(), heap.end(), compare);
 
-    /* BFS算法*/
-    while (!q.empty()) {
-        QString currentLine = q.front();
-        q.pop();
+    const bool byStations = transferTieBreak == FEWER_STATIONS;
+    auto relax = [&](int group, StationId station, int previous, const TransferCost& cost) {
+        if (side.settled[group] == epoch) {
+            return;
+        }
+        if (side.reached[group] == epoch && !compare(std::make_pair(side.cost[group], group), std::make_pair(cost, group))) {
+            return;
+        }
+        side.cost[group]    = cost;
+        side.prev[group]    = previous;
+        side.station[group] = station;
+        side.reached[group] = epoch;
+        heap.push_back(std::make_pair(cost, group));
+        std::push_heap(heap.begin(), heap.end(), compare);
+        lastStats.heapPushes++;
+    };
+
+    int found = -1;
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), compare);
+        const int current = heap.back().second;
+        heap.pop_back();
+        if (side.settled[current] == epoch) {
+            continue; // 过期条目
+        }
+        side.settled[current] = epoch;
+        lastStats.nodesExpanded++;
 
-        /* 如果当前线路是终点所在的线路，找到路径*/
-        if (endLines.contains(currentLine)) {
+        const StationId    station = side.station[current];
+        const TransferCost cost    = side.cost[current];
+        if (station == to) {
+            found = current;
             break;
         }
 
-        /* 遍历所有相邻线路*/
-        for (const auto& [neighbor, weight] : lineGraph[currentLine]) {
-            if (!visited.contains(neighbor)) {
-                dist[neighbor] = dist[currentLine] + weight;
-                prev[neighbor] = currentLine;
-                visited.insert(neighbor);
-                q.push(neighbor);
+        /* 沿当前线路前往相邻站点*/
+        const LineId line = csr.groupLines[current];
+        for (int k = csr.groupEdgeOffsets[current]; k < csr.groupEdgeOffsets[current + 1]; k++) {
+            const int       e        = csr.groupEdges[k];
+            if (closures != nullptr && closures->isEdgeClosed(e)) {
+                continue; // 封闭的区间
             }
+            const StationId neighbor = csr.targets[e];
+            TransferCost    next     = cost;
+            next.primary   += byStations ? 1.0 : csr.weights[e];
+            next.secondary += byStations ? csr.weights[e] : 1.0;
+            relax(graph->findLineGroup(neighbor, line), neighbor, current, next);
         }
-    }
-
-    /* 找到最少换乘的线路路径*/
-    QString bestEndLine;
-    int minTransfers = std::numeric_limits<int>::max();
 
-    for (const QString& line : endLines) {
-        if (dist[line] < minTransfers) {
-            minTransfers = dist[line];
-            bestEndLine  = line;
+        /* 在本站换乘其他线路*/
+        for (int g = csr.groupOffsets[station]; g < csr.groupOffsets[station + 1]; g++) {
+            if (g != current) {
+                TransferCost next = cost;
+                next.transfers++;
+                relax(g, station, current, next);
+            }
         }
     }
 
-    if (minTransfers == std::numeric_limits<int>::max()) {
-        qDebug() << "最少换乘算法未找到有效路径";
-        // 回退到最少站点算法
-        qDebug() << "回退到最少站点算法";
-        return findMinStationsPath(from, to);
+    if (found < 0) {
+        return QVector<StationId>();
     }
 
-    /* 重构线路路径*/
-    QVector<QString> linePath;
-    QString currentLine = bestEndLine;
-
-    while (!currentLine.isEmpty()) {
-        linePath.prepend(currentLine);
-        currentLine = prev.value(currentLine, "");
+    /* 重构路径，换乘边两端为同一站点，只保留一次*/
+    QVector<StationId> path;
+    for (int g = found; g >= 0; g = side.prev[g]) {
+        if (path.isEmpty() || path.last() != side.station[g]) {
+            path.append(side.station[g]);
+        }
     }
+    std::reverse(path.begin(), path.end());
 
-    qDebug() << "线路路径:" << linePath;
+    transfers = side.cost[found].transfers;
+    qDebug() << "扩展分组数:" << lastStats.nodesExpanded << "换乘次数:" << transfers;
+    return path;
+}
 
-    /* 将线路路径转换为站点路径*/
-    QVector<QString> stationNames = convertLinePathToStationPath(linePath, from, to);
-    if (stationNames.isEmpty()) {
-        qDebug() << "错误: 无法将线路路径转换为站点路径";
-        // 回退到最少站点算法
-        qDebug() << "回退到最少站点算法";
-        return findMinStationsPath(from, to);
+/***************************************************************************
+  函数名称：PathFinder::findMinCostPath
+  功    能：查找广义代价最小的路径
+  输入参数：const QString& from       - 起点名称
+			const QString& to         - 终点名称
+			CostBreakdown* breakdown  - 不为空时输出代价分解，无结果时total为-1
+  返 回 值：MetroPath - 搜索得到的地铁线路，不可达或没有对应的代价模型时为空
+  说    明：权重随查询变化，不经过结果缓存和全源路径表；跳过临时封闭的
+            车站和区间。路径段按搜索实际乘坐的线路划分，换乘次数与代价
+            分解一致
+  ***************************************************************************/
+MetroPath PathFinder::findMinCostPath(const QString& from, const QString& to, CostBreakdown* breakdown) {
+    CostBreakdown costs;
+    costs.total = -1;
+    if (breakdown != nullptr) {
+        *breakdown = costs;
     }
 
-    MetroPath result = buildPath(stationNames);
-    result.transferCount = minTransfers;
+    if (graph == nullptr || !graph->hasStation(from) || !graph->hasStation(to)) {
+        qDebug() << "错误: 起点或终点不存在";
+        return MetroPath();
+    }
+    if (costModel == nullptr || !costModel->matches(*graph)) {
+        qDebug() << "错误: 广义代价模型与当前图版本不对应";
+        return MetroPath();
+    }
 
-    qDebug() << "最少换乘路径找到，换乘次数:" << result.transferCount;
+    const ClosureMaskPtr closures = activeClosures(graph->getClosures());
+    const QVector<int>   groups   = minCostSearch(graph->getStationId(from), graph->getStationId(to), costs, closures);
+    if (groups.isEmpty()) {
+        qDebug() << "广义代价搜索未找到有效路径";
+        return MetroPath();
+    }
+    if (breakdown != nullptr) {
+        *breakdown = costs;
+    }
 
+    MetroPath result = buildGroupPath(groups);
+    qDebug() << "广义代价最小路径找到，代价:" << costs.total << "换乘次数:" << costs.transfers;
     return result;
 }
 
 /***************************************************************************
-  函数名称：PathFinder::getStationLines
-  功    能：获取站点到线路的映射
-  输入参数：
-  返 回 值：QMap<Qstring,QVector<QString>> - 站点到线路的映射
-  说    明：
-***************************************************************************/
-QMap<QString, QVector<QString>> PathFinder::getStationLines() const {
-    QMap<QString, QVector<QString>> stationLines;
+  函数名称：PathFinder::minCostSearch
+  功    能：在(站点, 线路)扩展图上搜索广义代价最小的路径
+  输入参数：StationId from          - 起点编号
+			StationId to            - 终点编号
+			CostBreakdown& breakdown - 输出代价分解
+			const ClosureMaskPtr& closures - 本次查询生效的临时封闭，没有时为空
+  返 回 值：QVector<int> - 从起点到终点的(站点, 线路)分组序列，不可达时为空
+  说    明：与最少换乘搜索使用同一扩展图：沿线路到相邻站的代价为乘车权重
+            乘以出边的乘车秒数，同站换到其他线路的代价为步行权重乘以该线路
+            对的步行秒数再加换乘惩罚。各项时间已按出边和分组预先算好，权重
+            只在松弛时相乘，内层循环与CSR上的Dijkstra相同。启发为乘车权重
+            乘以地标给出的乘车时间下界，换乘的代价非负，因此启发不超过真实
+            代价且满足一致性，首次确定终点的某个分组时即为最优
+  ***************************************************************************/
+QVector<int> PathFinder::minCostSearch(StationId from, StationId to, CostBreakdown& breakdown, const ClosureMaskPtr& closures) {
+    const MetroCsr&      csr      = graph->getCsr();
+    const CostModel&     model    = *costModel;
+    lastStats = SearchStats();
+    scratch.prepare(graph->getStationCount(), csr.groupLines.size());
+    const quint32   epoch = scratch.epoch;
+    CostSearchSide& side  = scratch.costs;
+    std::vector<std::pair<double, int>>& heap = side.heap;
+    std::greater<std::pair<double, int>> compare;
+
+    const double rideWeight = costWeights.inVehicle;
+    const double walkWeight = costWeights.walking;
+    const double penalty    = costWeights.transfer;
+
+    /* 启发取乘车权重乘以各地标三角不等式给出的乘车时间下界中的最大者*/
+    const int    landmarkCount = model.getLandmarkCount();
+    const float* targetSeconds = model.getLandmarkRow(to);
+    auto heuristic = [&](StationId station) {
+        const float* row   = model.getLandmarkRow(station);
+        float        bound = 0;
+        for (int l = 0; l < landmarkCount; l++) {
+            if (row[l] >= 0 && targetSeconds[l] >= 0) {
+                bound = qMax(bound, std::fabs(row[l] - targetSeconds[l]));
+            }
+        }
+        return rideWeight * bound;
+    };
+
+    /* 起点在各条线路上的分组代价均为0*/
+    const double fromBound = heuristic(from);
+    for (int g = csr.groupOffsets[from]; g < csr.groupOffsets[from + 1]; g++) {
+        side.cost[g]    = 0;
+        side.prev[g]    = -1;
+        side.station[g] = from;
+        side.reached[g] = epoch;
+        heap.push_back(std::make_pair(fromBound, g));
+        lastStats.heapPushes++;
+    }
+    std::make_heap(heap.begin(), heap.end(), compare);
+
+    auto relax = [&](int group, StationId station, int previous, double cost, double bound) {
+        if (side.settled[group] == epoch || (side.reached[group] == epoch && side.cost[group] <= cost)) {
+            return;
+        }
+        side.cost[group]    = cost;
+        side.prev[group]    = previous;
+        side.station[group] = station;
+        side.reached[group] = epoch;
+        heap.push_back(std::make_pair(cost + bound, group));
+        std::push_heap(heap.begin(), heap.end(), compare);
+        lastStats.heapPushes++;
+    };
+
+    int found = -1;
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), compare);
+        const int current = heap.back().second;
+        heap.pop_back();
+        if (side.settled[current] == epoch) {
+            continue; // 过期条目
+        }
+        side.settled[current] = epoch;
+        lastStats.nodesExpanded++;
 
-    /* 遍历所有连接，构建站点到线路的映射*/
-    for (const StationConnection& conn : graph->getConnections()) {
-        if (!stationLines[conn.station1].contains(conn.line)) {
-            stationLines[conn.station1].append(conn.line);
+        const StationId station = side.station[current];
+        const double    cost    = side.cost[current];
+        if (station == to) {
+            found = current;
+            break;
+        }
+
+        /* 沿当前线路前往相邻站点*/
+        const LineId line = csr.groupLines[current];
+        for (int k = csr.groupEdgeOffsets[current]; k < csr.groupEdgeOffsets[current + 1]; k++) {
+            const int e = csr.groupEdges[k];
+            if (closures != nullptr && closures->isEdgeClosed(e)) {
+                continue; // 封闭的区间
+            }
+            const StationId neighbor = csr.targets[e];
+            relax(graph->findLineGroup(neighbor, line), neighbor, current,
+                  cost + rideWeight * model.getRideSeconds(e), heuristic(neighbor));
+        }
+
+        /* 在本站步行换乘其他线路，启发与当前分组相同*/
+        const int    first = csr.groupOffsets[station];
+        const float* walks = model.getWalkRow(current);
+        const double bound = heuristic(station);
+        for (int g = first; g < csr.groupOffsets[station + 1]; g++) {
+            if (g != current) {
+                relax(g, station, current, cost + walkWeight * walks[g - first] + penalty, bound);
+            }
+        }
+    }
+
+    if (found < 0) {
+        return QVector<int>();
+    }
+
+    /* 重构分组序列并分解代价，换乘边两端为同一站点*/
+    QVector<int> path;
+    for (int g = found; g >= 0; g = side.prev[g]) {
+        const int previous = side.prev[g];
+        if (previous >= 0 && side.station[previous] == side.station[g]) {
+            breakdown.walking += model.getWalkRow(previous)[g - csr.groupOffsets[side.station[g]]];
+            breakdown.transfers++;
         }
-        if (!stationLines[conn.station2].contains(conn.line)) {
-            stationLines[conn.station2].append(conn.line);
+        else if (previous >= 0) {
+            float ride = std::numeric_limits<float>::max();
+            for (int k = csr.groupEdgeOffsets[previous]; k < csr.groupEdgeOffsets[previous + 1]; k++) {
+                const int e = csr.groupEdges[k];
+                if (csr.targets[e] == side.station[g] && (closures == nullptr || !closures->isEdgeClosed(e))) {
+                    ride = qMin(ride, model.getRideSeconds(e));
+                }
+            }
+            breakdown.inVehicle += ride;
         }
+        path.append(g);
     }
+    std::reverse(path.begin(), path.end());
 
-    return stationLines;
+    breakdown.total = side.cost[found];
+    qDebug() << "扩展分组数:" << lastStats.nodesExpanded << "广义代价:" << breakdown.total;
+    return path;
 }
 
 /***************************************************************************
@@ -285,15 +953,30 @@ QMap<QString, QVector<QString>> PathFinder::getStationLines() const {
   功    能：最少站点策略
   输入参数：const QString& from - 起点名称
 			const QString& to   - 终点名称
+			const ClosureMaskPtr& closures - 本次查询生效的临时封闭，没有时为空
   返 回 值：MetroPath - 搜索得到的地铁线路
-  说    明：使用BFS算法辅助搜索
+  说    明：有对应的全源路径表时直接查表，否则按设置使用BFS、双向BFS或
+            以地标下界为启发的A*
   ***************************************************************************/
-MetroPath PathFinder::findMinStationsPath(const QString& from, const QString& to) {
+MetroPath PathFinder::findMinStationsPath(const QString& from, const QString& to, const ClosureMaskPtr& closures) {
     qDebug() << "开始搜索最少站点路径从" << from << "到" << to;
 
     /* 使用BFS找到最短路径（站点数最少）*/
-    QVector<QString> stationNames = bfsShortestPath(from, to);
-    MetroPath        path         = buildPath(stationNames);
+    StationId          fromId     = graph->getStationId(from);
+    StationId          toId       = graph->getStationId(to);
+    QVector<StationId> stationIds;
+    if (hasRouteTable(closures)) {
+        lastStats  = SearchStats();
+        stationIds = routeTable->getPath(MIN_STATIONS, fromId, toId);
+    }
+    else if (stationsAlgorithm == ALT_BFS) {
+        stationIds = landmarkBfsPath(fromId, toId, closures);
+    }
+    else {
+        stationIds = stationsAlgorithm == BIDIRECTIONAL_BFS ? bidirectionalBfsPath(fromId, toId, closures)
+                                                            : bfsShortestPath(fromId, toId, closures);
+    }
+    MetroPath          path       = buildPath(stationIds, closures);
 
     qDebug() << "最少站点路径找到，站点数:" << path.stationCount;
     return path;
@@ -304,15 +987,34 @@ MetroPath PathFinder::findMinStationsPath(const QString& from, const QString& to
   功    能：最短距离策略
   输入参数：const QString& from - 起点名称
 			const QString& to   - 终点名称
+			const ClosureMaskPtr& closures - 本次查询生效的临时封闭，没有时为空
   返 回 值：MetroPath - 搜索得到的地铁线路
-  说    明：使用Dijkstra算法辅助搜索
+  说    明：依次优先使用对应当前图版本的全源路径表和收缩层次，都没有时按
+            设置使用Dijkstra、A*、ALT或双向Dijkstra算法；收缩层次的捷径按
+            未封闭的图计算，有临时封闭时不使用。封闭只会使里程变长，地标
+            下界仍然成立，ALT不受影响
   ***************************************************************************/
-MetroPath PathFinder::findMinDistancePath(const QString& from, const QString& to) {
+MetroPath PathFinder::findMinDistancePath(const QString& from, const QString& to, const ClosureMaskPtr& closures) {
     qDebug() << "开始搜索最短距离路径从" << from << "到" << to;
 
-    /* 使用Dijkstra算法找到最短路径（距离最短）*/
-    QVector<QString> stationNames = dijkstraShortestPath(from, to);
-    MetroPath        path         = buildPath(stationNames);
+    /* 按设置的算法找到最短路径（距离最短）*/
+    StationId          fromId = graph->getStationId(from);
+    StationId          toId   = graph->getStationId(to);
+    QVector<StationId> stationIds;
+    if (hasRouteTable(closures)) {
+        lastStats  = SearchStats();
+        stationIds = routeTable->getPath(MIN_DISTANCE, fromId, toId);
+    }
+    else if (hierarchy != nullptr && hierarchy->matches(*graph) && closures == nullptr) {
+        stationIds = hierarchyShortestPath(fromId, toId);
+    }
+    else if (distanceAlgorithm == BIDIRECTIONAL_DIJKSTRA) {
+        stationIds = bidirectionalDijkstraPath(fromId, toId, closures);
+    }
+    else {
+        stationIds = dijkstraShortestPath(fromId, toId, distanceAlgorithm, closures);
+    }
+    MetroPath          path       = buildPath(stationIds, closures);
 
     qDebug() << "最短距离路径找到，总距离:" << path.totalDistance;
     return path;
@@ -320,548 +1022,1495 @@ MetroPath PathFinder::findMinDistancePath(const QString& from, const QString& to
 
 /***************************************************************************
   函数名称：PathFinder::dijkstraShortestPath
-  功    能：Dijkstra算法实现最短路径搜索
-  输入参数：const QString& from - 起点名称
-			const QString& to   - 终点名称
-  返 回 值：QVector<QString> - 搜索得到的站点名称列表
-  说    明：
+  功    能：Dijkstra、A*或ALT算法实现最短路径搜索
+  输入参数：StationId from              - 起点编号
+			StationId to                - 终点编号
+			DistanceAlgorithm algorithm - DIJKSTRA不使用启发，A_STAR以到终点的直线
+			                              距离为启发，ALT_A_STAR再与地标下界取较大者
+			const ClosureMaskPtr& closures - 本次查询生效的临时封闭，没有时为空
+  返 回 值：QVector<StationId> - 搜索得到的站点编号列表
+  说    明：二叉堆按(距离+启发值, 编号)出堆，不使用启发时与逐个扫描取最小者
+            的顺序一致；距离变小时直接压入新条目，出堆时跳过过期条目；终点
+            出堆即停止。边长本身就是两站的直线距离，直线距离启发满足三角
+            不等式；地标下界由最短里程的三角不等式得到，同样是一致的，两个
+            一致启发的较大者仍一致，因此A*和ALT都在终点出堆时得到最短距离
   ***************************************************************************/
-QVector<QString> PathFinder::dijkstraShortestPath(const QString& from, const QString& to) {
-    qDebug() << "开始Dijkstra搜索从" << from << "到" << to;
-
-    QMap<QString, double>  dist;
-    QMap<QString, QString> prev;
-    QSet<QString>          unvisited;
+QVector<StationId> PathFinder::dijkstraShortestPath(StationId from, StationId to, DistanceAlgorithm algorithm, const ClosureMaskPtr& closures) {
+    const bool useHeuristic = algorithm == A_STAR || algorithm == ALT_A_STAR;
+    qDebug() << (useHeuristic ? "开始A*搜索从" : "开始Dijkstra搜索从") << graph->getStationName(from) << "到" << graph->getStationName(to);
+
+    lastStats = SearchStats();
+    const MetroCsr&      csr          = graph->getCsr();
+    const int            stationCount = graph->getStationCount();
+    if (from == INVALID_ID || to == INVALID_ID) {
+        return QVector<StationId>();
+    }
 
     /* 初始化*/
-    QVector<QString> allStations = graph->getStationNames();
-    for (const QString& station : allStations) {
-        dist[station] = std::numeric_limits<double>::max();
-        prev[station] = "";
-        unvisited.insert(station);
+    scratch.prepare(stationCount);
+    const quint32 epoch = scratch.epoch;
+    SearchSide&   side  = scratch.forward;
+    std::vector<std::pair<double, StationId>>& heap = side.heap;
+    ComparePair compare;
+    LandmarkBound landmarks;
+    if (algorithm == ALT_A_STAR) {
+        landmarks = LandmarkBound(graph->getLandmarks(), to);
     }
-    dist[from] = 0;
-
-    while (!unvisited.isEmpty()) {
-        /* 找到未访问节点中距离最小的*/
-        QString current;
-        double minDist = std::numeric_limits<double>::max();
-        for (const QString& station : unvisited) {
-            if (dist[station] < minDist) {
-                minDist = dist[station];
-                current = station;
-            }
+    auto heuristic = [&](StationId station) {
+        if (!useHeuristic) {
+            return 0.0;
         }
-
-        if (current.isEmpty()) {
-            break; // 没有可达节点
+        const double straight = graph->calculateDistance(station, to);
+        return algorithm == ALT_A_STAR ? qMax(straight, landmarks.distance(station)) : straight;
+    };
+
+    side.dist[from]    = 0;
+    side.prev[from]    = INVALID_ID;
+    side.reached[from] = epoch;
+    heap.push_back(std::make_pair(heuristic(from), from));
+    lastStats.heapPushes++;
+
+    bool found = false;
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), compare);
+        const StationId current = heap.back().second;
+        heap.pop_back();
+
+        if (side.settled[current] == epoch) {
+            continue; // 过期条目
         }
+        side.settled[current] = epoch;
+        lastStats.nodesExpanded++;
 
         if (current == to) {
+            found = true;
             break; // 找到目标节点
         }
 
-        unvisited.remove(current);
-
-        /* 更新邻居节点的距离*/
-        Station station = graph->getStation(current);
-        for (const QString& neighbor : station.connectedStations) {
-            if (unvisited.contains(neighbor)) {
-                double alt = dist[current] + calculateDistance(current, neighbor);
-                if (alt < dist[neighbor]) {
-                    dist[neighbor] = alt;
-                    prev[neighbor] = current;
-                }
+        /* 更新邻居节点的距离，边长已预先存放在CSR中*/
+        const double base = side.dist[current];
+        for (int e = csr.offsets[current]; e < csr.offsets[current + 1]; e++) {
+            if (closures != nullptr && closures->isEdgeClosed(e)) {
+                continue; // 封闭的区间
+            }
+            StationId neighbor = csr.targets[e];
+            if (side.settled[neighbor] == epoch) {
+                continue;
+            }
+            double alt = base + csr.weights[e];
+            if (side.reached[neighbor] != epoch || alt < side.dist[neighbor]) {
+                side.dist[neighbor]    = alt;
+                side.prev[neighbor]    = current;
+                side.reached[neighbor] = epoch;
+                double key = alt + heuristic(neighbor);
+                heap.push_back(std::make_pair(key, neighbor));
+                std::push_heap(heap.begin(), heap.end(), compare);
+                lastStats.heapPushes++;
             }
         }
     }
 
-    /* 重构路径*/
-    QVector<QString> path;
-    QString current = to;
-    while (!current.isEmpty()) {
-        path.prepend(current);
-        current = prev.value(current, "");
+    /* 检查是否找到了有效路径*/
+    if (!found || from == to) {
+        qDebug() << "最短距离搜索未找到有效路径";
+        return QVector<StationId>();
     }
 
-    /* 检查是否找到了有效路径*/
-    if (path.size() < 2 || path.first() != from) {
-        qDebug() << "Dijkstra未找到有效路径";
-        return QVector<QString>();
+    /* 重构路径*/
+    QVector<StationId> path;
+    for (StationId current = to; current != INVALID_ID; current = side.prev[current]) {
+        path.append(current);
     }
+    std::reverse(path.begin(), path.end());
 
-    qDebug() << "Dijkstra找到路径:" << path;
+    qDebug() << "最短距离搜索找到路径，站点数:" << path.size() << "扩展站点数:" << lastStats.nodesExpanded;
     return path;
 }
 /***************************************************************************
   函数名称：PathFinder::bfsShortestPath
   功    能：BFS算法实现最短路径搜索
-  输入参数：const QString& from - 起点名称
-			const QString& to   - 终点名称
-  返 回 值：QVector<QString> - 搜索得到的站点名称列表
-  说    明：
+  输入参数：StationId from - 起点编号
+			StationId to   - 终点编号
+			const ClosureMaskPtr& closures - 本次查询生效的临时封闭，没有时为空
+  返 回 值：QVector<StationId> - 搜索得到的站点编号列表
+  说    明：CSR中的邻居已按站点名称有序，出队时无需再排序
   ***************************************************************************/
-QVector<QString> PathFinder::bfsShortestPath(const QString& from, const QString& to) {
-    qDebug() << "开始BFS搜索从" << from << "到" << to;
+QVector<StationId> PathFinder::bfsShortestPath(StationId from, StationId to, const ClosureMaskPtr& closures) {
+    qDebug() << "开始BFS搜索从" << graph->getStationName(from) << "到" << graph->getStationName(to);
 
     /* 检查起点和终点是否存在*/
-    if (!graph->hasStation(from)) {
-        qDebug() << "错误: 起点" << from << "不存在";
-        return QVector<QString>();
+    if (from == INVALID_ID) {
+        qDebug() << "错误: 起点不存在";
+        return QVector<StationId>();
     }
-    if (!graph->hasStation(to)) {
-        qDebug() << "错误: 终点" << to   << "不存在";
-        return QVector<QString>();
+    if (to == INVALID_ID) {
+        qDebug() << "错误: 终点不存在";
+        return QVector<StationId>();
     }
 
-    /* 使用BFS找到最短路径*/
-    QMap<QString, QString> cameFrom;
-    QSet<QString>          visited;
-    std::queue<QString>    queue;
+    /* 使用BFS找到最短路径，队列和标记取自复用的临时数组*/
+    const MetroCsr&      csr      = graph->getCsr();
+    lastStats = SearchStats();
+    scratch.prepare(graph->getStationCount());
+    const quint32       epoch = scratch.epoch;
+    SearchSide&         side  = scratch.forward;
+    QVector<StationId>& queue = side.queue;
 
-    queue.push(from);
-    visited.insert(from);
-    cameFrom[from] = "";
+    queue.append(from);
+    side.prev[from]    = INVALID_ID;
+    side.reached[from] = epoch;
 
-    while (!queue.empty()) {
-        QString current = queue.front();
-        queue.pop();
+    for (int head = 0; head < queue.size(); head++) {
+        StationId current = queue[head];
+        lastStats.nodesExpanded++;
 
         if (current == to) {
             /* 重构路径*/
-            QVector<QString> path;
-            QString node = current;
-            while (!node.isEmpty()) {
-                path.prepend(node);
-                node = cameFrom.value(node, "");
+            QVector<StationId> path;
+            for (StationId node = current; node != INVALID_ID; node = side.prev[node]) {
+                path.append(node);
             }
-            qDebug() << "找到路径:" << path;
+            std::reverse(path.begin(), path.end());
+            qDebug() << "找到路径，站点数:" << path.size();
             return path;
         }
 
-        Station station = graph->getStation(current);
-
-        /* 按照某种顺序处理邻居，例如按名称排序以确保一致性*/
-        QVector<QString> neighbors = station.connectedStations;
-        std::sort(neighbors.begin(), neighbors.end());
-
-        for (const QString& neighbor : neighbors) {
-            if (!visited.contains(neighbor)) {
-                visited.insert(neighbor);
-                cameFrom[neighbor] = current;
-                queue.push(neighbor);
+        for (int e = csr.offsets[current]; e < csr.offsets[current + 1]; e++) {
+            if (closures != nullptr && closures->isEdgeClosed(e)) {
+                continue; // 封闭的区间
+            }
+            StationId neighbor = csr.targets[e];
+            if (side.reached[neighbor] != epoch) {
+                side.reached[neighbor] = epoch;
+                side.prev[neighbor]    = current;
+                queue.append(neighbor);
+                lastStats.heapPushes++;
             }
         }
     }
 
     qDebug() << "未找到路径";
-    return QVector<QString>();
+    return QVector<StationId>();
 }
 
 /***************************************************************************
-  函数名称：PathFinder::buildPath
-  功    能：从站点名称列表构建完整路径信息
-  输入参数：const QVector<QString>& stationNames - 站点名称列表
-  返 回 值：
-  说    明：
-***************************************************************************/
-MetroPath PathFinder::buildPath(const QVector<QString>& stationNames) {
-    MetroPath path;
-    path.transferCount = 0;
-    path.stationCount  = 0;
-    path.totalDistance = 0;
+  函数名称：PathFinder::landmarkBfsPath
+  功    能：以地标下界为启发的A*实现最少站点路径搜索
+  输入参数：StationId from - 起点编号
+			StationId to   - 终点编号
+			const ClosureMaskPtr& closures - 本次查询生效的临时封闭，没有时为空
+  返 回 值：QVector<StationId> - 搜索得到的站点编号列表
+  说    明：每段区间代价为1，启发值为各地标区间数之差的最大值，满足三角不等式，
+            终点出堆时站点数最少；与BFS得到的站点数相同，站点数相同的多条路径
+            中选出的可能不同。键为(区间数+启发值)，相同时已走区间数多者优先，
+            即沿同一条下界紧的路径一直走到终点，两者合并为一个浮点键出堆
+  ***************************************************************************/
+QVector<StationId> PathFinder::landmarkBfsPath(StationId from, StationId to, const ClosureMaskPtr& closures) {
+    lastStats = SearchStats();
+    if (from == INVALID_ID || to == INVALID_ID) {
+        return QVector<StationId>();
+    }
+    qDebug() << "开始ALT搜索从" << graph->getStationName(from) << "到" << graph->getStationName(to);
+
+    const MetroCsr&      csr          = graph->getCsr();
+    const int            stationCount = graph->getStationCount();
+    scratch.prepare(stationCount);
+    const quint32 epoch = scratch.epoch;
+    SearchSide&   side  = scratch.forward;
+    std::vector<std::pair<double, StationId>>& heap = side.heap;
+    ComparePair compare;
+    const LandmarkBound landmarks(graph->getLandmarks(), to);
+    const double        scale = stationCount + 1.0; //区间数小于站点数，键中区间数之差不会越过启发值之差
+    auto key = [&](int hops, StationId station) {
+        return (hops + landmarks.hops(station)) * scale - hops;
+    };
+
+    side.dist[from]    = 0;
+    side.prev[from]    = INVALID_ID;
+    side.reached[from] = epoch;
+    heap.push_back(std::make_pair(key(0, from), from));
+    lastStats.heapPushes++;
+
+    bool found = false;
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), compare);
+        const StationId current = heap.back().second;
+        heap.pop_back();
+
+        if (side.settled[current] == epoch) {
+            continue; // 过期条目
+        }
+        side.settled[current] = epoch;
+        lastStats.nodesExpanded++;
 
-    if (stationNames.size() < 2) {
-        qDebug() << "路径构建失败: 站点数量不足";
-        return path;
+        if (current == to) {
+            found = true;
+            break;
+        }
+
+        const int hops = int(side.dist[current]) + 1;
+        for (int e = csr.offsets[current]; e < csr.offsets[current + 1]; e++) {
+            if (closures != nullptr && closures->isEdgeClosed(e)) {
+                continue; // 封闭的区间
+            }
+            StationId neighbor = csr.targets[e];
+            if (side.settled[neighbor] == epoch) {
+                continue;
+            }
+            if (side.reached[neighbor] != epoch || hops < side.dist[neighbor]) {
+                side.dist[neighbor]    = hops;
+                side.prev[neighbor]    = current;
+                side.reached[neighbor] = epoch;
+                heap.push_back(std::make_pair(key(hops, neighbor), neighbor));
+                std::push_heap(heap.begin(), heap.end(), compare);
+                lastStats.heapPushes++;
+            }
+        }
     }
 
-    path.stationCount = stationNames.size();
+    if (!found) {
+        qDebug() << "未找到路径";
+        return QVector<StationId>();
+    }
 
-    /* 构建路径段*/
-    PathSegment currentSegment;
-    currentSegment.from = stationNames.first();
-    currentSegment.stations.append(stationNames.first());
+    QVector<StationId> path;
+    for (StationId current = to; current != INVALID_ID; current = side.prev[current]) {
+        path.append(current);
+    }
+    std::reverse(path.begin(), path.end());
 
-    for (int i = 1; i < stationNames.size(); i++) {
-        QString currentStation = stationNames[i];
-        QString prevStation    = stationNames[i - 1];
+    qDebug() << "找到路径，站点数:" << path.size() << "扩展站点数:" << lastStats.nodesExpanded;
+    return path;
+}
 
-        /* 计算距离*/
-        path.totalDistance += calculateDistance(prevStation, currentStation);
+/***************************************************************************
+  函数名称：PathFinder::bidirectionalBfsPath
+  功    能：双向BFS实现最少站点路径搜索
+  输入参数：StationId from - 起点编号
+			StationId to   - 终点编号
+			const ClosureMaskPtr& closures - 本次查询生效的临时封闭，没有时为空
+  返 回 值：QVector<StationId> - 搜索得到的站点编号列表
+  说    明：每轮从当前层较小的一侧展开一整层，展开时遇到另一侧已到达的站点
+            即记录候选路径；有候选的一层展开完后取其中最短者，此时不存在更短的
+            路径（更短的路径会在之前的某一层被发现）
+  ***************************************************************************/
+QVector<StationId> PathFinder::bidirectionalBfsPath(StationId from, StationId to, const ClosureMaskPtr& closures) {
+    qDebug() << "开始双向BFS搜索从" << graph->getStationName(from) << "到" << graph->getStationName(to);
 
-        QString line = getLineBetweenStations(prevStation, currentStation);
+    lastStats = SearchStats();
+    if (from == INVALID_ID || to == INVALID_ID) {
+        return QVector<StationId>();
+    }
+    if (from == to) {
+        return QVector<StationId>{ from };
+    }
 
-        if (line.isEmpty()) {
-            qDebug() << "警告: 站点" << prevStation << "和" << currentStation << "之间没有线路信息";
-            /* 尝试使用前一段的线路*/
-            if (!currentSegment.line.isEmpty()) {
-                line = currentSegment.line;
-                qDebug() << "使用前一段的线路:" << line;
-            }
-            else {
-                line = QString::fromUtf8("未知");
+    const MetroCsr& csr = graph->getCsr();
+    scratch.prepare(graph->getStationCount());
+    const quint32 epoch    = scratch.epoch;
+    SearchSide*   sides[]  = { &scratch.forward, &scratch.backward };
+    StationId     roots[]  = { from, to };
+    int           levelBegin[] = { 0, 0 };
+    for (int s = 0; s < 2; s++) {
+        sides[s]->queue.append(roots[s]);
+        sides[s]->dist[roots[s]]    = 0;
+        sides[s]->prev[roots[s]]    = INVALID_ID;
+        sides[s]->reached[roots[s]] = epoch;
+    }
+
+    int       best        = std::numeric_limits<int>::max();
+    StationId meetForward = INVALID_ID; //相遇边在起点一侧的站点
+    StationId meetBackward = INVALID_ID; //相遇边在终点一侧的站点
+
+    while (levelBegin[0] < sides[0]->queue.size() && levelBegin[1] < sides[1]->queue.size()) {
+        /* 选择当前层较小的一侧*/
+        const int s = sides[0]->queue.size() - levelBegin[0] <= sides[1]->queue.size() - levelBegin[1] ? 0 : 1;
+        SearchSide& side  = *sides[s];
+        SearchSide& other = *sides[1 - s];
+
+        const int levelEnd = side.queue.size();
+        for (int i = levelBegin[s]; i < levelEnd; i++) {
+            StationId current = side.queue[i];
+            lastStats.nodesExpanded++;
+            for (int e = csr.offsets[current]; e < csr.offsets[current + 1]; e++) {
+                if (closures != nullptr && closures->isEdgeClosed(e)) {
+                    continue; // 封闭的区间
+                }
+                StationId neighbor = csr.targets[e];
+                if (other.reached[neighbor] == epoch) {
+                    int length = static_cast<int>(side.dist[current] + other.dist[neighbor]) + 1;
+                    if (length < best) {
+                        best         = length;
+                        meetForward  = s == 0 ? current : neighbor;
+                        meetBackward = s == 0 ? neighbor : current;
+                    }
+                }
+                if (side.reached[neighbor] != epoch) {
+                    side.reached[neighbor] = epoch;
+                    side.dist[neighbor]    = side.dist[current] + 1;
+                    side.prev[neighbor]    = current;
+                    side.queue.append(neighbor);
+                    lastStats.heapPushes++;
+                }
             }
         }
+        levelBegin[s] = levelEnd;
 
-        if (currentSegment.line.isEmpty()) {
-            currentSegment.line = line;
-            currentSegment.to   = currentStation;
-            currentSegment.stations.append(currentStation);
+        if (best != std::numeric_limits<int>::max()) {
+            QVector<StationId> path = joinSearchTrees(meetForward, meetBackward);
+            qDebug() << "双向BFS找到路径，站点数:" << path.size() << "扩展站点数:" << lastStats.nodesExpanded;
+            return path;
         }
-        else if (currentSegment.line == line) {
-            currentSegment.to = currentStation;
-            currentSegment.stations.append(currentStation);
+    }
+
+    qDebug() << "未找到路径";
+    return QVector<StationId>();
+}
+
+/***************************************************************************
+  函数名称：PathFinder::bidirectionalDijkstraPath
+  功    能：双向Dijkstra实现最短距离路径搜索
+  输入参数：StationId from - 起点编号
+			StationId to   - 终点编号
+			const ClosureMaskPtr& closures - 本次查询生效的临时封闭，没有时为空
+  返 回 值：QVector<StationId> - 搜索得到的站点编号列表
+  说    明：每次从堆顶距离较小的一侧出堆一个站点；任一侧更新某站距离而另一侧
+            已到达该站时，更新经过该站的最短距离mu；两侧堆顶距离之和不小于mu
+            时，任何尚未发现的路径都不会更短，搜索停止
+  ***************************************************************************/
+QVector<StationId> PathFinder::bidirectionalDijkstraPath(StationId from, StationId to, const ClosureMaskPtr& closures) {
+    qDebug() << "开始双向Dijkstra搜索从" << graph->getStationName(from) << "到" << graph->getStationName(to);
+
+    lastStats = SearchStats();
+    if (from == INVALID_ID || to == INVALID_ID || from == to) {
+        return QVector<StationId>();
+    }
+
+    const MetroCsr& csr = graph->getCsr();
+    scratch.prepare(graph->getStationCount());
+    const quint32 epoch   = scratch.epoch;
+    SearchSide*   sides[] = { &scratch.forward, &scratch.backward };
+    StationId     roots[] = { from, to };
+    ComparePair   compare;
+    for (int s = 0; s < 2; s++) {
+        sides[s]->dist[roots[s]]    = 0;
+        sides[s]->prev[roots[s]]    = INVALID_ID;
+        sides[s]->reached[roots[s]] = epoch;
+        sides[s]->heap.push_back(std::make_pair(0.0, roots[s]));
+        lastStats.heapPushes++;
+    }
+
+    double    mu      = std::numeric_limits<double>::max();
+    StationId meeting = INVALID_ID; //最短路径经过的两侧共同到达的站点
+
+    while (!sides[0]->heap.empty() && !sides[1]->heap.empty()) {
+        /* 堆顶是本侧未确定站点距离的下界，两侧之和不小于mu即可停止*/
+        if (sides[0]->heap.front().first + sides[1]->heap.front().first >= mu) {
+            break;
         }
-        else {
-            // 换乘点
-            path.segments.append(currentSegment);
-            path.transferCount++;
 
-            currentSegment      = PathSegment();
-            currentSegment.line = line;
-            currentSegment.from = prevStation; // 换乘站
-            currentSegment.to   = currentStation;
-            currentSegment.stations.append(prevStation);
-            currentSegment.stations.append(currentStation);
+        const int s = compare(sides[1]->heap.front(), sides[0]->heap.front()) ? 0 : 1;
+        SearchSide& side  = *sides[s];
+        SearchSide& other = *sides[1 - s];
+
+        std::pop_heap(side.heap.begin(), side.heap.end(), compare);
+        const StationId current = side.heap.back().second;
+        side.heap.pop_back();
+        if (side.settled[current] == epoch) {
+            continue; // 过期条目
         }
-    }
+        side.settled[current] = epoch;
+        lastStats.nodesExpanded++;
 
-    if (!currentSegment.stations.isEmpty()) {
-        path.segments.append(currentSegment);
+        const double base = side.dist[current];
+        for (int e = csr.offsets[current]; e < csr.offsets[current + 1]; e++) {
+            if (closures != nullptr && closures->isEdgeClosed(e)) {
+                continue; // 封闭的区间
+            }
+            StationId neighbor = csr.targets[e];
+            if (side.settled[neighbor] == epoch) {
+                continue;
+            }
+            double alt = base + csr.weights[e];
+            if (side.reached[neighbor] != epoch || alt < side.dist[neighbor]) {
+                side.dist[neighbor]    = alt;
+                side.prev[neighbor]    = current;
+                side.reached[neighbor] = epoch;
+                side.heap.push_back(std::make_pair(alt, neighbor));
+                std::push_heap(side.heap.begin(), side.heap.end(), compare);
+                lastStats.heapPushes++;
+
+                if (other.reached[neighbor] == epoch && alt + other.dist[neighbor] < mu) {
+                    mu      = alt + other.dist[neighbor];
+                    meeting = neighbor;
+                }
+            }
+        }
     }
 
-    qDebug() << "构建路径完成，段数:" << path.segments.size() << "换乘次数:" << path.transferCount;
+    if (meeting == INVALID_ID) {
+        qDebug() << "最短距离搜索未找到有效路径";
+        return QVector<StationId>();
+    }
 
+    QVector<StationId> path = joinSearchTrees(meeting, meeting);
+    qDebug() << "双向Dijkstra找到路径，站点数:" << path.size() << "扩展站点数:" << lastStats.nodesExpanded;
     return path;
 }
+
 /***************************************************************************
-  函数名称：PathFinder::calculateDistance
-  功    能：计算两个站点之间的距离
-  输入参数：const QString& station1 - 站点名称1 
-            const QString& station2 - 站点名称2
-  返 回 值：double 两个站点之间的距离
-  说    明：
-***************************************************************************/
-double PathFinder::calculateDistance(const QString& station1, const QString& station2) {
-    Station s1 = graph->getStation(station1);
-    Station s2 = graph->getStation(station2);
+  函数名称：PathFinder::hierarchyShortestPath
+  功    能：在收缩层次上搜索最短距离路径
+  输入参数：StationId from - 起点编号
+			StationId to   - 终点编号
+  返 回 值：QVector<StationId> - 展开捷径后的站点编号列表
+  说    明：两侧都只沿向上图搜索，最短路径上层次最高的站点会被两侧同时到达；
+            与双向Dijkstra不同，一侧堆顶不小于mu时只停止该侧，两侧都停止后
+            结束。找到的边序列逐条展开，得到的站点序列交给buildPath，路径段
+            的划分与其他算法一致
+  ***************************************************************************/
+QVector<StationId> PathFinder::hierarchyShortestPath(StationId from, StationId to) {
+    qDebug() << "开始收缩层次搜索从" << graph->getStationName(from) << "到" << graph->getStationName(to);
 
-    /* 检查站点是否存在*/
-    if (s1.name.isEmpty() || s2.name.isEmpty()) {
-        qDebug() << "警告: 计算距离时站点不存在";
-        return 1.0; // 返回默认距离
+    lastStats = SearchStats();
+    if (from == INVALID_ID || to == INVALID_ID || from == to) {
+        return QVector<StationId>();
+    }
+
+    const UpwardGraph& upward = hierarchy->getUpwardGraph();
+    scratch.prepare(graph->getStationCount());
+    const quint32 epoch   = scratch.epoch;
+    SearchSide*   sides[] = { &scratch.forward, &scratch.backward };
+    StationId     roots[] = { from, to };
+    ComparePair   compare;
+    for (int s = 0; s < 2; s++) {
+        sides[s]->dist[roots[s]]    = 0;
+        sides[s]->prev[roots[s]]    = INVALID_ID;
+        sides[s]->reached[roots[s]] = epoch;
+        sides[s]->heap.push_back(std::make_pair(0.0, roots[s]));
+        lastStats.heapPushes++;
     }
 
-    /* 使用真实坐标计算距离（简单的欧几里得距离）*/
-    double dx       = s1.realPosition.x() - s2.realPosition.x();
-    double dy       = s1.realPosition.y() - s2.realPosition.y();
-    double distance = std::sqrt(dx * dx + dy * dy);
+    double    mu      = std::numeric_limits<double>::max();
+    StationId meeting = INVALID_ID; //最短路径上层次最高的站点
 
-    /*
-      将经纬度距离转换为近似公里数
-      1度纬度约111公里，1度经度约111*cos(纬度)公里
-      上海纬度约31度，所以1度经度约111*cos(31°) ≈ 95公里
-    */
-    double latToKm    = 111.0;
-    double lonToKm    = 111.0 * std::cos(31.0 * M_PI / 180.0);
+    for (;;) {
+        /* 堆顶不小于mu的一侧已无法改进结果*/
+        bool active[2];
+        for (int s = 0; s < 2; s++) {
+            active[s] = !sides[s]->heap.empty() && sides[s]->heap.front().first < mu;
+        }
+        if (!active[0] && !active[1]) {
+            break;
+        }
 
-    double distanceKm = std::sqrt(std::pow(dx * lonToKm, 2) + std::pow(dy * latToKm, 2));
+        const int s = !active[1] || (active[0] && compare(sides[1]->heap.front(), sides[0]->heap.front())) ? 0 : 1;
+        SearchSide& side  = *sides[s];
+        SearchSide& other = *sides[1 - s];
 
-    qDebug() << "计算距离:" << station1 << "->" << station2 << "=" << distanceKm << "公里";
+        std::pop_heap(side.heap.begin(), side.heap.end(), compare);
+        const StationId current = side.heap.back().second;
+        side.heap.pop_back();
+        if (side.settled[current] == epoch) {
+            continue; // 过期条目
+        }
+        side.settled[current] = epoch;
+        lastStats.nodesExpanded++;
+
+        const double base = side.dist[current];
+        if (other.reached[current] == epoch && base + other.dist[current] < mu) {
+            mu      = base + other.dist[current];
+            meeting = current;
+        }
 
-    return distanceKm;
+        /* 若经由层次更高的已到达站点可更快到达本站，本站不在最短路径上，不再展开*/
+        bool stalled = false;
+        for (int e = upward.offsets[current]; !stalled && e < upward.offsets[current + 1]; e++) {
+            StationId neighbor = upward.targets[e];
+            stalled = side.reached[neighbor] == epoch && side.dist[neighbor] + upward.weights[e] < base;
+        }
+        if (stalled) {
+            continue;
+        }
+
+        for (int e = upward.offsets[current]; e < upward.offsets[current + 1]; e++) {
+            StationId neighbor = upward.targets[e];
+            double    alt      = base + upward.weights[e];
+            if (side.reached[neighbor] != epoch || alt < side.dist[neighbor]) {
+                side.dist[neighbor]    = alt;
+                side.prev[neighbor]    = current;
+                side.reached[neighbor] = epoch;
+                side.heap.push_back(std::make_pair(alt, neighbor));
+                std::push_heap(side.heap.begin(), side.heap.end(), compare);
+                lastStats.heapPushes++;
+
+                if (other.reached[neighbor] == epoch && alt + other.dist[neighbor] < mu) {
+                    mu      = alt + other.dist[neighbor];
+                    meeting = neighbor;
+                }
+            }
+        }
+    }
+
+    if (meeting == INVALID_ID) {
+        qDebug() << "最短距离搜索未找到有效路径";
+        return QVector<StationId>();
+    }
+
+    /* 展开向上图中的边*/
+    QVector<StationId> hops = joinSearchTrees(meeting, meeting);
+    QVector<StationId> path;
+    path.append(hops.first());
+    for (int i = 1; i < hops.size(); i++) {
+        hierarchy->unpackEdge(hops[i - 1], hops[i], path);
+    }
+
+    qDebug() << "收缩层次找到路径，站点数:" << path.size() << "扩展站点数:" << lastStats.nodesExpanded;
+    return path;
 }
 
 /***************************************************************************
-  函数名称：PathFinder::getLineBetweenStations
-  功    能：查找两个站点之间的线路
-  输入参数：const QString& station1 - 站点名称1
-			const QString& station2 - 站点名称2
-  返 回 值：QString - 连接两个站点的线路名称
-  说    明：
-***************************************************************************/
-QString PathFinder::getLineBetweenStations(const QString& station1, const QString& station2)const {
-    StationConnection conn = graph->getConnection(station1, station2);
-    if (!conn.line.isEmpty()) {
-        return conn.line;
+  函数名称：PathFinder::joinSearchTrees
+  功    能：拼接双向搜索两侧搜索树中的路径
+  输入参数：StationId forwardEnd  - 起点一侧搜索树中的站点
+			StationId backwardEnd - 终点一侧搜索树中的站点，与forwardEnd相同或相邻
+  返 回 值：QVector<StationId> - 从起点到终点的站点编号列表
+  说    明：两端相同时该站只出现一次
+  ***************************************************************************/
+QVector<StationId> PathFinder::joinSearchTrees(StationId forwardEnd, StationId backwardEnd) const {
+    QVector<StationId> path;
+    for (StationId node = forwardEnd; node != INVALID_ID; node = scratch.forward.prev[node]) {
+        path.append(node);
     }
+    std::reverse(path.begin(), path.end());
 
-    /* 如果直接连接不存在，尝试反向查找*/
-    conn = graph->getConnection(station2, station1);
-    if (!conn.line.isEmpty()) {
-        return conn.line;
+    StationId node = backwardEnd == forwardEnd ? scratch.backward.prev[backwardEnd] : backwardEnd;
+    for (; node != INVALID_ID; node = scratch.backward.prev[node]) {
+        path.append(node);
     }
-    qDebug() << "警告: 无法找到站点" << station1 << "和" << station2 << "之间的线路";
-    return "";
+    return path;
 }
+
 /***************************************************************************
-  函数名称：PathFinder::convertLinePathToStationPath
-  功    能：将线路路径转换为站点路径
-  输入参数：const QVector<QString>& linePath  - 线路路径
-			const QString&          from      - 起点站点名称
-			const QString&          to        - 终点站点名称
-  返 回 值：QVector<QString> - 站点路径
-  说    明：
-***************************************************************************/
-QVector<QString> PathFinder::convertLinePathToStationPath(const QVector<QString>& linePath, const QString& from, const QString& to) {
-    qDebug() << "将线路路径转换为站点路径:" << linePath;
+  函数名称：PathFinder::findParetoPaths
+  功    能：查找换乘次数、经过站点数和总距离三者互不支配的全部路径
+  输入参数：const QString& from - 起点站名称
+			const QString& to   - 终点站名称
+  返 回 值：QVector<MetroPath> - 路径列表，按换乘次数、站点数、距离排序，
+                                 起终点无效、相同或不可达时为空
+  说    明：一次搜索同时给出三种策略各自的最优解以及两两之间的折中方案；
+            列表第一条即为换乘最少（站点少者优先）的路径
+  ***************************************************************************/
+QVector<MetroPath> PathFinder::findParetoPaths(const QString& from, const QString& to) {
+    QVector<MetroPath> paths;
+    if (graph == nullptr || !graph->hasStation(from) || !graph->hasStation(to) || from == to) {
+        return paths;
+    }
 
-    if (linePath.isEmpty()) {
-        qDebug() << "错误: 线路路径为空";
-        return QVector<QString>();
+    const StationId      toId     = graph->getStationId(to);
+    const ClosureMaskPtr closures = activeClosures(graph->getClosures());
+    paretoRounds(graph->getStationId(from), toId, closures);
+
+    /* 终点上未被支配的标签即为结果，各轮依次生成，已按换乘次数排序*/
+    QVector<int> results;
+    ParetoSearchSide& pareto = scratch.pareto;
+    if (pareto.bagReached[toId] == scratch.epoch) {
+        for (int label = pareto.bagHead[toId]; label >= 0; label = pareto.labels[label].nextInBag) {
+            if (!pareto.labels[label].dominated) {
+                results.append(label);
+            }
+        }
+    }
+    std::sort(results.begin(), results.end(), [&pareto](int a, int b) {
+        const ParetoLabel& first  = pareto.labels[a];
+        const ParetoLabel& second = pareto.labels[b];
+        if (first.transfers != second.transfers)
+            return first.transfers < second.transfers;
+        if (first.hops != second.hops)
+            return first.hops < second.hops;
+        return first.distance < second.distance;
+    });
+
+    for (int label : results) {
+        paths.append(buildGroupPath(paretoGroups(label)));
     }
 
-    /* 获取线路到站点的映射*/
-    QMap<QString, QVector<QString>> lineStations = getLineStations();
-    QMap<QString, QVector<QString>> stationLines = getStationLines();
+    qDebug() << "多目标搜索找到" << paths.size() << "条互不支配的路径";
+    return paths;
+}
 
-    /* 构建站点路径*/
-    QVector<QString> stationPath;
-    stationPath.append(from);
+/***************************************************************************
+  函数名称：PathFinder::paretoRounds
+  功    能：按换乘次数分轮进行多目标搜索
+  输入参数：StationId from - 起点编号
+			StationId to   - 终点编号
+			const ClosureMaskPtr& closures - 本次查询生效的临时封闭，没有时为空
+  返 回 值：
+  说    明：与RAPTOR相同，第k轮从上一轮新到达的标签出发，在所在站换乘一条
+            其他线路并沿线路乘坐到各站，生成换乘k次的标签，第0轮从起点
+            上车；没有新标签时搜索结束。每个站点保留一组互不支配的标签。
+            新标签的代价加上到终点的下界（最少区间数、直线距离）若已被
+            终点的标签支配，就不可能延伸为更好的结果（目标剪枝）。两个下界
+            都满足三角不等式，沿线路前进时代价加下界只增不减，因此某一步
+            被剪枝后，同一次乘车继续前进的各步也都被剪枝
+  ***************************************************************************/
+void PathFinder::paretoRounds(StationId from, StationId to, const ClosureMaskPtr& closures) {
+    const MetroCsr& csr = graph->getCsr();
+    scratch.prepare(graph->getStationCount(), csr.groupLines.size());
+    prepareRides(closures);
+    lastStats = SearchStats();
+
+    ParetoSearchSide& pareto = scratch.pareto;
+    pareto.labels.clear();
+    pareto.marked.clear();
+
+    /* 由终点做一次BFS得到各站到终点的最少区间数，起点不可达时不再搜索*/
+    const int stationCount = graph->getStationCount();
+    std::fill(pareto.hopBound.begin(), pareto.hopBound.end(), stationCount);
+    QVector<StationId>& queue = scratch.backward.queue;
+    queue.append(to);
+    pareto.hopBound[to] = 0;
+    for (int head = 0; head < queue.size(); head++) {
+        const StationId current = queue[head];
+        for (int e = csr.offsets[current]; e < csr.offsets[current + 1]; e++) {
+            if (closures != nullptr && closures->isEdgeClosed(e)) {
+                continue; // 封闭的区间
+            }
+            if (pareto.hopBound[csr.targets[e]] == stationCount) {
+                pareto.hopBound[csr.targets[e]] = pareto.hopBound[current] + 1;
+                queue.append(csr.targets[e]);
+            }
+        }
+    }
+    if (pareto.hopBound[from] == stationCount) {
+        return;
+    }
+    for (int station = 0; station < stationCount; station++) {
+        pareto.distanceBound[station] = graph->calculateDistance(StationId(station), to);
+    }
 
-    /* 对于每条线路，找到换乘站*/
-    for (int i = 0; i < linePath.size() - 1; i++) {
-        QString currentLine = linePath[i];
-        QString nextLine    = linePath[i + 1];
+    addParetoLabel(ParetoLabel{ from, INVALID_ID, from, 0, 0, 0.0, 0, -1, -1, false });
+    pareto.marked.append(0);
 
-        /* 找出两条线路的共同站点（换乘站）*/
-        QVector<QString> commonStations;
-        for (const QString& station : lineStations[currentLine]) {
-            if (lineStations[nextLine].contains(station)) {
-                commonStations.append(station);
+    for (int round = 0; !pareto.marked.isEmpty(); round++) {
+        pareto.generated.clear();
+        for (int index : pareto.marked) {
+            if (pareto.labels[index].dominated) {
+                continue;
+            }
+
+            /* labels在加入标签时可能重新分配，先复制*/
+            const ParetoLabel current = pareto.labels[index];
+            lastStats.nodesExpanded++;
+            for (int g = csr.groupOffsets[current.station]; g < csr.groupOffsets[current.station + 1]; g++) {
+                const LineId line = csr.groupLines[g];
+                if (line == current.line) {
+                    continue;
+                }
+                const ParetoRideStep* ride  = pareto.rides.constData() + pareto.rideOffsets[g];
+                const int             steps = pareto.rideOffsets[g + 1] - pareto.rideOffsets[g];
+                pareto.pruned[0] = 0;
+                for (int step = 1; step < steps; step++) {
+                    const int    hops     = current.hops + ride[step].hops;
+                    const double distance = current.distance + ride[step].distance;
+                    const StationId station  = ride[step].station;
+                    pareto.pruned[step] = pareto.pruned[ride[step].parent]
+                                       || paretoDominated(to, hops + pareto.hopBound[station],
+                                                          distance + pareto.distanceBound[station]);
+                    if (pareto.pruned[step]) {
+                        continue;
+                    }
+                    if (addParetoLabel(ParetoLabel{ station, line, current.station, round,
+                                                    hops, distance, step, index, -1, false })) {
+                        pareto.generated.append(pareto.labels.size() - 1);
+                    }
+                }
             }
         }
+        pareto.marked.swap(pareto.generated);
+    }
+}
 
-        if (commonStations.isEmpty()) {
-            qDebug() << "错误: 找不到线路" << currentLine << "和" << nextLine << "的共同站点";
-            return QVector<QString>();
+/***************************************************************************
+  函数名称：PathFinder::paretoDominated
+  功    能：判断站点已有的标签是否支配给定的代价
+  输入参数：StationId station - 站点编号
+			int hops          - 区间数
+			double distance   - 里程
+  返 回 值：bool - 是否被支配
+  说    明：已有标签的换乘次数不多于新标签，只需比较站点数和里程；
+            与已有标签相同也视为被支配
+  ***************************************************************************/
+bool PathFinder::paretoDominated(StationId station, int hops, double distance) const {
+    const ParetoSearchSide& pareto = scratch.pareto;
+    if (pareto.bagReached[station] != scratch.epoch) {
+        return false;
+    }
+    for (int other = pareto.bagHead[station]; other >= 0; other = pareto.labels[other].nextInBag) {
+        const ParetoLabel& label = pareto.labels[other];
+        if (!label.dominated && label.hops <= hops && label.distance <= distance + 1e-9) {
+            return true;
         }
+    }
+    return false;
+}
 
-        /* 选择距离当前站点最近的换乘站*/
-        QString bestTransferStation = commonStations.first();
-        int     minDistance         = std::numeric_limits<int>::max();
+/***************************************************************************
+  函数名称：PathFinder::addParetoLabel
+  功    能：将不被支配的标签加入所在站点的标签组
+  输入参数：const ParetoLabel& label - 新标签
+  返 回 值：bool - 是否加入
+  说    明：同一轮中被新标签支配的旧标签标记后不再扩展
+  ***************************************************************************/
+bool PathFinder::addParetoLabel(const ParetoLabel& label) {
+    ParetoSearchSide& pareto  = scratch.pareto;
+    const StationId   station = label.station;
+    if (paretoDominated(station, label.hops, label.distance)) {
+        return false;
+    }
+    if (pareto.bagReached[station] != scratch.epoch) {
+        pareto.bagReached[station] = scratch.epoch;
+        pareto.bagHead[station]    = -1;
+    }
 
-        for (const QString& station : commonStations) {
-            /* 计算从当前站点到换乘站的距离（站点数）*/
-            QVector<QString> pathToStation = findPathOnLine(currentLine, stationPath.last(), station);
-            if (!pathToStation.isEmpty() && pathToStation.size() < minDistance) {
-                minDistance         = pathToStation.size();
-                bestTransferStation = station;
-            }
+    for (int other = pareto.bagHead[station]; other >= 0; other = pareto.labels[other].nextInBag) {
+        ParetoLabel& old = pareto.labels[other];
+        if (old.transfers == label.transfers && label.hops <= old.hops && label.distance <= old.distance) {
+            old.dominated = true;
         }
+    }
+    pareto.labels.append(label);
+    pareto.labels.last().nextInBag = pareto.bagHead[station];
+    pareto.bagHead[station]        = pareto.labels.size() - 1;
+    lastStats.heapPushes++;
+    return true;
+}
 
-        /* 在当前线路上找到从当前站点到换乘站的路径*/
-        QVector<QString> pathOnCurrentLine = findPathOnLine(currentLine, stationPath.last(), bestTransferStation);
-        if (pathOnCurrentLine.isEmpty()) {
-            qDebug() << "错误: 无法在线路" << currentLine << "上找到从" << stationPath.last() << "到" << bestTransferStation << "的路径";
-            return QVector<QString>();
+/***************************************************************************
+  函数名称：PathFinder::prepareRides
+  功    能：计算从各(站点, 线路)分组上车后沿线路乘车的步骤
+  输入参数：const ClosureMaskPtr& closures - 本次查询生效的临时封闭，没有时为空
+  返 回 值：
+  说    明：乘车步骤只依赖地铁图和封闭情况，同一版本的同一封闭情况只计算
+            一次。每个分组沿本线路广度优先，环线和支线上每站只经过一次，取
+            区间数最少的方向，区间封闭时环线改走另一个方向；搜索和展开路径
+            都使用这些步骤，得到的站点序列一致
+  ***************************************************************************/
+void PathFinder::prepareRides(const ClosureMaskPtr& closures) {
+    ParetoSearchSide&    pareto     = scratch.pareto;
+    const quint64        generation = closures != nullptr ? closures->generation : 0;
+    if (!pareto.rideOffsets.isEmpty() && pareto.rideClosures == generation) {
+        return;
+    }
+    pareto.rideClosures = generation;
+
+    const MetroCsr&      csr        = graph->getCsr();
+    const int            groupCount = csr.groupLines.size();
+    QVector<int>         visited(groupCount, -1);
+    QVector<int>         queue;
+    int                  longest = 0;
+    pareto.rides.clear();
+    pareto.rideOffsets.resize(groupCount + 1);
+    for (int station = 0; station < graph->getStationCount(); station++) {
+        for (int start = csr.groupOffsets[station]; start < csr.groupOffsets[station + 1]; start++) {
+            const int    base = pareto.rides.size();
+            const LineId line = csr.groupLines[start];
+            pareto.rideOffsets[start] = base;
+            pareto.rides.append(ParetoRideStep{ StationId(station), 0, 0.0, -1 });
+            queue.clear();
+            queue.append(start);
+            visited[start] = start;
+            for (int head = 0; head < queue.size(); head++) {
+                const ParetoRideStep step = pareto.rides[base + head];
+                for (int k = csr.groupEdgeOffsets[queue[head]]; k < csr.groupEdgeOffsets[queue[head] + 1]; k++) {
+                    const int       e        = csr.groupEdges[k];
+                    if (closures != nullptr && closures->isEdgeClosed(e)) {
+                        continue; // 封闭的区间
+                    }
+                    const StationId neighbor = csr.targets[e];
+                    const int       group    = graph->findLineGroup(neighbor, line);
+                    if (visited[group] != start) {
+                        visited[group] = start;
+                        queue.append(group);
+                        pareto.rides.append(ParetoRideStep{ neighbor, step.hops + 1, step.distance + csr.weights[e], head });
+                    }
+                }
+            }
+            longest = qMax(longest, queue.size());
         }
+    }
+    pareto.rideOffsets[groupCount] = pareto.rides.size();
+    pareto.pruned.resize(longest);
+}
 
-        /* 添加到站点路径（去掉第一个站点，因为它已经在路径中）*/
-        for (int j = 1; j < pathOnCurrentLine.size(); j++) {
-            stationPath.append(pathOnCurrentLine[j]);
+/***************************************************************************
+  函数名称：PathFinder::paretoGroups
+  功    能：展开标签对应的(站点, 线路)分组序列
+  输入参数：int label - 标签下标
+  返 回 值：QVector<int> - 从起点上车的分组到该标签所在站下车的分组
+  说    明：沿上车标签逐段回溯，每段从记下的下车步骤沿乘车步骤回到上车站，
+            途经各站都取本段乘坐线路的分组；换乘站先后出现下车和上车两个
+            分组，路径段和换乘次数因此与搜索实际乘坐的线路一致
+  ***************************************************************************/
+QVector<int> PathFinder::paretoGroups(int label) const {
+    const ParetoSearchSide& pareto = scratch.pareto;
+    QVector<int>            reversed;
+    for (int index = label; pareto.labels[index].prev >= 0; index = pareto.labels[index].prev) {
+        const ParetoLabel&    current = pareto.labels[index];
+        const ParetoRideStep* ride    = pareto.rides.constData()
+                                      + pareto.rideOffsets[graph->findLineGroup(current.boarded, current.line)];
+        for (int step = current.rideStep; step >= 0; step = ride[step].parent) {
+            reversed.append(graph->findLineGroup(ride[step].station, current.line));
         }
     }
+    std::reverse(reversed.begin(), reversed.end());
+    return reversed;
+}
 
-    /* 在最后一条线路上找到从当前站点到终点的路径*/
-    QString          lastLine       = linePath.last();
-    QVector<QString> pathOnLastLine = findPathOnLine(lastLine, stationPath.last(), to);
-    if (pathOnLastLine.isEmpty()) {
-        qDebug() << "错误: 无法在线路" << lastLine << "上找到从" << stationPath.last() << "到" << to << "的路径";
-        return QVector<QString>();
+/***************************************************************************
+  函数名称：PathFinder::findAlternativePaths
+  功    能：查找两站之间按策略排序的前若干条无环路径
+  输入参数：const QString& from     - 起点站名称
+			const QString& to       - 终点站名称
+			SearchStrategy strategy - 排序所依据的策略
+			int count               - 需要的路径条数
+			int maxExpansions       - 偏离搜索累计展开站点数（最少换乘为分组数）的上限
+  返 回 值：QVector<MetroPath> - 路径列表，第一条与该策略的最优路径代价相同；
+                                 起终点无效、相同或不可达时为空
+  说    明：Yen算法：第k条路径从第k-1条路径的每个站点偏离，偏离点之前沿用
+            原路径，之后重新搜索，在全部候选中取代价最小者。以终点为根的
+            搜索树在各次偏离搜索间共用：树上到终点的代价是偏离搜索的精确
+            下界，树上路径未被封锁时直接采用，否则以其为启发做A*。展开
+            站点数达到上限后不再产生新候选，返回已得到的路径。
+            最短距离按里程、最少站点按区间数（再比较里程）排序；最少换乘
+            的代价依赖线路而不是单条边，在(站点, 线路)分组图上运行Yen算法，
+            见transferAlternatives
+  ***************************************************************************/
+QVector<MetroPath> PathFinder::findAlternativePaths(const QString& from, const QString& to,
+                                                    SearchStrategy strategy, int count, int maxExpansions) {
+    QVector<MetroPath> paths;
+    lastStats = SearchStats();
+    if (graph == nullptr || count <= 0 || !graph->hasStation(from) || !graph->hasStation(to) || from == to) {
+        return paths;
     }
 
-    /* 添加到站点路径（去掉第一个站点，因为它已经在路径中）*/
-    for (int j = 1; j < pathOnLastLine.size(); j++) {
-        stationPath.append(pathOnLastLine[j]);
+    const StationId      fromId     = graph->getStationId(from);
+    const StationId      toId       = graph->getStationId(to);
+    const bool           byDistance = strategy == MIN_DISTANCE;
+    const ClosureMaskPtr closures   = activeClosures(graph->getClosures());
+    if (strategy == MIN_TRANSFER) {
+        int budget = maxExpansions;
+        paths = transferAlternatives(fromId, toId, count, budget, closures);
+        lastStats.nodesExpanded = maxExpansions - budget;
+        qDebug() << "找到" << paths.size() << "条备选路径";
+        return paths;
     }
 
-    qDebug() << "转换后的站点路径:" << stationPath;
-    return stationPath;
-}
+    /* 以终点为根的搜索树，所有偏离搜索共用*/
+    SearchTree tree(*graph);
+    tree.grow(toId, byDistance ? MIN_DISTANCE : MIN_STATIONS, transferTieBreak, closures);
+    if (!tree.isReached(fromId)) {
+        return paths;
+    }
+    auto edgeCost = [this, byDistance](StationId station1, StationId station2) {
+        return byDistance ? graph->calculateDistance(station1, station2) : 1.0;
+    };
+    auto treeCost = [&tree, byDistance](StationId station) {
+        return byDistance ? tree.getDistance(station) : double(tree.getStationCount(station) - 1);
+    };
+
+    /* 已确定的路径和候选路径，代价相同时站点少者优先，再比较里程*/
+    struct Candidate {
+        double             cost;     //按策略的代价
+        double             distance; //里程，用于代价相同时比较
+        QVector<StationId> stations; //站点编号列表
+    };
+    auto better = [](const Candidate& a, const Candidate& b) {
+        if (a.cost != b.cost)
+            return a.cost < b.cost;
+        if (a.stations.size() != b.stations.size())
+            return a.stations.size() < b.stations.size();
+        return a.distance < b.distance;
+    };
+    auto distanceOf = [this](const QVector<StationId>& stations) {
+        double distance = 0;
+        for (int i = 1; i < stations.size(); i++) {
+            distance += graph->calculateDistance(stations[i - 1], stations[i]);
+        }
+        return distance;
+    };
+
+    QVector<Candidate> accepted;
+    QVector<Candidate> candidates;
+    QVector<StationId> first;
+    for (StationId station = fromId; station != INVALID_ID; station = tree.getNext(station)) {
+        first.append(station);
+    }
+    accepted.append(Candidate{ treeCost(fromId), distanceOf(first), first });
+
+    int budget = maxExpansions;
+    while (accepted.size() < count && budget > 0) {
+        const QVector<StationId> previous = accepted.last().stations;
+        double rootCost = 0;
+        for (int i = 0; i + 1 < previous.size() && budget > 0; i++) {
+            const StationId spur = previous[i];
+            if (i > 0) {
+                rootCost += edgeCost(previous[i - 1], spur);
+            }
 
-/***************************************************************************
-  函数名称：PathFinder::findPathOnline
-  功    能：在路线上查找两个站点之间的路径
-  输入参数：const QString& line - 线路名称
-            const QString& from - 起点站名称
-			const QString& to   - 终点站名称
-  返 回 值：QVector<QString> 线路上两个站点之间的路径
-  说    明：
-***************************************************************************/
-QVector<QString> PathFinder::findPathOnLine(const QString& line, const QString& from, const QString& to) {
-    qDebug() << "在线路" << line << "上查找从" << from << "到" << to << "的路径";
+            /* 与当前路径偏离点之前相同的已确定路径，其下一站都要封锁*/
+            QVector<StationId> blockedNext;
+            for (const Candidate& path : accepted) {
+                if (path.stations.size() > i + 1 && std::equal(previous.begin(), previous.begin() + i + 1, path.stations.begin())) {
+                    blockedNext.append(path.stations[i + 1]);
+                }
+            }
 
-    /* 获取线路上的所有站点*/
-    QMap<QString, QVector<QString>> lineStations   = getLineStations();
-    QVector<QString>                stationsOnLine = lineStations[line];
+            const QVector<StationId> spurStations = spurPath(previous.mid(0, i + 1), blockedNext, toId, tree, byDistance, budget, closures);
+            if (spurStations.isEmpty()) {
+                continue;
+            }
+            QVector<StationId> stations = previous.mid(0, i);
+            stations += spurStations;
 
-    /* 找出起点和终点在线路上的位置*/
-    int fromIndex = stationsOnLine.indexOf(from);
-    int toIndex   = stationsOnLine.indexOf(to);
+            bool duplicate = false;
+            for (const Candidate& path : candidates) {
+                duplicate = duplicate || path.stations == stations;
+            }
+            if (!duplicate) {
+                double cost = rootCost;
+                for (int j = 1; j < spurStations.size(); j++) {
+                    cost += edgeCost(spurStations[j - 1], spurStations[j]);
+                }
+                candidates.append(Candidate{ cost, distanceOf(stations), stations });
+            }
+        }
+        if (candidates.isEmpty()) {
+            break;
+        }
+        auto best = std::min_element(candidates.begin(), candidates.end(), better);
+        accepted.append(*best);
+        candidates.erase(best);
+    }
 
-    if (fromIndex == -1 || toIndex == -1) {
-        qDebug() << "错误: 站点" << from << "或" << to << "不在线路" << line << "上";
-        return QVector<QString>();
+    for (const Candidate& path : accepted) {
+        paths.append(buildPath(path.stations, closures));
     }
 
-    /* 检查线路是否有分支*/
-    bool hasBranch = false;
-    for (const QString& station : stationsOnLine) {
-        Station stationInfo = graph->getStation(station);
-        if (stationInfo.connectedStations.size() > 2) {
-            hasBranch = true;
-            break;
+    lastStats.nodesExpanded = maxExpansions - budget;
+    qDebug() << "找到" << paths.size() << "条备选路径";
+    return paths;
+}
+
+/***************************************************************************
+  函数名称：PathFinder::transferAlternatives
+  功    能：查找按换乘次数排序的前若干条无环路径
+  输入参数：StationId from - 起点编号
+			StationId to   - 终点编号
+			int count      - 需要的路径条数
+			int& budget    - 剩余可展开的分组数，搜索中递减
+			const ClosureMaskPtr& closures - 本次查询生效的临时封闭，没有时为空
+  返 回 值：QVector<MetroPath> - 路径列表，按(换乘次数, 次要项, 最后项)升序
+  说    明：路径表示为分组序列，相邻两项或沿线路到相邻站，或在同一站换乘；
+            代价与minTransferSearch相同，按transferTieBreak逐项比较，各项
+            可逐段相加，因此Yen算法在分组图上直接成立：每次偏离搜索都是
+            该策略下的精确最优。起点前有一个虚拟源点，从它偏离即改换起点
+            上车的线路。同一站点序列可对应不同的乘车线路（如3号线与4号线
+            共线区间），这些分组序列照常参与Yen算法，但只输出代价最小的一条
+  ***************************************************************************/
+QVector<MetroPath> PathFinder::transferAlternatives(StationId from, StationId to, int count, int& budget, const ClosureMaskPtr& closures) {
+    const MetroCsr& csr        = graph->getCsr();
+    const bool      byStations = transferTieBreak == FEWER_STATIONS;
+    QVector<StationId> groupStations(csr.groupLines.size());
+    for (StationId station = 0; station < StationId(graph->getStationCount()); station++) {
+        for (int g = csr.groupOffsets[station]; g < csr.groupOffsets[station + 1]; g++) {
+            groupStations[g] = station;
         }
     }
 
-    /* 如果没有分支，直接返回简单路径*/
-    if (!hasBranch) {
-        QVector<QString> path;
-        if (fromIndex <= toIndex) {
-            /* 正向*/
-            for (int i = fromIndex; i <= toIndex; i++) {
-                path.append(stationsOnLine[i]);
+    /* 分组序列前count项的代价，换乘边两端为同一站点*/
+    auto prefixCost = [&](const QVector<int>& groups, int count) {
+        TransferCost cost;
+        for (int i = 1; i < count; i++) {
+            const StationId previous = groupStations[groups[i - 1]];
+            const StationId current  = groupStations[groups[i]];
+            if (previous == current) {
+                cost.transfers++;
+                continue;
             }
+            const double distance = graph->calculateDistance(previous, current);
+            cost.primary   += byStations ? 1.0 : distance;
+            cost.secondary += byStations ? distance : 1.0;
         }
-        else {
-            /* 反向*/
-            for (int i = fromIndex; i >= toIndex; i--) {
-                path.append(stationsOnLine[i]);
+        return cost;
+    };
+    auto stationsOf = [&](const QVector<int>& groups) {
+        QVector<StationId> stations;
+        for (int g : groups) {
+            if (stations.isEmpty() || stations.last() != groupStations[g]) {
+                stations.append(groupStations[g]);
             }
         }
-        return path;
+        return stations;
+    };
+
+    /* 已确定的路径和候选路径*/
+    struct Candidate {
+        TransferCost cost;   //按策略的代价
+        QVector<int> groups; //分组序列
+    };
+    CompareTransferCost compare;
+    auto better = [&compare](const Candidate& a, const Candidate& b) {
+        return compare(std::make_pair(b.cost, 0), std::make_pair(a.cost, 0));
+    };
+
+    QVector<Candidate>          accepted;
+    QVector<Candidate>          candidates;
+    QVector<QVector<StationId>> shown;
+    QVector<MetroPath>          paths;
+    const QVector<int> first = transferSpurPath(QVector<int>(), QVector<int>(), from, to, groupStations, budget, closures);
+    if (first.isEmpty()) {
+        return paths;
     }
+    candidates.append(Candidate{ prefixCost(first, first.size()), first });
+
+    while (paths.size() < count && !candidates.isEmpty()) {
+        auto best = std::min_element(candidates.begin(), candidates.end(), better);
+        accepted.append(*best);
+        candidates.erase(best);
+
+        /* 站点序列与已输出的路径相同时只参与偏离，不再输出*/
+        const QVector<int>&      previous = accepted.last().groups;
+        const QVector<StationId> stations = stationsOf(previous);
+        if (!shown.contains(stations)) {
+            shown.append(stations);
+            paths.append(buildGroupPath(previous));
+        }
 
-    /* 对于有分支的线路，使用BFS找到路径*/
-    return findAlternativePathOnLine(line, from, to, "");
+        /* 偏离点i为-1时从虚拟源点偏离，改换起点上车的分组*/
+        for (int i = -1; i + 1 < previous.size() && budget > 0; i++) {
+            QVector<int> blockedNext;
+            for (const Candidate& path : accepted) {
+                if (path.groups.size() > i + 1 && std::equal(previous.begin(), previous.begin() + i + 1, path.groups.begin())) {
+                    blockedNext.append(path.groups[i + 1]);
+                }
+            }
+
+            const QVector<int> rootGroups = previous.mid(0, i + 1);
+            const QVector<int> spurGroups = transferSpurPath(rootGroups, blockedNext, from, to, groupStations, budget, closures);
+            if (spurGroups.isEmpty()) {
+                continue;
+            }
+            QVector<int> groups = previous.mid(0, qMax(i, 0));
+            groups += spurGroups;
+
+            bool duplicate = false;
+            for (const Candidate& path : candidates) {
+                duplicate = duplicate || path.groups == groups;
+            }
+            if (!duplicate) {
+                candidates.append(Candidate{ prefixCost(groups, groups.size()), groups });
+            }
+        }
+    }
+    return paths;
 }
+
 /***************************************************************************
-  函数名称：PathFinder::findAlternativePathOnLine
-  功    能：在线路上查找两个站点之间的替代路径，处理分支情况
-  输入参数：const QString& line        - 线路名称
-			const QString& from        - 起点站名称
-			const QString& to          - 终点站名称
-			const QString& branchPoint - 分支点站名称（可选）
-  返 回 值：QVector<QString> 线路上两个站点之间的路径
-  说    明：
+  函数名称：PathFinder::transferSpurPath
+  功    能：分组图上Yen算法的偏离搜索
+  输入参数：const QVector<int>& rootGroups       - 起点到偏离点的分组，最后一个为偏离点；
+                                                  为空时从虚拟源点出发
+			const QVector<int>& blockedNext      - 偏离点不能直接前往的分组
+			StationId from                       - 起点编号
+			StationId to                         - 终点编号
+			const QVector<StationId>& groupStations - 各分组所属的站点
+			int& budget                          - 剩余可展开的分组数，搜索中递减
+			const ClosureMaskPtr& closures - 本次查询生效的临时封闭，没有时为空
+  返 回 值：QVector<int> - 从偏离点（或起点上车的分组）到终点某分组的分组
+                           序列，不可达或超出上限时为空
+  说    明：与minTransferSearch相同的字典序Dijkstra，另加三条限制：偏离点
+            之前的站点和离开后的偏离站不可再经过，保证路径无环；起点不换乘，
+            起点上车的线路由虚拟源点选择；不连续换乘两次，否则可绕过被封锁
+            的换乘。在这些限制下最优路径不会重复经过同一站点
   ***************************************************************************/
-QVector<QString> PathFinder::findAlternativePathOnLine(const QString& line, const QString& from,const QString& to, const QString& branchPoint) {
-    qDebug() << "尝试找到替代路径，处理分支:" << line << from << "->" << to << "分支点:" << branchPoint;
+QVector<int> PathFinder::transferSpurPath(const QVector<int>& rootGroups, const QVector<int>& blockedNext,
+                                          StationId from, StationId to,
+                                          const QVector<StationId>& groupStations, int& budget,
+                                          const ClosureMaskPtr& closures) {
+    const MetroCsr&      csr      = graph->getCsr();
+    scratch.prepare(graph->getStationCount(), csr.groupLines.size());
+    const quint32       epoch   = scratch.epoch;
+    TransferSearchSide& side    = scratch.groups;
+    SearchSide&         blocked = scratch.backward;
+    std::vector<std::pair<TransferCost, int>>& heap = side.heap;
+    CompareTransferCost compare;
+
+    /* 用backward.settled标记不可经过的站点*/
+    const StationId spurStation = rootGroups.isEmpty() ? from : groupStations[rootGroups.last()];
+    for (int g : rootGroups) {
+        blocked.settled[groupStations[g]] = epoch;
+    }
+    blocked.settled[spurStation] = epoch;
+    const bool spurByTransfer = rootGroups.size() >= 2 && groupStations[rootGroups[rootGroups.size() - 2]] == spurStation;
 
-    /* 使用BFS在线路上找到从起点到终点的路径*/
-    QMap<QString, QString> cameFrom;
-    QSet<QString>          visited;
-    std::queue<QString>    queue;
+    auto relax = [&](int group, int previous, const TransferCost& cost) {
+        if (side.settled[group] == epoch) {
+            return;
+        }
+        if (side.reached[group] == epoch && !compare(std::make_pair(side.cost[group], group), std::make_pair(cost, group))) {
+            return;
+        }
+        side.cost[group]    = cost;
+        side.prev[group]    = previous;
+        side.station[group] = groupStations[group];
+        side.reached[group] = epoch;
+        heap.push_back(std::make_pair(cost, group));
+        std::push_heap(heap.begin(), heap.end(), compare);
+        lastStats.heapPushes++;
+    };
+    if (rootGroups.isEmpty()) {
+        for (int g = csr.groupOffsets[from]; g < csr.groupOffsets[from + 1]; g++) {
+            if (!blockedNext.contains(g)) {
+                relax(g, -1, TransferCost());
+            }
+        }
+    }
+    else {
+        relax(rootGroups.last(), -1, TransferCost());
+    }
 
-    queue.push(from);
-    visited.insert(from);
-    cameFrom[from] = "";
+    const bool byStations = transferTieBreak == FEWER_STATIONS;
+    const bool fromSpur   = !rootGroups.isEmpty();
+    int found = -1;
+    while (!heap.empty() && budget > 0) {
+        std::pop_heap(heap.begin(), heap.end(), compare);
+        const int current = heap.back().second;
+        heap.pop_back();
+        if (side.settled[current] == epoch) {
+            continue; // 过期条目
+        }
+        side.settled[current] = epoch;
+        budget--;
+
+        const StationId    station  = side.station[current];
+        const TransferCost cost     = side.cost[current];
+        const bool         atSpur   = fromSpur && side.prev[current] < 0;
+        if (station == to) {
+            found = current;
+            break;
+        }
 
-    while (!queue.empty()) {
-        QString current = queue.front();
-        queue.pop();
+        /* 沿当前线路前往相邻站点*/
+        const LineId line = csr.groupLines[current];
+        for (int k = csr.groupEdgeOffsets[current]; k < csr.groupEdgeOffsets[current + 1]; k++) {
+            const int e = csr.groupEdges[k];
+            if (closures != nullptr && closures->isEdgeClosed(e)) {
+                continue; // 封闭的区间
+            }
+            const StationId neighbor = csr.targets[e];
+            const int       group    = graph->findLineGroup(neighbor, line);
+            if (blocked.settled[neighbor] == epoch || (atSpur && blockedNext.contains(group))) {
+                continue;
+            }
+            TransferCost next = cost;
+            next.primary   += byStations ? 1.0 : csr.weights[e];
+            next.secondary += byStations ? csr.weights[e] : 1.0;
+            relax(group, current, next);
+        }
 
-        if (current == to) {
-            /* 重构路径*/
-            QVector<QString> path;
-            QString node = current;
-            while (!node.isEmpty()) {
-                path.prepend(node);
-                node = cameFrom.value(node, "");
+        /* 在本站换乘其他线路：起点不换乘，也不连续换乘*/
+        const bool byTransfer = atSpur ? spurByTransfer
+                                       : side.prev[current] >= 0 && side.station[side.prev[current]] == station;
+        if (station == from || byTransfer) {
+            continue;
+        }
+        for (int g = csr.groupOffsets[station]; g < csr.groupOffsets[station + 1]; g++) {
+            if (g != current && !(atSpur && blockedNext.contains(g))) {
+                TransferCost next = cost;
+                next.transfers++;
+                relax(g, current, next);
             }
-            qDebug() << "找到替代路径:" << path;
-            return path;
         }
+    }
 
-        Station stationInfo = graph->getStation(current);
+    QVector<int> groups;
+    if (found < 0) {
+        return groups;
+    }
+    for (int g = found; g >= 0; g = side.prev[g]) {
+        groups.prepend(g);
+    }
+    return groups;
+}
 
-        /* 只考虑在同一线路上的邻居*/
-        for (const QString& neighbor : stationInfo.connectedStations) {
-            QString neighborLine = getLineBetweenStations(current, neighbor);
-            if (neighborLine == line && !visited.contains(neighbor)) {
-                visited.insert(neighbor);
-                cameFrom[neighbor] = current;
-                queue.push(neighbor);
-            }
+/***************************************************************************
+  函数名称：PathFinder::spurPath
+  功    能：Yen算法中从偏离点到终点的搜索
+  输入参数：const QVector<StationId>& rootPath    - 起点到偏离点的站点，最后一个为偏离点
+			const QVector<StationId>& blockedNext - 偏离点不能直接前往的站点
+			StationId to                          - 终点编号
+			const SearchTree& tree                - 以终点为根的搜索树
+			bool byDistance                       - 代价为里程（否则为区间数）
+			int& budget                           - 剩余可展开的站点数，搜索中递减
+			const ClosureMaskPtr& closures - 本次查询生效的临时封闭，没有时为空
+  返 回 值：QVector<StationId> - 从偏离点到终点的站点列表，不可达或超出上限时为空
+  说    明：偏离点之前的站点不可再经过。封锁只会使代价变大，树上代价仍是
+            下界：树上路径未经过封锁的站点时即为最优，无需搜索；否则以树上
+            代价为启发做A*，启发满足三角不等式，终点出堆即为最优
+  ***************************************************************************/
+QVector<StationId> PathFinder::spurPath(const QVector<StationId>& rootPath, const QVector<StationId>& blockedNext,
+                                        StationId to, const SearchTree& tree, bool byDistance, int& budget,
+                                        const ClosureMaskPtr& closures) {
+    const MetroCsr&      csr          = graph->getCsr();
+    const StationId      spur         = rootPath.last();
+    const int            stationCount = graph->getStationCount();
+
+    /* 用backward.settled标记不可经过的站点，backward.reached标记偏离点不能前往的站点*/
+    scratch.prepare(stationCount);
+    const quint32 epoch   = scratch.epoch;
+    SearchSide&   side    = scratch.forward;
+    SearchSide&   blocked = scratch.backward;
+    for (int i = 0; i + 1 < rootPath.size(); i++) {
+        blocked.settled[rootPath[i]] = epoch;
+    }
+    for (StationId station : blockedNext) {
+        blocked.reached[station] = epoch;
+    }
+
+    /* 树上路径未被封锁时直接采用*/
+    QVector<StationId> path;
+    bool clean = tree.isReached(spur);
+    for (StationId station = spur; clean && station != INVALID_ID; station = tree.getNext(station)) {
+        if (blocked.settled[station] == epoch || (path.size() == 1 && blocked.reached[station] == epoch)) {
+            clean = false;
         }
+        path.append(station);
     }
+    if (clean) {
+        return path;
+    }
+    path.clear();
+
+    auto heuristic = [&tree, byDistance](StationId station) {
+        return byDistance ? tree.getDistance(station) : double(tree.getStationCount(station) - 1);
+    };
+    std::vector<std::pair<double, StationId>>& heap = side.heap;
+    ComparePair compare;
+    side.dist[spur]    = 0;
+    side.prev[spur]    = INVALID_ID;
+    side.reached[spur] = epoch;
+    heap.push_back(std::make_pair(heuristic(spur), spur));
+
+    bool found = false;
+    while (!heap.empty() && budget > 0) {
+        std::pop_heap(heap.begin(), heap.end(), compare);
+        const StationId current = heap.back().second;
+        heap.pop_back();
+        if (side.settled[current] == epoch) {
+            continue;
+        }
+        side.settled[current] = epoch;
+        budget--;
+        if (current == to) {
+            found = true;
+            break;
+        }
 
-    qDebug() << "错误: 无法在线路" << line << "上找到从" << from << "到" << to << "的替代路径";
-    return QVector<QString>();
+        for (int e = csr.offsets[current]; e < csr.offsets[current + 1]; e++) {
+            if (closures != nullptr && closures->isEdgeClosed(e)) {
+                continue; // 封闭的区间
+            }
+            const StationId neighbor = csr.targets[e];
+            if (side.settled[neighbor] == epoch || blocked.settled[neighbor] == epoch || !tree.isReached(neighbor)
+                || (current == spur && blocked.reached[neighbor] == epoch)) {
+                continue;
+            }
+            const double alt = side.dist[current] + (byDistance ? csr.weights[e] : 1.0);
+            if (side.reached[neighbor] != epoch || alt < side.dist[neighbor]) {
+                side.dist[neighbor]    = alt;
+                side.prev[neighbor]    = current;
+                side.reached[neighbor] = epoch;
+                heap.push_back(std::make_pair(alt + heuristic(neighbor), neighbor));
+                std::push_heap(heap.begin(), heap.end(), compare);
+            }
+        }
+    }
+    if (!found) {
+        return path;
+    }
+    for (StationId station = to; station != INVALID_ID; station = side.prev[station]) {
+        path.prepend(station);
+    }
+    return path;
 }
 
 /***************************************************************************
-  函数名称：PathFinder::getLineStations
-  功    能：获取线路到站点的映射
-  输入参数：
-  返 回 值：QMap<QString,QVector<QString>> - 线路到站点的映射
-  说    明：
+  函数名称：PathFinder::buildPath
+  功    能：从站点编号列表构建完整路径信息
+  输入参数：const QVector<StationId>& stationIds - 站点编号列表
+            const ClosureMaskPtr& closures       - 本次查询生效的临时封闭，没有时为空
+  返 回 值：
+  说    明：封闭须与搜索得到站点序列时所用的相同，否则可能选到封闭的线路
 ***************************************************************************/
-QMap<QString, QVector<QString>> PathFinder::getLineStations() const {
-    QMap<QString, QVector<QString>> lineStations;
-
-    /* 遍历所有连接，构建线路到站点的映射*/
-    for (const StationConnection& conn : graph->getConnections()) {
-        if (!lineStations[conn.line].contains(conn.station1)) {
-            lineStations[conn.line].append(conn.station1);
-        }
-        if (!lineStations[conn.line].contains(conn.station2)) {
-            lineStations[conn.line].append(conn.station2);
-        }
-    }
-
-    /* 对每条线路的站点进行排序（按照线路顺序）*/
-    for (auto& line : lineStations.keys()) {
-        /* 使用BFS从任意站点开始构建线路顺序*/
-        QVector<QString>    sortedStations;
-        QSet<QString>       visited;
-        std::queue<QString> queue;
-
-        /* 找到端点（连接数为1的站点）*/
-        QString endStation;
-        for (const QString& station : lineStations[line]) {
-            Station stationInfo = graph->getStation(station);
-            int connectionCount = 0;
-            for (const QString& neighbor : stationInfo.connectedStations) {
-                if (getLineBetweenStations(station, neighbor) == line) {
-                    connectionCount++;
+MetroPath PathFinder::buildPath(const QVector<StationId>& stationIds, const ClosureMaskPtr& closures) {
+    if (stationIds.size() < 2) {
+        qDebug() << "路径构建失败: 站点数量不足";
+        return MetroPath{ QVector<PathSegment>(), 0, 0, 0 };
+    }
+
+    /* 为每一段区间选择线路：能沿用当前线路时沿用，否则选择向前延伸最远的线路，
+       这样共线区间（如3号线与4号线）不会产生多余的换乘*/
+    QVector<QVector<LineId>> hopLines(stationIds.size());
+    for (int i = 1; i < stationIds.size(); i++) {
+        hopLines[i] = graph->getLinesBetween(stationIds[i - 1], stationIds[i]);
+        if (closures != nullptr) {
+            /* 共线区间中只封闭了部分线路时，不能选择封闭的线路*/
+            const StationId previous = stationIds[i - 1];
+            const StationId current  = stationIds[i];
+            hopLines[i].erase(std::remove_if(hopLines[i].begin(), hopLines[i].end(), [&](LineId line) {
+                return closures->isSegmentClosed(previous, current, line);
+            }), hopLines[i].end());
+        }
+    }
+
+    QVector<LineId> chosenLines(stationIds.size(), INVALID_ID);
+    LineId          runningLine = INVALID_ID;
+    for (int i = 1; i < stationIds.size(); i++) {
+        if (runningLine == INVALID_ID || !hopLines[i].contains(runningLine)) {
+            runningLine = INVALID_ID;
+            int bestReach = 0;
+            for (LineId candidate : hopLines[i]) {
+                int reach = i;
+                while (reach + 1 < stationIds.size() && hopLines[reach + 1].contains(candidate)) {
+                    reach++;
+                }
+                if (runningLine == INVALID_ID || reach > bestReach) {
+                    runningLine = candidate;
+                    bestReach   = reach;
                 }
-            }
-            if (connectionCount == 1) {
-                endStation = station;
-                break;
             }
         }
+        chosenLines[i] = runningLine;
+    }
+    return buildSegments(stationIds, chosenLines);
+}
 
-        /* 如果没有找到端点，选择第一个站点*/
-        if (endStation.isEmpty()) {
-            endStation = lineStations[line].first();
+/***************************************************************************
+  函数名称：PathFinder::buildGroupPath
+  功    能：从(站点, 线路)分组序列构建完整路径信息
+  输入参数：const QVector<int>& groups - 分组序列，相邻两项在同一站时为换乘
+  返 回 值：MetroPath - 路径信息
+  说    明：每段区间的线路取搜索实际乘坐的线路，路径段和换乘次数与搜索的
+            代价一致，不再像buildPath那样按站点序列重新选择
+***************************************************************************/
+MetroPath PathFinder::buildGroupPath(const QVector<int>& groups) {
+    const MetroCsr&    csr = graph->getCsr();
+    QVector<StationId> stationIds;
+    QVector<LineId>    chosenLines;
+    for (int g : groups) {
+        const StationId station = StationId(std::upper_bound(csr.groupOffsets.begin(), csr.groupOffsets.end(), g)
+                                            - csr.groupOffsets.begin() - 1);
+        if (stationIds.isEmpty() || stationIds.last() != station) {
+            stationIds.append(station);
+            chosenLines.append(csr.groupLines[g]);
         }
+    }
+    if (stationIds.size() < 2) {
+        qDebug() << "路径构建失败: 站点数量不足";
+        return MetroPath{ QVector<PathSegment>(), 0, 0, 0 };
+    }
+    chosenLines[0] = INVALID_ID;
+    return buildSegments(stationIds, chosenLines);
+}
 
-        queue.push(endStation);
-        visited.insert(endStation);
+/***************************************************************************
+  函数名称：PathFinder::buildSegments
+  功    能：按每段区间选定的线路构建路径段
+  输入参数：const QVector<StationId>& stationIds - 站点编号列表，至少两站
+			const QVector<LineId>& chosenLines   - 第i项为第i-1站到第i站乘坐的线路，第0项不用
+  返 回 值：MetroPath - 路径信息
+  说    明：线路改变处开始新的路径段，换乘站同时出现在前后两段中
+***************************************************************************/
+MetroPath PathFinder::buildSegments(const QVector<StationId>& stationIds, const QVector<LineId>& chosenLines) {
+    MetroPath path;
+    path.transferCount = 0;
+    path.stationCount  = stationIds.size();
+    path.totalDistance = 0;
 
-        while (!queue.empty()) {
-            QString current = queue.front();
-            queue.pop();
+    /* 构建路径段*/
+    PathSegment currentSegment;
+    currentSegment.from = graph->getStationName(stationIds.first());
+    currentSegment.stations.append(currentSegment.from);
 
-            sortedStations.append(current);
+    for (int i = 1; i < stationIds.size(); i++) {
+        const QString& currentStation = graph->getStationName(stationIds[i]);
+        const QString& prevStation    = graph->getStationName(stationIds[i - 1]);
 
-            Station stationInfo = graph->getStation(current);
-            for (const QString& neighbor : stationInfo.connectedStations) {
-                if (getLineBetweenStations(current, neighbor) == line && !visited.contains(neighbor)) {
-                    visited.insert(neighbor);
-                    queue.push(neighbor);
-                }
+        /* 计算距离*/
+        path.totalDistance += calculateDistance(stationIds[i - 1], stationIds[i]);
+
+        QString line = graph->getLineName(chosenLines[i]);
+
+        if (line.isEmpty()) {
+            qDebug() << "警告: 站点" << prevStation << "和" << currentStation << "之间没有线路信息";
+            /* 尝试使用前一段的线路*/
+            if (!currentSegment.line.isEmpty()) {
+                line = currentSegment.line;
+                qDebug() << "使用前一段的线路:" << line;
+            }
+            else {
+                line = QString::fromUtf8("未知");
             }
         }
 
-        /* 更新线路的站点顺序*/
-        lineStations[line] = sortedStations;
+        if (currentSegment.line.isEmpty()) {
+            currentSegment.line = line;
+            currentSegment.to   = currentStation;
+            currentSegment.stations.append(currentStation);
+        }
+        else if (currentSegment.line == line) {
+            currentSegment.to = currentStation;
+            currentSegment.stations.append(currentStation);
+        }
+        else {
+            // 换乘点
+            path.segments.append(currentSegment);
+            path.transferCount++;
+
+            currentSegment      = PathSegment();
+            currentSegment.line = line;
+            currentSegment.from = prevStation; // 换乘站
+            currentSegment.to   = currentStation;
+            currentSegment.stations.append(prevStation);
+            currentSegment.stations.append(currentStation);
+        }
+    }
+
+    if (!currentSegment.stations.isEmpty()) {
+        path.segments.append(currentSegment);
+    }
+
+    qDebug() << "构建路径完成，段数:" << path.segments.size() << "换乘次数:" << path.transferCount;
+
+    return path;
+}
+/***************************************************************************
+  函数名称：PathFinder::calculateDistance
+  功    能：计算两个站点之间的距离
+  输入参数：StationId station1 - 站点编号1
+            StationId station2 - 站点编号2
+  返 回 值：double 两个站点之间的距离
+  说    明：
+***************************************************************************/
+double PathFinder::calculateDistance(StationId station1, StationId station2) const {
+    /* 检查站点是否存在*/
+    if (station1 == INVALID_ID || station2 == INVALID_ID) {
+        qDebug() << "警告: 计算距离时站点不存在";
+        return 1.0; // 返回默认距离
     }
 
-    return lineStations;
+    return graph->calculateDistance(station1, station2);
 }
+
 /*PathFinder.cpp*/
\ No newline at end of file
@@ -8,11 +8,13 @@
 #define PATHFINDER_H
 
 #include "MetroGraph.h"
+#include "ContractionHierarchy.h"
+#include "CostModel.h"
 #include <QVector>
 #include <QString>
 #include <QMap>
-#include <queue>
 #include <functional>
+#include <vector>
 #include <QSet>
 
 /*搜索策略枚举*/
@@ -22,6 +24,43 @@ enum SearchStrategy {
     MIN_DISTANCE     // 路径长度最短
 };
 
+/*最少换乘策略在换乘次数相同时的比较依据*/
+enum TransferTieBreak {
+    FEWER_STATIONS,  // 经过站点少者优先，再比较距离
+    SHORTER_DISTANCE // 距离短者优先，再比较站点数
+};
+
+/*最少站点策略使用的搜索算法*/
+enum StationsAlgorithm {
+    BFS,              // 从起点单向广度优先搜索
+    BIDIRECTIONAL_BFS,// 从起点和终点交替逐层扩展，两侧相遇即停止
+    ALT_BFS           // 以地标给出的区间数下界为启发的A*，向终点方向扩展
+};
+
+/*最短距离策略使用的搜索算法*/
+enum DistanceAlgorithm {
+    DIJKSTRA,              // Dijkstra，向各方向均匀扩展
+    A_STAR,                // A*，以到终点的直线距离为启发，向终点方向扩展
+    BIDIRECTIONAL_DIJKSTRA,// 从起点和终点同时运行Dijkstra
+    ALT_A_STAR             // A*，以直线距离和地标给出的里程下界中较大者为启发
+};
+
+/*最近一次搜索的统计信息*/
+struct SearchStats {
+    int nodesExpanded = 0; //出队或出堆并展开出边的站点数（双向搜索为两侧之和）
+    int heapPushes    = 0; //压入堆或队列的条目数（含过期条目）
+};
+
+class RouteTable;
+class RouteCache;
+class SearchTree;
+
+/*只读的全源路径表，可在多个查找器之间共享*/
+typedef std::shared_ptr<const RouteTable> RouteTablePtr;
+
+/*路径查询结果缓存，可在多个查找器之间共享*/
+typedef std::shared_ptr<RouteCache> RouteCachePtr;
+
 /*路径段信息*/
 struct PathSegment {
 	QString          line;    //线路名称
@@ -38,39 +77,200 @@ struct MetroPath {
 	double               totalDistance; //总距离
 };
 
+/*只读的路径结果，由路径缓存共享*/
+typedef std::shared_ptr<const MetroPath> MetroPathPtr;
+
+/*多起点到多终点的结果矩阵，按[起点序号 * 终点数 + 终点序号]存放*/
+struct OdMatrix {
+    int             originCount      = 0; //起点数（行数）
+    int             destinationCount = 0; //终点数（列数）
+    QVector<double> distances;            //路径里程（公里），不可达为-1
+    QVector<int>    transfers;            //换乘次数，不可达为-1
+    QVector<int>    stationCounts;        //经过站点数（含两端），不可达为0
+};
+
+/*从一个站点出发到全图各站的结果，按站点编号存放*/
+struct Isochrone {
+    StationId       origin   = INVALID_ID;   //出发站，无效时其余各项为空
+    SearchStrategy  strategy = MIN_DISTANCE; //搜索策略，决定各站按哪项代价分级
+    QVector<double> distances;               //路径里程（公里），不可达为-1
+    QVector<int>    transfers;               //换乘次数，不可达为-1
+    QVector<int>    stationCounts;           //经过站点数（含两端），不可达为0
+
+    double             getCost(StationId station)  const; //按策略取该站的代价，不可达为-1
+    QVector<StationId> reachableWithin(double budget) const; //代价不超过budget的站点，按代价升序
+};
+
+/*一个搜索方向的临时数组*/
+struct SearchSide {
+    QVector<double>    dist;    //该方向的出发站到各站的距离
+    QVector<StationId> prev;    //搜索树中朝向出发站的前驱
+    QVector<quint32>   reached; //等于epoch时dist和prev对本次搜索有效
+    QVector<quint32>   settled; //等于epoch时该站距离已确定
+    std::vector<std::pair<double, StationId>> heap; //二叉堆，同一站点可有多个过期条目（惰性删除）
+    QVector<StationId> queue;   //广度优先搜索的队列
+};
+
+/*最少换乘搜索中到达一个(站点, 线路)分组的代价，按成员顺序逐项比较*/
+struct TransferCost {
+    int    transfers = 0; //换乘次数
+    double primary   = 0; //次要比较项（站点数或距离，由TransferTieBreak决定）
+    double secondary = 0; //最后比较项（距离或站点数）
+};
+
+/*最少换乘搜索的临时数组，按CSR中的(站点, 线路)分组编号*/
+struct TransferSearchSide {
+    QVector<TransferCost> cost;    //到达各分组的代价
+    QVector<int>          prev;    //前驱分组，-1表示起点所在的分组
+    QVector<StationId>    station; //分组所属的站点
+    QVector<quint32>      reached; //等于epoch时cost、prev和station对本次搜索有效
+    QVector<quint32>      settled; //等于epoch时该分组代价已确定
+    std::vector<std::pair<TransferCost, int>> heap; //二叉堆，惰性删除
+};
+
+/*广义代价搜索的临时数组，按CSR中的(站点, 线路)分组编号*/
+struct CostSearchSide {
+    QVector<double>    cost;    //到达各分组的广义代价
+    QVector<int>       prev;    //前驱分组，-1表示起点所在的分组
+    QVector<StationId> station; //分组所属的站点
+    QVector<quint32>   reached; //等于epoch时cost、prev和station对本次搜索有效
+    QVector<quint32>   settled; //等于epoch时该分组代价已确定
+    std::vector<std::pair<double, int>> heap; //二叉堆，键为代价加启发，惰性删除
+};
+
+/*多目标搜索中的一个标签：乘坐一条线路到达某站时的(换乘次数, 区间数, 里程)*/
+struct ParetoLabel {
+    StationId station;   //到达的站点
+    LineId    line;      //本段乘坐的线路，起点标签为INVALID_ID
+    StationId boarded;   //本段的上车站
+    int       transfers; //换乘次数，即生成该标签的轮次
+    int       hops;      //经过的区间数
+    double    distance;  //里程
+    int       rideStep;  //下车站在上车分组乘车步骤中的下标，起点标签为0
+    int       prev;      //上车时所在的标签，起点标签为-1
+    int       nextInBag; //同一站点的下一个标签，-1表示结束
+    bool      dominated; //是否已被同一站点后来的标签支配
+};
+
+/*从一个(站点, 线路)分组上车后沿线路广度优先乘车的一步*/
+struct ParetoRideStep {
+    StationId station;  //到达的站点
+    int       hops;     //自上车站起的区间数
+    double    distance; //自上车站起的里程
+    int       parent;   //本次乘车中的上一步，上车站为-1
+};
+
+/*多目标搜索的临时数组*/
+struct ParetoSearchSide {
+    QVector<ParetoLabel>    labels;      //全部标签，按生成顺序
+    QVector<int>            bagHead;     //按站点：该站第一个标签，-1表示没有
+    QVector<quint32>        bagReached;  //按站点：等于epoch时bagHead有效
+    QVector<int>            marked;      //上一轮生成的标签
+    QVector<int>            generated;   //本轮生成的标签
+    QVector<char>           pruned;      //本次乘车中各步是否已被终点的标签支配
+    QVector<int>            hopBound;    //按站点：到终点的最少区间数，用于剪枝
+    QVector<double>         distanceBound; //按站点：到终点的直线距离，用于剪枝
+    QVector<int>            rideOffsets; //按分组：从该分组上车的各步位于rides[rideOffsets[g], rideOffsets[g+1])，为空时尚未计算
+    QVector<ParetoRideStep> rides;       //各分组上车后的乘车步骤，只依赖地铁图和封闭情况，换图时清空
+    quint64                 rideClosures = 0; //rides对应的封闭修改次数，没有封闭时为0
+};
+
+/*单次搜索使用的临时数组，在同一查找器的多次查询之间复用*/
+struct SearchScratch {
+    SearchSide         forward;   //从起点出发的方向
+    SearchSide         backward;  //从终点出发的方向，仅双向搜索使用
+    TransferSearchSide groups;    //最少换乘搜索使用
+    CostSearchSide     costs;     //广义代价搜索使用
+    ParetoSearchSide   pareto;    //多目标搜索使用
+    quint32            epoch = 0; //当前搜索的编号，递增即可作废上次的结果
+
+    void prepare(int stationCount, int groupCount = 0); //开始新的搜索
+};
+
 /*路径查找器*/
 class PathFinder {
 public:
-    PathFinder(const MetroGraph* graph);                                                //构造函数
+    static const int DEFAULT_ALTERNATIVE_BUDGET = 200000; //备选路径查询默认的展开站点数上限
+
+    explicit PathFinder(MetroGraphPtr graph = MetroGraphPtr());                        //构造函数
     MetroPath findPath(const QString& from, const QString& to, SearchStrategy strategy);//查找路径
-	void      setGraph(const MetroGraph* graph);                                        //设置地铁图
+    QVector<MetroPath> findParetoPaths(const QString& from, const QString& to);         //查找换乘次数、站点数和里程互不支配的全部路径
+    QVector<MetroPath> findAlternativePaths(const QString& from, const QString& to, SearchStrategy strategy,
+                                            int count, int maxExpansions = DEFAULT_ALTERNATIVE_BUDGET); //查找按策略排序的前count条无环路径
+	void      setGraph(MetroGraphPtr graph);                                            //设置地铁图版本
+	void      setTransferTieBreak(TransferTieBreak tieBreak);                           //设置最少换乘策略的次要比较依据
+	void      setStationsAlgorithm(StationsAlgorithm algorithm);                        //设置最少站点策略的搜索算法
+	void      setDistanceAlgorithm(DistanceAlgorithm algorithm);                        //设置最短距离策略的搜索算法
+	void      setContractionHierarchy(ContractionHierarchyPtr hierarchy);               //设置最短距离查询使用的收缩层次索引
+	ContractionHierarchyPtr getContractionHierarchy() const;                            //获取收缩层次索引
+	void      setRouteTable(RouteTablePtr table);                                       //设置全源路径表
+	RouteTablePtr getRouteTable() const;                                                //获取全源路径表
+	void      setRouteCache(RouteCachePtr cache);                                       //设置findPath使用的结果缓存
+	RouteCachePtr getRouteCache() const;                                                //获取结果缓存
+	const SearchStats& getLastStats() const;                                            //获取最近一次站点级搜索的统计
+	OdMatrix  computeMatrix(const QVector<StationId>& origins, const QVector<StationId>& destinations,
+	                        SearchStrategy strategy, int threadCount = 0)       const;  //多线程计算多起点到多终点的结果矩阵
+	Isochrone computeIsochrone(const QString& from, SearchStrategy strategy)        const;  //一次搜索得到起点到全图各站的结果
+	MetroPath findMinCostPath(const QString& from, const QString& to,
+	                          CostBreakdown* breakdown = nullptr);                     //查找广义代价最小的路径
+	void      setCostModel(CostModelPtr model);                                         //设置广义代价模型
+	CostModelPtr getCostModel() const;                                                  //获取广义代价模型
+	void      setCostWeights(const CostWeights& weights);                               //设置广义代价各项的权重
+	const CostWeights& getCostWeights() const;                                          //获取广义代价各项的权重
 
 private:
-	const MetroGraph* graph; //地铁线路图指针
+	MetroGraphPtr     graph;             //固定的地铁线路图版本
+	SearchScratch     scratch;           //搜索用的临时数组
+	TransferTieBreak  transferTieBreak;  //最少换乘策略的次要比较依据
+	StationsAlgorithm stationsAlgorithm; //最少站点策略的搜索算法
+	DistanceAlgorithm distanceAlgorithm; //最短距离策略的搜索算法
+	ContractionHierarchyPtr hierarchy;   //收缩层次索引，与当前图版本对应时优先使用
+	RouteTablePtr     routeTable;        //全源路径表，与当前图版本对应时最优先使用
+	RouteCachePtr     routeCache;        //findPath的结果缓存，为空时不缓存
+	CostModelPtr      costModel;         //广义代价模型，与当前图版本对应时才能查询
+	CostWeights       costWeights;       //广义代价各项的权重
+	SearchStats       lastStats;         //最近一次站点级搜索的统计
 
     /* 三种搜索策略的具体实现*/
-	MetroPath findMinTransferPath(const QString& from, const QString& to); // 最少换乘
-	MetroPath findMinStationsPath(const QString& from, const QString& to); // 经过站点最少
-	MetroPath findMinDistancePath(const QString& from, const QString& to); // 路径长度最短
+	MetroPath searchPath(const QString& from, const QString& to, SearchStrategy strategy,
+	                     const ClosureMaskPtr& closures);                                 // 按策略分派搜索
+	MetroPath findMinTransferPath(const QString& from, const QString& to, const ClosureMaskPtr& closures); // 最少换乘
+	MetroPath findMinStationsPath(const QString& from, const QString& to, const ClosureMaskPtr& closures); // 经过站点最少
+	MetroPath findMinDistancePath(const QString& from, const QString& to, const ClosureMaskPtr& closures); // 路径长度最短
 
     /* 辅助函数*/
-	QVector<QString> bfsShortestPath(const QString& from, const QString& to);                       // 广度优先搜索
-	QVector<QString> dijkstraShortestPath(const QString& from, const QString& to);                  // Dijkstra算法
-	MetroPath        buildPath(const QVector<QString>& stationNames);                               // 构建路径信息
-	QString          getLineBetweenStations(const QString& station1, const QString& station2) const;// 获取两站间的线路
-	double           calculateDistance(const QString& station1, const QString& station2);           // 计算两站间距离
-
-    /* 最少换乘算法的辅助函数*/
-	QMap<QString, QVector<QString>> getStationLines() const; // 获取每个站点的线路信息
-	QMap<QString, QVector<QString>> getLineStations() const; // 获取每条线路的站点信息
-    QVector<QString> convertLinePathToStationPath(
-		const QVector<QString>& linePath,const QString& from, 
-		const QString& to);                                  // 将线路路径转换为站点路径
-    QVector<QString> findPathOnLine(const QString& line,
-		const QString& from, const QString& to);             // 在路线上查路径
-    QVector<QString> findAlternativePathOnLine(const QString& line, const QString& from,
-		const QString& to, const QString& branchPoint);      // 在支线上查路径
-
+	bool               hasRouteTable(const ClosureMaskPtr& closures)                            const;// 全源路径表是否对应当前图版本且可用
+	static ClosureMaskPtr activeClosures(const ClosureMaskPtr& mask);                                 // 生效的临时封闭，没有任何封闭时为空
+	QVector<StationId> bfsShortestPath(StationId from, StationId to, const ClosureMaskPtr& closures);      // 广度优先搜索
+	QVector<StationId> bidirectionalBfsPath(StationId from, StationId to, const ClosureMaskPtr& closures); // 双向广度优先搜索
+	QVector<StationId> dijkstraShortestPath(StationId from, StationId to, DistanceAlgorithm algorithm,
+	                                        const ClosureMaskPtr& closures);                          // Dijkstra、A*或ALT算法
+	QVector<StationId> landmarkBfsPath(StationId from, StationId to, const ClosureMaskPtr& closures);      // 以地标下界为启发的最少站点A*
+	QVector<StationId> bidirectionalDijkstraPath(StationId from, StationId to, const ClosureMaskPtr& closures); // 双向Dijkstra算法
+	QVector<StationId> hierarchyShortestPath(StationId from, StationId to);                           // 收缩层次上的双向向上搜索
+	QVector<StationId> joinSearchTrees(StationId forwardEnd, StationId backwardEnd)          const;// 拼接双向搜索两侧的路径
+	QVector<StationId> minTransferSearch(StationId from, StationId to, int& transfers,
+	                                     const ClosureMaskPtr& closures);                             // (站点, 线路)分组上的字典序Dijkstra
+	QVector<int>       minCostSearch(StationId from, StationId to, CostBreakdown& breakdown,
+	                                 const ClosureMaskPtr& closures);                                 // (站点, 线路)分组上的广义代价A*
+	void               paretoRounds(StationId from, StationId to, const ClosureMaskPtr& closures);   // 按换乘次数分轮的多目标搜索
+	bool               paretoDominated(StationId station, int hops, double distance)            const;// 站点已有的标签是否支配给定代价
+	bool               addParetoLabel(const ParetoLabel& label);                                     // 加入不被支配的标签
+	void               prepareRides(const ClosureMaskPtr& closures);                                 // 计算从各分组上车的乘车步骤
+	QVector<int>       paretoGroups(int label)                                                  const;// 展开标签对应的(站点, 线路)分组序列
+	QVector<StationId> spurPath(const QVector<StationId>& rootPath, const QVector<StationId>& blockedNext,
+	                            StationId to, const SearchTree& tree, bool byDistance, int& budget,
+	                            const ClosureMaskPtr& closures);                                      // Yen算法的偏离搜索
+	QVector<MetroPath> transferAlternatives(StationId from, StationId to, int count, int& budget,
+	                                        const ClosureMaskPtr& closures);                          // 分组图上按换乘次数排序的Yen算法
+	QVector<int>       transferSpurPath(const QVector<int>& rootGroups, const QVector<int>& blockedNext, StationId from, StationId to,
+	                                    const QVector<StationId>& groupStations, int& budget,
+	                                    const ClosureMaskPtr& closures);                              // 分组图上Yen算法的偏离搜索
+	MetroPath          buildPath(const QVector<StationId>& stationIds, const ClosureMaskPtr& closures); // 构建路径信息（按编号）
+	MetroPath          buildGroupPath(const QVector<int>& groups);                                    // 按(站点, 线路)分组序列构建路径信息
+	MetroPath          buildSegments(const QVector<StationId>& stationIds,
+	                                 const QVector<LineId>& chosenLines);                            // 按每段选定的线路构建路径段
+	double             calculateDistance(StationId station1, StationId station2)                const;// 计算两站间距离
 };
 
 #endif // PATHFINDER_H
\ No newline at end of file
@@ -0,0 +1,237 @@
+﻿/***************************************************************************
+  文件名称：RouteCache.cpp
+  功    能：路径查询结果缓存的实现文件
+  说    明：双向链表按最近使用排列条目，哈希表从键定位到链表节点，查找、
+            加入和淘汰都是O(1)；全部操作在一把互斥锁内完成
+***************************************************************************/
+
+#include "RouteCache.h"
+#include <QMutexLocker>
+
+namespace {
+
+/*路径是否经过封闭的车站或区间，按站点和线路名称逐段比较*/
+bool touchesClosure(const MetroGraph& graph, const ClosureMask& closures, const MetroPath& path) {
+    for (const PathSegment& segment : path.segments) {
+        const LineId line = graph.getLineId(segment.line);
+        for (int i = 1; i < segment.stations.size(); i++) {
+            if (closures.isSegmentClosed(graph.getStationId(segment.stations[i - 1]),
+                                         graph.getStationId(segment.stations[i]), line)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+/***************************************************************************
+  函数名称：RouteCache::Key::operator==
+  功    能：比较两个缓存键
+  输入参数：const Key& other - 另一个键
+  返 回 值：bool - 各字段是否都相同
+  说    明：
+***************************************************************************/
+bool RouteCache::Key::operator==(const Key& other) const {
+    return from == other.from && to == other.to && strategy == other.strategy
+        && variant == other.variant && version == other.version && closures == other.closures;
+}
+
+/***************************************************************************
+  函数名称：qHash
+  功    能：计算缓存键的哈希
+  输入参数：const RouteCache::Key& key - 缓存键
+            size_t seed                - 哈希种子
+  返 回 值：size_t - 哈希值
+  说    明：起终点编号占主要部分，策略和设置只取低位混入；同一时刻的条目
+            封闭修改次数都相同，不参与哈希
+***************************************************************************/
+size_t qHash(const RouteCache::Key& key, size_t seed) {
+    const quint64 stations = (quint64(key.from) << 32) | key.to;
+    const quint64 options  = (quint64(key.strategy) << 8) ^ quint64(key.variant) ^ (key.version << 16);
+    return qHash(stations ^ (options * 0x9E3779B97F4A7C15ull), seed);
+}
+
+/***************************************************************************
+  函数名称：RouteCache::Stats::hitRate
+  功    能：计算命中率
+  输入参数：
+  返 回 值：double - 命中次数占查询次数的比例
+  说    明：
+***************************************************************************/
+double RouteCache::Stats::hitRate() const {
+    const quint64 total = hits + misses;
+    return total == 0 ? 0.0 : double(hits) / double(total);
+}
+
+/***************************************************************************
+  函数名称：RouteCache::RouteCache
+  功    能：构造函数
+  输入参数：int capacity - 最多保存的条目数，至少为1
+  返 回 值：
+  说    明：
+***************************************************************************/
+RouteCache::RouteCache(int capacity) : capacity(qMax(1, capacity)), latestVersion(0), latestClosures(0) {
+    index.reserve(this->capacity);
+}
+
+/***************************************************************************
+  函数名称：RouteCache::acceptVersion
+  功    能：按查询的地铁图版本维护缓存
+  输入参数：quint64 version - 查询所用的地铁图版本号
+  返 回 值：bool - 该版本是否为见过的最新版本
+  说    明：调用方已持有锁；出现更新的版本说明地铁图已被编辑，旧版本的条目
+            不会再被新版本的查询命中，直接全部清除；仍持有旧版本的查找器
+            查询时返回false，其结果不再加入缓存
+***************************************************************************/
+bool RouteCache::acceptVersion(quint64 version) {
+    if (version < latestVersion) {
+        return false;
+    }
+    if (version > latestVersion) {
+        removeAll();
+        latestVersion  = version;
+        latestClosures = 0;
+    }
+    return true;
+}
+
+/***************************************************************************
+  函数名称：RouteCache::removeAll
+  功    能：清除全部条目
+  输入参数：
+  返 回 值：
+  说    明：调用方已持有锁；清除的条目计入invalidations
+***************************************************************************/
+void RouteCache::removeAll() {
+    stats.invalidations += entries.size();
+    entries.clear();
+    index.clear();
+}
+
+/***************************************************************************
+  函数名称：RouteCache::acceptClosures
+  功    能：按地铁图上当前的临时封闭维护缓存
+  输入参数：const MetroGraph& graph         - 查询所用的地铁图版本
+            const ClosureMaskPtr& closures - 该版本上当前的封闭，可为空
+  返 回 值：
+  说    明：封闭的修改次数与条目一致时直接返回，只多一次比较。封闭范围只
+            扩大时，封闭只会删去一些路径，未经过封闭处的最优路径仍然最优，
+            只清除经过封闭处的条目，其余条目改记新的修改次数；其间有封闭被
+            恢复时全部清除。旧版本和较旧的封闭不处理，其查询不会命中，
+            结果也不会加入
+***************************************************************************/
+void RouteCache::acceptClosures(const MetroGraph& graph, const ClosureMaskPtr& closures) {
+    QMutexLocker locker(&mutex);
+    if (!acceptVersion(graph.getVersion())) {
+        return;
+    }
+    const quint64 generation = closures != nullptr ? closures->generation : 0;
+    if (generation <= latestClosures) {
+        return;
+    }
+
+    if (closures->reopened > latestClosures) {
+        removeAll();
+    }
+    else {
+        for (EntryIterator it = entries.begin(); it != entries.end(); ) {
+            index.remove(it->key);
+            if (touchesClosure(graph, *closures, *it->path)) {
+                it = entries.erase(it);
+                stats.invalidations++;
+                continue;
+            }
+            it->key.closures = generation;
+            index.insert(it->key, it);
+            ++it;
+        }
+    }
+    latestClosures = generation;
+}
+
+/***************************************************************************
+  函数名称：RouteCache::find
+  功    能：查找缓存的查询结果
+  输入参数：const Key& key - 缓存键
+  返 回 值：MetroPathPtr - 缓存的结果，未命中时为空指针
+  说    明：命中的条目移到表头，成为最近使用的条目；封闭的修改次数与条目
+            不一致时不命中，调用方应先调用acceptClosures
+***************************************************************************/
+MetroPathPtr RouteCache::find(const Key& key) {
+    QMutexLocker locker(&mutex);
+    if (!acceptVersion(key.version) || key.closures != latestClosures) {
+        stats.misses++;
+        return MetroPathPtr();
+    }
+
+    QHash<Key, EntryIterator>::iterator it = index.find(key);
+    if (it == index.end()) {
+        stats.misses++;
+        return MetroPathPtr();
+    }
+    stats.hits++;
+    entries.splice(entries.begin(), entries, it.value());
+    return it.value()->path;
+}
+
+/***************************************************************************
+  函数名称：RouteCache::insert
+  功    能：加入一条查询结果
+  输入参数：const Key& key          - 缓存键
+            const MetroPathPtr& path - 只读的查询结果
+  返 回 值：
+  说    明：键已存在时替换结果；容量已满时先淘汰表尾最久未用的条目
+***************************************************************************/
+void RouteCache::insert(const Key& key, const MetroPathPtr& path) {
+    QMutexLocker locker(&mutex);
+    if (path == nullptr || !acceptVersion(key.version) || key.closures != latestClosures) {
+        return;
+    }
+
+    QHash<Key, EntryIterator>::iterator it = index.find(key);
+    if (it != index.end()) {
+        it.value()->path = path;
+        entries.splice(entries.begin(), entries, it.value());
+        return;
+    }
+
+    if (int(entries.size()) >= capacity) {
+        index.remove(entries.back().key);
+        entries.pop_back();
+        stats.evictions++;
+    }
+    entries.push_front(Entry{ key, path });
+    index.insert(key, entries.begin());
+}
+
+/***************************************************************************
+  函数名称：RouteCache::clear
+  功    能：清空全部条目
+  输入参数：
+  返 回 值：
+  说    明：命中统计不清零
+***************************************************************************/
+void RouteCache::clear() {
+    QMutexLocker locker(&mutex);
+    entries.clear();
+    index.clear();
+}
+
+/***************************************************************************
+  函数名称：RouteCache::getStats
+  功    能：获取命中统计
+  输入参数：
+  返 回 值：Stats - 统计的副本，含当前条目数和容量
+  说    明：
+***************************************************************************/
+RouteCache::Stats RouteCache::getStats() const {
+    QMutexLocker locker(&mutex);
+    Stats result    = stats;
+    result.size     = int(entries.size());
+    result.capacity = capacity;
+    return result;
+}
+
+/*RouteCache.cpp*/
@@ -0,0 +1,82 @@
+﻿/***************************************************************************
+  文件名称：RouteCache.h
+  功    能：路径查询结果缓存的头文件
+  说    明：按(起点, 终点, 策略, 查找器设置, 地铁图版本)缓存findPath的结果，
+            容量固定，满时淘汰最久未用的一条；结果以只读共享指针保存，命中
+            时无需重新搜索和构建路径。键中带有版本号，地铁图被编辑发布新版本
+            后，首次以新版本查询时自动清除旧版本的全部条目；版本号由
+            MetroGraphStore发布时分配，未经发布的图不应共用同一缓存。临时封闭
+            不改变版本号：封闭范围扩大时只清除经过封闭处的条目，其余条目
+            仍是最优的；有封闭被恢复时原先绕行的结果可能不再最优，全部清除
+***************************************************************************/
+
+#ifndef ROUTECACHE_H
+#define ROUTECACHE_H
+
+#include "MetroGraph.h"
+#include "PathFinder.h"
+#include <QHash>
+#include <QMutex>
+#include <list>
+
+/*路径查询结果缓存，可在多个查找器和线程之间共享*/
+class RouteCache {
+public:
+    static const int DEFAULT_CAPACITY = 1024; //默认容量（条）
+
+    /*缓存的键*/
+    struct Key {
+        StationId      from;     //起点编号
+        StationId      to;       //终点编号
+        SearchStrategy strategy; //搜索策略
+        int            variant;  //该策略下影响所选路径的查找器设置
+        quint64        version;  //地铁图版本号
+        quint64        closures; //查询时临时封闭的修改次数，没有封闭时为0
+
+        bool operator==(const Key& other) const;
+    };
+
+    /*命中统计*/
+    struct Stats {
+        quint64 hits          = 0; //命中次数
+        quint64 misses        = 0; //未命中次数
+        quint64 evictions     = 0; //因容量已满淘汰的条目数
+        quint64 invalidations = 0; //因地铁图版本更新或临时封闭清除的条目数
+        int     size          = 0; //当前条目数
+        int     capacity      = 0; //容量
+
+        double hitRate() const; //命中率，尚无查询时为0
+    };
+
+    explicit RouteCache(int capacity = DEFAULT_CAPACITY); //构造函数
+
+    void         acceptClosures(const MetroGraph& graph,
+                                const ClosureMaskPtr& closures); //按图上当前的封闭清除受影响的条目，查找前调用
+    MetroPathPtr find(const Key& key);                           //查找结果，命中时移到最近使用的位置，未命中为空指针
+    void         insert(const Key& key, const MetroPathPtr& path); //加入结果，满时淘汰最久未用的条目
+    void         clear();                                        //清空全部条目，统计保留
+    Stats        getStats()                               const; //获取命中统计
+
+private:
+    /*一条缓存结果*/
+    struct Entry {
+        Key          key;  //键
+        MetroPathPtr path; //只读的查询结果
+    };
+    typedef std::list<Entry>::iterator EntryIterator;
+
+    mutable QMutex              mutex;         //保护以下全部成员
+    int                         capacity;      //容量
+    quint64                     latestVersion; //见过的最新地铁图版本号
+    quint64                     latestClosures;//条目对应的临时封闭修改次数
+    std::list<Entry>            entries;       //按最近使用排列，表头最新
+    QHash<Key, EntryIterator>   index;         //键到条目的映射
+    Stats                       stats;         //命中统计
+
+    bool acceptVersion(quint64 version); //遇到新版本时清除旧条目，返回该版本是否仍是最新
+    void removeAll();                    //清除全部条目并计入统计
+};
+
+size_t qHash(const RouteCache::Key& key, size_t seed = 0); //缓存键的哈希
+
+#endif // ROUTECACHE_H
@@ -0,0 +1,403 @@
+﻿/***************************************************************************
+  文件名称：RouteTable.cpp
+  功    能：全源路径表的实现文件
+  说    明：每个终点各做一次完整搜索，得到以终点为根的搜索树（SearchTree），
+            树中各站指向终点方向的下一跳即为下一跳矩阵的一列。不同终点互不
+            相关，按终点分给多个线程并行计算，每个线程只写自己负责的列。
+            文件由定长文件头和依次排列的定长数组段组成，按本机字节序存储
+***************************************************************************/
+
+#include "RouteTable.h"
+#include "SearchTree.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QThread>
+#include <QThreadPool>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <cstddef>
+#include <cstring>
+
+namespace {
+
+const quint32 BYTE_ORDER_MARK  = 0x01020304u; //用于识别字节序不同的文件
+const int     MAX_HASH_LENGTH  = 32;          //文件头中哈希的最大长度
+const quint8  NO_TRANSFERS     = 0xFFu;       //换乘次数表中表示不可达
+
+/*文件头*/
+struct RouteTableHeader {
+    quint32 magic;                 //文件标识
+    quint32 version;               //格式版本
+    quint32 byteOrder;             //字节序标记
+    quint32 hashLength;            //CSR出边哈希的实际长度
+    quint8  hash[MAX_HASH_LENGTH]; //CSR出边哈希
+    quint32 stationCount;          //站点数量
+    quint32 groupCount;            //(站点, 线路)分组数量
+    quint32 reserved[2];           //保留，对齐用
+    quint64 fileSize;              //文件总长度
+};
+
+} // namespace
+
+const quint16 RouteTable::NO_HOP; //以引用方式传给QVector::fill，需要类外定义
+
+/***************************************************************************
+  函数名称：RouteTable::RouteTable
+  功    能：构造函数
+  输入参数：
+  返 回 值：
+  说    明：
+***************************************************************************/
+RouteTable::RouteTable() : stationCount(0), groupCount(0), graphVersion(0) {
+}
+
+/***************************************************************************
+  函数名称：RouteTable::setGraph
+  功    能：记录地铁图的规模、哈希和分组所属站点
+  输入参数：const MetroGraph& graph - 地铁图
+  返 回 值：
+  说    明：构建和读取共用
+***************************************************************************/
+void RouteTable::setGraph(const MetroGraph& graph) {
+    const MetroCsr& csr = graph.getCsr();
+    stationCount = graph.getStationCount();
+    groupCount   = csr.groupLines.size();
+    hash         = graph.getEdgeHash();
+    graphVersion = graph.getVersion();
+    groupStations.resize(groupCount);
+    for (int station = 0; station < stationCount; station++) {
+        for (int g = csr.groupOffsets[station]; g < csr.groupOffsets[station + 1]; g++) {
+            groupStations[g] = quint16(station);
+        }
+    }
+}
+
+/***************************************************************************
+  函数名称：RouteTable::build
+  功    能：构建全源路径表
+  输入参数：const MetroGraph& graph - 地铁图
+            int threadCount         - 线程数，0表示按处理器核数
+  返 回 值：RouteTablePtr - 构建完成的路径表，站点或分组过多时为空
+  说    明：终点按编号轮流分给各线程
+***************************************************************************/
+RouteTablePtr RouteTable::build(const MetroGraph& graph, int threadCount) {
+    if (graph.getStationCount() >= MAX_STATIONS || graph.getCsr().groupLines.size() >= MAX_STATIONS) {
+        qWarning() << "站点过多，不构建全源路径表:" << graph.getStationCount();
+        return RouteTablePtr();
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    std::shared_ptr<RouteTable> table(new RouteTable());
+    table->setGraph(graph);
+    const int cells = table->stationCount * table->stationCount;
+    for (int s = 0; s < STRATEGY_COUNT; s++) {
+        table->distances[s].fill(-1.0f, cells);
+        table->transfers[s].fill(NO_TRANSFERS, cells);
+        if (s != MIN_TRANSFER) {
+            table->nextStation[s].fill(NO_HOP, cells);
+        }
+    }
+    table->firstGroup.fill(NO_HOP, cells);
+    table->nextGroup.fill(NO_HOP, table->stationCount * table->groupCount);
+
+    if (threadCount <= 0) {
+        threadCount = QThread::idealThreadCount();
+    }
+    threadCount = qBound(1, threadCount, qMax(1, table->stationCount));
+
+    /* 各线程只写自己负责的列，数组已在此分配完毕，线程中不会发生分离*/
+    QThreadPool pool;
+    pool.setMaxThreadCount(threadCount);
+    RouteTable* target = table.get();
+    for (int k = 0; k < threadCount; k++) {
+        pool.start([target, &graph, k, threadCount]() { target->buildDestinations(graph, k, threadCount); });
+    }
+    pool.waitForDone();
+
+    qDebug() << "全源路径表构建完成:" << table->stationCount << "个站点," << threadCount << "个线程,"
+             << timer.elapsed() << "毫秒";
+    return table;
+}
+
+/***************************************************************************
+  函数名称：RouteTable::buildDestinations
+  功    能：计算一组终点对应的各列
+  输入参数：const MetroGraph& graph - 地铁图
+            int first               - 第一个终点编号
+            int step                - 终点编号间隔
+  返 回 值：
+  说    明：对每个终点依次以三种策略生成搜索树，最少换乘时站点少者优先，
+            每个线程使用自己的搜索树；表按未封闭的图计算，不受临时封闭影响
+***************************************************************************/
+void RouteTable::buildDestinations(const MetroGraph& graph, int first, int step) {
+    SearchTree tree(graph);
+    for (int to = first; to < stationCount; to += step) {
+        const int column = to * stationCount;
+
+        /* 最少站点和最短距离：树中朝向根的下一站即下一跳*/
+        for (SearchStrategy strategy : { MIN_STATIONS, MIN_DISTANCE }) {
+            tree.grow(StationId(to), strategy);
+            float*   distanceColumn = distances[strategy].data() + column;
+            quint8*  transferColumn = transfers[strategy].data() + column;
+            quint16* nextColumn     = nextStation[strategy].data() + column;
+            for (int from = 0; from < stationCount; from++) {
+                if (tree.isReached(StationId(from))) {
+                    const StationId next = tree.getNext(StationId(from));
+                    distanceColumn[from] = float(tree.getDistance(StationId(from)));
+                    transferColumn[from] = quint8(qMin(tree.getTransfers(StationId(from)), int(NO_TRANSFERS) - 1));
+                    nextColumn[from]     = next == INVALID_ID ? NO_HOP : quint16(next);
+                }
+            }
+        }
+
+        /* 最少换乘：记录各站出发所用的分组和各分组朝向终点的下一个分组*/
+        tree.grow(StationId(to), MIN_TRANSFER);
+        const int groupColumn    = to * groupCount;
+        float*    distanceColumn = distances[MIN_TRANSFER].data() + column;
+        quint8*   transferColumn = transfers[MIN_TRANSFER].data() + column;
+        for (int from = 0; from < stationCount; from++) {
+            if (tree.isReached(StationId(from))) {
+                firstGroup[column + from] = quint16(tree.getFirstGroup(StationId(from)));
+                distanceColumn[from]      = float(tree.getDistance(StationId(from)));
+                transferColumn[from]      = quint8(qMin(tree.getTransfers(StationId(from)), int(NO_TRANSFERS) - 1));
+            }
+        }
+        for (int group = 0; group < groupCount; group++) {
+            const int next = tree.getNextGroup(group);
+            if (next >= 0) {
+                nextGroup[groupColumn + group] = quint16(next);
+            }
+        }
+    }
+}
+
+/***************************************************************************
+  函数名称：RouteTable::matches
+  功    能：判断路径表是否对应该地铁图版本
+  输入参数：const MetroGraph& graph - 地铁图
+  返 回 值：bool - 是否对应
+  说    明：图被修改后版本号改变，旧表不再使用
+***************************************************************************/
+bool RouteTable::matches(const MetroGraph& graph) const {
+    return graph.getVersion() == graphVersion && graph.getStationCount() == stationCount;
+}
+
+/***************************************************************************
+  函数名称：RouteTable::getPath
+  功    能：沿下一跳矩阵得到两站之间的路径
+  输入参数：SearchStrategy strategy - 搜索策略
+            StationId from          - 起点编号
+            StationId to            - 终点编号
+  返 回 值：QVector<StationId> - 站点编号列表，不可达或起终点相同时为空，
+            与在线搜索一致
+  说    明：耗时与路径长度成正比；最少换乘沿分组走，同站换乘的两个分组
+            只记一次站点
+***************************************************************************/
+QVector<StationId> RouteTable::getPath(SearchStrategy strategy, StationId from, StationId to) const {
+    QVector<StationId> path;
+    if (from >= StationId(stationCount) || to >= StationId(stationCount) || from == to) {
+        return path;
+    }
+    path.append(from);
+    const int column = int(to) * stationCount;
+
+    if (strategy == MIN_TRANSFER) {
+        const int groupColumn = int(to) * groupCount;
+        quint16   group       = firstGroup[column + from];
+        for (int steps = 0; group != NO_HOP && groupStations[group] != to; steps++) {
+            group = steps < groupCount ? nextGroup[groupColumn + group] : NO_HOP;
+            if (group != NO_HOP && groupStations[group] != path.last()) {
+                path.append(groupStations[group]);
+            }
+        }
+        return group == NO_HOP ? QVector<StationId>() : path;
+    }
+
+    const QVector<quint16>& next = nextStation[strategy];
+    for (StationId current = from; current != to; ) {
+        const quint16 hop = next[column + current];
+        if (hop == NO_HOP || path.size() > stationCount) {
+            return QVector<StationId>();
+        }
+        current = hop;
+        path.append(current);
+    }
+    return path;
+}
+
+/***************************************************************************
+  函数名称：RouteTable::getDistance
+  功    能：获取某策略下两站之间路径的里程
+  输入参数：SearchStrategy strategy - 搜索策略
+            StationId from          - 起点编号
+            StationId to            - 终点编号
+  返 回 值：double - 里程（公里），不可达时为-1
+  说    明：以单精度保存
+***************************************************************************/
+double RouteTable::getDistance(SearchStrategy strategy, StationId from, StationId to) const {
+    if (from >= StationId(stationCount) || to >= StationId(stationCount)) {
+        return -1;
+    }
+    return distances[strategy][int(to) * stationCount + from];
+}
+
+/***************************************************************************
+  函数名称：RouteTable::getTransfers
+  功    能：获取某策略下两站之间路径的换乘次数
+  输入参数：SearchStrategy strategy - 搜索策略
+            StationId from          - 起点编号
+            StationId to            - 终点编号
+  返 回 值：int - 换乘次数，不可达时为-1
+  说    明：
+***************************************************************************/
+int RouteTable::getTransfers(SearchStrategy strategy, StationId from, StationId to) const {
+    if (from >= StationId(stationCount) || to >= StationId(stationCount)) {
+        return -1;
+    }
+    const quint8 value = transfers[strategy][int(to) * stationCount + from];
+    return value == NO_TRANSFERS ? -1 : int(value);
+}
+
+/***************************************************************************
+  函数名称：RouteTable::save
+  功    能：将路径表写入二进制文件
+  输入参数：const QString& filename - 文件名
+  返 回 值：bool - 是否写入成功
+  说    明：分组所属站点可由地铁图恢复，不写入文件；通过QSaveFile原子替换
+***************************************************************************/
+bool RouteTable::save(const QString& filename) const {
+    RouteTableHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic        = MAGIC;
+    header.version      = VERSION;
+    header.byteOrder    = BYTE_ORDER_MARK;
+    header.hashLength   = quint32(qMin(int(hash.size()), MAX_HASH_LENGTH));
+    std::memcpy(header.hash, hash.constData(), header.hashLength);
+    header.stationCount = quint32(stationCount);
+    header.groupCount   = quint32(groupCount);
+
+    /* 按元素大小从大到小排列各段*/
+    QByteArray buffer(reinterpret_cast<const char*>(&header), int(sizeof(header)));
+    auto append = [&buffer](const void* data, qint64 bytes) {
+        buffer.append(reinterpret_cast<const char*>(data), int(bytes));
+    };
+    for (int s = 0; s < STRATEGY_COUNT; s++) {
+        append(distances[s].constData(), qint64(distances[s].size()) * sizeof(float));
+    }
+    append(nextStation[MIN_STATIONS].constData(), qint64(nextStation[MIN_STATIONS].size()) * sizeof(quint16));
+    append(nextStation[MIN_DISTANCE].constData(), qint64(nextStation[MIN_DISTANCE].size()) * sizeof(quint16));
+    append(firstGroup.constData(), qint64(firstGroup.size()) * sizeof(quint16));
+    append(nextGroup.constData(),  qint64(nextGroup.size())  * sizeof(quint16));
+    for (int s = 0; s < STRATEGY_COUNT; s++) {
+        append(transfers[s].constData(), transfers[s].size());
+    }
+    const quint64 fileSize = quint64(buffer.size());
+    std::memcpy(buffer.data() + offsetof(RouteTableHeader, fileSize), &fileSize, sizeof(fileSize));
+
+    QSaveFile file(filename);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "无法写入全源路径表文件:" << filename;
+        return false;
+    }
+    if (file.write(buffer) != buffer.size() || !file.commit()) {
+        qWarning() << "全源路径表文件写入失败:" << filename;
+        return false;
+    }
+
+    qDebug() << "已写入全源路径表" << filename << ":" << buffer.size() << "字节";
+    return true;
+}
+
+/***************************************************************************
+  函数名称：RouteTable::load
+  功    能：读取与地铁图匹配的路径表文件
+  输入参数：const MetroGraph& graph - 地铁图
+            const QString& filename - 文件名
+  返 回 值：RouteTablePtr - 读取的路径表，文件缺失或不匹配时为空
+  说    明：标识、版本、字节序、CSR出边哈希、长度或编号范围任一不符都视为
+            失效，由调用方重新构建
+***************************************************************************/
+RouteTablePtr RouteTable::load(const MetroGraph& graph, const QString& filename) {
+    QFile file(filename);
+    if (!file.exists() || !file.open(QIODevice::ReadOnly)) {
+        return RouteTablePtr();
+    }
+
+    const qint64 fileSize = file.size();
+    if (fileSize < qint64(sizeof(RouteTableHeader))) {
+        return RouteTablePtr();
+    }
+
+    const uchar* base = file.map(0, fileSize);
+    if (base == nullptr) {
+        qWarning() << "全源路径表文件映射失败:" << filename;
+        return RouteTablePtr();
+    }
+
+    std::shared_ptr<RouteTable> table(new RouteTable());
+    table->setGraph(graph);
+    const qint64 cells      = qint64(table->stationCount) * table->stationCount;
+    const qint64 groupCells = qint64(table->stationCount) * table->groupCount;
+    const qint64 expected   = qint64(sizeof(RouteTableHeader)) + STRATEGY_COUNT * cells * qint64(sizeof(float))
+                            + (3 * cells + groupCells) * qint64(sizeof(quint16)) + STRATEGY_COUNT * cells;
+
+    /* 校验文件头*/
+    RouteTableHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    const int hashLength = qMin(int(table->hash.size()), MAX_HASH_LENGTH);
+    if (header.magic != MAGIC || header.version != VERSION || header.byteOrder != BYTE_ORDER_MARK
+        || header.fileSize != quint64(fileSize) || fileSize != expected
+        || header.hashLength != quint32(hashLength)
+        || std::memcmp(header.hash, table->hash.constData(), size_t(hashLength)) != 0
+        || header.stationCount != quint32(table->stationCount) || header.groupCount != quint32(table->groupCount)) {
+        qDebug() << "全源路径表与地铁图不匹配，忽略:" << filename;
+        file.unmap(const_cast<uchar*>(base));
+        return RouteTablePtr();
+    }
+
+    const uchar* cursor = base + sizeof(header);
+    auto read = [&cursor](auto& target, qint64 count) {
+        target.resize(int(count));
+        const size_t bytes = size_t(count) * sizeof(target[0]);
+        if (bytes > 0) {
+            std::memcpy(target.data(), cursor, bytes);
+        }
+        cursor += bytes;
+    };
+    for (int s = 0; s < STRATEGY_COUNT; s++) {
+        read(table->distances[s], cells);
+    }
+    read(table->nextStation[MIN_STATIONS], cells);
+    read(table->nextStation[MIN_DISTANCE], cells);
+    read(table->firstGroup, cells);
+    read(table->nextGroup, groupCells);
+    for (int s = 0; s < STRATEGY_COUNT; s++) {
+        read(table->transfers[s], cells);
+    }
+    file.unmap(const_cast<uchar*>(base));
+
+    /* 编号范围*/
+    bool valid = true;
+    for (int s : { int(MIN_STATIONS), int(MIN_DISTANCE) }) {
+        for (quint16 hop : table->nextStation[s]) {
+            valid = valid && (hop == NO_HOP || hop < table->stationCount);
+        }
+    }
+    for (quint16 group : table->firstGroup) {
+        valid = valid && (group == NO_HOP || group < table->groupCount);
+    }
+    for (quint16 group : table->nextGroup) {
+        valid = valid && (group == NO_HOP || group < table->groupCount);
+    }
+    if (!valid) {
+        qWarning() << "全源路径表文件内容损坏:" << filename;
+        return RouteTablePtr();
+    }
+
+    qDebug() << "从文件加载全源路径表:" << table->stationCount << "个站点";
+    return table;
+}
+
+/*RouteTable.cpp*/
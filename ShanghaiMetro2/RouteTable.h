@@ -0,0 +1,53 @@
+﻿/***************************************************************************
+  文件名称：RouteTable.h
+  功    能：全源路径表的头文件
+  说    明：对每种搜索策略预先计算任意两站之间的结果，保存距离、换乘次数和
+            紧凑的下一跳矩阵，查询时沿下一跳走完路径即可，无需搜索；
+            表的大小与站点数的平方成正比，适用于随程序发布的规模的网络
+***************************************************************************/
+
+#ifndef ROUTETABLE_H
+#define ROUTETABLE_H
+
+#include "MetroGraph.h"
+#include "PathFinder.h"
+#include <QString>
+#include <QVector>
+
+/*全源路径表*/
+class RouteTable {
+public:
+    static const quint32 MAGIC        = 0x3154524Du; //文件标识"MRT1"
+    static const quint32 VERSION      = 1;           //格式版本，布局变化时递增
+    static const quint16 NO_HOP       = 0xFFFFu;     //下一跳矩阵中表示不可达
+    static const int     MAX_STATIONS = 0xFFFF;      //下一跳用16位编号，站点和分组数都须小于该值
+    static const int     STRATEGY_COUNT = 3;         //SearchStrategy的取值个数
+
+    static RouteTablePtr build(const MetroGraph& graph, int threadCount = 0);           //构建路径表，threadCount为0时按处理器核数
+    static RouteTablePtr load(const MetroGraph& graph, const QString& filename);        //读取与该地铁图匹配的路径表文件
+    bool                 save(const QString& filename)                          const;  //将路径表写入文件
+
+    bool               matches(const MetroGraph& graph)                                     const;//路径表是否对应该地铁图版本
+    QVector<StationId> getPath(SearchStrategy strategy, StationId from, StationId to)       const;//沿下一跳得到的站点编号列表，不可达时为空
+    double             getDistance(SearchStrategy strategy, StationId from, StationId to)   const;//该策略路径的里程（公里），不可达时为-1
+    int                getTransfers(SearchStrategy strategy, StationId from, StationId to)  const;//该策略路径的换乘次数，不可达时为-1
+
+private:
+    int                 stationCount;   //站点数
+    int                 groupCount;     //CSR中(站点, 线路)分组数
+    QByteArray          hash;           //构建时CSR出边的哈希
+    quint64             graphVersion;   //对应的地铁图版本号
+    QVector<float>      distances[STRATEGY_COUNT]; //按[to * stationCount + from]存放的里程，不可达为-1
+    QVector<quint8>     transfers[STRATEGY_COUNT]; //按[to * stationCount + from]存放的换乘次数，不可达为255
+    QVector<quint16>    nextStation[STRATEGY_COUNT]; //最少站点和最短距离：按[to * stationCount + from]存放的下一站
+    QVector<quint16>    firstGroup;     //最少换乘：按[to * stationCount + from]存放的起点所用分组
+    QVector<quint16>    nextGroup;      //最少换乘：按[to * groupCount + group]存放的下一个分组
+    QVector<quint16>    groupStations;  //分组所属的站点
+
+    RouteTable();                                     //只能通过build或load创建
+    void setGraph(const MetroGraph& graph);           //记录图的规模、哈希和分组所属站点
+    void buildDestinations(const MetroGraph& graph,
+                           int first, int step);      //计算终点编号为first, first+step, ...的各列
+};
+
+#endif // ROUTETABLE_H
@@ -0,0 +1,381 @@
+﻿/***************************************************************************
+  文件名称：SearchTree.cpp
+  功    能：单源完整搜索树的实现文件
+  说    明：三种策略的搜索均不提前停止；搜索结束后沿树计算里程和换乘次数，
+            换乘次数与PathFinder::buildPath的分段方式一致。全源路径表和
+            多起终点矩阵都以此为基础；除全源路径表外，搜索跳过临时封闭的出边
+***************************************************************************/
+
+#include "SearchTree.h"
+#include <algorithm>
+
+namespace {
+
+/*站点堆的比较函数：距离小者优先，距离相同时编号小者优先*/
+struct CompareDistance {
+    bool operator()(const std::pair<double, StationId>& a, const std::pair<double, StationId>& b) const {
+        if (a.first != b.first)
+            return a.first > b.first;
+        return a.second > b.second;
+    }
+};
+
+} // namespace
+
+/***************************************************************************
+  函数名称：SearchTree::SearchTree
+  功    能：构造函数
+  输入参数：const MetroGraph& graph - 地铁图
+  返 回 值：
+  说    明：按站点数和分组数一次分配全部临时数组，并记录各分组所属的站点
+***************************************************************************/
+SearchTree::SearchTree(const MetroGraph& graph)
+    : graph(graph), root(INVALID_ID), epoch(0) {
+    const MetroCsr& csr          = graph.getCsr();
+    const int       stationCount = graph.getStationCount();
+    const int       groupCount   = csr.groupLines.size();
+
+    dist.resize(stationCount);
+    transfers.resize(stationCount);
+    hops.resize(stationCount);
+    parent.resize(stationCount);
+    firstGroup.resize(stationCount);
+    reached.assign(stationCount, 0);
+    settled.assign(stationCount, 0);
+    order.reserve(stationCount);
+    hopCost.resize(groupCount);
+    hopStamp.assign(groupCount, 0);
+    groupCost.resize(groupCount);
+    groupPrev.resize(groupCount);
+    groupReached.assign(groupCount, 0);
+    groupSettled.assign(groupCount, 0);
+    groupStation.resize(groupCount);
+    for (int station = 0; station < stationCount; station++) {
+        for (int g = csr.groupOffsets[station]; g < csr.groupOffsets[station + 1]; g++) {
+            groupStation[g] = StationId(station);
+        }
+    }
+}
+
+/***************************************************************************
+  函数名称：SearchTree::grow
+  功    能：以指定站点为根重新搜索全图
+  输入参数：StationId root           - 根
+            SearchStrategy strategy  - 搜索策略
+            TransferTieBreak tieBreak - 最少换乘策略在换乘次数相同时的比较依据
+            const ClosureMaskPtr& closures - 要绕开的临时封闭，为空时按未封闭的图搜索
+  返 回 值：
+  说    明：编号递增即可作废上次的结果，回绕时清零各标记数组；封闭由调用方
+            在查询开始时取得，整棵树按同一封闭情况搜索
+***************************************************************************/
+void SearchTree::grow(StationId root, SearchStrategy strategy, TransferTieBreak tieBreak, const ClosureMaskPtr& closures) {
+    if (++epoch == 0) {
+        std::fill(reached.begin(), reached.end(), 0);
+        std::fill(settled.begin(), settled.end(), 0);
+        std::fill(hopStamp.begin(), hopStamp.end(), 0);
+        std::fill(groupReached.begin(), groupReached.end(), 0);
+        std::fill(groupSettled.begin(), groupSettled.end(), 0);
+        epoch = 1;
+    }
+    this->root = root;
+    order.clear();
+    this->closures = closures != nullptr && !closures->isEmpty() ? closures : ClosureMaskPtr();
+    if (root >= StationId(dist.size())) {
+        return;
+    }
+
+    switch (strategy) {
+    case MIN_STATIONS:
+        growStations();
+        fillAlongTree();
+        break;
+    case MIN_DISTANCE:
+        growDistance();
+        fillAlongTree();
+        break;
+    case MIN_TRANSFER:
+        growTransfers(tieBreak);
+        break;
+    }
+}
+
+/***************************************************************************
+  函数名称：SearchTree::growStations
+  功    能：广度优先搜索全图，得到最少站点树
+  输入参数：
+  返 回 值：
+  说    明：站点入队即确定
+***************************************************************************/
+void SearchTree::growStations() {
+    const MetroCsr& csr = graph.getCsr();
+
+    order.push_back(root);
+    settled[root] = epoch;
+    for (size_t head = 0; head < order.size(); head++) {
+        const StationId current = order[head];
+        for (int e = csr.offsets[current]; e < csr.offsets[current + 1]; e++) {
+            if (closures != nullptr && closures->isEdgeClosed(e)) {
+                continue; // 封闭的区间
+            }
+            const StationId neighbor = csr.targets[e];
+            if (settled[neighbor] != epoch) {
+                settled[neighbor] = epoch;
+                parent[neighbor]  = current;
+                order.push_back(neighbor);
+            }
+        }
+    }
+}
+
+/***************************************************************************
+  函数名称：SearchTree::growDistance
+  功    能：Dijkstra搜索全图，得到最短距离树
+  输入参数：
+  返 回 值：
+  说    明：二叉堆惰性删除，距离相同时编号小者先出堆
+***************************************************************************/
+void SearchTree::growDistance() {
+    const MetroCsr& csr = graph.getCsr();
+    CompareDistance compare;
+
+    heap.clear();
+    dist[root]    = 0;
+    reached[root] = epoch;
+    heap.push_back(std::make_pair(0.0, root));
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), compare);
+        const StationId current = heap.back().second;
+        heap.pop_back();
+        if (settled[current] == epoch) {
+            continue;
+        }
+        settled[current] = epoch;
+        order.push_back(current);
+        for (int e = csr.offsets[current]; e < csr.offsets[current + 1]; e++) {
+            if (closures != nullptr && closures->isEdgeClosed(e)) {
+                continue; // 封闭的区间
+            }
+            const StationId neighbor = csr.targets[e];
+            const double    alt      = dist[current] + csr.weights[e];
+            if (settled[neighbor] != epoch && (reached[neighbor] != epoch || alt < dist[neighbor])) {
+                reached[neighbor] = epoch;
+                dist[neighbor]    = alt;
+                parent[neighbor]  = current;
+                heap.push_back(std::make_pair(alt, neighbor));
+                std::push_heap(heap.begin(), heap.end(), compare);
+            }
+        }
+    }
+}
+
+/***************************************************************************
+  函数名称：SearchTree::growTransfers
+  功    能：在(站点, 线路)分组上做字典序Dijkstra，得到最少换乘树
+  输入参数：TransferTieBreak tieBreak - 换乘次数相同时的比较依据
+  返 回 值：
+  说    明：沿线路行进一站不增加换乘，同站换到另一分组换乘次数加一；
+            分组按代价从小到大确定，每个站点第一个确定的分组即为该站出发
+            所用的分组，其代价就是该站的结果
+***************************************************************************/
+void SearchTree::growTransfers(TransferTieBreak tieBreak) {
+    const MetroCsr& csr = graph.getCsr();
+
+    /* 代价逐项比较，小者优先，代价相同时分组编号小者优先*/
+    auto greater = [tieBreak](const std::pair<GroupCost, int>& a, const std::pair<GroupCost, int>& b) {
+        if (a.first.transfers != b.first.transfers)
+            return a.first.transfers > b.first.transfers;
+        if (tieBreak == FEWER_STATIONS && a.first.hops != b.first.hops)
+            return a.first.hops > b.first.hops;
+        if (a.first.distance != b.first.distance)
+            return a.first.distance > b.first.distance;
+        if (a.first.hops != b.first.hops)
+            return a.first.hops > b.first.hops;
+        return a.second > b.second;
+    };
+    auto relax = [&](int group, int previous, const GroupCost& cost) {
+        if (groupSettled[group] == epoch) {
+            return;
+        }
+        if (groupReached[group] == epoch && !greater(std::make_pair(groupCost[group], group), std::make_pair(cost, group))) {
+            return;
+        }
+        groupReached[group] = epoch;
+        groupCost[group]    = cost;
+        groupPrev[group]    = previous;
+        groupHeap.push_back(std::make_pair(cost, group));
+        std::push_heap(groupHeap.begin(), groupHeap.end(), greater);
+    };
+
+    groupHeap.clear();
+    for (int g = csr.groupOffsets[root]; g < csr.groupOffsets[root + 1]; g++) {
+        relax(g, -1, GroupCost{ 0, 0, 0.0 });
+    }
+    while (!groupHeap.empty()) {
+        std::pop_heap(groupHeap.begin(), groupHeap.end(), greater);
+        const int current = groupHeap.back().second;
+        groupHeap.pop_back();
+        if (groupSettled[current] == epoch) {
+            continue;
+        }
+        groupSettled[current] = epoch;
+
+        const GroupCost cost    = groupCost[current];
+        const StationId station = groupStation[current];
+        if (settled[station] != epoch) {
+            settled[station]    = epoch;
+            firstGroup[station] = current;
+            dist[station]       = cost.distance;
+            transfers[station]  = cost.transfers;
+            hops[station]       = cost.hops;
+            order.push_back(station);
+        }
+
+        const LineId line = csr.groupLines[current];
+        for (int k = csr.groupEdgeOffsets[current]; k < csr.groupEdgeOffsets[current + 1]; k++) {
+            const int       e        = csr.groupEdges[k];
+            if (closures != nullptr && closures->isEdgeClosed(e)) {
+                continue; // 封闭的区间
+            }
+            const StationId neighbor = csr.targets[e];
+            relax(graph.findLineGroup(neighbor, line), current,
+                  GroupCost{ cost.transfers, cost.hops + 1, cost.distance + csr.weights[e] });
+        }
+        for (int g = csr.groupOffsets[station]; g < csr.groupOffsets[station + 1]; g++) {
+            if (g != current) {
+                relax(g, current, GroupCost{ cost.transfers + 1, cost.hops, cost.distance });
+            }
+        }
+    }
+}
+
+/***************************************************************************
+  函数名称：SearchTree::fillAlongTree
+  功    能：沿最少站点树或最短距离树计算各站的里程、换乘次数和区间数
+  输入参数：
+  返 回 值：
+  说    明：站点按确定顺序处理，其下一站已处理完毕。以线路L离开本站时，
+            若下一站也能以L离开则沿用，否则在下一站换乘，取两者较小者
+***************************************************************************/
+void SearchTree::fillAlongTree() {
+    const MetroCsr& csr = graph.getCsr();
+
+    dist[root]      = 0;
+    transfers[root] = 0;
+    hops[root]      = 0;
+    parent[root]    = INVALID_ID;
+    for (size_t i = 1; i < order.size(); i++) {
+        const StationId station = order[i];
+        const StationId hop     = parent[station];
+        double weight = 0;
+        int    best   = -1;
+        for (int g = csr.groupOffsets[station]; g < csr.groupOffsets[station + 1]; g++) {
+            for (int k = csr.groupEdgeOffsets[g]; k < csr.groupEdgeOffsets[g + 1]; k++) {
+                const int e = csr.groupEdges[k];
+                if (closures != nullptr && closures->isEdgeClosed(e)) {
+                    continue; // 封闭的区间
+                }
+                if (csr.targets[e] != hop) {
+                    continue;
+                }
+                weight = csr.weights[e];
+                int cost = 0;
+                if (hop != root) {
+                    const int continued = graph.findLineGroup(hop, csr.groupLines[g]);
+                    cost = transfers[hop] + 1;
+                    if (continued >= 0 && hopStamp[continued] == epoch) {
+                        cost = std::min(cost, hopCost[continued]);
+                    }
+                }
+                hopCost[g]  = cost;
+                hopStamp[g] = epoch;
+                best = best < 0 ? cost : std::min(best, cost);
+                break;
+            }
+        }
+        dist[station]      = dist[hop] + weight;
+        transfers[station] = best;
+        hops[station]      = hops[hop] + 1;
+    }
+}
+
+/***************************************************************************
+  函数名称：SearchTree::isReached
+  功    能：判断站点是否可由根到达
+  输入参数：StationId station - 站点编号
+  返 回 值：bool - 是否可达
+  说    明：
+***************************************************************************/
+bool SearchTree::isReached(StationId station) const {
+    return station < StationId(settled.size()) && settled[station] == epoch;
+}
+
+/***************************************************************************
+  函数名称：SearchTree::getDistance
+  功    能：获取树上路径的里程
+  输入参数：StationId station - 站点编号
+  返 回 值：double - 里程（公里），不可达时为-1
+  说    明：
+***************************************************************************/
+double SearchTree::getDistance(StationId station) const {
+    return isReached(station) ? dist[station] : -1;
+}
+
+/***************************************************************************
+  函数名称：SearchTree::getTransfers
+  功    能：获取树上路径的换乘次数
+  输入参数：StationId station - 站点编号
+  返 回 值：int - 换乘次数，不可达时为-1
+  说    明：
+***************************************************************************/
+int SearchTree::getTransfers(StationId station) const {
+    return isReached(station) ? transfers[station] : -1;
+}
+
+/***************************************************************************
+  函数名称：SearchTree::getStationCount
+  功    能：获取树上路径经过的站点数
+  输入参数：StationId station - 站点编号
+  返 回 值：int - 站点数（含两端），不可达时为0
+  说    明：与MetroPath::stationCount的含义一致
+***************************************************************************/
+int SearchTree::getStationCount(StationId station) const {
+    return isReached(station) ? hops[station] + 1 : 0;
+}
+
+/***************************************************************************
+  函数名称：SearchTree::getNext
+  功    能：获取朝向根的下一站
+  输入参数：StationId station - 站点编号
+  返 回 值：StationId - 下一站，根和不可达时为INVALID_ID
+  说    明：只对最少站点和最短距离树有效
+***************************************************************************/
+StationId SearchTree::getNext(StationId station) const {
+    return isReached(station) && station != root ? parent[station] : INVALID_ID;
+}
+
+/***************************************************************************
+  函数名称：SearchTree::getFirstGroup
+  功    能：获取该站出发所用的(站点, 线路)分组
+  输入参数：StationId station - 站点编号
+  返 回 值：int - 分组编号，不可达时为-1
+  说    明：只对最少换乘树有效
+***************************************************************************/
+int SearchTree::getFirstGroup(StationId station) const {
+    return isReached(station) ? firstGroup[station] : -1;
+}
+
+/***************************************************************************
+  函数名称：SearchTree::getNextGroup
+  功    能：获取朝向根的下一个分组
+  输入参数：int group - 分组编号
+  返 回 值：int - 下一个分组，根所在的分组和未到达的分组为-1
+  说    明：只对最少换乘树有效
+***************************************************************************/
+int SearchTree::getNextGroup(int group) const {
+    if (group < 0 || group >= int(groupSettled.size()) || groupSettled[group] != epoch) {
+        return -1;
+    }
+    return groupPrev[group];
+}
+
+/*SearchTree.cpp*/
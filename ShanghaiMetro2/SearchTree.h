@@ -0,0 +1,69 @@
+﻿/***************************************************************************
+  文件名称：SearchTree.h
+  功    能：单源完整搜索树的头文件
+  说    明：从一个站点出发按某种搜索策略搜遍全图，得到以该站为根的搜索树
+            以及各站沿树上路径到根的里程、换乘次数和站点数；地铁图是无向的，
+            树上路径反过来即为从各站到根的路径。同一对象可依次以不同站点为
+            根重复使用，临时数组只分配一次；不同线程应各用一个对象
+***************************************************************************/
+
+#ifndef SEARCHTREE_H
+#define SEARCHTREE_H
+
+#include "MetroGraph.h"
+#include "PathFinder.h"
+#include <vector>
+
+/*单源完整搜索树*/
+class SearchTree {
+public:
+    explicit SearchTree(const MetroGraph& graph);                                     //构造函数，按图的规模分配临时数组
+    void      grow(StationId root, SearchStrategy strategy,
+                   TransferTieBreak tieBreak = FEWER_STATIONS,
+                   const ClosureMaskPtr& closures = ClosureMaskPtr());                //以root为根重新搜索全图
+
+    bool      isReached(StationId station)       const;//该站是否可由根到达
+    double    getDistance(StationId station)     const;//树上路径的里程（公里），不可达时为-1
+    int       getTransfers(StationId station)    const;//树上路径的最少换乘次数，不可达时为-1
+    int       getStationCount(StationId station) const;//树上路径经过的站点数（含两端），不可达时为0
+    StationId getNext(StationId station)         const;//最少站点和最短距离：朝向根的下一站，根和不可达时为INVALID_ID
+    int       getFirstGroup(StationId station)   const;//最少换乘：该站出发所用的(站点, 线路)分组，不可达时为-1
+    int       getNextGroup(int group)            const;//最少换乘：朝向根的下一个分组，根所在的分组为-1
+
+private:
+    /*最少换乘搜索中到达一个分组的代价，比较顺序由TransferTieBreak决定*/
+    struct GroupCost {
+        int    transfers; //换乘次数
+        int    hops;      //经过的区间数
+        double distance;  //里程
+    };
+
+    const MetroGraph&      graph;        //地铁图，须比本对象存活更久
+    ClosureMaskPtr         closures;     //本次搜索生效的封闭，没有时为空
+    StationId              root;         //当前的根
+    quint32                epoch;        //当前搜索的编号，各标记数组等于它时有效
+    std::vector<double>    dist;         //按站点：树上路径的里程
+    std::vector<int>       transfers;    //按站点：树上路径的最少换乘次数
+    std::vector<int>       hops;         //按站点：树上路径的区间数
+    std::vector<StationId> parent;       //按站点：朝向根的下一站
+    std::vector<int>       firstGroup;   //按站点：最少换乘时出发所用的分组
+    std::vector<quint32>   reached;      //按站点：等于epoch时已到达
+    std::vector<quint32>   settled;      //按站点：等于epoch时已确定
+    std::vector<StationId> order;        //按站点确定的顺序，下一站总在前面
+    std::vector<int>       hopCost;      //按分组：以该线路离开本站时的最少换乘次数
+    std::vector<quint32>   hopStamp;     //按分组：等于epoch时hopCost有效
+    std::vector<GroupCost> groupCost;    //按分组：最少换乘搜索中的代价
+    std::vector<int>       groupPrev;    //按分组：朝向根的下一个分组
+    std::vector<quint32>   groupReached; //按分组：等于epoch时已到达
+    std::vector<quint32>   groupSettled; //按分组：等于epoch时已确定
+    std::vector<StationId> groupStation; //按分组：所属的站点
+    std::vector<std::pair<double, StationId>> heap;      //站点堆
+    std::vector<std::pair<GroupCost, int>>    groupHeap; //分组堆
+
+    void growStations();                       //广度优先搜索，得到最少站点树
+    void growDistance();                       //Dijkstra，得到最短距离树
+    void growTransfers(TransferTieBreak tieBreak); //分组上的字典序Dijkstra，得到最少换乘树
+    void fillAlongTree();                      //沿树计算各站的里程、换乘次数和区间数
+};
+
+#endif // SEARCHTREE_H
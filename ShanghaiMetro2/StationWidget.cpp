@@ -19,7 +19,8 @@
 ***************************************************************************/
 StationWidget::StationWidget(QWidget* parent)
     : QWidget(parent), 
-    metroGraph(nullptr), scale(1.0)          , offset(0, 0),
+    isochroneBudget(0),
+    scale(1.0)          , offset(0, 0),
     isDragging(false)  , selectionMode(false), showRightClickFeedback(false) 
 {
     setMouseTracking(true);
@@ -53,19 +54,96 @@ void StationWidget::setSelectionMode(bool enabled) {
 /***************************************************************************
   函数名称：StationWidget::setMetroGraph
   功    能：设置地铁线路
-  输入参数：const MetroGraph graph - 地铁线路图
+  输入参数：MetroGraphPtr graphPtr - 地铁线路图版本
   返 回 值：
-  说    明：
+  说    明：控件持有该版本直到下次设置，缓存的连接指针在此期间始终有效
 ***************************************************************************/
-void StationWidget::setMetroGraph(const MetroGraph& graph) {
-    metroGraph = &graph;
-    stationPositions.clear();
+void StationWidget::setMetroGraph(MetroGraphPtr graphPtr) {
+    if (!graphPtr) {
+        return;
+    }
 
-    for (const Station& station : graph.getStations()) {
-        stationPositions[station.name] = station.graphPosition;
+    /* 可达范围按旧版本计算，图变化后不再准确*/
+    isochrone = Isochrone();
+
+    /* 紧接当前版本的新版本只按变更更新缓存*/
+    const bool incremental = metroGraph && !graphPtr->getChanges().isEmpty()
+                          && graphPtr->getVersion() == metroGraph->getVersion() + 1;
+    metroGraph = graphPtr;
+    if (incremental) {
+        applyGraphChanges(graphPtr->getChanges());
+        return;
     }
+    const MetroGraph& graph = *metroGraph;
 
-    update(); // 强制重绘
+    /* 按编号缓存线路颜色*/
+    const int lineCount = graph.getLineCount();
+    const QVector<MetroLine>& lines = graph.getLines();
+    lineColors.resize(lineCount);
+    for (LineId line = 0; line < static_cast<LineId>(lineCount); line++) {
+        lineColors[line] = lines[line].color;
+    }
+
+    /* 按编号缓存站点位置、颜色和换乘标记，绘制时无需再遍历全部连接*/
+    const int stationCount = graph.getStationCount();
+    stationPositions.resize(stationCount);
+    stationColors.resize(stationCount);
+    transferStations.resize(stationCount);
+    pathStations.fill(false, stationCount);
+
+    for (StationId id = 0; id < static_cast<StationId>(stationCount); id++) {
+        stationPositions[id] = graph.getStationById(id).graphPosition;
+        updateStationCache(id);
+    }
+
+    setPath(currentPath); // 按新编号重建路径站点标记
+}
+
+/***************************************************************************
+  函数名称：StationWidget::applyGraphChanges
+  功    能：按变更列表更新缓存
+  输入参数：const QVector<MetroChange>& changes - 相对上一版本的变更
+  返 回 值：
+  说    明：只触及新增的站点、线路和连接两端的站点
+***************************************************************************/
+void StationWidget::applyGraphChanges(const QVector<MetroChange>& changes) {
+    const MetroGraph& graph = *metroGraph;
+
+    for (const MetroChange& change : changes) {
+        switch (change.type) {
+        case MetroChange::LineAdded:
+            lineColors.append(graph.getLines()[change.line].color);
+            break;
+        case MetroChange::StationAdded:
+            stationPositions.append(graph.getStationById(change.station1).graphPosition);
+            stationColors.append(QColor(Qt::black));
+            transferStations.append(false);
+            pathStations.append(false);
+            updateStationCache(change.station1);
+            break;
+        case MetroChange::ConnectionAdded:
+            updateStationCache(change.station1);
+            updateStationCache(change.station2);
+            break;
+        }
+    }
+
+    /* 路径连接指针指向旧版本，需按新版本重新查找*/
+    pathConnections = getPathConnections();
+    update();
+}
+
+/***************************************************************************
+  函数名称：StationWidget::updateStationCache
+  功    能：更新单个站点的颜色和换乘标记缓存
+  输入参数：StationId id - 站点编号
+  返 回 值：
+  说    明：站点颜色取第一条出边所在线路的颜色
+***************************************************************************/
+void StationWidget::updateStationCache(StationId id) {
+    const QVector<StationEdge>& edges = metroGraph->getStationEdges(id);
+    stationColors[id]    = edges.isEmpty() ? QColor(Qt::black) : lineColors[edges.first().line];
+    transferStations[id] = metroGraph->isTransferStation(id);
 }
 
 /***************************************************************************
@@ -77,6 +155,49 @@ void StationWidget::setMetroGraph(const MetroGraph& graph) {
 ***************************************************************************/
 void StationWidget::setPath(const MetroPath& path) {
     currentPath = path;
+
+    /* 标记路径上的站点，绘制时按编号直接查询*/
+    pathStations.fill(false);
+    if (metroGraph != nullptr) {
+        for (const PathSegment& segment : currentPath.segments) {
+            for (const QString& stationName : segment.stations) {
+                StationId id = metroGraph->getStationId(stationName);
+                if (id != INVALID_ID && id < static_cast<StationId>(pathStations.size())) {
+                    pathStations[id] = true;
+                }
+            }
+        }
+    }
+
+    /* 路径连接只在路径或线路图变化时查找一次，绘制时直接使用*/
+    pathConnections = getPathConnections();
+
+    update();
+}
+
+/***************************************************************************
+  函数名称：StationWidget::setIsochrone
+  功    能：设置可达范围叠加层
+  输入参数：const Isochrone& result - 从起点到各站的结果
+            double budget           - 预算，单位与结果的策略相同
+  返 回 值：
+  说    明：代价不超过预算的站点按代价由绿到红分级着色
+***************************************************************************/
+void StationWidget::setIsochrone(const Isochrone& result, double budget) {
+    isochrone       = result;
+    isochroneBudget = budget;
+    update();
+}
+
+/***************************************************************************
+  函数名称：StationWidget::clearIsochrone
+  功    能：清除可达范围叠加层
+  输入参数：
+  返 回 值：
+  说    明：
+***************************************************************************/
+void StationWidget::clearIsochrone() {
+    isochrone = Isochrone();
     update();
 }
 
@@ -112,25 +233,25 @@ void StationWidget::paintEvent(QPaintEvent* event) {
         drawConnection(painter, conn, false);
     }
 
+    /* 可达范围画在站点之下，路径之前*/
+    drawIsochrone(painter);
+
     /* 然后绘制路径（高亮显示）*/
     drawPath(painter);
 
     /* 最后绘制所有站点*/
-    for (const Station& station : metroGraph->getStations()) {
-        bool isInPath = false;
-        for (const PathSegment& segment : currentPath.segments) {
-            if (segment.stations.contains(station.name)) {
-                isInPath = true;
-                break;
-            }
-        }
-        drawStation(painter, station, isInPath);
+    for (StationId id = 0; id < static_cast<StationId>(stationPositions.size()); id++) {
+        drawStation(painter, id, pathStations[id]);
     }
 
+    /* 临时封闭画在最上层*/
+    drawClosures(painter);
+
     painter.restore();
 
     /* 绘制图例（在右下角）*/
     drawLegend(painter);
+    drawIsochroneLegend(painter);
 
     if (showRightClickFeedback) {
         painter.save();
@@ -201,35 +322,117 @@ void StationWidget::drawLegend(QPainter& painter) {
 }
 
 /***************************************************************************
-  函数名称：StationWidget::drawStation
-  功    能：绘制站点
-  输入参数：QPainter&      painter       - 绘图对象引用
-			const Station& station       - 站点信息
-			bool           isHighlighted - 是否高亮显示
+  函数名称：StationWidget::drawIsochrone
+  功    能：绘制可达范围
+  输入参数：QPainter& painter - 绘图对象引用
   返 回 值：
-  说    明：内置一个可以识别是否是换乘站的方法
+  说    明：在预算内的站点下方画半透明的色圈，超出预算或不可达的不画
 ***************************************************************************/
-void StationWidget::drawStation(QPainter& painter, const Station& station, bool isHighlighted) {
-    QPoint pos = getStationPosition(station);
+void StationWidget::drawIsochrone(QPainter& painter) {
+    if (isochrone.origin == INVALID_ID)
+        return;
 
-    /* 识别换乘站：检查站点是否连接了多条线路*/
-    bool isTransferStation = false;
-    QSet<QString> connectedLines; // 使用集合存储连接的线路
+    painter.setPen(Qt::NoPen);
+    const int count = qMin(isochrone.stationCounts.size(), stationPositions.size());
+    for (StationId id = 0; id < static_cast<StationId>(count); id++) {
+        const double cost = isochrone.getCost(id);
+        if (cost < 0 || cost > isochroneBudget) {
+            continue;
+        }
+        painter.setBrush(getIsochroneColor(cost));
+        painter.drawEllipse(stationPositions[id], 12, 12);
+    }
+}
 
-    /* 获取站点连接的所有线路*/
+/***************************************************************************
+  函数名称：StationWidget::drawClosures
+  功    能：绘制临时封闭的区间和车站
+  输入参数：QPainter& painter - 绘图对象引用
+  返 回 值：
+  说    明：封闭取自当前显示的版本，每次绘制时读取，封闭变化后调用update()
+            即可刷新；封闭的区间画深灰色虚线，封闭的车站画红色叉号
+***************************************************************************/
+void StationWidget::drawClosures(QPainter& painter) {
+    const ClosureMaskPtr closures = metroGraph->getClosures();
+    if (closures == nullptr || closures->isEmpty())
+        return;
+
+    painter.setPen(QPen(QColor(60, 60, 60), 4, Qt::DashLine, Qt::FlatCap));
+    painter.setBrush(Qt::NoBrush);
     for (const StationConnection& conn : metroGraph->getConnections()) {
-        if (conn.station1 == station.name || conn.station2 == station.name) {
-            connectedLines.insert(conn.line);
+        if (!closures->isSegmentClosed(conn.id1, conn.id2, conn.lineId)) {
+            continue;
+        }
+        QPainterPath path;
+        path.moveTo(stationPositions[conn.id1]);
+        for (const QPoint& via : conn.viaPoints) {
+            path.lineTo(via);
+        }
+        path.lineTo(stationPositions[conn.id2]);
+        painter.drawPath(path);
+    }
+
+    painter.setPen(QPen(Qt::red, 3));
+    for (StationId id : closures->stations) {
+        if (id >= static_cast<StationId>(stationPositions.size())) {
+            continue;
         }
+        const QPoint pos = stationPositions[id];
+        painter.drawLine(pos + QPoint(-7, -7), pos + QPoint(7, 7));
+        painter.drawLine(pos + QPoint(-7, 7), pos + QPoint(7, -7));
+    }
+}
+
+/***************************************************************************
+  函数名称：StationWidget::drawIsochroneLegend
+  功    能：绘制可达范围色标
+  输入参数：QPainter& painter - 绘图对象引用
+  返 回 值：
+  说    明：在左上角画十级色块，两端标注0和预算
+***************************************************************************/
+void StationWidget::drawIsochroneLegend(QPainter& painter) {
+    if (isochrone.origin == INVALID_ID)
+        return;
+
+    QString unit;
+    switch (isochrone.strategy) {
+    case MIN_TRANSFER: unit = QString::fromUtf8(" 次换乘"); break;
+    case MIN_STATIONS: unit = QString::fromUtf8(" 站");     break;
+    case MIN_DISTANCE: unit = QString::fromUtf8(" 公里");   break;
     }
 
-    /* 如果连接了多条线路，则是换乘站*/
-    if (connectedLines.size() > 1) {
-        isTransferStation = true;
+    const int steps   = 10;
+    const int blockW  = 16;
+    const int legendX = 10;
+    const int legendY = 10;
+    painter.setPen(Qt::NoPen);
+    for (int k = 0; k < steps; k++) {
+        painter.setBrush(getIsochroneColor(isochroneBudget * k / (steps - 1)));
+        painter.drawRect(legendX + k * blockW, legendY, blockW, 10);
     }
 
-    /* 绘制站点*/
-    if (isTransferStation) {
+    painter.setPen(Qt::black);
+    painter.setFont(QFont("Arial", 8));
+    painter.drawText(legendX, legendY + 24, QString("0"));
+    painter.drawText(legendX + steps * blockW + 5, legendY + 10,
+                     QString::number(isochroneBudget) + unit);
+}
+
+/***************************************************************************
+  函数名称：StationWidget::drawStation
+  功    能：绘制站点
+  输入参数：QPainter& painter       - 绘图对象引用
+			StationId id            - 站点编号
+			bool      isHighlighted - 是否高亮显示
+  返 回 值：
+  说    明：换乘站标记来自按编号缓存的数组
+***************************************************************************/
+void StationWidget::drawStation(QPainter& painter, StationId id, bool isHighlighted) {
+    const Station& station = metroGraph->getStationById(id);
+    QPoint         pos     = stationPositions[id];
+
+    /* 绘制站点，换乘标记已在setMetroGraph中按编号预先计算*/
+    if (transferStations[id]) {
         /* 换乘站 - 先绘制白色背景圆*/
         painter.setPen(Qt::NoPen);
         painter.setBrush(QColor(240, 240, 240)); // 使用与背景相同的颜色
@@ -255,7 +458,7 @@ void StationWidget::drawStation(QPainter& painter, const Station& station, bool
         painter.drawEllipse(pos, 6, 6);
 
         /* 再使用线路颜色的空心圆*/
-        QColor lineColor = getStationLineColor(station.name);
+        QColor lineColor = getStationLineColor(id);
         painter.setPen(QPen(lineColor, 2));
         painter.setBrush(Qt::NoBrush);
         painter.drawEllipse(pos, 5, 5);
@@ -298,16 +501,13 @@ void StationWidget::drawStation(QPainter& painter, const Station& station, bool
   说    明：
 ***************************************************************************/
 void StationWidget::drawConnection(QPainter& painter, const StationConnection& conn, bool isHighlighted) {
-    QPoint fromPos = getStationPosition(metroGraph->getStation(conn.station1));
-    QPoint toPos   = getStationPosition(metroGraph->getStation(conn.station2));
+    QPoint fromPos = stationPositions[conn.id1];
+    QPoint toPos   = stationPositions[conn.id2];
 
     /* 找到线路颜色*/
     QColor lineColor = QColor(100, 100, 100, 150); // 默认灰色
-    for (const MetroLine& metroLine : metroGraph->getLines()) {
-        if (metroLine.name == conn.line) {
-            lineColor = metroLine.color;
-            break;
-        }
+    if (conn.lineId < static_cast<LineId>(lineColors.size())) {
+        lineColor = lineColors[conn.lineId];
     }
 
     /* 如果是高亮显示，使用更亮的颜色并加粗*/
@@ -342,25 +542,11 @@ void StationWidget::drawConnection(QPainter& painter, const StationConnection& c
         painter.drawLine(fromPos, toPos);
     }
     else {
-        /* 有拐点的连接 - 绘制折线*/
-        QVector<QPoint> sortedViaPoints = conn.viaPoints;
-
-        /* 计算每个转折点到起点的距离，用于排序*/
-        auto distanceToStart = [fromPos](const QPoint& p) {
-            return std::sqrt(std::pow(p.x() - fromPos.x(), 2) + std::pow(p.y() - fromPos.y(), 2));
-        };
-
-        /* 按照距离起点的远近排序*/
-        std::sort(sortedViaPoints.begin(), sortedViaPoints.end(),
-            [&](const QPoint& a, const QPoint& b) {
-                return distanceToStart(a) < distanceToStart(b);
-        });
-
-        /* 绘制折线*/
+        /* 有拐点的连接 - 转折点已在加载时按到起点的距离排好序，直接绘制折线*/
         QPainterPath path;
         path.moveTo(fromPos);
 
-        for (const QPoint& via : sortedViaPoints) {
+        for (const QPoint& via : conn.viaPoints) {
             path.lineTo(via);
         }
 
@@ -384,37 +570,22 @@ void StationWidget::drawPath(QPainter& painter) {
     QColor highlightColor(255, 50, 50);
     QColor glowColor     (255, 100, 100, 200); // 半透明的红色用于发光效果
 
-    /* 获取路径中的所有连接*/
-    QVector<StationConnection> pathConnections = getPathConnections();
-
     /* 首先绘制发光效果（阴影）*/
     painter.setPen(QPen(glowColor, 7, Qt::SolidLine, Qt::RoundCap));
-    for (const StationConnection& conn : pathConnections) {
-        QPoint fromPos = getStationPosition(metroGraph->getStation(conn.station1));
-        QPoint toPos   = getStationPosition(metroGraph->getStation(conn.station2));
+    for (const StationConnection* connPtr : pathConnections) {
+        const StationConnection& conn = *connPtr;
+        QPoint fromPos = stationPositions[conn.id1];
+        QPoint toPos   = stationPositions[conn.id2];
 
         if (conn.viaPoints.isEmpty()) {
             painter.drawLine(fromPos, toPos);
         }
         else {
-            QVector<QPoint> sortedViaPoints = conn.viaPoints;
-
-            /* 计算每个转折点到起点的距离，用于排序*/
-            auto distanceToStart = [fromPos](const QPoint& p) {
-                return std::sqrt(std::pow(p.x() - fromPos.x(), 2) + std::pow(p.y() - fromPos.y(), 2));
-            };
-
-            /* 按照距离起点的远近排序*/
-            std::sort(sortedViaPoints.begin(), sortedViaPoints.end(),
-                [&](const QPoint& a, const QPoint& b) {
-                    return distanceToStart(a) < distanceToStart(b);
-            });
-
-            /* 绘制折线*/
+            /* 绘制折线，转折点已在加载时按到起点的距离排好序*/
             QPainterPath path;
             path.moveTo(fromPos);
 
-            for (const QPoint& via : sortedViaPoints) {
+            for (const QPoint& via : conn.viaPoints) {
                 path.lineTo(via);
             }
 
@@ -425,32 +596,20 @@ void StationWidget::drawPath(QPainter& painter) {
 
      /* 然后绘制高亮连接线*/
     painter.setPen(QPen(highlightColor, 3, Qt::SolidLine, Qt::RoundCap));
-    for (const StationConnection& conn : pathConnections) {
-        QPoint fromPos = getStationPosition(metroGraph->getStation(conn.station1));
-        QPoint toPos   = getStationPosition(metroGraph->getStation(conn.station2));
+    for (const StationConnection* connPtr : pathConnections) {
+        const StationConnection& conn = *connPtr;
+        QPoint fromPos = stationPositions[conn.id1];
+        QPoint toPos   = stationPositions[conn.id2];
 
         if (conn.viaPoints.isEmpty()) {
             painter.drawLine(fromPos, toPos);
         }
         else {
-            QVector<QPoint> sortedViaPoints = conn.viaPoints;
-
-            /* 计算每个转折点到起点的距离，用于排序*/
-            auto distanceToStart = [fromPos](const QPoint& p) {
-                return std::sqrt(std::pow(p.x() - fromPos.x(), 2) + std::pow(p.y() - fromPos.y(), 2));
-            };
-
-            /* 按照距离起点的远近排序*/
-            std::sort(sortedViaPoints.begin(), sortedViaPoints.end(),
-                [&](const QPoint& a, const QPoint& b) {
-                    return distanceToStart(a) < distanceToStart(b);
-            });
-
-            /* 绘制折线*/
+            /* 绘制折线，转折点已在加载时按到起点的距离排好序*/
             QPainterPath path;
             path.moveTo(fromPos);
 
-            for (const QPoint& via : sortedViaPoints) {
+            for (const QPoint& via : conn.viaPoints) {
                 path.lineTo(via);
             }
 
@@ -462,11 +621,12 @@ void StationWidget::drawPath(QPainter& painter) {
     /* 高亮显示路径上的站点*/
     for (const PathSegment& segment : currentPath.segments) {
         for (const QString& stationName : segment.stations) {
-            if (metroGraph->hasStation(stationName)) {
-                Station station = metroGraph->getStation(stationName);
+            StationId id = metroGraph->getStationId(stationName);
+            if (id != INVALID_ID) {
+                const Station& station = metroGraph->getStationById(id);
 
                 /* 绘制高亮效果*/
-                QPoint pos = getStationPosition(station);
+                QPoint pos = stationPositions[id];
 
                 /* 绘制发光效果*/
                 QRadialGradient gradient(pos, 15);
@@ -566,18 +726,12 @@ void StationWidget::mousePressEvent(QMouseEvent* event) {
         /* 将鼠标位置转换为图上的坐标*/
         QPoint scenePos = toGraph(event->pos());
 
-        /* 查找最近的站点*/
-        double minDist = 20.0 / scale;
+        /* 通过空间网格查找最近的站点*/
         QString selectedStation;
-
-        for (const Station& station : metroGraph->getStations()) {
-            QPoint stationPos = getStationPosition(station);
-            double dist = std::sqrt(std::pow(stationPos.x() - scenePos.x(), 2) +
-                std::pow(stationPos.y() - scenePos.y(), 2));
-
-            if (dist < minDist) {
-                minDist = dist;
-                selectedStation = station.name;
+        if (metroGraph) {
+            StationId id = metroGraph->findNearestStation(scenePos, 20.0 / scale);
+            if (id != INVALID_ID) {
+                selectedStation = metroGraph->getStationName(id);
             }
         }
 
@@ -693,55 +847,61 @@ QPoint StationWidget::toGraph(const QPoint& viewportPoint) const {
   函数名称：StationWidget::getPathConnections
   功    能：获取路径中的所有连接
   输入参数：
-  返 回 值：QVector<StationConnection> - 路径连接列表
-  说    明：
+  返 回 值：QVector<const StationConnection*> - 路径连接列表
+  说    明：返回的指针指向线路图内部存储，线路图修改后需重新获取
   ***************************************************************************/
-QVector<StationConnection> StationWidget::getPathConnections() const {
-    QVector<StationConnection> pathConnections;
+QVector<const StationConnection*> StationWidget::getPathConnections() const {
+    QVector<const StationConnection*> connections;
 
-    if (currentPath.segments.isEmpty()) 
-        return pathConnections;
+    if (!metroGraph || currentPath.segments.isEmpty()) 
+        return connections;
 
-    /* 收集路径中所有相邻站点对*/
-    QVector<QPair<QString, QString>> stationPairs;
+    /* 为路径段中每对相邻站点找到所乘线路上的连接*/
     for (const PathSegment& segment : currentPath.segments) {
+        LineId line = metroGraph->getLineId(segment.line);
         for (int i = 1; i < segment.stations.size(); i++) {
-            stationPairs.append(qMakePair(segment.stations[i - 1], segment.stations[i]));
-        }
-    }
+            StationId id1 = metroGraph->getStationId(segment.stations[i - 1]);
+            StationId id2 = metroGraph->getStationId(segment.stations[i]);
+            if (id1 == INVALID_ID || id2 == INVALID_ID) {
+                continue;
+            }
 
-    /* 为每对站点找到对应的连接*/
-    for (const auto& pair : stationPairs) {
-        StationConnection conn = metroGraph->getConnection(pair.first, pair.second);
-        if (!conn.station1.isEmpty()) {
-            pathConnections.append(conn);
+            const StationConnection* conn = nullptr;
+            if (line != INVALID_ID) {
+                conn = metroGraph->findConnection(id1, id2, line);
+            }
+            if (conn == nullptr) {
+                conn = metroGraph->findConnection(id1, id2);
+            }
+            if (conn != nullptr) {
+                connections.append(conn);
+            }
         }
     }
 
-    return pathConnections;
+    return connections;
 }
 /***************************************************************************
   函数名称：StationWidget::getStationLineColor
   功    能：获取站点所属线路的颜色
-  输入参数：const QString& stationName - 站点名称
+  输入参数：StationId id - 站点编号
   返 回 值：QColor - 线路颜色
-  说    明：
+  说    明：取站点第一条出边所在线路的颜色
   ***************************************************************************/
-QColor StationWidget::getStationLineColor(const QString& stationName) const {
-    if (!metroGraph) return Qt::black;
-
-    // 获取站点所在的第一个线路的颜色
-    for (const StationConnection& conn : metroGraph->getConnections()) {
-        if (conn.station1 == stationName || conn.station2 == stationName) {
-            for (const MetroLine& metroLine : metroGraph->getLines()) {
-                if (metroLine.name == conn.line) {
-                    return metroLine.color;
-                }
-            }
-            break;
-        }
-    }
+QColor StationWidget::getStationLineColor(StationId id) const {
+    if (!metroGraph || id >= static_cast<StationId>(stationColors.size())) return Qt::black;
+    return stationColors[id];
+}
 
-    return Qt::black;
+/***************************************************************************
+  函数名称：StationWidget::getIsochroneColor
+  功    能：按代价取可达范围的分级颜色
+  输入参数：double cost - 到达站点的代价
+  返 回 值：QColor - 代价为0时为绿色，等于预算时为红色，半透明
+  说    明：
+  ***************************************************************************/
+QColor StationWidget::getIsochroneColor(double cost) const {
+    const double ratio = isochroneBudget > 0 ? qBound(0.0, cost / isochroneBudget, 1.0) : 0.0;
+    return QColor::fromHsv(static_cast<int>(120 * (1 - ratio)), 220, 230, 150);
 }
 /*StationWidget.cpp*/
\ No newline at end of file
@@ -16,8 +16,10 @@ class StationWidget : public QWidget {
     Q_OBJECT
 public:
 	explicit StationWidget(QWidget* parent = nullptr); // 构造函数
-	void     setMetroGraph(const MetroGraph& graph);   // 设置地铁图
+	void     setMetroGraph(MetroGraphPtr graphPtr);    // 设置地铁图版本
 	void     setPath(const MetroPath& path);           // 设置当前路径
+	void     setIsochrone(const Isochrone& result, double budget); // 设置可达范围叠加层
+	void     clearIsochrone();                         // 清除可达范围叠加层
 
 protected:
     /*重写鼠标事件*/
@@ -36,9 +38,16 @@ public slots:
     void setSelectionMode(bool enabled); //设置选择模式
 
 private:
-	const MetroGraph*     metroGraph;		      // 地铁线路图指针
+	MetroGraphPtr         metroGraph;		      // 正在显示的地铁线路图版本
     MetroPath             currentPath;            // 当前路径
-	QMap<QString, QPoint> stationPositions;		  // 站点位置映射
+	Isochrone             isochrone;              // 可达范围，origin无效时不绘制
+	double                isochroneBudget;        // 可达范围的预算，决定颜色分级
+	QVector<QPoint>       stationPositions;		  // 按站点编号索引的位置
+	QVector<QColor>       stationColors;          // 按站点编号索引的线路颜色
+	QVector<bool>         transferStations;       // 按站点编号索引的换乘站标记
+	QVector<bool>         pathStations;           // 按站点编号索引的路径站点标记
+	QVector<const StationConnection*> pathConnections; // 路径经过的连接，指向图内存储
+	QVector<QColor>       lineColors;             // 按线路编号索引的线路颜色
 	double                scale;				  // 缩放比例
 	QPoint                offset;				  // 偏移量
 	QPoint                lastDragPos;			  // 上次拖拽位置
@@ -50,17 +59,23 @@ private:
 	QTimer*               feedbackTimer;          // 反馈显示定时器
 
 	/*绘制方法*/
-    void drawStation(QPainter& painter, const Station& station, bool isHighlighted = false);           //绘制站点
+    void drawStation(QPainter& painter, StationId id, bool isHighlighted = false);                     //绘制站点
     void drawConnection(QPainter& painter, const StationConnection& conn, bool isHighlighted = false); //绘制连接线
 	void drawPath(QPainter& painter);                                                                  //绘制路径
 	void drawLegend(QPainter& painter);                                                                //绘制图例
+	void drawIsochrone(QPainter& painter);                                                             //绘制可达范围
+	void drawIsochroneLegend(QPainter& painter);                                                       //绘制可达范围色标
+	void drawClosures(QPainter& painter);                                                              //绘制临时封闭
+	QColor getIsochroneColor(double cost)                                                       const; //按代价取分级颜色
 
 	/*辅助方法*/
     QPoint                     getStationPosition(const Station& station) const; //获取站点位置
     QPoint					   toViewport(const QPoint& graphPoint)       const; //换算窗口坐标
     QPoint					   toGraph(const QPoint& viewportPoint)       const; //换算图上实际坐标
-	QVector<StationConnection> getPathConnections()                       const; //获取路径连接线
-	QColor getStationLineColor(const QString& stationName)				  const; //获取站点线路颜色
+	QVector<const StationConnection*> getPathConnections()                const; //获取路径连接线
+	QColor getStationLineColor(StationId id)				              const; //获取站点线路颜色
+	void   applyGraphChanges(const QVector<MetroChange>& changes);              //按变更更新缓存
+	void   updateStationCache(StationId id);                                    //更新单个站点的缓存
 
 };
 
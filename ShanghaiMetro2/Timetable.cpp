@@ -0,0 +1,513 @@
+﻿/***************************************************************************
+  文件名称：Timetable.cpp
+  功    能：列车时刻表的实现文件
+  说    明：timetable.json的结构为：
+            defaults  - 全部线路的默认运营参数：speed（旅行速度，公里/小时）、
+                        dwell（停站秒数）、minSection/maxSection（区间运行
+                        秒数的上下限）、transfer（换乘秒数）和headways（按时段
+                        的发车间隔，每项为from、to和headway秒数）
+            lines     - 按线路覆盖默认参数，可用routes给出各交路的两端站名，
+                        service为false时该线路不按间隔生成车次
+            transfers - 按站名单独配置的换乘秒数
+            walks     - 换乘站内两条线路站台之间的步行秒数，每项为station、
+                        from、to和walk，oneWay为true时只用于from换到to，
+                        未配置的线路对按该站的换乘秒数
+            trips     - 逐车次给出的停站时刻，每项为line和stops，stops中每站
+                        为station、arrival和departure
+            未在lines中出现的线路按默认参数沿线路拓扑中的各走向双向开行
+***************************************************************************/
+
+#include "Timetable.h"
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QStringList>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+/*一个时段的发车间隔*/
+struct HeadwayPeriod {
+    int from;    //时段开始（秒）
+    int to;      //时段结束（秒），不含
+    int headway; //发车间隔（秒）
+};
+
+/*一条线路按间隔开行时使用的参数，区间运行参数在加载后保留*/
+struct ServiceSettings : TimetableService {
+    bool                   enabled = true; //是否按间隔生成车次
+    QVector<HeadwayPeriod> headways;       //各时段的发车间隔
+};
+
+/***************************************************************************
+  函数名称：walkKey
+  功    能：步行时间表的键
+  输入参数：StationId station - 站点编号
+            LineId from       - 换出的线路
+            LineId to         - 换入的线路
+  返 回 值：quint64 - 键
+  说    明：线路编号各占16位，线路数远小于此
+***************************************************************************/
+quint64 walkKey(StationId station, LineId from, LineId to) {
+    return (quint64(station) << 32) | (quint64(from & 0xFFFF) << 16) | quint64(to & 0xFFFF);
+}
+
+/***************************************************************************
+  函数名称：readSettings
+  功    能：用JSON对象中出现的字段覆盖运营参数
+  输入参数：const QJsonObject& object - defaults或lines中的一项
+            ServiceSettings& settings - 被覆盖的参数
+  返 回 值：
+  说    明：未出现的字段保持原值，非法的时段被忽略；只覆盖minSection时
+            继承的maxSection也不会小于它
+***************************************************************************/
+void readSettings(const QJsonObject& object, ServiceSettings& settings) {
+    if (object.contains("speed") && object.value("speed").toDouble() > 0) {
+        settings.speed = object.value("speed").toDouble();
+    }
+    if (object.contains("dwell")) {
+        settings.dwell = qMax(0, object.value("dwell").toInt());
+    }
+    if (object.contains("minSection")) {
+        settings.minSection = qMax(1, object.value("minSection").toInt());
+    }
+    if (object.contains("maxSection")) {
+        settings.maxSection = object.value("maxSection").toInt();
+    }
+    settings.maxSection = qMax(settings.maxSection, settings.minSection);
+    if (object.contains("service")) {
+        settings.enabled = object.value("service").toBool(true);
+    }
+    if (object.contains("headways")) {
+        settings.headways.clear();
+        for (const QJsonValue& value : object.value("headways").toArray()) {
+            const QJsonObject period = value.toObject();
+            HeadwayPeriod entry;
+            entry.from    = Timetable::parseTime(period.value("from").toString());
+            entry.to      = Timetable::parseTime(period.value("to").toString());
+            entry.headway = period.value("headway").toInt();
+            if (entry.from < 0 || entry.to <= entry.from || entry.headway <= 0) {
+                qWarning() << "忽略无效的发车时段:" << period.value("from").toString() << period.value("to").toString();
+                continue;
+            }
+            settings.headways.append(entry);
+        }
+    }
+}
+
+} // namespace
+
+/***************************************************************************
+  函数名称：Timetable::Timetable
+  功    能：构造函数
+  输入参数：
+  返 回 值：
+  说    明：
+***************************************************************************/
+Timetable::Timetable() : stationCount(0), defaultTransfer(DEFAULT_TRANSFER_TIME) {}
+
+/***************************************************************************
+  函数名称：Timetable::parseTime
+  功    能：解析时刻
+  输入参数：const QString& text - "HH:MM"或"HH:MM:SS"，小时可以大于23
+  返 回 值：int - 当日零点起的秒数，格式错误时为-1
+  说    明：
+***************************************************************************/
+int Timetable::parseTime(const QString& text) {
+    const QStringList parts = text.split(':');
+    if (parts.size() < 2 || parts.size() > 3) {
+        return -1;
+    }
+    int values[3] = { 0, 0, 0 };
+    for (int i = 0; i < parts.size(); i++) {
+        bool ok = false;
+        values[i] = parts[i].toInt(&ok);
+        if (!ok || values[i] < 0 || (i > 0 && values[i] >= 60)) {
+            return -1;
+        }
+    }
+    return values[0] * 3600 + values[1] * 60 + values[2];
+}
+
+/***************************************************************************
+  函数名称：Timetable::formatTime
+  功    能：将秒数格式化为时刻
+  输入参数：int seconds - 当日零点起的秒数
+  返 回 值：QString - "HH:MM"，秒数向下取整到分钟
+  说    明：跨过零点的时刻小时数大于23，与时刻表中的写法一致
+***************************************************************************/
+QString Timetable::formatTime(int seconds) {
+    return QString("%1:%2").arg(seconds / 3600, 2, 10, QChar('0')).arg(seconds / 60 % 60, 2, 10, QChar('0'));
+}
+
+/***************************************************************************
+  函数名称：Timetable::load
+  功    能：读取时刻表并展开为车次
+  输入参数：const MetroGraph& graph - 站名和线路所依据的地铁图
+            const QString& filename - timetable.json的路径
+  返 回 值：TimetablePtr - 时刻表，文件不存在或无法解析时为空指针
+  说    明：按间隔开行的线路在每个时段内从各交路两端同时按间隔发车，一条
+            线路有k个交路时各交路的间隔为k倍并依次错开一个间隔，共用区段上
+            的发车间隔与配置一致；区间运行时间按两站间里程和旅行速度估算并
+            限制在上下限之间，环线车次绕行一周回到始发站；站名或线路名无法
+            识别、相邻两站不在该线路上相连或时刻倒退的车次被跳过
+***************************************************************************/
+TimetablePtr Timetable::load(const MetroGraph& graph, const QString& filename) {
+    QFile file(filename);
+    if (!file.exists() || !file.open(QIODevice::ReadOnly)) {
+        return TimetablePtr();
+    }
+    QJsonParseError error;
+    const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &error);
+    if (error.error != QJsonParseError::NoError || !document.isObject()) {
+        qWarning() << "无效的时刻表文件:" << filename << error.errorString();
+        return TimetablePtr();
+    }
+    const QJsonObject root = document.object();
+
+    std::shared_ptr<Timetable> table(new Timetable());
+    table->stationCount = graph.getStationCount();
+
+    /* 默认参数、各站换乘时间和站内各线路之间的步行时间*/
+    ServiceSettings defaults;
+    const QJsonObject defaultObject = root.value("defaults").toObject();
+    readSettings(defaultObject, defaults);
+    table->defaultService  = defaults;
+    table->defaultTransfer = defaultObject.contains("transfer") ? qMax(0, defaultObject.value("transfer").toInt())
+                                                                : DEFAULT_TRANSFER_TIME;
+    table->transferTimes.fill(table->defaultTransfer, table->stationCount);
+    const QJsonObject transferObject = root.value("transfers").toObject();
+    for (const QString& name : transferObject.keys()) {
+        const StationId id = graph.getStationId(name);
+        if (id == INVALID_ID) {
+            qWarning() << "时刻表中的换乘站不存在:" << name;
+            continue;
+        }
+        table->transferTimes[id] = qMax(0, transferObject.value(name).toInt());
+    }
+    for (const QJsonValue& value : root.value("walks").toArray()) {
+        const QJsonObject object  = value.toObject();
+        const StationId   station = graph.getStationId(object.value("station").toString());
+        const LineId      from    = graph.getLineId(object.value("from").toString());
+        const LineId      to      = graph.getLineId(object.value("to").toString());
+        if (station == INVALID_ID || from == INVALID_ID || to == INVALID_ID || from == to) {
+            qWarning() << "忽略无效的换乘步行时间:" << object.value("station").toString()
+                       << object.value("from").toString() << object.value("to").toString();
+            continue;
+        }
+        const qint32 walk = qMax(0, object.value("walk").toInt());
+        table->walkTimes.insert(walkKey(station, from, to), walk);
+        if (!object.value("oneWay").toBool(false)) {
+            table->walkTimes.insert(walkKey(station, to, from), walk);
+        }
+    }
+
+    /* 按线路覆盖参数*/
+    QVector<ServiceSettings>             settings(graph.getLineCount(), defaults);
+    QVector<QVector<QVector<StationId>>> routes(graph.getLineCount());
+    for (const QJsonValue& value : root.value("lines").toArray()) {
+        const QJsonObject object = value.toObject();
+        const LineId      line   = graph.getLineId(object.value("line").toString());
+        if (line == INVALID_ID) {
+            qWarning() << "时刻表中的线路不存在:" << object.value("line").toString();
+            continue;
+        }
+        readSettings(object, settings[line]);
+        for (const QJsonValue& routeValue : object.value("routes").toArray()) {
+            const QJsonArray         ends  = routeValue.toArray();
+            const QVector<StationId> route = graph.getLinePath(line, graph.getStationId(ends.at(0).toString()),
+                                                                     graph.getStationId(ends.at(1).toString()));
+            if (route.size() < 2) {
+                qWarning() << "无法识别的交路:" << graph.getLineName(line) << ends.at(0).toString() << ends.at(1).toString();
+                continue;
+            }
+            routes[line].append(route);
+        }
+    }
+
+    table->services.resize(graph.getLineCount());
+    for (LineId line = 0; line < LineId(graph.getLineCount()); line++) {
+        table->services[line] = settings[line];
+    }
+
+    /* 未指定交路的线路沿拓扑中的各走向开行，环线回到始发站*/
+    const LineTopology& topology = graph.getLineTopology();
+    for (LineId line = 0; line < LineId(graph.getLineCount()); line++) {
+        if (!routes[line].isEmpty()) {
+            continue;
+        }
+        for (const LineRoute& route : topology.routes[line]) {
+            QVector<StationId> stations = route.stations;
+            if (route.loop && stations.size() > 2) {
+                stations.append(stations.first());
+            }
+            if (stations.size() >= 2) {
+                routes[line].append(stations);
+            }
+        }
+    }
+
+    /* 按间隔展开车次*/
+    QVector<qint32> arrivals;
+    QVector<qint32> departures;
+    for (LineId line = 0; line < LineId(graph.getLineCount()); line++) {
+        const ServiceSettings& service    = settings[line];
+        const int              routeCount = routes[line].size();
+        if (!service.enabled) {
+            continue;
+        }
+        for (int r = 0; r < routeCount; r++) {
+            for (int direction = 0; direction < 2; direction++) {
+                QVector<StationId> stations = routes[line][r];
+                if (direction == 1) {
+                    std::reverse(stations.begin(), stations.end());
+                }
+                /* 区间里程取线路走向上的累计里程之差，站点不在走向上时退回两站直线距离*/
+                QVector<int> sections(stations.size() - 1);
+                for (int i = 0; i + 1 < stations.size(); i++) {
+                    double distance = graph.getLineDistance(line, stations[i], stations[i + 1]);
+                    if (distance < 0) {
+                        distance = graph.calculateDistance(stations[i], stations[i + 1]);
+                    }
+                    sections[i] = table->getSectionTime(line, distance);
+                }
+
+                for (const HeadwayPeriod& period : service.headways) {
+                    const int step = period.headway * routeCount;
+                    for (int start = period.from + r * period.headway; start < period.to; start += step) {
+                        arrivals.resize(stations.size());
+                        departures.resize(stations.size());
+                        arrivals[0] = departures[0] = start;
+                        for (int i = 1; i < stations.size(); i++) {
+                            arrivals[i]   = departures[i - 1] + sections[i - 1];
+                            departures[i] = i + 1 < stations.size() ? arrivals[i] + service.dwell : arrivals[i];
+                        }
+                        table->addTrip(line, stations, arrivals, departures);
+                    }
+                }
+            }
+        }
+    }
+
+    /* 逐车次给出的时刻*/
+    for (const QJsonValue& value : root.value("trips").toArray()) {
+        const QJsonObject object = value.toObject();
+        const LineId      line   = graph.getLineId(object.value("line").toString());
+        QVector<StationId> stations;
+        arrivals.clear();
+        departures.clear();
+        bool valid = line != INVALID_ID;
+        for (const QJsonValue& stopValue : object.value("stops").toArray()) {
+            if (!valid) {
+                break;
+            }
+            const QJsonObject stop      = stopValue.toObject();
+            const StationId   station   = graph.getStationId(stop.value("station").toString());
+            int               arrival   = parseTime(stop.value("arrival").toString());
+            int               departure = parseTime(stop.value("departure").toString());
+            arrival   = arrival   < 0 ? departure : arrival;
+            departure = departure < 0 ? arrival   : departure;
+            valid = station != INVALID_ID && arrival >= 0 && departure >= arrival
+                 && (stations.isEmpty() || (arrival >= departures.last()
+                                            && graph.findConnection(stations.last(), station, line) != nullptr));
+            stations.append(station);
+            arrivals.append(arrival);
+            departures.append(departure);
+        }
+        if (!valid || stations.size() < 2) {
+            qWarning() << "忽略无效的车次:" << object.value("line").toString();
+            continue;
+        }
+        table->addTrip(line, stations, arrivals, departures);
+    }
+
+    table->buildConnections();
+    qDebug() << "时刻表加载完成:" << table->trips.size() << "个车次," << table->connections.size() << "段区间运行";
+    return table;
+}
+
+/***************************************************************************
+  函数名称：Timetable::addTrip
+  功    能：登记一个车次
+  输入参数：LineId line                       - 所属线路
+            const QVector<StationId>& stations - 依次的停站
+            const QVector<qint32>& arrivals    - 各站到达时刻
+            const QVector<qint32>& departures  - 各站出发时刻
+  返 回 值：
+  说    明：三个数组长度相同，时刻不倒退由调用方保证
+***************************************************************************/
+void Timetable::addTrip(LineId line, const QVector<StationId>& stations,
+                        const QVector<qint32>& arrivals, const QVector<qint32>& departures) {
+    TimetableTrip trip;
+    trip.line      = line;
+    trip.firstStop = stopStations.size();
+    trip.stopCount = stations.size();
+    trips.append(trip);
+    stopStations  .append(stations);
+    stopArrivals  .append(arrivals);
+    stopDepartures.append(departures);
+}
+
+/***************************************************************************
+  函数名称：Timetable::buildConnections
+  功    能：由车次生成区间运行并按时间排序
+  输入参数：
+  返 回 值：
+  说    明：同一车次的相邻区间运行出发时刻可能相同（停站时间为0），
+            按到达时刻、车次和停站位置依次比较，保证车次内的先后顺序
+***************************************************************************/
+void Timetable::buildConnections() {
+    connections.clear();
+    connections.reserve(stopStations.size() - trips.size());
+    for (int t = 0; t < trips.size(); t++) {
+        const TimetableTrip& trip = trips[t];
+        for (int i = 0; i + 1 < trip.stopCount; i++) {
+            const int stop = trip.firstStop + i;
+            TimetableConnection connection;
+            connection.from      = stopStations[stop];
+            connection.to        = stopStations[stop + 1];
+            connection.departure = stopDepartures[stop];
+            connection.arrival   = stopArrivals[stop + 1];
+            connection.trip      = t;
+            connection.stop      = i;
+            connections.append(connection);
+        }
+    }
+    std::sort(connections.begin(), connections.end(), [](const TimetableConnection& a, const TimetableConnection& b) {
+        if (a.departure != b.departure)
+            return a.departure < b.departure;
+        if (a.arrival != b.arrival)
+            return a.arrival < b.arrival;
+        if (a.trip != b.trip)
+            return a.trip < b.trip;
+        return a.stop < b.stop;
+    });
+}
+
+/***************************************************************************
+  函数名称：Timetable::getStationCount
+  功    能：获取时刻表覆盖的站点编号上界
+  输入参数：
+  返 回 值：int - 加载时地铁图的站点数，之后新增的站点不在时刻表中
+  说    明：
+***************************************************************************/
+int Timetable::getStationCount() const {
+    return stationCount;
+}
+
+/***************************************************************************
+  函数名称：Timetable::getTripCount
+  功    能：获取车次数
+  输入参数：
+  返 回 值：int - 车次数
+  说    明：
+***************************************************************************/
+int Timetable::getTripCount() const {
+    return trips.size();
+}
+
+/***************************************************************************
+  函数名称：Timetable::getConnections
+  功    能：获取全部区间运行
+  输入参数：
+  返 回 值：const QVector<TimetableConnection>& - 按出发时刻排序的区间运行
+  说    明：
+***************************************************************************/
+const QVector<TimetableConnection>& Timetable::getConnections() const {
+    return connections;
+}
+
+/***************************************************************************
+  函数名称：Timetable::getTrip
+  功    能：获取车次
+  输入参数：int trip - 车次编号
+  返 回 值：const TimetableTrip& - 车次信息
+  说    明：
+***************************************************************************/
+const TimetableTrip& Timetable::getTrip(int trip) const {
+    return trips[trip];
+}
+
+/***************************************************************************
+  函数名称：Timetable::getStopStation
+  功    能：获取停站对应的站点
+  输入参数：int stop - 停站在全部停站中的下标
+  返 回 值：StationId - 站点编号
+  说    明：
+***************************************************************************/
+StationId Timetable::getStopStation(int stop) const {
+    return stopStations[stop];
+}
+
+/***************************************************************************
+  函数名称：Timetable::getTransferTime
+  功    能：获取在某站换乘其他车次所需的最短时间
+  输入参数：StationId id - 站点编号
+  返 回 值：int - 秒数
+  说    明：留在同一车次上不受此限制
+***************************************************************************/
+int Timetable::getTransferTime(StationId id) const {
+    return transferTimes[id];
+}
+
+/***************************************************************************
+  函数名称：Timetable::findFirstConnection
+  功    能：查找第一个出发时刻不早于给定时刻的区间运行
+  输入参数：int time - 时刻（秒）
+  返 回 值：int - 区间运行下标，都早于该时刻时为区间运行总数
+  说    明：二分查找
+***************************************************************************/
+int Timetable::findFirstConnection(int time) const {
+    return int(std::lower_bound(connections.begin(), connections.end(), time,
+                                [](const TimetableConnection& connection, int value) {
+                                    return connection.departure < value;
+                                }) - connections.begin());
+}
+
+/***************************************************************************
+  函数名称：Timetable::getSectionTime
+  功    能：按里程估算区间运行时间
+  输入参数：LineId line     - 线路编号
+            double distance - 两站间里程（公里）
+  返 回 值：int - 秒数，按旅行速度折算并限制在该线路的上下限之间
+  说    明：按间隔生成的车次即用此时间；加载后新增的线路按默认参数
+***************************************************************************/
+int Timetable::getSectionTime(LineId line, double distance) const {
+    const TimetableService& service = line < LineId(services.size()) ? services[line] : defaultService;
+    const double            seconds = distance / service.speed * 3600;
+    return qBound(service.minSection, int(std::lround(seconds)), service.maxSection);
+}
+
+/***************************************************************************
+  函数名称：Timetable::getDwellTime
+  功    能：获取线路的停站时间
+  输入参数：LineId line - 线路编号
+  返 回 值：int - 秒数
+  说    明：加载后新增的线路按默认参数
+***************************************************************************/
+int Timetable::getDwellTime(LineId line) const {
+    return line < LineId(services.size()) ? services[line].dwell : defaultService.dwell;
+}
+
+/***************************************************************************
+  函数名称：Timetable::getWalkTime
+  功    能：获取在换乘站内由一条线路步行到另一条线路站台的时间
+  输入参数：StationId station - 站点编号
+            LineId from       - 换出的线路
+            LineId to         - 换入的线路
+  返 回 值：int - 秒数
+  说    明：walks中未配置的线路对按该站的换乘时间，加载后新增的站点按
+            默认换乘时间
+***************************************************************************/
+int Timetable::getWalkTime(StationId station, LineId from, LineId to) const {
+    const QHash<quint64, qint32>::const_iterator it = walkTimes.constFind(walkKey(station, from, to));
+    if (it != walkTimes.constEnd()) {
+        return it.value();
+    }
+    return station < StationId(stationCount) ? transferTimes[station] : defaultTransfer;
+}
+
+/*Timetable.cpp*/
@@ -0,0 +1,107 @@
+﻿/***************************************************************************
+  文件名称：Timetable.h
+  功    能：列车时刻表的头文件
+  说    明：与metroInfo.json并列的timetable.json给出各线路的发车间隔或逐车次
+            的停站时刻，加载时按间隔展开为车次，并把每个车次相邻两站之间的
+            一段运行记为一个"区间运行"，全部区间运行按发车时刻排序后连续存放，
+            供ConnectionScan按时间顺序扫描；时刻均为当日零点起的秒数，
+            跨过零点的车次可大于86400。各线路的区间运行参数和换乘站内
+            各线路之间的步行时间也由此提供，供CostModel估算广义代价
+***************************************************************************/
+
+#ifndef TIMETABLE_H
+#define TIMETABLE_H
+
+#include "MetroGraph.h"
+#include <QString>
+#include <QVector>
+#include <QHash>
+#include <memory>
+
+/*一个车次在相邻两站之间的一段运行*/
+struct TimetableConnection {
+    StationId from;      //出发站
+    StationId to;        //到达站
+    qint32    departure; //出发时刻（秒）
+    qint32    arrival;   //到达时刻（秒）
+    qint32    trip;      //所属车次
+    qint32    stop;      //出发站在车次停站序列中的位置
+};
+
+/*一条线路的区间运行参数*/
+struct TimetableService {
+    double speed      = 40;  //旅行速度（公里/小时）
+    int    dwell      = 30;  //停站时间（秒）
+    int    minSection = 90;  //区间运行时间下限（秒）
+    int    maxSection = 300; //区间运行时间上限（秒）
+};
+
+/*一个车次*/
+struct TimetableTrip {
+    LineId line;      //所属线路
+    int    firstStop; //停站位于stopStations等数组的[firstStop, firstStop + stopCount)
+    int    stopCount; //停站数
+};
+
+/*行程中乘坐一个车次的一段*/
+struct TimetableLeg {
+    LineId             line;      //线路
+    int                trip;      //车次
+    qint32             departure; //上车站的出发时刻
+    qint32             arrival;   //下车站的到达时刻
+    QVector<StationId> stations;  //上车站到下车站途经的站点（含两端）
+};
+
+/*最早到达查询的结果*/
+struct TimetableJourney {
+    QVector<TimetableLeg> legs;           //各段，为空表示当日无法到达
+    qint32                departure = -1; //查询的出发时刻
+    qint32                arrival   = -1; //到达终点的时刻，无法到达时为-1
+};
+
+class Timetable;
+
+/*只读的时刻表，可在多个查询对象之间共享*/
+typedef std::shared_ptr<const Timetable> TimetablePtr;
+
+/*列车时刻表*/
+class Timetable {
+public:
+    static const int DEFAULT_TRANSFER_TIME = 180; //未单独配置的站点的换乘时间（秒）
+
+    static TimetablePtr load(const MetroGraph& graph, const QString& filename); //读取时刻表并展开为车次
+    static int          parseTime(const QString& text);                        //"HH:MM"或"HH:MM:SS"转为秒，格式错误时为-1
+    static QString      formatTime(int seconds);                               //秒转为"HH:MM"
+
+    int                                 getStationCount()              const;//时刻表覆盖的站点编号上界
+    int                                 getTripCount()                 const;//车次数
+    const QVector<TimetableConnection>& getConnections()               const;//按出发时刻排序的全部区间运行
+    const TimetableTrip&                getTrip(int trip)              const;//获取车次
+    StationId                           getStopStation(int stop)       const;//停站对应的站点
+    int                                 getTransferTime(StationId id)  const;//在该站换乘其他车次所需的最短时间（秒）
+    int                                 findFirstConnection(int time)  const;//第一个出发时刻不早于time的区间运行下标
+    int                                 getSectionTime(LineId line, double distance)           const;//按里程估算该线路的区间运行秒数
+    int                                 getDwellTime(LineId line)                              const;//该线路的停站秒数
+    int                                 getWalkTime(StationId station, LineId from, LineId to) const;//在该站由from线步行到to线站台的秒数
+
+private:
+    int                          stationCount;   //站点编号上界
+    QVector<TimetableTrip>       trips;          //全部车次
+    QVector<StationId>           stopStations;   //各车次依次的停站
+    QVector<qint32>              stopArrivals;   //停站的到达时刻
+    QVector<qint32>              stopDepartures; //停站的出发时刻
+    QVector<TimetableConnection> connections;    //按(出发, 到达, 车次, 停站)排序的区间运行
+    QVector<qint32>              transferTimes;  //按站点的换乘时间
+    int                          defaultTransfer;//加载后新增站点的换乘时间
+    TimetableService             defaultService; //加载后新增线路的区间运行参数
+    QVector<TimetableService>    services;       //按线路的区间运行参数
+    QHash<quint64, qint32>       walkTimes;      //按(站点, 换出线路, 换入线路)单独配置的步行时间
+
+    Timetable();                                              //只能通过load创建
+    void addTrip(LineId line, const QVector<StationId>& stations,
+                 const QVector<qint32>& arrivals,
+                 const QVector<qint32>& departures);          //登记一个车次
+    void buildConnections();                                  //由车次生成并排序区间运行
+};
+
+#endif // TIMETABLE_H
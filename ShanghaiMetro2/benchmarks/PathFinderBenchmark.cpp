@@ -0,0 +1,653 @@
+﻿/***************************************************************************
+  文件名称：PathFinderBenchmark.cpp
+  功    能：路径查找性能测试程序
+  说    明：测量最少站点策略（BFS、双向BFS与ALT）和最短距离策略（Dijkstra、A*、
+            双向Dijkstra、ALT与收缩层次）的单次查询耗时和扩展站点数，以及三种策略
+            查全源路径表的耗时（表的大小与站点数平方成正比，只在小网络上构建），
+            多目标搜索与依次运行三种策略的耗时对比，
+            以及多起终点矩阵在不同线程数下的耗时、一次单源搜索与逐站findPath的对比，
+            数据目录中有timetable.json时还测量全天时刻表上的最早到达查询和
+            两组权重下的广义代价查询（并与不剪枝的Dijkstra比对结果），
+            分别在随程序发布的地铁网络和由其复制拼接而成的大规模合成网络上运行；
+            开始前先确认fixtures目录中格式错误的数据文件都被拒绝加载。
+            用法：PathFinderBenchmark <metroInfo.json> [复制份数=100] [查询次数=1000]
+***************************************************************************/
+
+#include "MetroGraph.h"
+#include "PathFinder.h"
+#include "ContractionHierarchy.h"
+#include "RouteTable.h"
+#include "ConnectionScan.h"
+#include <QFile>
+#include <QDir>
+#include <QFileInfo>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QtGlobal>
+#include <QPair>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <vector>
+
+static const int MAX_ROUTE_TABLE_STATIONS = 4000; //超过该站点数时不构建全源路径表（约300MB）
+static const int MATRIX_SIZE              = 100;  //多起终点矩阵的起点数和终点数
+
+#ifndef METRO_FIXTURE_DIR
+#define METRO_FIXTURE_DIR "benchmarks/fixtures" //格式错误的数据文件所在目录，由CMake给出绝对路径
+#endif
+
+/***************************************************************************
+  函数名称：silentMessageHandler
+  功    能：丢弃调试输出
+  输入参数：QtMsgType type                     - 消息类型
+            const QMessageLogContext& context  - 消息来源
+            const QString& message             - 消息内容
+  返 回 值：
+  说    明：查询过程中的qDebug输出会掩盖算法本身的耗时
+***************************************************************************/
+static void silentMessageHandler(QtMsgType, const QMessageLogContext&, const QString&) {
+}
+
+/***************************************************************************
+  函数名称：jsonString
+  功    能：将字符串写成JSON字符串字面量
+  输入参数：const QString& text - 原始字符串
+  返 回 值：QByteArray - 带引号的UTF-8字面量
+  说    明：站点和线路名称只需转义引号和反斜杠
+***************************************************************************/
+static QByteArray jsonString(const QString& text) {
+    QByteArray result("\"");
+    for (char c : text.toUtf8()) {
+        if (c == '"' || c == '\\') {
+            result.append('\\');
+        }
+        result.append(c);
+    }
+    result.append('"');
+    return result;
+}
+
+/***************************************************************************
+  函数名称：writeSyntheticNetwork
+  功    能：将地铁网络复制多份拼接成合成网络并写成JSON
+  输入参数：const MetroGraph& base - 原始网络
+            int copies             - 复制份数
+            const QString& filename - 输出文件名
+  返 回 值：bool - 是否写入成功
+  说    明：各份按网格排列，名称加"#序号"后缀，坐标按网格平移；
+            相邻两份的对应站点每隔若干站由联络线相连，使整个网络连通
+***************************************************************************/
+static bool writeSyntheticNetwork(const MetroGraph& base, int copies, const QString& filename) {
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    const int side   = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(copies))));
+    const int stride = 20; //每隔多少个站点设一条联络线
+    const QString connector = QString::fromUtf8("联络线");
+    auto suffix = [](const QString& name, int copy) {
+        return name + "#" + QString::number(copy);
+    };
+
+    /* 线路*/
+    QByteArray out("{\"lines\":[");
+    for (int copy = 0; copy < copies; copy++) {
+        for (const MetroLine& line : base.getLines()) {
+            out += "{\"name\":" + jsonString(suffix(line.name, copy)) + ",\"color\":["
+                 + QByteArray::number(line.color.red()) + "," + QByteArray::number(line.color.green()) + ","
+                 + QByteArray::number(line.color.blue()) + "]},";
+        }
+    }
+    out += "{\"name\":" + jsonString(connector) + ",\"color\":[128,128,128]}],\"stations\":[";
+
+    /* 站点：每条连接只写在站点1一侧，加载时会补全反方向*/
+    const int stationCount = base.getStationCount();
+    QVector<QVector<const StationConnection*>> outgoing(stationCount);
+    for (const StationConnection& connection : base.getConnections()) {
+        outgoing[connection.id1].append(&connection);
+    }
+
+    bool first = true;
+    for (int copy = 0; copy < copies; copy++) {
+        const int row = copy / side;
+        const int col = copy % side;
+        for (StationId id = 0; id < static_cast<StationId>(stationCount); id++) {
+            const Station& station = base.getStationById(id);
+            out += first ? "{" : ",{";
+            first = false;
+            out += "\"name\":" + jsonString(suffix(station.name, copy))
+                 + ",\"tag\":" + jsonString(station.tag) + ",\"type\":" + jsonString(station.type)
+                 + ",\"graph-position\":[" + QByteArray::number(station.graphPosition.x() + col * 2000) + ","
+                 + QByteArray::number(station.graphPosition.y() + row * 2000) + "]"
+                 + ",\"real-position\":[" + QByteArray::number(station.realPosition.x() + col * 0.8, 'f', 6) + ","
+                 + QByteArray::number(station.realPosition.y() + row * 0.6, 'f', 6) + "],\"edges\":[";
+
+            QByteArray edges;
+            for (const StationConnection* connection : outgoing[id]) {
+                edges += ",{\"to\":" + jsonString(suffix(connection->station2, copy))
+                       + ",\"line\":" + jsonString(suffix(connection->line, copy)) + "}";
+            }
+            if (id % stride == 0) {
+                if (col + 1 < side && copy + 1 < copies) {
+                    edges += ",{\"to\":" + jsonString(suffix(station.name, copy + 1)) + ",\"line\":" + jsonString(connector) + "}";
+                }
+                if (copy + side < copies) {
+                    edges += ",{\"to\":" + jsonString(suffix(station.name, copy + side)) + ",\"line\":" + jsonString(connector) + "}";
+                }
+            }
+            out += edges.mid(edges.isEmpty() ? 0 : 1) + "]}";
+        }
+    }
+    out += "]}";
+
+    return file.write(out) == out.size();
+}
+
+/***************************************************************************
+  函数名称：runQueries
+  功    能：在一个网络上运行随机起终点的站点级查询并输出耗时和扩展站点数
+  输入参数：const char* label       - 网络名称
+            MetroGraphPtr graph     - 地铁图版本
+            int queryCount          - 查询次数
+  返 回 值：
+  说    明：起终点由固定种子生成，各算法使用相同的查询，多次运行结果可比；
+            每种算法先运行一次预热
+***************************************************************************/
+static void runQueries(const char* label, MetroGraphPtr graph, int queryCount) {
+    const int    stationCount = graph->getStationCount();
+    std::mt19937 random(20240601u);
+    std::uniform_int_distribution<int> pick(0, stationCount - 1);
+    QVector<QPair<StationId, StationId>> queries;
+    for (int i = 0; i < queryCount; i++) {
+        StationId from = pick(random);
+        StationId to   = pick(random);
+        queries.append(qMakePair(from, to));
+    }
+    std::printf("%s: %d 站, %d 次查询\n", label, stationCount, queryCount);
+
+    QElapsedTimer buildTimer;
+    buildTimer.start();
+    ContractionHierarchyPtr hierarchy = ContractionHierarchy::build(*graph);
+    std::printf("  收缩层次构建 %.1f ms, 捷径 %d 条\n", buildTimer.nsecsElapsed() / 1e6, hierarchy->getShortcutCount());
+
+    buildTimer.start();
+    const int landmarkCount = graph->getLandmarks().landmarks.size();
+    std::printf("  地标表构建 %.1f ms, 地标 %d 个\n", buildTimer.nsecsElapsed() / 1e6, landmarkCount);
+
+    RouteTablePtr routeTable;
+    if (stationCount <= MAX_ROUTE_TABLE_STATIONS) {
+        buildTimer.start();
+        routeTable = RouteTable::build(*graph);
+        std::printf("  全源路径表构建 %.1f ms\n", buildTimer.nsecsElapsed() / 1e6);
+    }
+
+    struct Config {
+        const char*       name;
+        SearchStrategy    strategy;
+        StationsAlgorithm stations;
+        DistanceAlgorithm distance;
+        bool              useHierarchy;
+        bool              useRouteTable;
+    };
+    const Config configs[] = {
+        { "BFS",          MIN_STATIONS, BFS,               A_STAR,                 false, false },
+        { "双向BFS",      MIN_STATIONS, BIDIRECTIONAL_BFS, A_STAR,                 false, false },
+        { "ALT-站点",     MIN_STATIONS, ALT_BFS,           A_STAR,                 false, false },
+        { "Dijkstra",     MIN_DISTANCE, BFS,               DIJKSTRA,               false, false },
+        { "A*",           MIN_DISTANCE, BFS,               A_STAR,                 false, false },
+        { "双向Dijkstra", MIN_DISTANCE, BFS,               BIDIRECTIONAL_DIJKSTRA, false, false },
+        { "ALT-距离",     MIN_DISTANCE, BFS,               ALT_A_STAR,             false, false },
+        { "收缩层次",     MIN_DISTANCE, BFS,               A_STAR,                 true,  false },
+        { "查表-站点",    MIN_STATIONS, BFS,               A_STAR,                 false, true },
+        { "查表-距离",    MIN_DISTANCE, BFS,               A_STAR,                 false, true },
+        { "查表-换乘",    MIN_TRANSFER, BFS,               A_STAR,                 false, true },
+    };
+    for (const Config& config : configs) {
+        if (config.useRouteTable && routeTable == nullptr) {
+            continue;
+        }
+        PathFinder finder(graph);
+        finder.setStationsAlgorithm(config.stations);
+        finder.setDistanceAlgorithm(config.distance);
+        if (config.useHierarchy) {
+            finder.setContractionHierarchy(hierarchy);
+        }
+        if (config.useRouteTable) {
+            finder.setRouteTable(routeTable);
+        }
+        finder.findPath(graph->getStationName(0), graph->getStationName(stationCount - 1), config.strategy);
+
+        std::vector<double> micros;
+        micros.reserve(queryCount);
+        long long     expanded = 0;
+        int           found    = 0;
+        QElapsedTimer timer;
+        for (const QPair<StationId, StationId>& query : queries) {
+            const QString& from = graph->getStationName(query.first);
+            const QString& to   = graph->getStationName(query.second);
+            timer.start();
+            MetroPath path = finder.findPath(from, to, config.strategy);
+            micros.push_back(timer.nsecsElapsed() / 1000.0);
+            expanded += finder.getLastStats().nodesExpanded;
+            if (!path.segments.isEmpty()) {
+                found++;
+            }
+        }
+
+        std::sort(micros.begin(), micros.end());
+        double total = 0;
+        for (double value : micros) {
+            total += value;
+        }
+        std::printf("  %-12s 平均 %.1f us, 中位数 %.1f us, p99 %.1f us, 最大 %.1f us, 平均扩展 %.1f 站 (%d 次找到路径)\n",
+                    config.name, total / micros.size(), micros[micros.size() / 2],
+                    micros[std::min(micros.size() - 1, micros.size() * 99 / 100)], micros.back(),
+                    static_cast<double>(expanded) / queryCount, found);
+    }
+}
+
+/***************************************************************************
+  函数名称：runPareto
+  功    能：比较一次多目标搜索与依次运行三种策略的耗时
+  输入参数：const char* label    - 网络名称
+            MetroGraphPtr graph  - 地铁图
+            int queryCount       - 查询次数
+  返 回 值：
+  说    明：起终点与runQueries相同；三种策略使用查找器的默认算法
+***************************************************************************/
+static void runPareto(const char* label, MetroGraphPtr graph, int queryCount) {
+    const int    stationCount = graph->getStationCount();
+    std::mt19937 random(20240601u);
+    std::uniform_int_distribution<int> pick(0, stationCount - 1);
+    QVector<QPair<QString, QString>> queries;
+    for (int i = 0; i < queryCount; i++) {
+        StationId from = pick(random);
+        StationId to   = pick(random);
+        queries.append(qMakePair(graph->getStationName(from), graph->getStationName(to)));
+    }
+
+    PathFinder    finder(graph);
+    QElapsedTimer timer;
+    timer.start();
+    for (const QPair<QString, QString>& query : queries) {
+        finder.findPath(query.first, query.second, MIN_TRANSFER);
+        finder.findPath(query.first, query.second, MIN_STATIONS);
+        finder.findPath(query.first, query.second, MIN_DISTANCE);
+    }
+    const double separate = timer.nsecsElapsed() / 1000.0 / queryCount;
+
+    long long options = 0;
+    timer.start();
+    for (const QPair<QString, QString>& query : queries) {
+        options += finder.findParetoPaths(query.first, query.second).size();
+    }
+    const double pareto = timer.nsecsElapsed() / 1000.0 / queryCount;
+
+    std::printf("%s: 三种策略依次查找 平均 %.1f us, 多目标搜索 平均 %.1f us (平均 %.2f 个方案)\n",
+                label, separate, pareto, static_cast<double>(options) / queryCount);
+}
+
+/***************************************************************************
+  函数名称：runIsochrone
+  功    能：比较一次单源搜索与对每个终点分别调用findPath的耗时
+  输入参数：const char* label    - 网络名称
+            MetroGraphPtr graph  - 地铁图
+  返 回 值：
+  说    明：起点随机取20个；查找器不设路径缓存，逐站findPath都是完整查询
+***************************************************************************/
+static void runIsochrone(const char* label, MetroGraphPtr graph) {
+    const int    stationCount = graph->getStationCount();
+    const int    originCount  = 20;
+    std::mt19937 random(20240604u);
+    std::uniform_int_distribution<int> pick(0, stationCount - 1);
+    QVector<QString> origins;
+    for (int i = 0; i < originCount; i++) {
+        origins.append(graph->getStationName(pick(random)));
+    }
+
+    const SearchStrategy strategies[] = { MIN_TRANSFER, MIN_STATIONS, MIN_DISTANCE };
+    const char*          names[]      = { "最少换乘", "最少站点", "最短距离" };
+    PathFinder    finder(graph);
+    QElapsedTimer timer;
+    std::printf("%s: 单源到全部 %d 站\n", label, stationCount);
+    for (int k = 0; k < 3; k++) {
+        timer.start();
+        for (const QString& origin : origins) {
+            for (StationId to = 0; to < static_cast<StationId>(stationCount); to++) {
+                finder.findPath(origin, graph->getStationName(to), strategies[k]);
+            }
+        }
+        const double separate = timer.nsecsElapsed() / 1000.0 / originCount;
+
+        long long reached = 0;
+        timer.start();
+        for (const QString& origin : origins) {
+            reached += finder.computeIsochrone(origin, strategies[k]).reachableWithin(1e9).size();
+        }
+        const double isochrone = timer.nsecsElapsed() / 1000.0 / originCount;
+
+        std::printf("  %-8s 逐站findPath %.0f us, computeIsochrone %.1f us, 加速 %.0f 倍 (平均可达 %.0f 站)\n",
+                    names[k], separate, isochrone, separate / isochrone,
+                    static_cast<double>(reached) / originCount);
+    }
+}
+
+/***************************************************************************
+  函数名称：runMatrix
+  功    能：测量多起终点矩阵的耗时
+  输入参数：const char* label    - 网络名称
+            MetroGraphPtr graph  - 地铁图
+  返 回 值：
+  说    明：先测逐对调用findPath的耗时作为对照，再以1个线程到处理器核数
+            逐次加倍的线程数计算同一矩阵，输出相对单线程的加速比
+***************************************************************************/
+static void runMatrix(const char* label, MetroGraphPtr graph) {
+    const int    stationCount = graph->getStationCount();
+    std::mt19937 random(20240602u);
+    std::uniform_int_distribution<int> pick(0, stationCount - 1);
+    QVector<StationId> origins;
+    QVector<StationId> destinations;
+    for (int i = 0; i < MATRIX_SIZE; i++) {
+        origins.append(pick(random));
+        destinations.append(pick(random));
+    }
+    std::printf("%s: %dx%d 最短距离矩阵\n", label, MATRIX_SIZE, MATRIX_SIZE);
+
+    PathFinder    finder(graph);
+    QElapsedTimer timer;
+    timer.start();
+    for (StationId from : origins) {
+        for (StationId to : destinations) {
+            finder.findPath(graph->getStationName(from), graph->getStationName(to), MIN_DISTANCE);
+        }
+    }
+    std::printf("  逐对findPath   %.1f ms\n", timer.nsecsElapsed() / 1e6);
+
+    double single = 0;
+    for (int threads = 1; ; threads = std::min(threads * 2, QThread::idealThreadCount())) {
+        timer.start();
+        OdMatrix matrix = finder.computeMatrix(origins, destinations, MIN_DISTANCE, threads);
+        const double elapsed = timer.nsecsElapsed() / 1e6;
+        if (threads == 1) {
+            single = elapsed;
+        }
+        std::printf("  computeMatrix %2d 线程 %.1f ms, 加速 %.2f 倍 (%d 格)\n",
+                    threads, elapsed, single / elapsed, matrix.distances.size());
+        if (threads >= QThread::idealThreadCount()) {
+            break;
+        }
+    }
+}
+
+/***************************************************************************
+  函数名称：runTimetable
+  功    能：测量全天时刻表上最早到达查询的耗时
+  输入参数：const char* label       - 网络名称
+            const MetroGraph& graph - 地铁图
+            const QString& filename - 时刻表文件
+            int queryCount          - 查询次数
+  返 回 值：
+  说    明：出发时刻在05:30到23:00之间均匀随机
+***************************************************************************/
+static void runTimetable(const char* label, const MetroGraph& graph, const QString& filename, int queryCount) {
+    QElapsedTimer timer;
+    timer.start();
+    TimetablePtr timetable = Timetable::load(graph, filename);
+    if (timetable == nullptr) {
+        return;
+    }
+    std::printf("%s: 时刻表 %d 个车次, %d 段区间运行, 加载 %.1f ms\n", label, timetable->getTripCount(),
+                timetable->getConnections().size(), timer.nsecsElapsed() / 1e6);
+
+    const int    stationCount = graph.getStationCount();
+    std::mt19937 random(20240603u);
+    std::uniform_int_distribution<int> pick(0, stationCount - 1);
+    std::uniform_int_distribution<int> time(Timetable::parseTime("05:30"), Timetable::parseTime("23:00"));
+    ConnectionScan   scan(timetable);
+    std::vector<double> micros;
+    long long        scanned = 0;
+    int              found   = 0;
+    for (int i = 0; i < queryCount; i++) {
+        const StationId from      = pick(random);
+        const StationId to        = pick(random);
+        const int       departure = time(random);
+        timer.start();
+        TimetableJourney journey = scan.earliestArrival(from, to, departure);
+        micros.push_back(timer.nsecsElapsed() / 1000.0);
+        scanned += scan.getScannedCount();
+        if (!journey.legs.isEmpty()) {
+            found++;
+        }
+    }
+
+    std::sort(micros.begin(), micros.end());
+    double total = 0;
+    for (double value : micros) {
+        total += value;
+    }
+    std::printf("  最早到达     平均 %.1f us, 中位数 %.1f us, p99 %.1f us, 最大 %.1f us, 平均扫描 %.0f 段 (%d 次可达)\n",
+                total / micros.size(), micros[micros.size() / 2],
+                micros[std::min(micros.size() - 1, micros.size() * 99 / 100)], micros.back(),
+                static_cast<double>(scanned) / queryCount, found);
+}
+
+/***************************************************************************
+  函数名称：referenceCost
+  功    能：不剪枝地计算两站间的最小广义代价
+  输入参数：const MetroGraph& graph     - 地铁图
+            const CostModel& model      - 代价模型
+            const CostWeights& weights  - 各项权重
+            StationId from              - 起点编号
+            StationId to                - 终点编号
+  返 回 值：double - 最小广义代价，不可达时为-1
+  说    明：(站点, 线路)分组上不带启发、不提前结束的Dijkstra，边权与
+            PathFinder::findMinCostPath相同，用于校验其结果
+***************************************************************************/
+static double referenceCost(const MetroGraph& graph, const CostModel& model, const CostWeights& weights,
+                            StationId from, StationId to) {
+    const MetroCsr&     csr = graph.getCsr();
+    std::vector<double> cost(csr.groupLines.size(), -1);
+    std::vector<std::pair<double, int>> heap;
+    std::greater<std::pair<double, int>> compare;
+    auto relax = [&](int group, double value) {
+        if (cost[group] < 0 || value < cost[group]) {
+            cost[group] = value;
+            heap.push_back(std::make_pair(value, group));
+            std::push_heap(heap.begin(), heap.end(), compare);
+        }
+    };
+    for (int g = csr.groupOffsets[from]; g < csr.groupOffsets[from + 1]; g++) {
+        relax(g, 0);
+    }
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), compare);
+        const std::pair<double, int> top = heap.back();
+        heap.pop_back();
+        if (top.first > cost[top.second]) {
+            continue;
+        }
+        const int line = csr.groupLines[top.second];
+        for (int k = csr.groupEdgeOffsets[top.second]; k < csr.groupEdgeOffsets[top.second + 1]; k++) {
+            const int e = csr.groupEdges[k];
+            relax(graph.findLineGroup(csr.targets[e], line), top.first + weights.inVehicle * model.getRideSeconds(e));
+        }
+        const StationId station = StationId(std::upper_bound(csr.groupOffsets.begin(), csr.groupOffsets.end(), top.second)
+                                            - csr.groupOffsets.begin() - 1);
+        const int       first   = csr.groupOffsets[station];
+        for (int g = first; g < csr.groupOffsets[station + 1]; g++) {
+            if (g != top.second) {
+                relax(g, top.first + weights.walking * model.getWalkRow(top.second)[g - first] + weights.transfer);
+            }
+        }
+    }
+
+    double best = -1;
+    for (int g = csr.groupOffsets[to]; g < csr.groupOffsets[to + 1]; g++) {
+        if (cost[g] >= 0 && (best < 0 || cost[g] < best)) {
+            best = cost[g];
+        }
+    }
+    return best;
+}
+
+/***************************************************************************
+  函数名称：runGeneralizedCost
+  功    能：测量广义代价查询的耗时，并验证修改权重不需要重新预处理
+  输入参数：const char* label       - 网络名称
+            MetroGraphPtr graph     - 地铁图
+            const QString& filename - 提供运营参数的时刻表文件
+            int queryCount          - 查询次数
+  返 回 值：
+  说    明：同一组起终点先后按默认权重和偏重步行、换乘的权重各查询一遍，
+            两组权重共用同一个代价模型。计时之后逐条与referenceCost比对
+            代价，并检查代价分解的合计和路径段的换乘次数，不一致的查询数
+            应为0
+***************************************************************************/
+static void runGeneralizedCost(const char* label, MetroGraphPtr graph, const QString& filename, int queryCount) {
+    TimetablePtr timetable = Timetable::load(*graph, filename);
+    if (timetable == nullptr) {
+        return;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    CostModelPtr model = CostModel::build(*graph, *timetable);
+    std::printf("%s: 广义代价模型构建 %.2f ms\n", label, timer.nsecsElapsed() / 1e6);
+
+    const int    stationCount = graph->getStationCount();
+    std::mt19937 random(20240611u);
+    std::uniform_int_distribution<int> pick(0, stationCount - 1);
+    std::vector<std::pair<QString, QString>> queries;
+    for (int i = 0; i < queryCount; i++) {
+        queries.push_back(std::make_pair(graph->getStationName(pick(random)), graph->getStationName(pick(random))));
+    }
+
+    CostWeights walkAverse;
+    walkAverse.walking  = 4.0;
+    walkAverse.transfer = 600;
+    const std::pair<const char*, CostWeights> settings[] = {
+        { "默认权重", CostWeights() },
+        { "厌恶换乘", walkAverse }
+    };
+
+    PathFinder finder(graph);
+    finder.setCostModel(model);
+    for (const std::pair<const char*, CostWeights>& setting : settings) {
+        finder.setCostWeights(setting.second);
+        long long expanded  = 0;
+        long long transfers = 0;
+        timer.start();
+        for (const std::pair<QString, QString>& query : queries) {
+            CostBreakdown breakdown;
+            finder.findMinCostPath(query.first, query.second, &breakdown);
+            expanded  += finder.getLastStats().nodesExpanded;
+            transfers += qMax(0, breakdown.transfers);
+        }
+        std::printf("  广义代价-%s 平均 %.1f us, 平均展开 %.0f 个分组, 平均换乘 %.2f 次\n", setting.first,
+                    timer.nsecsElapsed() / 1000.0 / queryCount, static_cast<double>(expanded) / queryCount,
+                    static_cast<double>(transfers) / queryCount);
+
+        /* 与不剪枝的Dijkstra比对*/
+        const CostWeights& weights    = setting.second;
+        int                mismatches = 0;
+        for (const std::pair<QString, QString>& query : queries) {
+            CostBreakdown   breakdown;
+            const MetroPath path     = finder.findMinCostPath(query.first, query.second, &breakdown);
+            const double    expected = referenceCost(*graph, *model, weights, graph->getStationId(query.first),
+                                                     graph->getStationId(query.second));
+            const double    summed   = weights.inVehicle * breakdown.inVehicle + weights.walking * breakdown.walking
+                                     + weights.transfer * breakdown.transfers;
+            const bool      sameCost = std::fabs(expected - breakdown.total) <= 1e-6 * qMax(1.0, expected);
+            const bool      sameSum  = breakdown.total < 0 || std::fabs(summed - breakdown.total) <= 1e-3 * qMax(1.0, summed);
+            const bool      sameTransfers = path.segments.isEmpty()
+                                         || (path.transferCount == breakdown.transfers
+                                             && path.segments.size() == path.transferCount + 1);
+            if (!sameCost || !sameSum || !sameTransfers) {
+                mismatches++;
+            }
+        }
+        std::printf("  广义代价-%s 与不剪枝的Dijkstra比对 %d 次, 不一致 %d 次\n", setting.first, queryCount, mismatches);
+    }
+}
+
+/***************************************************************************
+  函数名称：checkRejectedFixtures
+  功    能：确认格式错误的数据文件被拒绝加载
+  输入参数：
+  返 回 值：bool - 全部被拒绝时为true
+  说    明：各文件是QJsonDocument会拒绝、而只数括号深度的读取器会接受的
+            数据，如mismatchedBrackets.json中的{"a": [1} ]
+***************************************************************************/
+static bool checkRejectedFixtures() {
+    const char* const fixtures[] = { "mismatchedBrackets.json" };
+    bool allRejected = true;
+    for (const char* name : fixtures) {
+        const QString filename = QDir(QString::fromUtf8(METRO_FIXTURE_DIR)).filePath(QString::fromUtf8(name));
+        if (!QFile::exists(filename)) {
+            std::printf("加载校验: 找不到 %s\n", filename.toLocal8Bit().constData());
+            allRejected = false;
+            continue;
+        }
+        MetroGraph graph;
+        const bool loaded = graph.loadFromJson(filename);
+        std::printf("加载校验: %s %s\n", name, loaded ? "被错误地接受" : "已拒绝");
+        allRejected = allRejected && !loaded;
+    }
+    return allRejected;
+}
+
+/***************************************************************************
+  函数名称：main
+  功    能：性能测试入口
+  输入参数：int   argc - 命令行参数数量
+            char* argv - 命令行参数数组
+  返 回 值：int - 0成功，1参数、数据错误或格式错误的文件被接受
+  说    明：
+***************************************************************************/
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::fprintf(stderr, "用法: %s <metroInfo.json> [复制份数=100] [查询次数=1000]\n", argv[0]);
+        return 1;
+    }
+    const int copies     = argc > 2 ? std::max(1, std::atoi(argv[2])) : 100;
+    const int queryCount = argc > 3 ? std::max(1, std::atoi(argv[3])) : 1000;
+    qInstallMessageHandler(silentMessageHandler);
+    if (!checkRejectedFixtures()) {
+        return 1;
+    }
+
+    /* 随程序发布的网络*/
+    std::shared_ptr<MetroGraph> base = std::make_shared<MetroGraph>();
+    if (!base->loadFromJson(QString::fromLocal8Bit(argv[1]))) {
+        std::fprintf(stderr, "无法加载 %s\n", argv[1]);
+        return 1;
+    }
+    runQueries("上海地铁", base, queryCount);
+    runPareto("上海地铁", base, queryCount);
+    runMatrix("上海地铁", base);
+    runIsochrone("上海地铁", base);
+    runTimetable("上海地铁", *base, QFileInfo(QString::fromLocal8Bit(argv[1])).dir().filePath("timetable.json"), queryCount);
+    runGeneralizedCost("上海地铁", base, QFileInfo(QString::fromLocal8Bit(argv[1])).dir().filePath("timetable.json"), queryCount);
+
+    /* 合成网络*/
+    const QString syntheticFile = QDir::tempPath() + "/metroBenchmark.json";
+    std::shared_ptr<MetroGraph> synthetic = std::make_shared<MetroGraph>();
+    if (!writeSyntheticNetwork(*base, copies, syntheticFile) || !synthetic->loadFromJson(syntheticFile)) {
+        std::fprintf(stderr, "无法生成合成网络\n");
+        return 1;
+    }
+    QFile::remove(syntheticFile);
+
+    char label[64];
+    std::snprintf(label, sizeof(label), "合成网络(%d份)", copies);
+    runQueries(label, synthetic, queryCount);
+    runPareto(label, synthetic, queryCount);
+    runMatrix(label, synthetic);
+    return 0;
+}
+
+/*PathFinderBenchmark.cpp*/